@@ -0,0 +1,370 @@
+/**
+ * @file bench_main.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the microbenchmarks of the string, parsing and page building functions the features spend their
+ *        CPU time in.
+ *
+ * @details Every benchmark runs on deterministic synthetic data sized like the largest subsystems (a 2000 row Req_DB
+ *          sheet, a 5000 page wiki listing), so two runs on the same machine can be compared. The results are printed
+ *          to stdout as JSON: nanoseconds, bytes allocated and allocations per operation and the peak RSS so far.
+ *
+ *          Usage: ./ERTbot_bench [name filter]
+ *
+ *          Allocations are only counted when built with `BENCHMARK_WRAP_ALLOCATIONS` (the linker's `--wrap`, Linux
+ *          only). The allocations made by cJSON are counted through `cJSON_InitHooks`.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <cjson/cJSON.h>
+#include "ERTbot_common.h"
+#include "ERTbot_features.h"
+#include "wikiAPI.h"
+#include "pageListHelpers.h"
+#include "requirementsHelpers.h"
+#include "stringHelpers.h"
+
+#define BENCH_NUMBER_OF_REQUIREMENTS 2000
+#define BENCH_REQUIREMENTS_PER_GROUP 50
+#define BENCH_NUMBER_OF_VERIFICATIONS 3
+#define BENCH_NUMBER_OF_PAGES 5000
+#define BENCH_APPENDS_PER_OPERATION 1000
+
+// Each benchmark doubles its iteration count until it has run for at least this long
+#define BENCH_MINIMUM_DURATION_NS 200000000LL
+#define BENCH_MAXIMUM_ITERATIONS 1000000L
+
+typedef struct benchmark {
+    const char *name;
+    void (*run)();
+} benchmark;
+
+static atomic_size_t numberOfAllocations = 0;
+static atomic_size_t numberOfBytesAllocated = 0;
+
+#ifdef BENCHMARK_WRAP_ALLOCATIONS
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size){
+    atomic_fetch_add_explicit(&numberOfAllocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&numberOfBytesAllocated, size, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+    atomic_fetch_add_explicit(&numberOfAllocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&numberOfBytesAllocated, count * size, memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size){
+    atomic_fetch_add_explicit(&numberOfAllocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&numberOfBytesAllocated, size, memory_order_relaxed);
+    return __real_realloc(pointer, size);
+}
+
+// cJSON is a shared library, its calls to malloc do not go through the linker's wrap
+static void* countingCJSONMalloc(size_t size){
+    return __wrap_malloc(size);
+}
+#endif
+
+// Fixtures, built once before the benchmarks run
+static char* requirementSheetJson = NULL;
+static char* pageListJson = NULL;
+static char* largePageContent = NULL;
+static cJSON* sheetValues = NULL;
+static cJSON* requirementList = NULL;
+static cJSON* verificationInformation = NULL;
+static cJSON* subsystem = NULL;
+static char* drlContent = NULL;
+
+// Keeps the compiler from optimising the benchmarked calls away
+static volatile size_t benchmarkSink = 0;
+
+static long long getMonotonicNanoseconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static long getPeakResidentSetKilobytes(){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+static char* appendFormatted(char* string, const char* format, ...){
+    char buffer[1024];
+
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(buffer, sizeof(buffer), format, arguments);
+    va_end(arguments);
+
+    return appendToString(string, buffer);
+}
+
+static void buildRequirementSheetFixture(){
+    static const char* const methods[] = {"Test", "Review Of Design", "Inspection", "Analysis"};
+    static const char* const statuses[] = {"uncompleted", "in progress", "completed"};
+    static const char* const deadlines[] = {"PDR", "CDR", "Integration", "Launch"};
+
+    char* json = duplicate_Malloc("{\"range\":\"Req_DB!A1:Z\",\"majorDimension\":\"ROWS\",\"values\":[[\"ID\",\"Title\",\"Description\"");
+    for(int verification = 1; verification <= BENCH_NUMBER_OF_VERIFICATIONS; verification++){
+        json = appendFormatted(json, ",\"Verification Deadline %d\",\"Verification Method %d\",\"Verification Status %d\"",
+                               verification, verification, verification);
+    }
+    json = appendToString(json, "]");
+
+    for(int row = 0; row < BENCH_NUMBER_OF_REQUIREMENTS; row++){
+        if(row % BENCH_REQUIREMENTS_PER_GROUP == 0){
+            json = appendFormatted(json, ",[\"Group %d\"]", row / BENCH_REQUIREMENTS_PER_GROUP);
+        }
+
+        json = appendFormatted(json, ",[\"2024_C_SE_%04d\",\"Requirement %d\",\"The system shall withstand a load of %d N.\\nIt is verified under \\\"nominal\\\" conditions.\\tSee   annex %d.\"",
+                               row, row, 100 + row, row % 7);
+
+        for(int verification = 0; verification < BENCH_NUMBER_OF_VERIFICATIONS; verification++){
+            json = appendFormatted(json, ",\"%s\",\"%s\",\"%s\"",
+                                   deadlines[(row + verification) % 4],
+                                   methods[(row + 2 * verification) % 4],
+                                   statuses[(row / 3 + verification) % 3]);
+        }
+        json = appendToString(json, "]");
+    }
+
+    requirementSheetJson = appendToString(json, "]}");
+}
+
+static void buildPageListFixture(){
+    char* json = duplicate_Malloc("{\"data\":{\"pages\":{\"list\":[");
+
+    for(int page = 0; page < BENCH_NUMBER_OF_PAGES; page++){
+        // One page in two is a requirement page, the others are spread across the rest of the wiki
+        const char* directory = page % 2 == 0 ? "competition/firehorn/systems_engineering/requirements" : "competition/firehorn/propulsion/notes";
+        json = appendFormatted(json, "%s{\"path\":\"%s/page_%d\",\"title\":\"Page %d\",\"id\":%d,\"updatedAt\":\"2024-%02d-%02dT12:00:00.000Z\"}",
+                               page == 0 ? "" : ",", directory, page, page, 1000 + page, 1 + page % 12, 1 + page % 28);
+    }
+
+    pageListJson = appendToString(json, "]}}}");
+}
+
+static void buildLargePageFixture(){
+    char* content = duplicate_Malloc("# Requirement page\n");
+
+    for(int line = 0; line < 1000; line++){
+        content = appendFormatted(content, "Line %d of the page, the system shall be \"verified\" before $ID$ is closed.\n", line);
+    }
+
+    largePageContent = appendToString(content, "<!-- end of page -->\n");
+}
+
+static void buildFixtures(){
+    buildRequirementSheetFixture();
+    buildPageListFixture();
+    buildLargePageFixture();
+
+    cJSON* sheet = cJSON_Parse(requirementSheetJson);
+    if(!sheet){
+        fprintf(stderr, "Could not parse the requirement sheet fixture\n");
+        exit(1);
+    }
+    sheetValues = cJSON_DetachItemFromObject(sheet, "values");
+    cJSON_Delete(sheet);
+
+    requirementList = cJSON_CreateObject();
+    cJSON_AddItemToObject(requirementList, "requirements", parseSheet(sheetValues));
+
+    verificationInformation = parseVerificationInformation(cJSON_GetObjectItem(requirementList, "requirements"));
+
+    subsystem = cJSON_CreateObject();
+    cJSON_AddStringToObject(subsystem, "Name", "Systems Engineering");
+    cJSON_AddStringToObject(subsystem, "Acronym", "SE");
+    cJSON_AddStringToObject(subsystem, "Requirement Pages Directory", "competition/firehorn/systems_engineering/requirements/");
+
+    drlContent = buildDrlFromJSONRequirementList(requirementList, subsystem);
+}
+
+static void freeFixtures(){
+    free(requirementSheetJson);
+    free(pageListJson);
+    free(largePageContent);
+    free(drlContent);
+    cJSON_Delete(sheetValues);
+    cJSON_Delete(requirementList);
+    cJSON_Delete(verificationInformation);
+    cJSON_Delete(subsystem);
+}
+
+static void benchReplaceWordRealloc(){
+    char* content = duplicate_Malloc(largePageContent);
+    content = replaceWord_Realloc(content, "\n", "\\\\n");
+    benchmarkSink += strlen(content);
+    free(content);
+}
+
+static void benchReplaceWordMalloc(){
+    char* content = replaceWord_Malloc(largePageContent, "$ID$", "2024_C_SE_0001");
+    benchmarkSink += strlen(content);
+    free(content);
+}
+
+static void benchAppendToString(){
+    char* content = duplicate_Malloc("");
+    for(int i = 0; i < BENCH_APPENDS_PER_OPERATION; i++){
+        content = appendToString(content, "| 2024_C_SE_0001 | Requirement title | Verification method |\n");
+    }
+    benchmarkSink += strlen(content);
+    free(content);
+}
+
+static void benchExtractText(){
+    char* text = extractText(largePageContent, "Line 500", "<!-- end of page -->", true, false);
+    benchmarkSink += strlen(text);
+    free(text);
+}
+
+static void benchParseSheet(){
+    cJSON* requirements = parseSheet(sheetValues);
+    benchmarkSink += (size_t)cJSON_GetArraySize(requirements);
+    cJSON_Delete(requirements);
+}
+
+static void benchParsePageList(){
+    pageList* head = NULL;
+    head = parseJSON(&head, pageListJson, "path", "requirements");
+    benchmarkSink += head != NULL;
+    freePageList(&head);
+}
+
+static void benchBuildDrl(){
+    char* drl = buildDrlFromJSONRequirementList(requirementList, subsystem);
+    benchmarkSink += strlen(drl);
+    free(drl);
+}
+
+static void benchBuildVcd(){
+    const cJSON* requirements = cJSON_GetObjectItem(requirementList, "requirements");
+
+    cJSON* information = parseVerificationInformation(requirements);
+    char* vcd = buildVCD(information, requirements, subsystem);
+    benchmarkSink += strlen(vcd);
+    free(vcd);
+    cJSON_Delete(information);
+}
+
+// Same chain as updateRequirementPage runs on every page before sending it
+static void benchEscapePageContent(){
+    char* content = duplicate_Malloc(drlContent);
+    content = replaceWord_Realloc(content, "\n", "\\\\n");
+    content = replaceWord_Realloc(content, "\"", "\\\\\\\"");
+    content = replaceWord_Realloc(content, "\r", "");
+    content = replaceWord_Realloc(content, "\t", "");
+    content = replaceWord_Realloc(content, "   ", "");
+    benchmarkSink += strlen(content);
+    free(content);
+}
+
+static const benchmark benchmarks[] = {
+    {"replaceWord_Realloc", benchReplaceWordRealloc},
+    {"replaceWord_Malloc", benchReplaceWordMalloc},
+    {"appendToString", benchAppendToString},
+    {"extractText", benchExtractText},
+    {"parseSheet", benchParseSheet},
+    {"parseJSON", benchParsePageList},
+    {"buildDrlFromJSONRequirementList", benchBuildDrl},
+    {"buildVCD", benchBuildVcd},
+    {"escapePageContent", benchEscapePageContent},
+};
+
+#define NUMBER_OF_BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static void runBenchmark(const benchmark* bench, bool isFirst){
+    // Warm up the caches and the allocator
+    bench->run();
+
+    long iterations = 1;
+    long long duration = 0;
+    size_t allocations = 0;
+    size_t bytes = 0;
+
+    while(1){
+        atomic_store(&numberOfAllocations, 0);
+        atomic_store(&numberOfBytesAllocated, 0);
+
+        long long start = getMonotonicNanoseconds();
+        for(long i = 0; i < iterations; i++){
+            bench->run();
+        }
+        duration = getMonotonicNanoseconds() - start;
+
+        allocations = atomic_load(&numberOfAllocations);
+        bytes = atomic_load(&numberOfBytesAllocated);
+
+        if(duration >= BENCH_MINIMUM_DURATION_NS || iterations >= BENCH_MAXIMUM_ITERATIONS){
+            break;
+        }
+        iterations *= 2;
+    }
+
+    printf("%s\n    {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.1f, ", isFirst ? "" : ",", bench->name,
+           iterations, (double)duration / iterations);
+
+#ifdef BENCHMARK_WRAP_ALLOCATIONS
+    printf("\"bytes_per_op\": %.1f, \"allocations_per_op\": %.1f, ", (double)bytes / iterations, (double)allocations / iterations);
+#else
+    (void)allocations;
+    (void)bytes;
+    printf("\"bytes_per_op\": null, \"allocations_per_op\": null, ");
+#endif
+
+    printf("\"peak_rss_kb\": %ld}", getPeakResidentSetKilobytes());
+    fflush(stdout);
+}
+
+int main(int argc, char **argv){
+    const char* filter = argc > 1 ? argv[1] : NULL;
+
+#ifdef BENCHMARK_WRAP_ALLOCATIONS
+    cJSON_Hooks hooks = {countingCJSONMalloc, free};
+    cJSON_InitHooks(&hooks);
+#endif
+
+    // The benchmarks measure the functions, not the debug lines they log
+    (void)setLogLevels("error");
+
+    buildFixtures();
+
+    printf("{\n  \"requirements\": %d,\n  \"pages\": %d,\n  \"benchmarks\": [", BENCH_NUMBER_OF_REQUIREMENTS, BENCH_NUMBER_OF_PAGES);
+
+    bool isFirst = true;
+    for(size_t i = 0; i < NUMBER_OF_BENCHMARKS; i++){
+        if(filter && !strstr(benchmarks[i].name, filter)){
+            continue;
+        }
+
+        runBenchmark(&benchmarks[i], isFirst);
+        isFirst = false;
+    }
+
+    printf("\n  ]\n}\n");
+
+    freeFixtures();
+    flushLogs();
+
+    return 0;
+}
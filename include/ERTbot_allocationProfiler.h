@@ -0,0 +1,60 @@
+#ifndef ERTBOT_ALLOCATION_PROFILER_H
+#define ERTBOT_ALLOCATION_PROFILER_H
+
+#include <stddef.h>
+
+/**
+ * @struct allocationProfile
+ * @brief Allocations made since `beginAllocationProfile`.
+ *
+ * @details
+ * - `numberOfAllocations`: Calls to malloc, calloc and realloc (cJSON included).
+ * - `bytesAllocated`: Bytes requested by these calls.
+ * - `peakLiveBytes`: Largest amount of memory allocated during the profile and not yet freed at the same time.
+ * - `leakedBlocks`, `leakedBytes`: Blocks allocated during the profile which have not been freed (yet).
+ */
+typedef struct allocationProfile {
+    unsigned long numberOfAllocations;
+    unsigned long long bytesAllocated;
+    unsigned long long peakLiveBytes;
+    unsigned long leakedBlocks;
+    unsigned long long leakedBytes;
+}allocationProfile;
+
+/**
+ * @brief Routes the allocations of cJSON through the profiler.
+ *
+ * @details Only does something in builds configured with `-DERTBOT_ALLOCATION_PROFILING=ON`, in which the linker also
+ *          routes every malloc, calloc, realloc and free of the bot through the `profiled*` functions below. Must be
+ *          called before the first cJSON object is created.
+ */
+void initializeAllocationProfiler();
+
+/**
+ * @brief Starts counting the allocations, attributed to the phase of the trace they are made in (or to `name` when
+ *        the command is not traced).
+ *
+ * @details Called by `executeCommand` for every command. Allocations made by other threads are counted under
+ *          "other threads".
+ */
+void beginAllocationProfile(const char *name);
+
+/**
+ * @brief Stops counting and logs the profile of the command and of each of its phases at the info level.
+ */
+void endAllocationProfile();
+
+/**
+ * @brief Returns the totals of the current (or last) profile.
+ */
+void getAllocationProfile(allocationProfile* profile);
+
+void* profiledMalloc(size_t size);
+
+void* profiledCalloc(size_t count, size_t size);
+
+void* profiledRealloc(void* pointer, size_t size);
+
+void profiledFree(void* pointer);
+
+#endif
@@ -2,13 +2,33 @@
 #define ERTBOT_COMMANDS_H
 
 #include "ERTbot_common.h"
+#include "ERTbot_commandRegistry.h"
 
 
-command** checkForCommand(command** commandQueue, PeriodicCommand** headOfPeriodicCommands);
+commandQueue* checkForCommand(commandQueue* queue, PeriodicCommand** headOfPeriodicCommands);
 
 PeriodicCommand** initalizePeriodicCommands(PeriodicCommand** headOfPeriodicCommands);
 
-command** executeCommand(command** commandQueue);
+/**
+ * @brief Removes the oldest command from the queue and executes it.
+ *
+ * @param[in, out] queue Queue of pending commands.
+ *
+ * @return commandQueue* The queue, without the executed command.
+ */
+commandQueue* executeCommand(commandQueue* queue);
+
+/**
+ * @brief Lets lightweight interactive commands run in between the pages of a long command.
+ *
+ * @details Meant to be called by bulk features at the end of each page iteration. At most every
+ *          `INTERACTIVE_COMMAND_POLL_PERIOD` seconds Slack is polled for new commands, then every lightweight command
+ *          (`help`, `updateReq <requirement ID>`) at the head of the interactive lane is run right away, with its own
+ *          status message. Other commands stay queued and run once the current command is finished. The response
+ *          buffer and status message of the interrupted command are restored before returning, its queued wiki
+ *          mutations are suspended with `suspendWikiMutations` meanwhile.
+ */
+void yieldToInteractiveCommands();
 
 /**
  * @brief Parses a command sentence into a `command` structure.
@@ -30,4 +50,14 @@ command** executeCommand(command** commandQueue);
  */
 void breakdownCommand(const char* sentence, command* cmd);
 
+extern const commandDefinition shutdownCommandDefinition;
+
+extern const commandDefinition helpCommandDefinition;
+
+extern const commandDefinition resetSnapshotsCommandDefinition;
+
+extern const commandDefinition setLogLevelCommandDefinition;
+
+extern const commandDefinition traceCommandDefinition;
+
 #endif
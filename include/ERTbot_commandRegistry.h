@@ -0,0 +1,98 @@
+#ifndef ERTBOT_COMMAND_REGISTRY_H
+#define ERTBOT_COMMAND_REGISTRY_H
+
+#include <stdbool.h>
+#include "ERTbot_common.h"
+
+/**
+ * @enum commandArgumentType
+ * @brief What a command expects as argument, used to validate commands before they are run and to build the help.
+ */
+typedef enum commandArgumentType {
+    COMMAND_ARGUMENT_NONE,
+    COMMAND_ARGUMENT_SUBSYSTEM,
+    COMMAND_ARGUMENT_SUBSYSTEM_LIST,
+    COMMAND_ARGUMENT_SUBSYSTEM_OR_REQUIREMENT_ID,
+    COMMAND_ARGUMENT_PAGE_ID,
+    COMMAND_ARGUMENT_TEXT
+}commandArgumentType;
+
+/**
+ * @enum commandConcurrencyClass
+ * @brief Which other commands a command may run alongside.
+ *
+ * @details
+ * - `COMMAND_CONCURRENCY_READ_ONLY`: Does not write anything, may run at any time.
+ * - `COMMAND_CONCURRENCY_SUBSYSTEM`: Writes the pages/sheets of the subsystem given as argument, must not run alongside
+ *   another command on the same subsystem.
+ * - `COMMAND_CONCURRENCY_EXCLUSIVE`: Must run alone.
+ * - `COMMAND_CONCURRENCY_PROBE`: Only reads, but fetches whole sheets and queues other commands (e.g.
+ *   `checkForChanges`), it is not run in between the pages of another command.
+ */
+typedef enum commandConcurrencyClass {
+    COMMAND_CONCURRENCY_READ_ONLY,
+    COMMAND_CONCURRENCY_SUBSYSTEM,
+    COMMAND_CONCURRENCY_EXCLUSIVE,
+    COMMAND_CONCURRENCY_PROBE
+}commandConcurrencyClass;
+
+/**
+ * @struct commandDefinition
+ * @brief Everything the bot needs to know about a command, each feature defines one for the commands it implements.
+ *
+ * @details
+ * - `name`: Name typed on Slack, e.g. "updateReq".
+ * - `argumentType`: Expected argument, commands with a missing argument are rejected before being run.
+ * - `concurrencyClass`: See `commandConcurrencyClass`.
+ * - `reportsStatus`: If true a "Starting"/"Finished" status message is sent around the handler.
+ * - `description`: One line description shown in the help.
+ * - `argumentDescription`: Description of the argument shown in the help, NULL if the command takes none.
+ * - `example`: Example shown in the help, NULL for none.
+ * - `handler`: Function implementing the command.
+ */
+typedef struct commandDefinition {
+    const char *name;
+    commandArgumentType argumentType;
+    commandConcurrencyClass concurrencyClass;
+    bool reportsStatus;
+    const char *description;
+    const char *argumentDescription;
+    const char *example;
+    void (*handler)(command cmd);
+}commandDefinition;
+
+/**
+ * @brief Builds the command lookup table.
+ *
+ * @details The table is a perfect hash: a seed is searched for which FNV-1a maps every registered name to a different
+ *          slot, so a lookup costs one hash and a single `strcmp`. Called once at startup, lookups call it themselves
+ *          if it was not.
+ */
+void initializeCommandRegistry();
+
+/**
+ * @brief Finds the definition of a command.
+ *
+ * @return const commandDefinition* The definition, or NULL if no command with that name is registered.
+ */
+const commandDefinition* findCommandDefinition(const char *name);
+
+/**
+ * @brief Checks a command's argument against the argument type of its definition.
+ */
+bool isCommandArgumentValid(const commandDefinition* definition, const char *argument);
+
+/**
+ * @brief Checks whether a command only touches a single page (or none) and may therefore run in between the pages
+ *        of a bulk command.
+ */
+bool isLightweightCommand(const command* cmd);
+
+/**
+ * @brief Builds the help text listing every registered command, in registration order.
+ *
+ * @return char* Newly allocated, JSON-escaped message which must be freed by the caller.
+ */
+char* buildHelpMessage();
+
+#endif
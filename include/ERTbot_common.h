@@ -1,6 +1,7 @@
 #ifndef ERTBOT_COMMON_H
 #define ERTBOT_COMMON_H
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <time.h>
 
@@ -54,6 +55,9 @@ extern memory chunk;
  * @var slackMessage::timestamp
  * Pointer to a string representing the timestamp when the message was sent.
  *
+ * @var slackMessage::next
+ * Pointer to the next message when several messages are fetched at once, NULL otherwise.
+ *
  * @details
  * The `slackMessage` structure is useful for storing and processing messages retrieved from Slack
  * in applications that interact with the Slack API or manage Slack communications.
@@ -62,6 +66,7 @@ typedef struct slackMessage {
   char *message;
   char *sender;
   char *timestamp;
+  struct slackMessage *next;
 }slackMessage;
 
 extern slackMessage* commandStatusMessage;
@@ -148,7 +153,75 @@ typedef struct command {
     struct command *next;
 }command;
 
-extern command** headOfCommandQueue;
+#define COMMAND_QUEUE_INDEX_SIZE 64
+
+/**
+ * @enum commandPriority
+ * @brief Lanes of the command queue, a command is only taken from a lane when every higher priority lane is empty.
+ *
+ * @details
+ * - `COMMAND_PRIORITY_INTERACTIVE`: Commands typed by a user on Slack.
+ * - `COMMAND_PRIORITY_SCHEDULED`: Periodic commands.
+ * - `COMMAND_PRIORITY_BACKGROUND`: Commands triggered by the bot itself (e.g. `onPageUpdate`).
+ */
+typedef enum commandPriority {
+    COMMAND_PRIORITY_INTERACTIVE,
+    COMMAND_PRIORITY_SCHEDULED,
+    COMMAND_PRIORITY_BACKGROUND,
+    NUMBER_OF_COMMAND_PRIORITIES
+}commandPriority;
+
+/**
+ * @struct commandQueueNode
+ * @brief A pending command stored in a `commandQueue`.
+ *
+ * @details
+ * - `cmd`: The pending command, its `function` and `argument` strings are owned by the node.
+ * - `priority`: Lane the node is linked in.
+ * - `previous`, `next`: Neighbours in the FIFO order of the lane, used for O(1) removal from anywhere in the queue.
+ * - `nextInIndex`: Next node in the same bucket of the queue's (function, argument) index.
+ * - `sequenceNumber`: Order in which the command was queued, lower is older.
+ */
+typedef struct commandQueueNode {
+    command cmd;
+    commandPriority priority;
+    unsigned long sequenceNumber;
+    struct commandQueueNode *previous;
+    struct commandQueueNode *next;
+    struct commandQueueNode *nextInIndex;
+}commandQueueNode;
+
+/**
+ * @struct commandQueueLane
+ * @brief FIFO of the pending commands of one priority.
+ */
+typedef struct commandQueueLane {
+    commandQueueNode *head;
+    commandQueueNode *tail;
+    int size;
+}commandQueueLane;
+
+/**
+ * @struct commandQueue
+ * @brief Priority queue of pending commands with O(1) enqueue/dequeue and duplicate coalescing.
+ *
+ * @details
+ * - `lanes`: One FIFO per `commandPriority`, oldest command at the head.
+ * - `size`: Number of pending commands over all lanes.
+ * - `nextSequenceNumber`: Sequence number given to the next queued command.
+ * - `index`: Hash buckets keyed by (function, argument), used to find an already pending identical command
+ *   (or a pending command which absorbs the new one, e.g. `sync X` absorbs `updateReq X`) without walking the queue.
+ * - `isJournaled`: Whether every queued command is appended to the command journal, see `openCommandJournal`.
+ */
+typedef struct commandQueue {
+    commandQueueLane lanes[NUMBER_OF_COMMAND_PRIORITIES];
+    int size;
+    unsigned long nextSequenceNumber;
+    commandQueueNode *index[COMMAND_QUEUE_INDEX_SIZE];
+    bool isJournaled;
+}commandQueue;
+
+extern commandQueue* mainCommandQueue;
 
 /**
  * @struct wikiFlag
@@ -185,6 +258,84 @@ extern PeriodicCommand** headOfPeriodicCommands;
 #define LOG_INFO 1
 #define LOG_ERROR 2
 
-void log_message(int level, const char *format, ...);
+/**
+ * @brief Lowest level compiled in, `log_message` calls below it compile to nothing (arguments included).
+ *        Defaults to LOG_DEBUG when DEBUG is defined and LOG_INFO otherwise, can be overridden with -DLOG_COMPILE_LEVEL.
+ */
+#ifndef LOG_COMPILE_LEVEL
+#ifdef DEBUG
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#else
+#define LOG_COMPILE_LEVEL LOG_INFO
+#endif
+#endif
+
+/**
+ * @brief Modules whose log level can be changed at runtime. A source file picks its module by defining `LOG_MODULE`
+ *        before its first include, files which do not are part of `LOG_MODULE_CORE`.
+ */
+#define LOG_MODULE_CORE 0
+#define LOG_MODULE_WIKI_API 1
+#define LOG_MODULE_SHEET_API 2
+#define LOG_MODULE_SLACK_API 3
+#define LOG_MODULE_API_HELPERS 4
+#define LOG_MODULE_FEATURES 5
+#define LOG_MODULE_HELPERS 6
+#define NUMBER_OF_LOG_MODULES 7
+
+#ifndef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_CORE
+#endif
+
+/**
+ * @var logModuleLevels
+ * @brief Runtime log level of each module, see `setLogModuleLevel`.
+ */
+extern int logModuleLevels[NUMBER_OF_LOG_MODULES];
+
+/**
+ * @brief True if a line of `level` logged from the current module would be written. Use it to guard work which is
+ *        only done to be logged (e.g. `cJSON_Print`).
+ */
+#define LOG_ENABLED(level) ((level) >= LOG_COMPILE_LEVEL && (level) >= logModuleLevels[LOG_MODULE])
+
+/**
+ * @brief Logs a printf-style line. Lines below `LOG_COMPILE_LEVEL` are removed at compile time and lines below the
+ *        module's runtime level are skipped before any argument is evaluated or formatted.
+ */
+#define log_message(level, ...) \
+    do { \
+        if (LOG_ENABLED(level)) { \
+            logMessage((level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+void logMessage(int level, const char *format, ...);
+
+/**
+ * @brief Sets the runtime level of the modules from the `ERTBOT_LOG_LEVEL` environment variable,
+ *        e.g. "info" or "info,wikiAPI=debug,features=error".
+ */
+void initializeLogLevels();
+
+/**
+ * @brief Sets the runtime level of a module ("core", "wikiAPI", "sheetAPI", "slackAPI", "apiHelpers", "features",
+ *        "helpers" or "all") to "debug", "info" or "error".
+ *
+ * @return int 0 on success, 1 if the module or level is unknown.
+ */
+int setLogModuleLevel(const char *moduleName, const char *levelName);
+
+/**
+ * @brief Applies a list of "level" or "module=level" settings separated by commas, see `initializeLogLevels`.
+ *
+ * @return int 0 on success, 1 if one of the settings was invalid (the valid ones are still applied).
+ */
+int setLogLevels(const char *settings);
+
+/**
+ * @brief Blocks (for at most a second) until every line logged so far has been written to the log files.
+ */
+void flushLogs();
 
 #endif
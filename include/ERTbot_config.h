@@ -7,6 +7,7 @@
 
 
 //Wiki
+#define WIKI_API_URL "https://rocket-team.epfl.ch/graphql" //overridden by the ERTBOT_WIKI_API_URL environment variable
 #define LINK_TRACKER_PAGE_ID "896"
 #define IMAGE_TRACKER_PAGE_ID "898"
 #define SYNC_TRACKER_PAGE_ID "899"
@@ -15,11 +16,80 @@
 #define BROKEN_LINKS_TRACKER_PAGE_ID "870"
 #define TEST_DRL_PAGE_ID "1125"
 #define TEST_REQ_PAGE_ID "1132"
+#define WIKI_PAGE_FETCH_BATCH_SIZE 20 //pages fetched by a single GraphQL query, see getPages
+#define WIKI_MUTATION_BATCH_MAX_MUTATIONS 50 //page mutations sent by a single GraphQL query, see flushWikiMutations
+#define WIKI_MUTATION_BATCH_MAX_BYTES (1024 * 1024) //a batch is sent before it grows larger than this
+#define WIKI_MUTATION_MAX_CONCURRENT_REQUESTS 4 //full mutation batches in flight at the same time
+#define WIKI_RENDER_QUEUE_MAX_PAGES 500 //queued renders are sent once this many pages are queued, see flushPageRenders
+#define WIKI_RENDER_BATCH_SIZE 10 //pages rendered by a single GraphQL query
+#define WIKI_RENDER_MAX_CONCURRENT_REQUESTS 4 //render requests in flight at the same time
+#define WIKI_PAGE_CACHE_DEFAULT_PATH "logs/pageCache.dat" //overridden by ERTBOT_PAGE_CACHE_PATH, see openPageCache
+#define REQUIREMENT_SNAPSHOT_DIRECTORY "logs/snapshots" //hashes of the requirement rows each feature last processed
+#define WIKI_PAGE_CACHE_COMPACTION_MIN_BYTES (16 * 1024 * 1024) //smaller page caches are never compacted
+
+//Google Sheets
+#define SHEETS_API_URL "https://sheets.googleapis.com/v4" //overridden by the ERTBOT_SHEETS_API_URL environment variable
+#define GOOGLE_OAUTH_URL "https://oauth2.googleapis.com/token" //overridden by the ERTBOT_GOOGLE_OAUTH_URL environment variable
 
 //Slack
+#define SLACK_API_URL "https://slack.com/api" //overridden by the ERTBOT_SLACK_API_URL environment variable
 #define SLACK_WIKI_TOOLBOX_CHANNEL "C06RQGVRKPU"
+#define SLACK_HISTORY_PAGE_SIZE 100 //maximum number of messages fetched per conversations.history call
+
+//Network
+#define NETWORK_TELEMETRY_DUMP_PERIOD 3600 //seconds between two dumps of the request timings to the info log
+#define HTTP_CASSETTE_DEFAULT_PATH "logs/http.cassette" //overridden by the ERTBOT_CASSETTE_PATH environment variable
+#define RATE_LIMIT_WIKI_PER_SECOND 20.0 //requests per second of each rate limit tier, overridden by ERTBOT_RATE_LIMITS
+#define RATE_LIMIT_WIKI_BURST 40 //requests which can be sent at once after the tier was idle
+#define RATE_LIMIT_SHEETS_READ_PER_SECOND 1.0 //60 read requests per minute per user
+#define RATE_LIMIT_SHEETS_READ_BURST 60
+#define RATE_LIMIT_SHEETS_WRITE_PER_SECOND 1.0 //60 write requests per minute per user
+#define RATE_LIMIT_SHEETS_WRITE_BURST 60
+#define RATE_LIMIT_GOOGLE_OAUTH_PER_SECOND 1.0
+#define RATE_LIMIT_GOOGLE_OAUTH_BURST 5
+#define RATE_LIMIT_SLACK_POST_PER_SECOND 1.0 //about one message per second per channel
+#define RATE_LIMIT_SLACK_POST_BURST 3
+#define RATE_LIMIT_SLACK_UPDATE_PER_SECOND 0.8 //Slack tier 3, 50 calls per minute
+#define RATE_LIMIT_SLACK_UPDATE_BURST 5
+#define RATE_LIMIT_SLACK_HISTORY_PER_SECOND 0.8 //Slack tier 3, 50 calls per minute
+#define RATE_LIMIT_SLACK_HISTORY_BURST 5
+#define RATE_LIMIT_DEFAULT_PAUSE_SECONDS 5 //pause of a tier answered 429 without a Retry-After header
+#define RATE_LIMIT_MAX_PAUSE_SECONDS 120 //longer Retry-After values are capped to this
+#define RATE_LIMIT_MAX_RETRIES 3 //times a request answered 429 is sent again once its tier is no longer paused
+#define HTTP_RETRY_MAX_ATTEMPTS 4 //attempts of a request which fails with a connection error or a 502, 503 or 504
+#define HTTP_RETRY_BASE_DELAY_MS 200 //the n-th retry waits a random delay below HTTP_RETRY_BASE_DELAY_MS * 2^n
+#define HTTP_RETRY_MAX_DELAY_MS 5000
+#define HTTP_RETRY_BUDGET_PER_COMMAND 30 //retries a command can use, an outage then fails it instead of slowing it down
+#define HTTP_CONNECT_TIMEOUT_MS 5000 //time a request can take to connect to its server
+#define HTTP_REQUEST_TIMEOUT_MS 30000 //time a request can take as a whole, a stalled server then fails it
+#define HTTP_COMMAND_DEADLINE_SECONDS 1800 //requests of a command still running after this long fail without being sent
+#define CIRCUIT_BREAKER_FAILURE_THRESHOLD 5 //failures in a row after which the requests to a service fail without being sent
+#define CIRCUIT_BREAKER_OPEN_SECONDS 30 //time the requests to a failing service are not sent for, doubled after every failed trial
+#define CIRCUIT_BREAKER_MAX_OPEN_SECONDS 300
 
 //Local
 #define MAXIMUM_NUMBER_OF_VERIFICATIONS 10
+#define COMMAND_JOURNAL_DEFAULT_PATH "logs/commandJournal.log" //overridden by ERTBOT_COMMAND_JOURNAL_PATH, see openCommandJournal
+#define COMMAND_JOURNAL_FSYNC_BATCH 64 //journal records written between two syncs to the disk, finished commands are always synced
+#define COMMAND_JOURNAL_COMPACTION_BYTES (1024 * 1024) //the journal is rewritten once it grows larger than this while idle
+#define INTERACTIVE_COMMAND_POLL_PERIOD 5 //seconds between two Slack polls while a bulk command is running
+#define REQUIREMENT_CHANGE_PROBE_PERIOD 300 //seconds between two checks of the sheets for changes, see checkForRequirementChanges
+
+//Logging
+#define LOG_RING_SIZE 4096 //number of lines the logger can hold before dropping, must be a power of two
+#define LOG_MAX_LINE_LENGTH 2048 //longer lines are truncated
+#define LOG_MAX_FILE_SIZE (10L * 1024 * 1024) //bytes, a log file is rotated once it reaches this size
+#define LOG_MAX_ROTATED_FILES 3 //debug.log.1 ... debug.log.3 are kept
+#define LOG_WRITER_IDLE_DELAY_MS 100 //the writer thread is also woken up as soon as a line is logged
+
+//Tracing
+#define TRACE_DIRECTORY "logs/traces" //one Chrome trace JSON file is written per traced command
+#define TRACE_MAX_FILES 50 //older trace files are deleted
+#define TRACE_MAX_EVENTS 100000 //spans beyond this number are counted but not recorded
+#define TRACE_MAX_DEPTH 32 //maximum number of nested open spans
+#define TRACE_SUMMARY_TOP_PHASES 5 //number of phases listed by "trace last"
+
+//Allocation profiling, only used when built with -DERTBOT_ALLOCATION_PROFILING=ON
+#define ALLOCATION_PROFILER_MAX_PHASES 32 //phases reported separately per command, including "other threads"
 
 #endif
@@ -1,7 +1,11 @@
 #ifndef ERTBOT_FEATURES_H
 #define ERTBOT_FEATURES_H
 
+#include <stdbool.h>
+#include <cjson/cJSON.h>
 #include "ERTbot_common.h"
+#include "ERTbot_commandRegistry.h"
+#include "requirementSnapshotHelpers.h"
 
 
 /**
@@ -21,6 +25,37 @@
  */
 void syncDrlToSheet(command cmd);
 
+/**
+ * @brief Queues the update and render of the DRL page of a subsystem, if the rows it is built from changed.
+ *
+ * @return requirementSnapshot* NULL if the DRL page is already up to date, otherwise the snapshot to save with
+ *         `saveRequirementSnapshot` once the queued mutations were flushed, then free. The flush forgets the DRL from
+ *         it if its update failed.
+ */
+requirementSnapshot* queueDrlUpdate(const cJSON* subsystem, const cJSON* requirementList);
+
+/**
+ * @brief Builds a DRL (Design Requirements List) string from a JSON object containing requirements.
+ *
+ * This function constructs a DRL string by iterating over a JSON array of requirement objects. Each requirement
+ * object is expected to contain specific fields such as "ID", "Path", "Title", and "Description". The resulting
+ * DRL string is built by appending formatted information from each requirement to a template DRL string.
+ *
+ * @param requirementList A `cJSON` object containing an array of requirement objects under the "requirements" key.
+ *
+ * @return A dynamically allocated string containing the formatted DRL. The caller is responsible for freeing this memory. If the input JSON is not properly formatted or if memory allocation fails, the function may return an incorrect or partially filled string.
+ *
+ * @details
+ * - The function first retrieves the "requirements" array from the `requirementList` object.
+ * - It initializes the DRL string using a predefined template.
+ * - For each requirement object in the array, it extracts the fields "ID", "Path", "Title", and "Description".
+ * - These fields are appended to the DRL string in a specific format, including separators and markers.
+ * - After processing all requirements, the function appends "{.links-list}" to the end of the DRL string.
+ * - If any errors are encountered (e.g., missing "requirements" array or incorrect object format), appropriate error messages are printed.
+ * - The function returns the final DRL string.
+ */
+char *buildDrlFromJSONRequirementList(const cJSON *requirementList, const cJSON* subsystem);
+
 /**
  * @brief Creates and updates a requirement page based on data from a Google Sheets document.
  * 
@@ -40,6 +75,18 @@ void syncDrlToSheet(command cmd);
  */
 void updateRequirementPage(command cmd);
 
+/**
+ * @brief Queues the update and render of the requirement pages whose requirement row changed since the last run.
+ *
+ * @param[in, out] requirementPages Requirement pages of the subsystem, the pages which are up to date are removed from
+ *                 the list.
+ * @param[in] reportsProgress If true a loading bar is sent as the pages are built.
+ *
+ * @return requirementSnapshot* The snapshot to save once the queued mutations were flushed, then free. The
+ *         requirements whose page could not be updated are forgotten from it.
+ */
+requirementSnapshot* queueRequirementPageUpdates(const cJSON* subsystem, const cJSON* requirementList, pageList** requirementPages, bool reportsProgress);
+
 /**
  * @brief Creates and updates a VCD (Verification Control Document) page based on data from a Google Sheets document and chart updates.
  * 
@@ -59,5 +106,75 @@ void updateRequirementPage(command cmd);
  */
 void updateVcdPage(command cmd);
 
+/**
+ * @brief Queues the update and render of the VCD page of a subsystem, if the rows it is built from changed.
+ *
+ * @return requirementSnapshot* Like for `queueDrlUpdate`.
+ */
+requirementSnapshot* queueVcdUpdate(const cJSON* subsystem, const cJSON* requirementList);
+
+/**
+ * @brief Groups the requirement IDs by verification deadline, then status, then method.
+ *
+ * @param requirements Array of requirement objects, as returned in "requirements" by `getRequirements`.
+ *
+ * @return cJSON* Object which must be freed by the caller with `cJSON_Delete`.
+ */
+cJSON* parseVerificationInformation(const cJSON* requirements);
+
+/**
+ * @brief Builds the content of a VCD page: one pie chart and one list of requirements per status for each deadline.
+ *
+ * @return char* Newly allocated, unescaped page content which must be freed by the caller.
+ */
+char* buildVCD(const cJSON* verificationInformation, const cJSON* requirements, const cJSON* subsystem);
+
 void createMissingRequirementPages(command cmd);
+
+/**
+ * @brief Queues the creation of a page for every requirement which has none in `requirementPages`.
+ *
+ * @return int Number of pages queued, the page list must be fetched again to get their ids once they are flushed.
+ */
+int queueMissingRequirementPages(const cJSON* subsystem, const cJSON* requirementList, const pageList* requirementPages, bool reportsProgress);
+
+/**
+ * @brief Syncs one subsystem, a comma separated list of subsystems or all of them, e.g. `sync ST`, `sync ST,GE` or
+ *        `sync all`.
+ *
+ * @details The subsystems are synced together in stages rather than one after the other: the INFO sheet and the wiki
+ *          pages are listed once, every Req_DB range is fetched in a single stage, then the missing pages of every
+ *          subsystem are created and finally every DRL, VCD and requirement page is rebuilt and written through the
+ *          concurrent mutation batches. The snapshots of the run are only saved if every mutation was applied.
+ */
+void syncSubsystems(command cmd);
+
+/**
+ * @brief Queues `sync X` for every subsystem X whose INFO row or Req_DB range changed since it was last synced.
+ *
+ * @details Every Req_DB spreadsheet is fetched with a single request, whatever the number of subsystems it holds.
+ *          Nothing is written, the fingerprints of the subsystems are only kept in memory so every subsystem is
+ *          synced by the first probe after a restart.
+ */
+void checkForRequirementChanges(command cmd);
+
+/**
+ * @brief Records that every page of a subsystem was synced with the sheets as the last change probe saw them.
+ *
+ * @details Called by `sync` once every mutation of the subsystem was applied and its snapshots saved. Until then the
+ *          probe keeps queuing a sync of the subsystem.
+ */
+void confirmSubsystemSync(const char *acronym);
+
+extern const commandDefinition updateDrlCommandDefinition;
+
+extern const commandDefinition updateReqCommandDefinition;
+
+extern const commandDefinition updateVcdCommandDefinition;
+
+extern const commandDefinition createMissingRequirementPagesCommandDefinition;
+
+extern const commandDefinition checkForChangesCommandDefinition;
+
+extern const commandDefinition syncCommandDefinition;
 #endif
\ No newline at end of file
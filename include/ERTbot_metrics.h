@@ -0,0 +1,58 @@
+#ifndef ERTBOT_METRICS_H
+#define ERTBOT_METRICS_H
+
+#include <stdbool.h>
+#include "ERTbot_common.h"
+
+/**
+ * @brief Starts the metrics listener if `ERTBOT_METRICS_PORT` is set.
+ *
+ * @details The listener runs on its own thread, is bound to 127.0.0.1 only and answers `GET /metrics` with every
+ *          metric in the Prometheus text format. Without the environment variable nothing is started and the metrics
+ *          are only kept in memory.
+ */
+void startMetricsServer();
+
+/**
+ * @brief Publishes the number of commands waiting in each lane of `queue`.
+ */
+void setQueueDepthMetric(const commandQueue* queue);
+
+/**
+ * @brief Adds a run of `commandName` to the command duration histogram.
+ */
+void recordCommandDurationMetric(const char *commandName, double seconds);
+
+/**
+ * @brief Counts a wiki page which was written, or skipped because it was already up to date.
+ */
+void countPageWriteMetric(bool wasWritten);
+
+/**
+ * @brief Counts a refresh of the Google OAuth token.
+ */
+void countOAuthRefreshMetric();
+
+/**
+ * @brief Counts a request an API answered with 429 Too Many Requests.
+ */
+void countRateLimitedResponseMetric();
+
+/**
+ * @brief Adds time spent waiting for a rate limit token before sending a request.
+ */
+void recordRateLimitWaitMetric(long long microseconds);
+
+/**
+ * @brief Records how late a periodic command was queued compared to its scheduled time.
+ */
+void recordSchedulerLagMetric(long lagInSeconds);
+
+/**
+ * @brief Builds the text served on /metrics.
+ *
+ * @return char* Newly allocated text which must be freed by the caller.
+ */
+char* buildMetricsText();
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef ERTBOT_TRACE_H
+#define ERTBOT_TRACE_H
+
+/**
+ * @enum traceCategory
+ * @brief What a span measures, shown as the category of the event in the trace viewer.
+ *
+ * @details
+ * - `TRACE_CATEGORY_COMMAND`: A whole command, opening one starts a new trace.
+ * - `TRACE_CATEGORY_FEATURE`: A feature run as part of a larger command (e.g. updateReq within sync).
+ * - `TRACE_CATEGORY_PHASE`: The time between two status messages, see `markTracePhase`.
+ * - `TRACE_CATEGORY_API`: A single HTTP request.
+ */
+typedef enum traceCategory {
+    TRACE_CATEGORY_COMMAND,
+    TRACE_CATEGORY_FEATURE,
+    TRACE_CATEGORY_PHASE,
+    TRACE_CATEGORY_API,
+    NUMBER_OF_TRACE_CATEGORIES
+}traceCategory;
+
+/**
+ * @brief Opens a span, which lasts until the matching `endTraceSpan`.
+ *
+ * @param[in] category See `traceCategory`. Spans other than commands opened while no command is traced are ignored,
+ *            so the Slack polling of the main loop does not produce traces.
+ * @param[in] name Name of the span, copied.
+ * @param[in] detail Optional extra information shown in the span's arguments (e.g. the command argument), may be NULL.
+ *
+ * @details Spans must be strictly nested. When the outermost command span ends, the trace is written to
+ *          `TRACE_DIRECTORY` in the Chrome trace event format (open it with chrome://tracing or ui.perfetto.dev) and
+ *          its summary replaces the one returned by `buildLastTraceSummary`.
+ */
+void beginTraceSpan(traceCategory category, const char *name, const char *detail);
+
+/**
+ * @brief Changes the directory the trace files are written to, NULL disables them.
+ *
+ * @details Defaults to `TRACE_DIRECTORY`, or to NULL when testing. With trace files disabled the summary returned by
+ *          `buildLastTraceSummary` is still kept.
+ */
+void setTraceDirectory(const char *directory);
+
+/**
+ * @brief Closes the innermost open span, closing first the phase it may still contain.
+ */
+void endTraceSpan();
+
+/**
+ * @brief Ends the current phase of the innermost span and starts a new one called `phaseName`.
+ *
+ * @details Called for every status message, so the phases of a command are the intervals between its status updates.
+ */
+void markTracePhase(const char *phaseName);
+
+/**
+ * @brief Returns the name of the innermost open span which is not an HTTP request, NULL if no command is traced.
+ *
+ * @details The returned string belongs to the span and changes when it closes.
+ */
+const char* getCurrentTracePhaseName();
+
+/**
+ * @brief Builds a short summary of the last trace: command, duration, file and the phases which took the longest.
+ *
+ * @return char* Newly allocated, JSON-escaped message which must be freed by the caller, or NULL if no command was
+ *         traced yet.
+ */
+char* buildLastTraceSummary();
+
+#endif
@@ -58,6 +58,27 @@ extern char *GOOGLE_CLIENT_SECRET;
  */
 extern char *GOOGLE_REFRESH_TOKEN;
 
+/**
+ * @enum apiService
+ * @brief Services the bot sends requests to, see `getApiUrl`.
+ */
+typedef enum apiService {
+    API_SERVICE_WIKI,
+    API_SERVICE_SHEETS,
+    API_SERVICE_GOOGLE_OAUTH,
+    API_SERVICE_SLACK
+}apiService;
+
+/**
+ * @brief Returns the URL requests to a service are sent to.
+ *
+ * @details The defaults are in ERTbot_config.h, each one can be replaced through an environment variable
+ *          (`ERTBOT_WIKI_API_URL`, `ERTBOT_SHEETS_API_URL`, `ERTBOT_GOOGLE_OAUTH_URL`, `ERTBOT_SLACK_API_URL`), e.g. to run
+ *          the bot against the fake servers of the load test. The Sheets and Slack URLs are base URLs, the method is
+ *          appended to them.
+ */
+const char* getApiUrl(apiService service);
+
 /**
  * @brief Initalises the API token by fetching the values from the server's system evironment variables
  */
@@ -0,0 +1,57 @@
+#ifndef ERTBOT_CIRCUIT_BREAKER_H
+#define ERTBOT_CIRCUIT_BREAKER_H
+
+#include <stdbool.h>
+#include <curl/curl.h>
+#include "networkTelemetry.h"
+#include "apiHelpers.h"
+
+/**
+ * @brief Service (and so host) the requests of an endpoint are sent to, each service has its own circuit.
+ */
+apiService getEndpointService(networkEndpoint endpoint);
+
+/**
+ * @brief Whether a request to the endpoint's service may be sent.
+ *
+ * @return bool false while the circuit of the service is open, the request must then fail without being sent.
+ *
+ * @details A circuit opens after `CIRCUIT_BREAKER_FAILURE_THRESHOLD` failures in a row and stays open for
+ *          `CIRCUIT_BREAKER_OPEN_SECONDS`. Requests are then let through again, the first one to complete closes the
+ *          circuit if it succeeded, or opens it again for twice as long (up to `CIRCUIT_BREAKER_MAX_OPEN_SECONDS`) if
+ *          it failed. Thread safe.
+ */
+bool allowCircuitRequest(networkEndpoint endpoint);
+
+/**
+ * @brief Counts the outcome of a request which was sent.
+ *
+ * @details Connection errors, timeouts and 5xx responses are failures. Other responses, including 4xx and 429 (left to
+ *          the rate limiter), show that the service is up.
+ */
+void reportCircuitResult(networkEndpoint endpoint, CURLcode result, long httpCode);
+
+/**
+ * @brief Whether the circuit of the endpoint's service is open, a failed request is then not retried.
+ */
+bool isCircuitOpen(networkEndpoint endpoint);
+
+/**
+ * @brief How long until every open circuit lets requests through again, in microseconds, 0 if none is open.
+ */
+long long getCircuitBreakerPause();
+
+/**
+ * @brief Number of times a circuit was opened or a request failed because its circuit was open.
+ *
+ * @details A command during which it changed did not get through to one of the services and should be run again once
+ *          the service is back.
+ */
+unsigned long getCircuitBreakerEventCount();
+
+/**
+ * @brief Closes every circuit.
+ */
+void resetCircuitBreakers();
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef ERTBOT_FETCH_STAGE_H
+#define ERTBOT_FETCH_STAGE_H
+
+#include <curl/curl.h>
+#include "ERTbot_common.h"
+#include "httpTransport.h"
+
+#define FETCH_STAGE_MAX_REQUESTS 8
+
+/**
+ * @struct fetchStage
+ * @brief Independent requests a feature needs before it can go on, sent at the same time instead of one after the
+ *        other.
+ *
+ * @details Add the requests with `addWikiFetch`, `addSheetFetch` or the helpers built on them (`addPageListFetch`,
+ *          `addRequirementsFetch`), send them all with `runFetchStage`, then read each response with
+ *          `getFetchResponse`. The stage owns every buffer until `freeFetchStage`.
+ */
+typedef struct fetchStage {
+    httpRequest requests[FETCH_STAGE_MAX_REQUESTS];
+    struct curl_slist* headers[FETCH_STAGE_MAX_REQUESTS];
+    char* urls[FETCH_STAGE_MAX_REQUESTS];
+    char* bodies[FETCH_STAGE_MAX_REQUESTS];
+    int numberOfRequests;
+    bool isSheetTokenRefreshed;
+}fetchStage;
+
+void initializeFetchStage(fetchStage* stage);
+
+/**
+ * @brief Adds a GraphQL query (the JSON body of the request) to the stage, the query is copied.
+ *
+ * @return int Index of the request, to pass to `getFetchResponse`.
+ */
+int addWikiFetch(fetchStage* stage, const char *query);
+
+/**
+ * @brief Adds the GET of a range of a Google Sheet to the stage, like `batchGetSheet`.
+ *
+ * @return int Index of the request, to pass to `getFetchResponse`.
+ *
+ * @details The OAuth token is refreshed before the first sheet request of the stage is added, the refresh is not part
+ *          of the stage.
+ */
+int addSheetFetch(fetchStage* stage, const char *sheetId, const char *range);
+
+/**
+ * @brief Sends every request of the stage at the same time and returns once they are all done.
+ */
+void runFetchStage(fetchStage* stage);
+
+/**
+ * @brief Returns the response of a request of the stage once it ran.
+ *
+ * @return const char* The response, owned by the stage. NULL if the request failed, the failure is logged.
+ */
+const char* getFetchResponse(const fetchStage* stage, int index);
+
+void freeFetchStage(fetchStage* stage);
+
+#endif
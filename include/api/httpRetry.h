@@ -0,0 +1,68 @@
+#ifndef ERTBOT_HTTP_RETRY_H
+#define ERTBOT_HTTP_RETRY_H
+
+#include <curl/curl.h>
+#include "networkTelemetry.h"
+
+/**
+ * @enum httpIdempotency
+ * @brief Whether a request can be sent again after a failure without changing what it does.
+ *
+ * @details
+ * - `HTTP_IDEMPOTENCY_FROM_ENDPOINT`: Given by the endpoint of the request, see `getEndpointIdempotency`.
+ * - `HTTP_IDEMPOTENCY_IDEMPOTENT`: Sending it twice has the same effect as once (queries, renders, updates to a given
+ *   content), it is retried after any transient failure.
+ * - `HTTP_IDEMPOTENCY_NOT_IDEMPOTENT`: Sending it twice may do it twice (creations, deletions, Slack messages), it is
+ *   only retried when it certainly did not reach the server.
+ */
+typedef enum httpIdempotency {
+    HTTP_IDEMPOTENCY_FROM_ENDPOINT,
+    HTTP_IDEMPOTENCY_IDEMPOTENT,
+    HTTP_IDEMPOTENCY_NOT_IDEMPOTENT
+}httpIdempotency;
+
+/**
+ * @brief Idempotency of the requests of an endpoint, never `HTTP_IDEMPOTENCY_FROM_ENDPOINT`.
+ */
+httpIdempotency getEndpointIdempotency(networkEndpoint endpoint);
+
+/**
+ * @brief Decides whether a failed request is sent again and takes a retry from the budget if it is.
+ *
+ * @param[in] attempt Number of times the request was already retried.
+ *
+ * @return long long -1 if the request is not retried, otherwise how long to wait before sending it again in
+ *         microseconds, a random delay between 0 and `HTTP_RETRY_BASE_DELAY_MS` * 2^attempt (full jitter) capped to
+ *         `HTTP_RETRY_MAX_DELAY_MS`.
+ *
+ * @details A request is retried at most `HTTP_RETRY_MAX_ATTEMPTS` - 1 times, and only while the retry budget of the
+ *          running command is not exhausted and the retry can be sent before its deadline. Idempotent requests are retried after a connection error, a timeout or a
+ *          502, 503 or 504 response, other requests only when the connection could not be established. 429 responses
+ *          are left to the rate limiter.
+ */
+long long getHttpRetryDelay(networkEndpoint endpoint, httpIdempotency idempotency, CURLcode result, long httpCode, int attempt);
+
+/**
+ * @brief Gives the command which starts a fresh budget of `HTTP_RETRY_BUDGET_PER_COMMAND` retries, and a deadline
+ *        `HTTP_COMMAND_DEADLINE_SECONDS` from now its requests must be done by.
+ *
+ * @details Must be paired with `endHttpRequestBudget`. A command run in between the pages of another gets its own
+ *          budget, the budget of the interrupted command is given back once it ends and its deadline is pushed back by
+ *          the time it was interrupted for.
+ */
+void beginHttpRequestBudget();
+
+void endHttpRequestBudget();
+
+/**
+ * @brief Number of retries left in the budget of the running command.
+ */
+int getRemainingHttpRetries();
+
+/**
+ * @brief Time left before the deadline of the running command in microseconds, 0 once it passed, -1 outside of any
+ *        command.
+ */
+long long getRemainingHttpTime();
+
+#endif
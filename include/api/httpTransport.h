@@ -0,0 +1,131 @@
+#ifndef ERTBOT_HTTP_TRANSPORT_H
+#define ERTBOT_HTTP_TRANSPORT_H
+
+#include <stdbool.h>
+#include <curl/curl.h>
+#include "networkTelemetry.h"
+#include "httpRetry.h"
+#include "ERTbot_common.h"
+
+/**
+ * @enum cassetteMode
+ * @brief What `performHttpRequest` does with the requests it is given.
+ *
+ * @details
+ * - `CASSETTE_MODE_OFF`: Requests are sent, nothing is recorded.
+ * - `CASSETTE_MODE_RECORD`: Requests are sent and every request/response pair is appended to the cassette.
+ * - `CASSETTE_MODE_REPLAY`: Nothing is sent, the responses are served from the cassette.
+ */
+typedef enum cassetteMode {
+    CASSETTE_MODE_OFF,
+    CASSETTE_MODE_RECORD,
+    CASSETTE_MODE_REPLAY
+}cassetteMode;
+
+/**
+ * @struct cassetteStatistics
+ * @brief How a replay went, a run which sends the same requests as the recorded one has no mismatch and no unused
+ *        interaction.
+ *
+ * @details
+ * - `replayedRequests`: Requests answered from the cassette.
+ * - `mismatchedRequests`: Requests which were not in the cassette, answered with the next recorded response of the
+ *   same endpoint (or a connection error if there was none left).
+ * - `unusedInteractions`: Recorded interactions no request asked for.
+ */
+typedef struct cassetteStatistics {
+    unsigned long replayedRequests;
+    unsigned long mismatchedRequests;
+    unsigned long unusedInteractions;
+}cassetteStatistics;
+
+/**
+ * @brief Sends a request prepared on `curl` (or answers it from the cassette) and stores the response in `chunk`.
+ *
+ * @param[in] curl Handle with every option already set, the response must be written to `chunk`. Not used in replay.
+ * @param[in] endpoint Kind of request, for the network telemetry and the cassette.
+ * @param[in] method HTTP method, part of what identifies the request in the cassette.
+ * @param[in] url URL of the request, only its path is used to identify the request (the host and query string may
+ *            change between the recording and the replay).
+ * @param[in] body Request body, NULL or "" for none.
+ * @param[out] httpCode Status code of the response, 0 if no response was received.
+ *
+ * @return CURLcode Result of `curl_easy_perform`, `CURLE_COULDNT_CONNECT` when replaying a request the cassette has
+ *         no response for or when the circuit of the service is open, `CURLE_OPERATION_TIMEDOUT` when the request
+ *         timed out or the deadline of the command passed.
+ *
+ * @details The cassette is set up on the first call from the environment:
+ *          - `ERTBOT_CASSETTE_MODE`: "record" or "replay", unset for neither.
+ *          - `ERTBOT_CASSETTE_PATH`: Cassette file, `HTTP_CASSETTE_DEFAULT_PATH` by default.
+ *          - `ERTBOT_CASSETTE_LATENCY`: "recorded" to wait as long as the recorded request took before serving its
+ *            response, "zero" (default) to serve it immediately.
+ *          A request is not sent while the circuit of its service is open (see `allowCircuitRequest`) or once the
+ *          deadline of the command passed (see `beginHttpRequestBudget`), it may take at most `HTTP_REQUEST_TIMEOUT_MS`
+ *          and `HTTP_CONNECT_TIMEOUT_MS` to connect. A sent request first waits for a token of its rate limit tier, see
+ *          `tryAcquireRateLimitToken`. A request
+ *          answered 429 pauses its tier and is sent again, at most `RATE_LIMIT_MAX_RETRIES` times. A request which
+ *          failed otherwise is sent again after a backoff if `getHttpRetryDelay` allows it, its idempotency is the one
+ *          of `endpoint`. The last response is the one returned.
+ */
+CURLcode performHttpRequest(CURL *curl, networkEndpoint endpoint, const char *method, const char *url, const char *body, long *httpCode);
+
+/**
+ * @brief Sends a request like `performHttpRequest`, but never waits: for requests which can be skipped, such as status
+ *        messages and loading bars.
+ *
+ * @return CURLcode `CURLE_AGAIN` if the rate limit tier of the endpoint had no token, nothing was sent (or nothing
+ *         more after a 429). A request which failed otherwise is not retried after a backoff.
+ */
+CURLcode tryPerformHttpRequest(CURL *curl, networkEndpoint endpoint, const char *method, const char *url, const char *body, long *httpCode);
+
+/**
+ * @struct httpRequest
+ * @brief A request sent by `performHttpRequests`.
+ *
+ * @details
+ * - `curl`: Handle with every option already set except where the response is written to, which must be `response`.
+ * - `endpoint`, `method`, `url`, `body`: As for `performHttpRequest`.
+ * - `idempotency`: Which failures the request is retried after, `HTTP_IDEMPOTENCY_FROM_ENDPOINT` (zero) to use the
+ *   idempotency of `endpoint`.
+ * - `response`: Buffer the response is written to, must start empty.
+ * - `result`, `httpCode`: Set once the request is done, as returned by `performHttpRequest`.
+ */
+typedef struct httpRequest {
+    CURL *curl;
+    networkEndpoint endpoint;
+    const char *method;
+    const char *url;
+    const char *body;
+    httpIdempotency idempotency;
+    memory response;
+    CURLcode result;
+    long httpCode;
+}httpRequest;
+
+/**
+ * @brief Sends several requests with at most `maximumConcurrentRequests` of them in flight at the same time.
+ *
+ * @details Returns once every request is done. The requests go through the cassette, the circuit breakers and the
+ *          timeouts like the one of `performHttpRequest`, a replay serves them one after the other in the order of the
+ *          array. A request is only started once its rate limit tier has a token, the requests which are retried are sent again after the
+ *          others once their backoff is over.
+ */
+void performHttpRequests(httpRequest* requests, int numberOfRequests, int maximumConcurrentRequests);
+
+/**
+ * @brief Starts recording to or replaying from a cassette, instead of the mode given by the environment.
+ *
+ * @details Recording truncates the file. A replay loads the whole cassette in memory and logs its statistics at exit.
+ *
+ * @return int 0 on success, 1 if the file could not be opened or is not a cassette (the mode is then off).
+ */
+int openCassette(cassetteMode mode, const char *path, bool replaysLatency);
+
+/**
+ * @brief Closes the cassette and goes back to sending requests without recording them.
+ */
+void closeCassette();
+
+void getCassetteStatistics(cassetteStatistics* statistics);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef ERTBOT_NETWORK_TELEMETRY_H
+#define ERTBOT_NETWORK_TELEMETRY_H
+
+#include <stdio.h>
+#include <curl/curl.h>
+
+/**
+ * @enum networkEndpoint
+ * @brief Kind of request, timings are aggregated per endpoint.
+ */
+typedef enum networkEndpoint {
+    NETWORK_ENDPOINT_WIKI_GET_PAGE,
+    NETWORK_ENDPOINT_WIKI_LIST_PAGES,
+    NETWORK_ENDPOINT_WIKI_UPDATE_PAGE,
+    NETWORK_ENDPOINT_WIKI_RENDER_PAGE,
+    NETWORK_ENDPOINT_WIKI_CREATE_PAGE,
+    NETWORK_ENDPOINT_WIKI_MOVE_PAGE,
+    NETWORK_ENDPOINT_WIKI_DELETE_PAGE,
+    NETWORK_ENDPOINT_WIKI_MUTATION_BATCH,
+    NETWORK_ENDPOINT_WIKI_OTHER,
+    NETWORK_ENDPOINT_SHEET_GET,
+    NETWORK_ENDPOINT_SHEET_UPDATE,
+    NETWORK_ENDPOINT_SHEET_OAUTH,
+    NETWORK_ENDPOINT_SLACK_POST,
+    NETWORK_ENDPOINT_SLACK_UPDATE,
+    NETWORK_ENDPOINT_SLACK_HISTORY,
+    NUMBER_OF_NETWORK_ENDPOINTS
+}networkEndpoint;
+
+/**
+ * @enum networkMetric
+ * @brief What is measured for each request.
+ *
+ * @details Times are in microseconds and are the duration of each stage, not curl's cumulative times:
+ * - `NETWORK_METRIC_DNS`: Name resolution.
+ * - `NETWORK_METRIC_CONNECT`: TCP connection.
+ * - `NETWORK_METRIC_TLS`: TLS handshake.
+ * - `NETWORK_METRIC_FIRST_BYTE`: From the request being sent to the first byte of the response, i.e. server time.
+ * - `NETWORK_METRIC_TOTAL`: Whole request.
+ * - `NETWORK_METRIC_BYTES_UP`, `NETWORK_METRIC_BYTES_DOWN`: Body sizes in bytes.
+ */
+typedef enum networkMetric {
+    NETWORK_METRIC_DNS,
+    NETWORK_METRIC_CONNECT,
+    NETWORK_METRIC_TLS,
+    NETWORK_METRIC_FIRST_BYTE,
+    NETWORK_METRIC_TOTAL,
+    NETWORK_METRIC_BYTES_UP,
+    NETWORK_METRIC_BYTES_DOWN,
+    NUMBER_OF_NETWORK_METRICS
+}networkMetric;
+
+/**
+ * @brief Finds the endpoint of a Wiki.js GraphQL request from its query.
+ */
+networkEndpoint classifyWikiQuery(const char *query);
+
+/**
+ * @brief Finds the endpoint of a Slack Web API call from its URL.
+ */
+networkEndpoint classifySlackUrl(const char *url);
+
+/**
+ * @brief Adds one request to the histograms of `endpoint`.
+ *
+ * @param[in] values One value per `networkMetric`.
+ */
+void recordNetworkSample(networkEndpoint endpoint, const long long values[NUMBER_OF_NETWORK_METRICS]);
+
+/**
+ * @brief Reads the timings and sizes of the request `curl` just performed and records them.
+ *
+ * @details Must be called after `curl_easy_perform` and before `curl_easy_cleanup`.
+ */
+void recordCurlTimings(networkEndpoint endpoint, CURL *curl);
+
+/**
+ * @brief Estimates a percentile of a metric from its histogram.
+ *
+ * @param[in] percentile Between 0 and 100.
+ *
+ * @return long long Upper bound of the histogram bucket holding the percentile, 0 if nothing was recorded.
+ */
+long long getNetworkPercentile(networkEndpoint endpoint, networkMetric metric, double percentile);
+
+/**
+ * @brief Number of requests recorded for `endpoint`.
+ */
+unsigned long getNetworkRequestCount(networkEndpoint endpoint);
+
+/**
+ * @brief Name of an endpoint, e.g. "wiki.getPage".
+ */
+const char* getNetworkEndpointName(networkEndpoint endpoint);
+
+/**
+ * @brief Writes one line per endpoint to the info log: request count, median and 90th percentile of each stage and the
+ *        average sizes.
+ *
+ * @details Called every `NETWORK_TELEMETRY_DUMP_PERIOD` seconds by `dumpNetworkTelemetryIfDue` and when the program
+ *          exits. The histograms are not reset, the numbers cover the whole run.
+ */
+void dumpNetworkTelemetry();
+
+/**
+ * @brief Calls `dumpNetworkTelemetry` if the last dump is older than `NETWORK_TELEMETRY_DUMP_PERIOD`.
+ */
+void dumpNetworkTelemetryIfDue();
+
+/**
+ * @brief Writes the request counts, durations and sizes of every endpoint in the Prometheus text format.
+ */
+void writeNetworkTelemetryMetrics(FILE *out);
+
+#endif
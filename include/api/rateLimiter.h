@@ -0,0 +1,87 @@
+#ifndef ERTBOT_RATE_LIMITER_H
+#define ERTBOT_RATE_LIMITER_H
+
+#include <stdbool.h>
+#include "networkTelemetry.h"
+
+/**
+ * @enum rateLimitTier
+ * @brief Group of endpoints which share a rate limit on the API's side, each tier has its own token bucket.
+ *
+ * @details
+ * - `RATE_LIMIT_TIER_WIKI`: Every Wiki.js GraphQL request.
+ * - `RATE_LIMIT_TIER_SHEETS_READ`, `RATE_LIMIT_TIER_SHEETS_WRITE`: Google Sheets read and write requests, which have
+ *   separate per minute quotas.
+ * - `RATE_LIMIT_TIER_GOOGLE_OAUTH`: Refreshes of the Google OAuth token.
+ * - `RATE_LIMIT_TIER_SLACK_POST`: `chat.postMessage`, about one message per second per channel.
+ * - `RATE_LIMIT_TIER_SLACK_UPDATE`: `chat.update` (status messages and loading bars), Slack's tier 3.
+ * - `RATE_LIMIT_TIER_SLACK_HISTORY`: `conversations.history`, Slack's tier 3.
+ */
+typedef enum rateLimitTier {
+    RATE_LIMIT_TIER_WIKI,
+    RATE_LIMIT_TIER_SHEETS_READ,
+    RATE_LIMIT_TIER_SHEETS_WRITE,
+    RATE_LIMIT_TIER_GOOGLE_OAUTH,
+    RATE_LIMIT_TIER_SLACK_POST,
+    RATE_LIMIT_TIER_SLACK_UPDATE,
+    RATE_LIMIT_TIER_SLACK_HISTORY,
+    NUMBER_OF_RATE_LIMIT_TIERS
+}rateLimitTier;
+
+/**
+ * @brief Tier the requests of an endpoint are counted against.
+ */
+rateLimitTier getRateLimitTier(networkEndpoint endpoint);
+
+/**
+ * @brief Name of a tier as used in `ERTBOT_RATE_LIMITS`, e.g. "slack_update".
+ */
+const char* getRateLimitTierName(rateLimitTier tier);
+
+/**
+ * @brief Changes the rate of a tier, its bucket is refilled.
+ *
+ * @param[in] requestsPerSecond Rate the bucket is refilled at, 0 or less disables the limit of the tier.
+ * @param[in] burst Number of requests which can be sent at once after the tier was idle, at least 1.
+ */
+void setRateLimit(rateLimitTier tier, double requestsPerSecond, double burst);
+
+/**
+ * @brief Changes the rate of several tiers from a comma separated list of `tier=requestsPerSecond/burst`, e.g.
+ *        "wiki=10/20,slack_update=0.5/3".
+ *
+ * @return int 0 on success, 1 if a setting could not be parsed (the other settings are still applied).
+ */
+int setRateLimits(const char *settings);
+
+/**
+ * @brief Sets every tier back to its default rate (or the one of `ERTBOT_RATE_LIMITS`) and lifts every pause.
+ */
+void resetRateLimits();
+
+/**
+ * @brief Takes a token from the bucket of the endpoint's tier if one is available.
+ *
+ * @return long long 0 if a token was taken, otherwise how long to wait in microseconds before trying again.
+ *
+ * @details On the first call the rates are set from the `RATE_LIMIT_*` defaults of `ERTbot_config.h`, then from
+ *          `ERTBOT_RATE_LIMITS` if it is set. Thread safe.
+ */
+long long tryAcquireRateLimitToken(networkEndpoint endpoint);
+
+/**
+ * @brief Waits until a token is available for the endpoint's tier and takes it.
+ */
+void waitForRateLimitToken(networkEndpoint endpoint);
+
+/**
+ * @brief Pauses the endpoint's tier after the API answered 429 Too Many Requests.
+ *
+ * @param[in] retryAfterSeconds Value of the `Retry-After` header, 0 or less if there was none, the tier is then paused
+ *            for `RATE_LIMIT_DEFAULT_PAUSE_SECONDS`. Capped to `RATE_LIMIT_MAX_PAUSE_SECONDS`.
+ *
+ * @details The bucket is emptied so that the requests which were waiting do not all go out at once when the pause ends.
+ */
+void reportRateLimitedResponse(networkEndpoint endpoint, long retryAfterSeconds);
+
+#endif
@@ -1,6 +1,24 @@
 #ifndef ERTBOT_SHEETAPI_H
 #define ERTBOT_SHEETAPI_H
 
+#include <curl/curl.h>
+#include "ERTbot_common.h"
+
+/**
+ * @brief Prepares a request to the Sheets API without sending it.
+ *
+ * @param[in] url URL of the request, see `buildBatchGetSheetUrl`.
+ * @param[in] requestType HTTP method (e.g. "GET", "POST").
+ * @param[in] query Request body, "" for none. Not copied, it must outlive the request.
+ * @param[out] response Buffer the response is written to.
+ * @param[out] headers Headers of the request, to be freed with `curl_slist_free_all` once it is done.
+ *
+ * @return CURL* Handle to be sent with `performHttpRequest` or `performHttpRequests`, NULL if libcurl failed.
+ *
+ * @note The request is authorized with the current `SHEET_API_TOKEN`, refresh it first with `refreshOAuthToken`.
+ */
+CURL* createSheetRequest(const char *url, const char *requestType, const char *query, memory *response, struct curl_slist **headers);
+
 /**
  * @brief Makes an API request to a specified URL using the provided query and request type.
  *
@@ -38,6 +56,13 @@ void sheetApi(char *query, char *url, char *requestType);
  */
 void batchUpdateSheet(const char *sheetId, const char *range, const char *values);
 
+/**
+ * @brief Builds the URL `batchGetSheet` sends its GET request to.
+ *
+ * @return char* Newly allocated URL which must be freed by the caller.
+ */
+char* buildBatchGetSheetUrl(const char *sheetId, const char *range);
+
 /**
  * @brief Retrieves data from a specified range in a Google Sheet by sending a GET request.
  *
@@ -54,6 +79,18 @@ void batchUpdateSheet(const char *sheetId, const char *range, const char *values
  */
 void batchGetSheet(const char *sheetId, const char *range);
 
+/**
+ * @brief Retrieves several ranges of a Google Sheet with a single `values:batchGet` request.
+ *
+ * @param[in] sheetId ID of the Google Sheet to be accessed.
+ * @param[in] ranges Ranges to retrieve, e.g. "ST!A1:AZ500".
+ * @param[in] numberOfRanges Number of elements of `ranges`.
+ *
+ * @details The response is stored in `chunk`, its "valueRanges" array holds one value range per requested range, in
+ *          the order they were requested.
+ */
+void batchGetSheetRanges(const char *sheetId, const char* const* ranges, int numberOfRanges);
+
 /**
  * @brief Refreshes the OAuth token by sending a POST request to the Google OAuth 2.0 server.
  *
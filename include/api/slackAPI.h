@@ -23,41 +23,59 @@
 int sendMessageToSlack(char *message);
 
 /**
- * @brief Checks the last message sent in a specified Slack channel by fetching the conversation history.
+ * @brief Fetches every message posted in the Slack channel since the last poll.
  *
- * @details This function sends a GET request to the Slack API to retrieve the most recent message from a specific
- *          Slack channel. The request URL is constructed using the channel ID and a limit of 1 message. The response
- *          is handled by the `writeCallback` function, which stores the result in a memory buffer. The function also
- *          checks for any errors in the HTTP request and verifies the HTTP status code. Resources are cleaned up
- *          after the request is completed.
+ * @param[in, out] cursor Timestamp of the newest message already seen, passed to Slack as `oldest=`. It is advanced to
+ *                        the newest message returned (including bot messages) and left untouched if the request fails.
  *
- * @note The function assumes that the environment variables `SLACK_API_TOKEN` and `SLACK_WIKI_TOOLBOX_CHANNEL`
- *       are set with the appropriate values. The function uses a global variable `chunk` of type `struct memory`
- *       to store the response data.
+ * @return slackMessage* List of the new messages ordered from oldest to newest, bot messages are left out. NULL if
+ *         there are none. The caller is responsible for freeing it with `freeSlackMessageList`.
+ *
+ * @details All of the new messages are fetched in a single `conversations.history` call (following Slack's
+ *          `next_cursor` if there are more than `SLACK_HISTORY_PAGE_SIZE`), so a burst of commands sent in between
+ *          two polls is handled in one round trip and none of them is lost.
  */
-void checkLastSlackMessage();
+slackMessage* getNewSlackMessages(char **cursor);
 
 /**
- * @brief Retrieves the most recent message from a Slack channel and populates a `slackMessage` struct with its details.
- *
- * @param[in] slackMsg A `slackMessage` struct that will be populated with the message details.
+ * @brief Parses a `conversations.history` response.
  *
- * @return slackMessage The populated `slackMessage` struct containing the message text, sender ID, and timestamp.
+ * @param[in] response Body of the response.
+ * @param[in, out] newestTimestamp Replaced by the newest `ts` of the response if it is newer, can be NULL.
+ * @param[out] nextPageCursor Set to Slack's `next_cursor` if there are more messages to fetch, NULL otherwise, can be NULL.
  *
- * @details This function calls `checkLastSlackMessage()` to retrieve the latest message from a Slack channel.
- *          It then parses the JSON response to extract the message text, sender ID, and timestamp using the
- *          `jsonParserGetStringValue()` function. These values are assigned to the corresponding fields of the
- *          `slackMessage` struct passed to the function. The response memory buffer is freed after parsing.
+ * @return slackMessage* The messages which were not sent by a bot, ordered from oldest to newest.
+ */
+slackMessage* parseSlackHistory(const char *response, char **newestTimestamp, char **nextPageCursor);
+
+/**
+ * @brief Compares two Slack timestamps ("seconds.sequence").
  *
- * @note The function assumes that `chunk.response` contains the JSON response from Slack, and that the `slackMessage`
- *       struct has fields for `message`, `sender`, and `timestamp` that are of type `char*`.
+ * @return int -1, 0 or 1 if the first timestamp is older, equal or newer than the second.
  */
-slackMessage* getSlackMessage(slackMessage* slackMsg);
+int compareSlackTimestamps(const char *firstTimestamp, const char *secondTimestamp);
+
+/**
+ * @brief Returns the current time as a Slack timestamp, to be used as initial polling cursor. Must be freed by the caller.
+ */
+char* getCurrentSlackTimestamp();
+
+void freeSlackMessageList(slackMessage** head);
 
 slackMessage* sendUpdatedableSlackMessage(slackMessage* slackMsg);
 
 int updateSlackMessage(slackMessage* slackMessage);
 
+/**
+ * @brief Sends the status messages and loading bars which were not sent for lack of a rate limit token, as long as
+ *        tokens are available. Never waits.
+ *
+ * @details `sendLoadingBar`, `updateCommandStatusMessage` and `sendCompletedStatusMessage` never wait for the
+ *          `slack_update` rate limit: when its tier has no token only the latest text of the message is kept, and sent
+ *          by the next status update or by this function, which the main loop calls every cycle.
+ */
+void sendDeferredStatusUpdates();
+
 void sendLoadingBar(const int currentValue, const int totalValue);
 
 void sendCompletedStatusMessage(const char *commandName);
@@ -2,7 +2,24 @@
 #define ERTBOT_WIKIAPI_H
 
 #include <stdbool.h>
+#include <curl/curl.h>
 #include "ERTbot_common.h"
+#include "fetchStage.h"
+
+/**
+ * @brief Sends a GraphQL query (the JSON body of the request) to the Wiki API, the response is stored in `chunk`.
+ */
+void wikiApi(char *query);
+
+/**
+ * @brief Creates a handle sending a GraphQL query (the JSON body of the request) to the Wiki API.
+ *
+ * @param[in] response Buffer the response is written to.
+ * @param[out] headers Headers of the request, to free with `curl_slist_free_all` once the handle is cleaned up.
+ *
+ * @return CURL* The handle, NULL if it could not be created.
+ */
+CURL* createWikiRequest(const char *query, memory *response, struct curl_slist **headers);
 
 /**
  * @brief Retrieves and updates the content of a page from the Wiki API.
@@ -12,16 +29,36 @@
  *
  * @return Pointer to the `pageList` structure with updated details.
  *
- * @details This function calls `getPageContentQuery` to fetch page content using the ID stored in the `pageList` node pointed
- *          to by `*head`. It then parses the JSON response to extract and populate various fields of the `pageList` structure:
- *          `id`, `title`, `path`, `description`, `content`, `updatedAt`, and `createdAt`. The function uses `jsonParserGetStringValue`
- *          to extract string values from the JSON response. Memory allocated for `chunk.response` is freed after use.
- *
- * @note Ensure that `getPageContentQuery` and `jsonParserGetStringValue` functions are correctly implemented and that `chunk.response`
- *       contains valid JSON data.
+ * @details This function calls `getPages` for the `pageList` node pointed to by `*head` only, which populates its
+ *          `title`, `path`, `description`, `content`, `updatedAt`, `createdAt` and `authorId`.
  */
 pageList* getPage(pageList** head);
 
+/**
+ * @brief Retrieves the content of the first `numberOfPages` pages of a list, `WIKI_PAGE_FETCH_BATCH_SIZE` pages per
+ *        request, or from the page cache.
+ *
+ * @param[in,out] head First page to retrieve, the id of every page must be set.
+ * @param[in] numberOfPages Number of pages to retrieve, fewer are retrieved if the list is shorter.
+ *
+ * @return pageList* The first page of the list which was not retrieved, NULL at the end of the list.
+ *
+ * @details The `single(id:)` lookups of a batch are combined into one GraphQL query using aliases. The `title`,
+ *          `path`, `description`, `content`, `updatedAt`, `createdAt` and `authorId` of every page are replaced by the
+ *          ones returned by the wiki, and left NULL for a page which does not exist. A page whose `updatedAt` is set
+ *          (e.g. by `populatePageList`) and which is in the page cache with the same `updatedAt` is not fetched, only
+ *          its `content` is set. Every page fetched is stored in the page cache.
+ */
+pageList* getPages(pageList* head, int numberOfPages);
+
+/**
+ * @brief Populates the pages of a list from the response of a query aliasing their `single(id:)` fields `page0`,
+ *        `page1`, ... in the same order.
+ *
+ * @param[in] response Response of the query, modified while it is parsed and restored afterwards.
+ */
+void parsePagesResponse(pageList* head, int numberOfPages, char* response);
+
 /**
  * @brief Updates the content of a page in the Wiki using a mutation query.
  *
@@ -83,6 +120,26 @@ void movePageMutation(pageList** head);
  */
 pageList* populatePageList(pageList** head, const char *filterType, const char *filterCondition);
 
+/**
+ * @brief Adds the listing of every wiki page `populatePageList` sends for `filterType` to a fetch stage.
+ *
+ * @return int Index of the request, its response is parsed with `parseJSON` and the same `filterType`.
+ */
+int addPageListFetch(fetchStage* stage, const char *filterType);
+
+/**
+ * @brief Filters the pages of a Wiki.js page list response and appends them to a linked list.
+ *
+ * @param[in, out] head Head of the list the matching pages are added to.
+ * @param[in] jsonString Response of a `pages { list }` query, each page must have its path, title, id and updatedAt.
+ * @param[in] filterType "path" (path contains `filterCondition`), "exact path" or "time" (updated after
+ *            `filterCondition`, the list must be sorted by update time).
+ * @param[in] filterCondition Value the pages are compared to, "none" keeps every page.
+ *
+ * @return pageList* The head of the list.
+ */
+pageList* parseJSON(pageList** head, const char* jsonString, const char* filterType, const char* filterCondition);
+
 
 void createPageMutation(const char* path, const char* content, const char* title);
 
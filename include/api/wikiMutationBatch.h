@@ -0,0 +1,85 @@
+#ifndef ERTBOT_WIKI_MUTATION_BATCH_H
+#define ERTBOT_WIKI_MUTATION_BATCH_H
+
+#include "ERTbot_common.h"
+#include "requirementSnapshotHelpers.h"
+
+/**
+ * @brief Queues the update of a page to its `content`, which must already be escaped like for
+ *        `updatePageContentMutation`.
+ *
+ * @details The queued mutations are sent together by `flushWikiMutations`. A batch holding
+ *          `WIKI_MUTATION_BATCH_MAX_MUTATIONS` mutations or `WIKI_MUTATION_BATCH_MAX_BYTES` bytes is sealed, and the
+ *          sealed batches are sent concurrently once `WIKI_MUTATION_MAX_CONCURRENT_REQUESTS` of them are waiting.
+ *          Mutations of the same page are applied in the order they were queued, those of different pages may be
+ *          applied in any order. The page's id and content are copied.
+ *
+ * @param[in] checkpoint Journaled with `journalCheckpoint` once the wiki applied the update, can be NULL.
+ * @param[in, out] snapshot Snapshot `snapshotKey` is forgotten from with `forgetRequirement` if the wiki did not apply
+ *                 the update, can be NULL. It must not be freed before the update is flushed.
+ */
+void queuePageUpdate(const pageList* page, const char *checkpoint, requirementSnapshot* snapshot, const char *snapshotKey);
+
+/**
+ * @brief Queues the rendering of a page, not done when testing (see `renderMutation`).
+ *
+ * @details A page is rendered once however many times it is queued before `flushPageRenders`, which is called at the
+ *          end of every command and as soon as `WIKI_RENDER_QUEUE_MAX_PAGES` pages are queued.
+ */
+void queuePageRender(const pageList* page);
+
+/**
+ * @brief Queues the creation of a page, the `content` must already be escaped like for `createPageMutation`.
+ */
+void queuePageCreation(const char* path, const char* content, const char* title);
+
+/**
+ * @brief Queues the deletion of a page.
+ */
+void queuePageDeletion(const char* id);
+
+/**
+ * @brief Counts a mutation which could not be queued, e.g. because the page it updates could not be fetched, in the
+ *        failures returned by the next `flushWikiMutations`.
+ *
+ * @param[in, out] snapshot Snapshot `snapshotKey` is forgotten from right away, like for `queuePageUpdate`, can be NULL.
+ */
+void countSkippedWikiMutation(requirementSnapshot* snapshot, const char *snapshotKey);
+
+/**
+ * @brief Sends the queued mutations, one GraphQL document per batch.
+ *
+ * @return int Number of mutations the wiki did not apply since the last call, including those of the batches which
+ *         were sent before it because they were full. Each one is logged with its page and the wiki's message.
+ *
+ * @details Every mutation is a top level `pages` field aliased `m0`, `m1`, ..., top level fields of a mutation are
+ *          executed one after the other in the order they were queued. The response of each alias
+ *          is matched back to the page of the mutation.
+ */
+int flushWikiMutations();
+
+/**
+ * @brief Sends the queued mutations, then renders the queued pages.
+ *
+ * @return int Number of mutations and renders the wiki did not apply.
+ *
+ * @details The renders are aliased like the mutations, `WIKI_RENDER_BATCH_SIZE` per request, with at most
+ *          `WIKI_RENDER_MAX_CONCURRENT_REQUESTS` requests in flight since rendering is slow on the wiki's side.
+ */
+int flushPageRenders();
+
+/**
+ * @brief Sets aside everything queued so far, including the failures not reported yet, so that a command run in
+ *        between the pages of another one sends and reports only its own mutations.
+ *
+ * @details Only one command can be suspended at a time, the queue is given back by `resumeWikiMutations`.
+ */
+void suspendWikiMutations();
+
+/**
+ * @brief Sends what was queued since `suspendWikiMutations` and gives back the suspended mutations, renders and
+ *        failures.
+ */
+void resumeWikiMutations();
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef ERTBOT_WIKI_PAGE_CACHE_H
+#define ERTBOT_WIKI_PAGE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "ERTbot_common.h"
+
+/**
+ * @struct pageCacheStatistics
+ * @brief What the page cache did since it was opened.
+ *
+ * @details
+ * - `hits`: Pages whose content was read from the cache instead of the wiki.
+ * - `misses`: Pages looked up which were not cached, or cached with another `updatedAt`.
+ * - `cachedPages`: Pages in the index, one per id.
+ * - `fileBytes`: Size of the data file, which also holds the stale versions of the pages until it is compacted.
+ */
+typedef struct pageCacheStatistics {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long cachedPages;
+    size_t fileBytes;
+}pageCacheStatistics;
+
+/**
+ * @brief Opens the page cache stored in the data file at `path`, creating it if it does not exist.
+ *
+ * @return int 0 on success, 1 if the file could not be opened, the cache then stays disabled.
+ *
+ * @details The file is read once to build the index, a record cut short by a crash is dropped. The file is compacted
+ *          first if most of it is taken by stale versions of the pages. Until the cache is opened every lookup misses
+ *          and nothing is stored.
+ */
+int openPageCache(const char *path);
+
+/**
+ * @brief Closes the page cache, it is disabled until it is opened again.
+ */
+void closePageCache();
+
+/**
+ * @brief Replaces the content of a page by its cached content, if the page was cached with the same `updatedAt`.
+ *
+ * @param[in,out] page Page whose `id` and `updatedAt` (as given by the page list) are set.
+ *
+ * @return bool true if the content was read from the cache, the page then does not need to be fetched.
+ */
+bool readCachedPageContent(pageList* page);
+
+/**
+ * @brief Appends the content of a page fetched from the wiki to the cache, keyed by its `id` and `updatedAt`.
+ *
+ * @details Pages without an `updatedAt` or a content are not stored, nor pages already cached as they are.
+ */
+void storePageContent(const pageList* page);
+
+void getPageCacheStatistics(pageCacheStatistics* result);
+
+#endif
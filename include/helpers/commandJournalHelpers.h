@@ -0,0 +1,66 @@
+#ifndef ERTBOT_COMMAND_JOURNAL_HELPERS_H
+#define ERTBOT_COMMAND_JOURNAL_HELPERS_H
+
+#include <stdbool.h>
+#include "ERTbot_common.h"
+
+/**
+ * @brief Opens the command journal stored at `path`, restores the commands it holds into `queue`, then journals every
+ *        command queued in `queue` from then on.
+ *
+ * @return int Number of commands restored, or -1 if the journal could not be opened, it then stays disabled.
+ *
+ * @details The commands which were pending when the bot stopped are queued again in the order they were queued. The
+ *          commands which were running are queued first, in the interactive lane, and the checkpoints they wrote are
+ *          kept until each of them finished once, see `isCommandCheckpointed`. Exclusive commands and commands without
+ *          an argument (e.g. `shutdown`) are not resumed. The journal is then rewritten with only what it restored.
+ *          Until the journal is opened nothing is written.
+ */
+int openCommandJournal(const char *path, commandQueue* queue);
+
+void closeCommandJournal();
+
+/**
+ * @brief Appends a call of `enqueueCommand` on the journaled queue to the journal.
+ *
+ * @details Called by `enqueueCommand` itself, every call is journaled even when the command is merged so that the
+ *          journal can be replayed through `enqueueCommand`.
+ */
+void journalQueuedCommand(const char *function, const char *argument, commandPriority priority);
+
+/**
+ * @brief Appends to the journal that a command was taken from the queue and started.
+ */
+void journalStartedCommand(const command* cmd);
+
+/**
+ * @brief Appends to the journal that a command finished.
+ *
+ * @details Once every restored command finished the restored checkpoints are forgotten. The journal is synced to the
+ *          disk, and rewritten if it grew larger than `COMMAND_JOURNAL_COMPACTION_BYTES` while no command is running.
+ */
+void journalFinishedCommand(const command* cmd);
+
+/**
+ * @brief Appends a checkpoint of the running command: something it did which does not need to be done again if the
+ *        command is restored, see `buildCheckpointKey`.
+ */
+void journalCheckpoint(const char *key);
+
+/**
+ * @brief Tells whether a restored command already did what `key` stands for before the bot stopped.
+ */
+bool isCommandCheckpointed(const char *key);
+
+/**
+ * @brief Builds the key of a checkpoint, e.g. "req 2024_C_SE_ST_REQ_01 <hash>".
+ *
+ * @param[in] name Kind of work, e.g. "req", "drl" or "vcd".
+ * @param[in] id What the work was done on, e.g. a requirement ID or a subsystem acronym.
+ * @param[in] hash Hash of everything the work depends on, so that a checkpoint is ignored once its inputs changed.
+ *
+ * @return char* Newly allocated key which must be freed by the caller.
+ */
+char* buildCheckpointKey(const char *name, const char *id, unsigned long long hash);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef ERTBOT_COMMAND_QUEUE_HELPERS_H
+#define ERTBOT_COMMAND_QUEUE_HELPERS_H
+
+#include <stdbool.h>
+#include "ERTbot_common.h"
+
+/**
+ * @brief Allocates an empty command queue.
+ *
+ * @return commandQueue* Pointer to the new queue. The caller is responsible for freeing it with `freeCommandQueue`.
+ */
+commandQueue* createCommandQueue();
+
+/**
+ * @brief Adds a command to the tail of its priority lane unless an equivalent command is already pending.
+ *
+ * @param[in, out] queue Queue to add the command to.
+ * @param[in] function Name of the command.
+ * @param[in] argument Argument of the command, can be NULL.
+ * @param[in] priority Lane the command is queued in.
+ *
+ * @return int 1 if a new command was queued, 0 if it was merged into an already pending command.
+ *
+ * @details Both the lookup and the insertion are O(1): the (function, argument) pair is looked up in the queue's
+ *          index instead of walking the lanes. The following commands are merged:
+ *          - an identical (function, argument) command which is already pending, it is moved to the tail of the
+ *            `priority` lane if that lane has a higher priority than the one it was pending in,
+ *          - `updateDRL X`, `updateReq X`, `updateVCD X` and `createMissingRequirementPages X` while `sync X` is pending
+ *            with the same or a higher priority,
+ *          - when `sync X` is queued, the pending commands it absorbs with the same or a lower priority are dropped
+ *            and `sync X` takes the place of the oldest of them so it does not lose its turn.
+ *          The strings are copied, the caller keeps ownership of `function` and `argument`.
+ */
+int enqueueCommand(commandQueue* queue, const char *function, const char *argument, commandPriority priority);
+
+/**
+ * @brief Removes the oldest command of the highest priority non-empty lane.
+ *
+ * @param[in, out] queue Queue to remove the command from.
+ * @param[out] cmd Receives the removed command. Ownership of `cmd->function` and `cmd->argument` is transferred to
+ *                 the caller who must release them with `freeCommand`.
+ *
+ * @return bool true if a command was removed, false if the queue was empty.
+ */
+bool dequeueCommand(commandQueue* queue, command* cmd);
+
+/**
+ * @brief Same as `dequeueCommand` but only looks at the lane of `priority`.
+ */
+bool dequeueCommandFromLane(commandQueue* queue, commandPriority priority, command* cmd);
+
+/**
+ * @brief Removes the pending (function, argument) command wherever it is queued.
+ *
+ * @return bool true if the command was pending and removed.
+ */
+bool removePendingCommand(commandQueue* queue, const char *function, const char *argument);
+
+/**
+ * @brief Returns the oldest command of the lane of `priority` without removing it, or NULL if the lane is empty.
+ */
+const command* peekCommand(const commandQueue* queue, commandPriority priority);
+
+bool isCommandQueueEmpty(const commandQueue* queue);
+
+/**
+ * @brief Frees the strings held by a command and resets them to NULL. The struct itself is not freed.
+ */
+void freeCommand(command* cmd);
+
+/**
+ * @brief Frees every pending command and the queue itself, then sets `*queue` to NULL.
+ */
+void freeCommandQueue(commandQueue** queue);
+
+#endif
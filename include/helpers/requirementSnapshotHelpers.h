@@ -0,0 +1,106 @@
+#ifndef ERTBOT_REQUIREMENT_SNAPSHOT_HELPERS_H
+#define ERTBOT_REQUIREMENT_SNAPSHOT_HELPERS_H
+
+#include <stdbool.h>
+#include <cjson/cJSON.h>
+#include "ERTbot_common.h"
+
+/**
+ * @brief Hash every snapshot key is chained from, see `hashRequirementRow`.
+ */
+#define REQUIREMENT_HASH_SEED 14695981039346656037ULL
+
+/**
+ * @brief The hash of every requirement a feature processed during its last run on a subsystem, and the ones it
+ *        processes during this run.
+ */
+typedef struct requirementSnapshot requirementSnapshot;
+
+/**
+ * @brief Changes the directory the snapshots are stored in, NULL disables them.
+ *
+ * @details Defaults to `REQUIREMENT_SNAPSHOT_DIRECTORY`, or to NULL when testing. With snapshots disabled every
+ *          requirement is reported as changed and nothing is saved.
+ */
+void setRequirementSnapshotDirectory(const char *directory);
+
+/**
+ * @brief Loads the snapshot a feature saved the last time it ran on a subsystem.
+ *
+ * @param[in] acronym Acronym of the subsystem.
+ * @param[in] name Name of the feature the snapshot belongs to, e.g. "req", "drl" or "vcd".
+ *
+ * @return requirementSnapshot* Never NULL, empty if the feature never ran on the subsystem or the snapshot could not be
+ *         read. Must be freed with `freeRequirementSnapshot`.
+ */
+requirementSnapshot* loadRequirementSnapshot(const char *acronym, const char *name);
+
+/**
+ * @brief Adds a requirement to the snapshot of this run and tells whether it changed since the last one.
+ *
+ * @param[in] id Key of the requirement, e.g. its ID.
+ * @param[in] hash Hash of everything the output of the feature for this requirement depends on.
+ *
+ * @return bool true if the requirement was not in the last snapshot or had another hash.
+ */
+bool isRequirementChanged(requirementSnapshot* snapshot, const char *id, unsigned long long hash);
+
+/**
+ * @brief Counts the requirements of the last snapshot which were not added to the snapshot of this run.
+ */
+int countRemovedRequirements(const requirementSnapshot* snapshot);
+
+/**
+ * @brief Leaves a requirement of this run out of the saved snapshot, so that the next run processes it again.
+ *
+ * @details Called for every requirement whose change could not be applied, e.g. because its mutation failed.
+ */
+void forgetRequirement(requirementSnapshot* snapshot, const char *id);
+
+/**
+ * @brief Counts the requirements of this run left out with `forgetRequirement`.
+ */
+int countForgottenRequirements(const requirementSnapshot* snapshot);
+
+/**
+ * @brief Saves the snapshot of this run in place of the last one, only the requirements added with
+ *        `isRequirementChanged` and not forgotten are kept.
+ *
+ * @return int 0 on success (or with snapshots disabled), 1 if the snapshot could not be written.
+ *
+ * @details Only call it once the changes were applied, with the requirements whose change was lost forgotten, the
+ *          next run would otherwise skip them.
+ */
+int saveRequirementSnapshot(const requirementSnapshot* snapshot);
+
+void freeRequirementSnapshot(requirementSnapshot* snapshot);
+
+/**
+ * @brief Deletes every snapshot of a subsystem, its next run then processes every requirement.
+ *
+ * @return int Number of snapshots deleted.
+ */
+int resetRequirementSnapshots(const char *acronym);
+
+/**
+ * @brief Chains the columns of a requirement row into a FNV-1a hash.
+ *
+ * @param[in] columns NULL terminated list of the columns to hash, a name ending with '*' matches every column starting
+ *            with the rest of the name. NULL hashes every column.
+ * @param[in] hash Hash to chain from, `REQUIREMENT_HASH_SEED` or the hash of what was hashed before.
+ *
+ * @details Both the column names and their values are hashed, in the order of the row.
+ */
+unsigned long long hashRequirementRow(const cJSON* requirement, const char* const* columns, unsigned long long hash);
+
+/**
+ * @brief Chains the columns of every row of a requirement list into a FNV-1a hash, in the order of the rows.
+ */
+unsigned long long hashRequirementList(const cJSON* requirements, const char* const* columns, unsigned long long hash);
+
+/**
+ * @brief Chains a string into a FNV-1a hash, NULL is hashed like an empty string.
+ */
+unsigned long long hashRequirementText(const char *text, unsigned long long hash);
+
+#endif
@@ -1,7 +1,11 @@
 #ifndef ERTBOT_REQUIREMENTS_HELPERS_H
 #define ERTBOT_REQUIREMENTS_HELPERS_H
 
+#include <stdbool.h>
 #include <cjson/cJSON.h>
+#include "fetchStage.h"
+
+#define REQUIREMENT_ID_MARKER "_REQ_"
 
 /**
  * @brief Parses a JSON string representing an array of requirements into a structured cJSON object.
@@ -22,10 +26,67 @@
  */
 cJSON *parseArrayIntoJSONRequirementList(const char *input_str);
 
+/**
+ * @brief Turns the rows of a sheet into objects keyed by the sheet's header row.
+ *
+ * @param values_array The "values" array of a Google Sheets response, its first row is the header.
+ *
+ * @return cJSON* Array with one object per row after the header, or NULL if a header value is missing or empty. The
+ *         caller is responsible for freeing it with `cJSON_Delete`.
+ */
+cJSON* parseSheet(const cJSON* values_array);
+
+/**
+ * @brief Fetches every row of the INFO sheet, one per subsystem.
+ *
+ * @return cJSON* Array of objects keyed by the INFO sheet's header row, or NULL if the sheet could not be fetched.
+ *         The caller is responsible for freeing it with `cJSON_Delete`.
+ */
+cJSON* getSubsystemsInfo();
+
+/**
+ * @brief Adds the request `getSubsystemsInfo` sends to a fetch stage.
+ *
+ * @return int Index of the request, its response is parsed with `parseSubsystemsInfo`.
+ */
+int addSubsystemsInfoFetch(fetchStage* stage);
+
+/**
+ * @brief Parses the response of the INFO sheet request like `getSubsystemsInfo`.
+ */
+cJSON* parseSubsystemsInfo(const char *response);
+
+/**
+ * @brief Fetches the row of the INFO sheet describing a subsystem.
+ *
+ * @param acronym Acronym of the subsystem (e.g. "ST").
+ *
+ * @return cJSON* Object keyed by the INFO sheet's header row, or NULL if the subsystem does not exist.
+ *         The caller is responsible for freeing it with `cJSON_Delete`.
+ */
 cJSON* getSubsystemInfo(const char* acronym);
 
+/**
+ * @brief Checks whether a command argument is a requirement ID (e.g. 2024_C_SE_ST_REQ_01) rather than a subsystem acronym.
+ */
+bool isRequirementId(const char* argument);
+
+/**
+ * @brief Extracts the subsystem acronym from a requirement ID, e.g. "ST" from 2024_C_SE_ST_REQ_01.
+ *
+ * @return char* Newly allocated acronym which must be freed by the caller, or NULL if the ID is malformed.
+ */
+char* getSubsystemAcronymFromRequirementId(const char* requirementId);
+
 cJSON* getRequirements(const cJSON* subsystem);
 
+/**
+ * @brief Adds the request `getRequirements` sends to a fetch stage.
+ *
+ * @return int Index of the request, its response is parsed with `parseArrayIntoJSONRequirementList`.
+ */
+int addRequirementsFetch(fetchStage* stage, const cJSON* subsystem);
+
 char* addDollarSigns(const char* characteristic);
 
 int addSectionToPageContent(char** pageContent, const char* template, const cJSON* object, const char* item);
@@ -9,6 +9,9 @@ export GOOGLE_REFRESH_TOKEN="YOUR API TOKEN"
 export WIKI_API_TOKEN="YOUR API TOKEN"
 export SHEET_API_TOKEN="YOUR API TOKEN"
 
+# Optional, serves Prometheus metrics on http://127.0.0.1:<port>/metrics
+#export ERTBOT_METRICS_PORT="9464"
+
 
 # Directory setup
 BUILD_DIR="build"
@@ -0,0 +1,429 @@
+/**
+ * @file allocationProfiler.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the allocation profiler, which reports how much each command and each of its phases allocates.
+ *
+ * @details In builds configured with `-DERTBOT_ALLOCATION_PROFILING=ON` the linker replaces malloc, calloc, realloc
+ *          and free by the `__wrap_*` functions below (`-Wl,--wrap`), and cJSON, a shared library the wrapping does
+ *          not reach, is given the same functions through `cJSON_InitHooks`. While a profile is running every block
+ *          allocated is kept in a hash table with its size and phase, so that freeing it can be accounted for. Blocks
+ *          allocated before the profile started are not tracked, freeing them is ignored.
+ *
+ *          Without the option nothing is wrapped and the profiles stay empty.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <cjson/cJSON.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "ERTbot_trace.h"
+#include "ERTbot_allocationProfiler.h"
+
+#define ALLOCATION_PHASE_NAME_LENGTH 64
+#define ALLOCATION_TABLE_INITIAL_CAPACITY 4096
+
+#ifdef ALLOCATION_PROFILING
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void __real_free(void* pointer);
+
+#define REAL_MALLOC __real_malloc
+#define REAL_CALLOC __real_calloc
+#define REAL_REALLOC __real_realloc
+#define REAL_FREE __real_free
+#else
+#define REAL_MALLOC malloc
+#define REAL_CALLOC calloc
+#define REAL_REALLOC realloc
+#define REAL_FREE free
+#endif
+
+typedef struct allocationPhase {
+    char name[ALLOCATION_PHASE_NAME_LENGTH];
+    unsigned long numberOfAllocations;
+    unsigned long long bytesAllocated;
+    unsigned long liveBlocks;
+    unsigned long long liveBytes;
+} allocationPhase;
+
+typedef struct trackedBlock {
+    uintptr_t pointer;
+    size_t size;
+    int phase;
+} trackedBlock;
+
+static atomic_bool isProfiling = false;
+static pthread_mutex_t profilerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t profiledThread;
+
+static char profileName[ALLOCATION_PHASE_NAME_LENGTH];
+static allocationProfile profile;
+static unsigned long long liveBytes = 0;
+
+// Phase 0 collects the allocations of the other threads, the last one those of the phases which did not fit
+static allocationPhase phases[ALLOCATION_PROFILER_MAX_PHASES];
+static int numberOfPhases = 0;
+static int lastPhase = -1;
+
+static trackedBlock* trackedBlocks = NULL;
+static size_t trackedBlocksCapacity = 0;
+static size_t numberOfTrackedBlocks = 0;
+
+static size_t hashPointer(uintptr_t pointer){
+    // Blocks are at least 16 byte aligned, the low bits carry no information
+    uint64_t hash = (uint64_t)(pointer >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(hash >> 32) & (trackedBlocksCapacity - 1);
+}
+
+static void insertTrackedBlock(trackedBlock block){
+    size_t slot = hashPointer(block.pointer);
+    while(trackedBlocks[slot].pointer != 0){
+        slot = (slot + 1) & (trackedBlocksCapacity - 1);
+    }
+
+    trackedBlocks[slot] = block;
+    numberOfTrackedBlocks++;
+}
+
+static bool growTrackedBlocks(){
+    size_t oldCapacity = trackedBlocksCapacity;
+    trackedBlock* oldBlocks = trackedBlocks;
+
+    size_t newCapacity = oldCapacity ? 2 * oldCapacity : ALLOCATION_TABLE_INITIAL_CAPACITY;
+    trackedBlock* newBlocks = (trackedBlock*)REAL_CALLOC(newCapacity, sizeof(trackedBlock));
+    if(!newBlocks){
+        return false;
+    }
+
+    trackedBlocks = newBlocks;
+    trackedBlocksCapacity = newCapacity;
+    numberOfTrackedBlocks = 0;
+
+    for(size_t i = 0; i < oldCapacity; i++){
+        if(oldBlocks[i].pointer != 0){
+            insertTrackedBlock(oldBlocks[i]);
+        }
+    }
+
+    REAL_FREE(oldBlocks);
+    return true;
+}
+
+static bool removeTrackedBlock(uintptr_t pointer, trackedBlock* removedBlock){
+    if(trackedBlocksCapacity == 0){
+        return false;
+    }
+
+    size_t slot = hashPointer(pointer);
+    while(trackedBlocks[slot].pointer != pointer){
+        if(trackedBlocks[slot].pointer == 0){
+            return false;
+        }
+        slot = (slot + 1) & (trackedBlocksCapacity - 1);
+    }
+
+    *removedBlock = trackedBlocks[slot];
+    trackedBlocks[slot].pointer = 0;
+    numberOfTrackedBlocks--;
+
+    // Linear probing without tombstones: move back the blocks of the same cluster which can now sit closer to home
+    size_t emptySlot = slot;
+    for(size_t next = (slot + 1) & (trackedBlocksCapacity - 1); trackedBlocks[next].pointer != 0; next = (next + 1) & (trackedBlocksCapacity - 1)){
+        size_t home = hashPointer(trackedBlocks[next].pointer);
+        bool canMove = emptySlot <= next ? (home <= emptySlot || home > next) : (home <= emptySlot && home > next);
+        if(canMove){
+            trackedBlocks[emptySlot] = trackedBlocks[next];
+            trackedBlocks[next].pointer = 0;
+            emptySlot = next;
+        }
+    }
+
+    return true;
+}
+
+static int findPhase(const char *name){
+    if(lastPhase >= 0 && strncmp(phases[lastPhase].name, name, ALLOCATION_PHASE_NAME_LENGTH - 1) == 0){
+        return lastPhase;
+    }
+
+    for(int i = 1; i < numberOfPhases; i++){
+        if(strncmp(phases[i].name, name, ALLOCATION_PHASE_NAME_LENGTH - 1) == 0){
+            lastPhase = i;
+            return i;
+        }
+    }
+
+    if(numberOfPhases == ALLOCATION_PROFILER_MAX_PHASES - 1){
+        numberOfPhases++;
+        snprintf(phases[numberOfPhases - 1].name, ALLOCATION_PHASE_NAME_LENGTH, "other phases");
+    }
+
+    if(numberOfPhases == ALLOCATION_PROFILER_MAX_PHASES){
+        return ALLOCATION_PROFILER_MAX_PHASES - 1;
+    }
+
+    snprintf(phases[numberOfPhases].name, ALLOCATION_PHASE_NAME_LENGTH, "%s", name);
+    lastPhase = numberOfPhases;
+    return numberOfPhases++;
+}
+
+static int findCurrentPhase(){
+    if(!pthread_equal(pthread_self(), profiledThread)){
+        return 0;
+    }
+
+    const char *phaseName = getCurrentTracePhaseName();
+    return findPhase(phaseName ? phaseName : profileName);
+}
+
+static void trackAllocation(void* pointer, size_t size){
+    pthread_mutex_lock(&profilerMutex);
+
+    if(!atomic_load_explicit(&isProfiling, memory_order_relaxed)){
+        pthread_mutex_unlock(&profilerMutex);
+        return;
+    }
+
+    int phase = findCurrentPhase();
+
+    profile.numberOfAllocations++;
+    profile.bytesAllocated += size;
+    phases[phase].numberOfAllocations++;
+    phases[phase].bytesAllocated += size;
+
+    // A block which cannot be tracked is still counted, freeing it will be ignored
+    if(2 * (numberOfTrackedBlocks + 1) <= trackedBlocksCapacity || growTrackedBlocks()){
+        trackedBlock block = {(uintptr_t)pointer, size, phase};
+        insertTrackedBlock(block);
+
+        phases[phase].liveBlocks++;
+        phases[phase].liveBytes += size;
+        liveBytes += size;
+        if(liveBytes > profile.peakLiveBytes){
+            profile.peakLiveBytes = liveBytes;
+        }
+    }
+
+    pthread_mutex_unlock(&profilerMutex);
+}
+
+/**
+ * @brief Stops tracking a block which is about to be freed or reallocated.
+ *
+ * @return bool true if the block was tracked, it is then copied to `removedBlock`.
+ */
+static bool untrackAllocation(void* pointer, trackedBlock* removedBlock){
+    pthread_mutex_lock(&profilerMutex);
+
+    bool isTracked = atomic_load_explicit(&isProfiling, memory_order_relaxed) && removeTrackedBlock((uintptr_t)pointer, removedBlock);
+    if(isTracked){
+        phases[removedBlock->phase].liveBlocks--;
+        phases[removedBlock->phase].liveBytes -= removedBlock->size;
+        liveBytes -= removedBlock->size;
+    }
+
+    pthread_mutex_unlock(&profilerMutex);
+    return isTracked;
+}
+
+/**
+ * @brief Tracks again a block `untrackAllocation` removed, without counting it as a new allocation.
+ */
+static void retrackAllocation(const trackedBlock* block){
+    pthread_mutex_lock(&profilerMutex);
+
+    // Its slot was freed when it was removed, unless the profile ended in between
+    if(atomic_load_explicit(&isProfiling, memory_order_relaxed) && 2 * (numberOfTrackedBlocks + 1) <= trackedBlocksCapacity){
+        insertTrackedBlock(*block);
+
+        phases[block->phase].liveBlocks++;
+        phases[block->phase].liveBytes += block->size;
+        liveBytes += block->size;
+    }
+
+    pthread_mutex_unlock(&profilerMutex);
+}
+
+void* profiledMalloc(size_t size){
+    void* pointer = REAL_MALLOC(size);
+
+    if(pointer && atomic_load_explicit(&isProfiling, memory_order_relaxed)){
+        trackAllocation(pointer, size);
+    }
+
+    return pointer;
+}
+
+void* profiledCalloc(size_t count, size_t size){
+    void* pointer = REAL_CALLOC(count, size);
+
+    if(pointer && atomic_load_explicit(&isProfiling, memory_order_relaxed)){
+        trackAllocation(pointer, count * size);
+    }
+
+    return pointer;
+}
+
+void* profiledRealloc(void* pointer, size_t size){
+    if(!atomic_load_explicit(&isProfiling, memory_order_relaxed)){
+        return REAL_REALLOC(pointer, size);
+    }
+
+    // Untracked before realloc frees it, another thread may be given the same address and track it right away
+    trackedBlock oldBlock;
+    bool isOldBlockTracked = pointer && untrackAllocation(pointer, &oldBlock);
+
+    void* newPointer = REAL_REALLOC(pointer, size);
+
+    if(newPointer){
+        trackAllocation(newPointer, size);
+    }
+
+    // On failure the old block is left untouched
+    else if(size != 0 && isOldBlockTracked){
+        retrackAllocation(&oldBlock);
+    }
+
+    return newPointer;
+}
+
+void profiledFree(void* pointer){
+    trackedBlock block;
+    if(pointer && atomic_load_explicit(&isProfiling, memory_order_relaxed)){
+        (void)untrackAllocation(pointer, &block);
+    }
+
+    REAL_FREE(pointer);
+}
+
+#ifdef ALLOCATION_PROFILING
+void* __wrap_malloc(size_t size){
+    return profiledMalloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+    return profiledCalloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size){
+    return profiledRealloc(pointer, size);
+}
+
+void __wrap_free(void* pointer){
+    profiledFree(pointer);
+}
+#endif
+
+void initializeAllocationProfiler(){
+#ifdef ALLOCATION_PROFILING
+    cJSON_Hooks hooks = {profiledMalloc, profiledFree};
+    cJSON_InitHooks(&hooks);
+
+    log_message(LOG_INFO, "Allocation profiling is enabled");
+#endif
+}
+
+void beginAllocationProfile(const char *name){
+    pthread_mutex_lock(&profilerMutex);
+
+    memset(&profile, 0, sizeof(profile));
+    memset(phases, 0, sizeof(phases));
+    snprintf(phases[0].name, ALLOCATION_PHASE_NAME_LENGTH, "other threads");
+    numberOfPhases = 1;
+    lastPhase = -1;
+    liveBytes = 0;
+
+    snprintf(profileName, sizeof(profileName), "%s", name ? name : "command");
+    profiledThread = pthread_self();
+
+    // The blocks of the previous profile are forgotten
+    if(trackedBlocks){
+        memset(trackedBlocks, 0, trackedBlocksCapacity * sizeof(trackedBlock));
+    }
+    numberOfTrackedBlocks = 0;
+
+    atomic_store(&isProfiling, true);
+
+    pthread_mutex_unlock(&profilerMutex);
+}
+
+#ifdef ALLOCATION_PROFILING
+static int comparePhasesByBytes(const void *a, const void *b){
+    const allocationPhase* phaseA = (const allocationPhase*)a;
+    const allocationPhase* phaseB = (const allocationPhase*)b;
+
+    if(phaseA->bytesAllocated == phaseB->bytesAllocated){
+        return 0;
+    }
+    return phaseA->bytesAllocated < phaseB->bytesAllocated ? 1 : -1;
+}
+
+static void logAllocationProfile(const allocationProfile* reportedProfile, allocationPhase* reportedPhases, int numberOfReportedPhases){
+    log_message(LOG_INFO, "Allocations of %s: %lu allocations, %llu bytes, peak live heap %llu bytes, %lu blocks (%llu bytes) not freed",
+                profileName, reportedProfile->numberOfAllocations, reportedProfile->bytesAllocated, reportedProfile->peakLiveBytes,
+                reportedProfile->leakedBlocks, reportedProfile->leakedBytes);
+
+    qsort(reportedPhases, (size_t)numberOfReportedPhases, sizeof(allocationPhase), comparePhasesByBytes);
+
+    for(int i = 0; i < numberOfReportedPhases; i++){
+        if(reportedPhases[i].numberOfAllocations == 0){
+            continue;
+        }
+
+        log_message(LOG_INFO, "    %s: %lu allocations, %llu bytes, %lu blocks (%llu bytes) not freed", reportedPhases[i].name,
+                    reportedPhases[i].numberOfAllocations, reportedPhases[i].bytesAllocated, reportedPhases[i].liveBlocks,
+                    reportedPhases[i].liveBytes);
+    }
+}
+#endif
+
+void endAllocationProfile(){
+    pthread_mutex_lock(&profilerMutex);
+
+    atomic_store(&isProfiling, false);
+
+    profile.leakedBlocks = 0;
+    profile.leakedBytes = 0;
+    for(int i = 0; i < numberOfPhases; i++){
+        profile.leakedBlocks += phases[i].liveBlocks;
+        profile.leakedBytes += phases[i].liveBytes;
+    }
+
+#ifdef ALLOCATION_PROFILING
+    // Logging allocates, the report is built from a copy once the lock is released
+    allocationProfile reportedProfile = profile;
+    allocationPhase reportedPhases[ALLOCATION_PROFILER_MAX_PHASES];
+    int numberOfReportedPhases = numberOfPhases;
+    memcpy(reportedPhases, phases, sizeof(phases));
+
+    pthread_mutex_unlock(&profilerMutex);
+
+    logAllocationProfile(&reportedProfile, reportedPhases, numberOfReportedPhases);
+#else
+    pthread_mutex_unlock(&profilerMutex);
+#endif
+}
+
+void getAllocationProfile(allocationProfile* result){
+    pthread_mutex_lock(&profilerMutex);
+
+    *result = profile;
+
+    // While the profile runs, what is not freed yet
+    if(atomic_load(&isProfiling)){
+        result->leakedBlocks = 0;
+        result->leakedBytes = 0;
+        for(int i = 0; i < numberOfPhases; i++){
+            result->leakedBlocks += phases[i].liveBlocks;
+            result->leakedBytes += phases[i].liveBytes;
+        }
+    }
+
+    pthread_mutex_unlock(&profilerMutex);
+}
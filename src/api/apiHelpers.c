@@ -4,9 +4,13 @@
  * @brief contains helper functions which are used by several api handling functions
  */
 
+#define LOG_MODULE LOG_MODULE_API_HELPERS
+
 #include <stdlib.h>
 #include <string.h>
 #include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "apiHelpers.h"
 
 
 char *GITHUB_API_TOKEN;
@@ -32,6 +36,39 @@ void initializeApiTokenVariables() {
     return;
 }
 
+const char* getApiUrl(apiService service){
+    const char *overrideVariable = NULL;
+    const char *defaultUrl = NULL;
+
+    switch(service){
+        case API_SERVICE_WIKI:
+            overrideVariable = "ERTBOT_WIKI_API_URL";
+            defaultUrl = WIKI_API_URL;
+            break;
+
+        case API_SERVICE_SHEETS:
+            overrideVariable = "ERTBOT_SHEETS_API_URL";
+            defaultUrl = SHEETS_API_URL;
+            break;
+
+        case API_SERVICE_GOOGLE_OAUTH:
+            overrideVariable = "ERTBOT_GOOGLE_OAUTH_URL";
+            defaultUrl = GOOGLE_OAUTH_URL;
+            break;
+
+        case API_SERVICE_SLACK:
+            overrideVariable = "ERTBOT_SLACK_API_URL";
+            defaultUrl = SLACK_API_URL;
+            break;
+    }
+
+    const char *url = overrideVariable ? getenv(overrideVariable) : NULL;
+    if(url && url[0] != '\0'){
+        return url;
+    }
+
+    return defaultUrl;
+}
 
 size_t writeCallback(const void *data, size_t size, size_t nmemb, void *clientp) {
     log_message(LOG_DEBUG, "Entering function writeCallback");
@@ -141,6 +178,12 @@ void resetChunkResponse(){
         free(chunk.response);
     }
 
+    // Empty rather than unterminated, a request which fails leaves it as is
     chunk.response = malloc(1);
+    if(!chunk.response){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+    chunk.response[0] = '\0';
     chunk.size = 0;
 }
\ No newline at end of file
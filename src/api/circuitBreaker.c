@@ -0,0 +1,180 @@
+/**
+ * @file circuitBreaker.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the circuit breakers which fail the requests to a service fast while it is down.
+ *
+ * @details Without them every request to a stalled service waits out its whole timeout (and its retries) before
+ *          failing. Once a service failed several times in a row its requests fail immediately, and the command queue
+ *          is paused until the service is tried again, see `getCircuitBreakerPause`.
+ */
+
+#define LOG_MODULE LOG_MODULE_API_HELPERS
+
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "circuitBreaker.h"
+
+#define NUMBER_OF_API_SERVICES (API_SERVICE_SLACK + 1)
+
+typedef struct circuit {
+    int consecutiveFailures;
+    double openSeconds;
+    double openUntil;
+    bool isOpen;
+} circuit;
+
+static const char* const serviceNames[] = {
+    [API_SERVICE_WIKI] = "wiki",
+    [API_SERVICE_SHEETS] = "Google Sheets",
+    [API_SERVICE_GOOGLE_OAUTH] = "Google OAuth",
+    [API_SERVICE_SLACK] = "Slack",
+};
+
+static const apiService endpointServices[] = {
+    [NETWORK_ENDPOINT_WIKI_GET_PAGE] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_WIKI_LIST_PAGES] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_WIKI_UPDATE_PAGE] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_WIKI_RENDER_PAGE] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_WIKI_CREATE_PAGE] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_WIKI_MOVE_PAGE] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_WIKI_DELETE_PAGE] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_WIKI_MUTATION_BATCH] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_WIKI_OTHER] = API_SERVICE_WIKI,
+    [NETWORK_ENDPOINT_SHEET_GET] = API_SERVICE_SHEETS,
+    [NETWORK_ENDPOINT_SHEET_UPDATE] = API_SERVICE_SHEETS,
+    [NETWORK_ENDPOINT_SHEET_OAUTH] = API_SERVICE_GOOGLE_OAUTH,
+    [NETWORK_ENDPOINT_SLACK_POST] = API_SERVICE_SLACK,
+    [NETWORK_ENDPOINT_SLACK_UPDATE] = API_SERVICE_SLACK,
+    [NETWORK_ENDPOINT_SLACK_HISTORY] = API_SERVICE_SLACK,
+};
+
+static circuit circuits[NUMBER_OF_API_SERVICES];
+static unsigned long eventCount = 0;
+static pthread_mutex_t circuitBreakerMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static double getMonotonicSeconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static bool isFailure(CURLcode result, long httpCode){
+    return result != CURLE_OK || httpCode >= 500;
+}
+
+apiService getEndpointService(networkEndpoint endpoint){
+    return endpointServices[endpoint];
+}
+
+bool allowCircuitRequest(networkEndpoint endpoint){
+    apiService service = endpointServices[endpoint];
+
+    pthread_mutex_lock(&circuitBreakerMutex);
+
+    circuit* serviceCircuit = &circuits[service];
+    bool isAllowed = !serviceCircuit->isOpen || getMonotonicSeconds() >= serviceCircuit->openUntil;
+    if(!isAllowed){
+        eventCount++;
+    }
+
+    pthread_mutex_unlock(&circuitBreakerMutex);
+
+    if(!isAllowed){
+        log_message(LOG_DEBUG, "%s is down, %s was not sent", serviceNames[service], getNetworkEndpointName(endpoint));
+    }
+    return isAllowed;
+}
+
+void reportCircuitResult(networkEndpoint endpoint, CURLcode result, long httpCode){
+    apiService service = endpointServices[endpoint];
+    bool isOpened = false;
+    bool isClosed = false;
+    double openSeconds = 0;
+
+    pthread_mutex_lock(&circuitBreakerMutex);
+
+    circuit* serviceCircuit = &circuits[service];
+
+    if(!isFailure(result, httpCode)){
+        isClosed = serviceCircuit->isOpen;
+        serviceCircuit->isOpen = false;
+        serviceCircuit->consecutiveFailures = 0;
+        serviceCircuit->openSeconds = 0;
+    }
+
+    // Only the first request to complete after the circuit was opened again decides, the others were sent alongside it
+    else if(!serviceCircuit->isOpen || getMonotonicSeconds() >= serviceCircuit->openUntil){
+        serviceCircuit->consecutiveFailures++;
+
+        if(serviceCircuit->isOpen || serviceCircuit->consecutiveFailures >= CIRCUIT_BREAKER_FAILURE_THRESHOLD){
+            serviceCircuit->openSeconds = serviceCircuit->isOpen ? serviceCircuit->openSeconds * 2 : CIRCUIT_BREAKER_OPEN_SECONDS;
+            if(serviceCircuit->openSeconds > CIRCUIT_BREAKER_MAX_OPEN_SECONDS){
+                serviceCircuit->openSeconds = CIRCUIT_BREAKER_MAX_OPEN_SECONDS;
+            }
+
+            serviceCircuit->isOpen = true;
+            serviceCircuit->openUntil = getMonotonicSeconds() + serviceCircuit->openSeconds;
+            eventCount++;
+
+            isOpened = true;
+            openSeconds = serviceCircuit->openSeconds;
+        }
+    }
+
+    pthread_mutex_unlock(&circuitBreakerMutex);
+
+    if(isOpened){
+        log_message(LOG_ERROR, "%s is down (%s, HTTP status code %ld), its requests fail without being sent for the next %.0f s",
+                    serviceNames[service], curl_easy_strerror(result), httpCode, openSeconds);
+    }
+    if(isClosed){
+        log_message(LOG_INFO, "%s is back up", serviceNames[service]);
+    }
+}
+
+bool isCircuitOpen(networkEndpoint endpoint){
+    pthread_mutex_lock(&circuitBreakerMutex);
+
+    const circuit* serviceCircuit = &circuits[endpointServices[endpoint]];
+    bool result = serviceCircuit->isOpen && getMonotonicSeconds() < serviceCircuit->openUntil;
+
+    pthread_mutex_unlock(&circuitBreakerMutex);
+
+    return result;
+}
+
+long long getCircuitBreakerPause(){
+    pthread_mutex_lock(&circuitBreakerMutex);
+
+    double now = getMonotonicSeconds();
+    double pauseSeconds = 0;
+
+    for(int service = 0; service < NUMBER_OF_API_SERVICES; service++){
+        if(circuits[service].isOpen && circuits[service].openUntil - now > pauseSeconds){
+            pauseSeconds = circuits[service].openUntil - now;
+        }
+    }
+
+    pthread_mutex_unlock(&circuitBreakerMutex);
+
+    return pauseSeconds > 0 ? (long long)(pauseSeconds * 1e6) + 1 : 0;
+}
+
+unsigned long getCircuitBreakerEventCount(){
+    pthread_mutex_lock(&circuitBreakerMutex);
+    unsigned long result = eventCount;
+    pthread_mutex_unlock(&circuitBreakerMutex);
+
+    return result;
+}
+
+void resetCircuitBreakers(){
+    pthread_mutex_lock(&circuitBreakerMutex);
+    memset(circuits, 0, sizeof(circuits));
+    pthread_mutex_unlock(&circuitBreakerMutex);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file fetchStage.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the fetch stages, which send the independent requests of a feature at the same time.
+ */
+
+#define LOG_MODULE LOG_MODULE_API_HELPERS
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <curl/curl.h>
+#include "ERTbot_common.h"
+#include "apiHelpers.h"
+#include "stringHelpers.h"
+#include "ERTbot_trace.h"
+#include "networkTelemetry.h"
+#include "httpTransport.h"
+#include "wikiAPI.h"
+#include "sheetAPI.h"
+#include "fetchStage.h"
+
+void initializeFetchStage(fetchStage* stage){
+    memset(stage, 0, sizeof(fetchStage));
+}
+
+static int reserveFetch(fetchStage* stage){
+    if(stage->numberOfRequests >= FETCH_STAGE_MAX_REQUESTS){
+        log_message(LOG_ERROR, "A fetch stage cannot hold more than %d requests", FETCH_STAGE_MAX_REQUESTS);
+        exit(1);
+    }
+
+    return stage->numberOfRequests++;
+}
+
+int addWikiFetch(fetchStage* stage, const char *query){
+    int index = reserveFetch(stage);
+    httpRequest* request = &stage->requests[index];
+
+    stage->bodies[index] = duplicate_Malloc(query);
+
+    request->endpoint = classifyWikiQuery(query);
+    request->method = "POST";
+    request->url = getApiUrl(API_SERVICE_WIKI);
+    request->body = stage->bodies[index];
+    request->curl = createWikiRequest(request->body, &request->response, &stage->headers[index]);
+    if(!request->curl){
+        log_message(LOG_ERROR, "Failed to initialize libcurl");
+        exit(1);
+    }
+
+    return index;
+}
+
+int addSheetFetch(fetchStage* stage, const char *sheetId, const char *range){
+    if(!stage->isSheetTokenRefreshed){
+        refreshOAuthToken();
+        stage->isSheetTokenRefreshed = true;
+    }
+
+    int index = reserveFetch(stage);
+    httpRequest* request = &stage->requests[index];
+
+    stage->urls[index] = buildBatchGetSheetUrl(sheetId, range);
+
+    request->endpoint = NETWORK_ENDPOINT_SHEET_GET;
+    request->method = "GET";
+    request->url = stage->urls[index];
+    request->body = "";
+    request->curl = createSheetRequest(request->url, request->method, request->body, &request->response, &stage->headers[index]);
+    if(!request->curl){
+        log_message(LOG_ERROR, "Failed to initialize libcurl");
+        exit(1);
+    }
+
+    return index;
+}
+
+void runFetchStage(fetchStage* stage){
+    log_message(LOG_DEBUG, "Entering function runFetchStage");
+
+    beginTraceSpan(TRACE_CATEGORY_API, "runFetchStage", NULL);
+
+    curl_global_init(CURL_GLOBAL_ALL);
+    performHttpRequests(stage->requests, stage->numberOfRequests, FETCH_STAGE_MAX_REQUESTS);
+    curl_global_cleanup();
+
+    for(int i = 0; i < stage->numberOfRequests; i++){
+        const httpRequest* request = &stage->requests[i];
+
+        if(request->result != CURLE_OK || request->httpCode != 200){
+            log_message(LOG_ERROR, "%s request of a fetch stage failed: %s, HTTP status code %ld",
+                        getNetworkEndpointName(request->endpoint), curl_easy_strerror(request->result), request->httpCode);
+        }
+    }
+
+    endTraceSpan();
+
+    log_message(LOG_DEBUG, "Exiting function runFetchStage");
+}
+
+const char* getFetchResponse(const fetchStage* stage, int index){
+    const httpRequest* request = &stage->requests[index];
+
+    if(request->result != CURLE_OK || request->httpCode != 200){
+        return NULL;
+    }
+
+    return request->response.response ? request->response.response : "";
+}
+
+void freeFetchStage(fetchStage* stage){
+    for(int i = 0; i < stage->numberOfRequests; i++){
+        curl_easy_cleanup(stage->requests[i].curl);
+        curl_slist_free_all(stage->headers[i]);
+        free(stage->requests[i].response.response);
+        free(stage->urls[i]);
+        free(stage->bodies[i]);
+    }
+
+    initializeFetchStage(stage);
+}
@@ -0,0 +1,194 @@
+/**
+ * @file httpRetry.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the policy deciding which failed requests are sent again, and when, and the deadline of each command.
+ *
+ * @details Retries wait a random delay under an exponentially growing bound (full jitter), so that the requests which
+ *          failed together do not all come back at the same time. Every command has a budget of retries and a
+ *          deadline: a flaky request costs a few hundred milliseconds, while an outage fails the command quickly
+ *          instead of making it wait on every one of its requests.
+ */
+
+#define LOG_MODULE LOG_MODULE_API_HELPERS
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "httpRetry.h"
+
+#define MAXIMUM_NESTED_RETRY_BUDGETS 8
+
+static const httpIdempotency endpointIdempotencies[] = {
+    [NETWORK_ENDPOINT_WIKI_GET_PAGE] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+    [NETWORK_ENDPOINT_WIKI_LIST_PAGES] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+    [NETWORK_ENDPOINT_WIKI_UPDATE_PAGE] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+    [NETWORK_ENDPOINT_WIKI_RENDER_PAGE] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+    [NETWORK_ENDPOINT_WIKI_CREATE_PAGE] = HTTP_IDEMPOTENCY_NOT_IDEMPOTENT,
+    [NETWORK_ENDPOINT_WIKI_MOVE_PAGE] = HTTP_IDEMPOTENCY_NOT_IDEMPOTENT,
+    [NETWORK_ENDPOINT_WIKI_DELETE_PAGE] = HTTP_IDEMPOTENCY_NOT_IDEMPOTENT,
+    [NETWORK_ENDPOINT_WIKI_MUTATION_BATCH] = HTTP_IDEMPOTENCY_NOT_IDEMPOTENT,
+    [NETWORK_ENDPOINT_WIKI_OTHER] = HTTP_IDEMPOTENCY_NOT_IDEMPOTENT,
+    [NETWORK_ENDPOINT_SHEET_GET] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+    [NETWORK_ENDPOINT_SHEET_UPDATE] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+    [NETWORK_ENDPOINT_SHEET_OAUTH] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+    [NETWORK_ENDPOINT_SLACK_POST] = HTTP_IDEMPOTENCY_NOT_IDEMPOTENT,
+    [NETWORK_ENDPOINT_SLACK_UPDATE] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+    [NETWORK_ENDPOINT_SLACK_HISTORY] = HTTP_IDEMPOTENCY_IDEMPOTENT,
+};
+
+typedef struct httpRequestBudget {
+    int remainingRetries;
+    double deadline;
+    double startTime;
+} httpRequestBudget;
+
+static int remainingRetries = HTTP_RETRY_BUDGET_PER_COMMAND;
+static double deadline = 0;
+static httpRequestBudget interruptedBudgets[MAXIMUM_NESTED_RETRY_BUDGETS];
+static int numberOfNestedBudgets = 0;
+static bool isExhaustionReported = false;
+static unsigned int jitterSeed = 0;
+static pthread_mutex_t retryBudgetMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static double getMonotonicSeconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+httpIdempotency getEndpointIdempotency(networkEndpoint endpoint){
+    return endpointIdempotencies[endpoint];
+}
+
+/**
+ * @brief Whether the request failed before any of it reached the server.
+ */
+static bool isConnectionNotEstablished(CURLcode result){
+    return result == CURLE_COULDNT_RESOLVE_HOST || result == CURLE_COULDNT_RESOLVE_PROXY ||
+           result == CURLE_COULDNT_CONNECT || result == CURLE_SSL_CONNECT_ERROR;
+}
+
+static bool isTransientFailure(CURLcode result, long httpCode){
+    if(result != CURLE_OK){
+        return isConnectionNotEstablished(result) || result == CURLE_OPERATION_TIMEDOUT || result == CURLE_SEND_ERROR ||
+               result == CURLE_RECV_ERROR || result == CURLE_GOT_NOTHING || result == CURLE_PARTIAL_FILE ||
+               result == CURLE_HTTP2 || result == CURLE_HTTP2_STREAM;
+    }
+
+    return httpCode == 502 || httpCode == 503 || httpCode == 504;
+}
+
+long long getHttpRetryDelay(networkEndpoint endpoint, httpIdempotency idempotency, CURLcode result, long httpCode, int attempt){
+    if(idempotency == HTTP_IDEMPOTENCY_FROM_ENDPOINT){
+        idempotency = endpointIdempotencies[endpoint];
+    }
+
+    bool isRetriable = idempotency == HTTP_IDEMPOTENCY_IDEMPOTENT ? isTransientFailure(result, httpCode) : isConnectionNotEstablished(result);
+    if(!isRetriable || attempt + 1 >= HTTP_RETRY_MAX_ATTEMPTS){
+        return -1;
+    }
+
+    pthread_mutex_lock(&retryBudgetMutex);
+
+    if(remainingRetries <= 0){
+        bool isReported = isExhaustionReported;
+        isExhaustionReported = true;
+        pthread_mutex_unlock(&retryBudgetMutex);
+
+        if(!isReported){
+            log_message(LOG_ERROR, "The retry budget of the command is exhausted, failed requests are no longer retried");
+        }
+        return -1;
+    }
+
+    if(jitterSeed == 0){
+        jitterSeed = (unsigned int)time(NULL) | 1;
+    }
+
+    long long bound = (long long)HTTP_RETRY_BASE_DELAY_MS * 1000 << (attempt < 16 ? attempt : 16);
+    if(bound > (long long)HTTP_RETRY_MAX_DELAY_MS * 1000){
+        bound = (long long)HTTP_RETRY_MAX_DELAY_MS * 1000;
+    }
+    long long delay = (long long)((double)rand_r(&jitterSeed) / ((double)RAND_MAX + 1) * (double)bound);
+
+    // The retry would not be answered before the command has to be done
+    if(deadline > 0 && getMonotonicSeconds() + (double)delay / 1e6 >= deadline){
+        pthread_mutex_unlock(&retryBudgetMutex);
+        log_message(LOG_ERROR, "%s failed and the deadline of the command is too close to retry it", getNetworkEndpointName(endpoint));
+        return -1;
+    }
+
+    remainingRetries--;
+
+    pthread_mutex_unlock(&retryBudgetMutex);
+
+    log_message(LOG_INFO, "%s failed (%s, HTTP status code %ld), retrying in %lld ms", getNetworkEndpointName(endpoint),
+                curl_easy_strerror(result), httpCode, delay / 1000);
+    return delay;
+}
+
+void beginHttpRequestBudget(){
+    pthread_mutex_lock(&retryBudgetMutex);
+
+    double now = getMonotonicSeconds();
+
+    if(numberOfNestedBudgets < MAXIMUM_NESTED_RETRY_BUDGETS){
+        interruptedBudgets[numberOfNestedBudgets] = (httpRequestBudget){remainingRetries, deadline, now};
+    }
+    numberOfNestedBudgets++;
+
+    remainingRetries = HTTP_RETRY_BUDGET_PER_COMMAND;
+    deadline = now + HTTP_COMMAND_DEADLINE_SECONDS;
+    isExhaustionReported = false;
+
+    pthread_mutex_unlock(&retryBudgetMutex);
+}
+
+void endHttpRequestBudget(){
+    pthread_mutex_lock(&retryBudgetMutex);
+
+    if(numberOfNestedBudgets > 0){
+        numberOfNestedBudgets--;
+    }
+
+    // Requests sent outside of any command get a fresh budget and have no deadline
+    if(numberOfNestedBudgets == 0){
+        remainingRetries = HTTP_RETRY_BUDGET_PER_COMMAND;
+        deadline = 0;
+    }
+
+    // The time the interrupted command spent waiting is given back to it
+    else if(numberOfNestedBudgets < MAXIMUM_NESTED_RETRY_BUDGETS){
+        const httpRequestBudget* interruptedBudget = &interruptedBudgets[numberOfNestedBudgets];
+        remainingRetries = interruptedBudget->remainingRetries;
+        deadline = interruptedBudget->deadline > 0 ? interruptedBudget->deadline + getMonotonicSeconds() - interruptedBudget->startTime : 0;
+    }
+    isExhaustionReported = remainingRetries <= 0;
+
+    pthread_mutex_unlock(&retryBudgetMutex);
+}
+
+int getRemainingHttpRetries(){
+    pthread_mutex_lock(&retryBudgetMutex);
+    int result = remainingRetries;
+    pthread_mutex_unlock(&retryBudgetMutex);
+
+    return result;
+}
+
+long long getRemainingHttpTime(){
+    pthread_mutex_lock(&retryBudgetMutex);
+    double commandDeadline = deadline;
+    pthread_mutex_unlock(&retryBudgetMutex);
+
+    if(commandDeadline <= 0){
+        return -1;
+    }
+
+    double remainingSeconds = commandDeadline - getMonotonicSeconds();
+    return remainingSeconds > 0 ? (long long)(remainingSeconds * 1e6) : 0;
+}
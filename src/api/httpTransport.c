@@ -0,0 +1,662 @@
+/**
+ * @file httpTransport.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the function every API sends its requests through, and the cassette it can record them to and
+ *        replay them from.
+ *
+ * @details A cassette is a text header followed by one record per request: a line with the endpoint, method, status
+ *          code, duration in microseconds, a hash identifying the request and the length of the response, then the
+ *          raw response. Request bodies are only kept as part of the hash, which keeps the cassette of a whole `sync`
+ *          small. The requests of a replay are matched to the recorded ones in order, by hash.
+ */
+
+#define LOG_MODULE LOG_MODULE_API_HELPERS
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "apiHelpers.h"
+#include "httpTransport.h"
+#include "rateLimiter.h"
+#include "httpRetry.h"
+#include "circuitBreaker.h"
+#include "ERTbot_metrics.h"
+
+#define CASSETTE_HEADER "ERTBOT_CASSETTE 1\n"
+
+typedef struct cassetteInteraction {
+    networkEndpoint endpoint;
+    long httpCode;
+    long long durationMicroseconds;
+    unsigned long long requestHash;
+    char *response;
+    size_t responseLength;
+    bool isUsed;
+} cassetteInteraction;
+
+static cassetteMode currentCassetteMode = CASSETTE_MODE_OFF;
+static bool isCassetteInitialized = false;
+static bool isReplayingLatency = false;
+static bool isReportRegisteredAtExit = false;
+static pthread_mutex_t cassetteMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static FILE *recordedCassette = NULL;
+
+static cassetteInteraction* interactions = NULL;
+static size_t numberOfInteractions = 0;
+static size_t nextInteraction = 0;
+static cassetteStatistics statistics;
+
+/**
+ * @brief FNV-1a over the method, the path of the URL and the body: what stays the same when the same command is run
+ *        again, against another host.
+ */
+static unsigned long long hashRequest(const char *method, const char *url, const char *body){
+    unsigned long long hash = 14695981039346656037ULL;
+
+    const char *path = strstr(url, "://");
+    path = path ? strchr(path + strlen("://"), '/') : url;
+    if(!path){
+        path = "/";
+    }
+    size_t pathLength = strcspn(path, "?");
+
+    const char *parts[] = {method, path, body ? body : ""};
+    size_t lengths[] = {strlen(method), pathLength, body ? strlen(body) : 0};
+
+    for(int part = 0; part < 3; part++){
+        for(size_t i = 0; i < lengths[part]; i++){
+            hash = (hash ^ (unsigned char)parts[part][i]) * 1099511628211ULL;
+        }
+        // Separator, so that moving a character from one part to the next changes the hash
+        hash = (hash ^ 0xff) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static bool findEndpointByName(const char *name, networkEndpoint* endpoint){
+    for(int i = 0; i < NUMBER_OF_NETWORK_ENDPOINTS; i++){
+        if(strcmp(getNetworkEndpointName((networkEndpoint)i), name) == 0){
+            *endpoint = (networkEndpoint)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void freeInteractions(){
+    for(size_t i = 0; i < numberOfInteractions; i++){
+        free(interactions[i].response);
+    }
+    free(interactions);
+
+    interactions = NULL;
+    numberOfInteractions = 0;
+    nextInteraction = 0;
+}
+
+static int loadCassette(const char *path){
+    FILE *file = fopen(path, "rb");
+    if(!file){
+        log_message(LOG_ERROR, "Could not open cassette %s", path);
+        return 1;
+    }
+
+    char line[256];
+    if(!fgets(line, sizeof(line), file) || strcmp(line, CASSETTE_HEADER) != 0){
+        log_message(LOG_ERROR, "%s is not a cassette", path);
+        fclose(file);
+        return 1;
+    }
+
+    size_t capacity = 0;
+    while(fgets(line, sizeof(line), file)){
+        char endpointName[64];
+        char method[16];
+        cassetteInteraction interaction;
+        memset(&interaction, 0, sizeof(interaction));
+
+        if(sscanf(line, "%63s %15s %ld %lld %llx %zu", endpointName, method, &interaction.httpCode,
+                  &interaction.durationMicroseconds, &interaction.requestHash, &interaction.responseLength) != 6
+           || !findEndpointByName(endpointName, &interaction.endpoint)){
+            log_message(LOG_ERROR, "Cassette %s is corrupted after %zu interactions", path, numberOfInteractions);
+            break;
+        }
+
+        interaction.response = (char*)malloc(interaction.responseLength + 1);
+        if(!interaction.response){
+            log_message(LOG_ERROR, "Memory allocation error");
+            exit(1);
+        }
+
+        if(fread(interaction.response, 1, interaction.responseLength, file) != interaction.responseLength){
+            log_message(LOG_ERROR, "Cassette %s is truncated after %zu interactions", path, numberOfInteractions);
+            free(interaction.response);
+            break;
+        }
+        interaction.response[interaction.responseLength] = '\0';
+        (void)fgetc(file);
+
+        if(numberOfInteractions == capacity){
+            capacity = capacity ? 2 * capacity : 256;
+            cassetteInteraction* newInteractions = (cassetteInteraction*)realloc(interactions, capacity * sizeof(cassetteInteraction));
+            if(!newInteractions){
+                log_message(LOG_ERROR, "Memory allocation error");
+                exit(1);
+            }
+            interactions = newInteractions;
+        }
+
+        interactions[numberOfInteractions++] = interaction;
+    }
+
+    fclose(file);
+
+    log_message(LOG_INFO, "Replaying %zu HTTP interactions from %s", numberOfInteractions, path);
+    return 0;
+}
+
+static void countUnusedInteractions(){
+    statistics.unusedInteractions = 0;
+    for(size_t i = 0; i < numberOfInteractions; i++){
+        if(!interactions[i].isUsed){
+            statistics.unusedInteractions++;
+        }
+    }
+}
+
+static void reportCassetteReplay(){
+    pthread_mutex_lock(&cassetteMutex);
+
+    if(currentCassetteMode == CASSETTE_MODE_REPLAY){
+        countUnusedInteractions();
+        log_message(LOG_INFO, "Cassette replay: %lu requests replayed, %lu not in the cassette, %lu recorded requests never sent",
+                    statistics.replayedRequests, statistics.mismatchedRequests, statistics.unusedInteractions);
+    }
+
+    pthread_mutex_unlock(&cassetteMutex);
+}
+
+static void closeCassetteLocked(){
+    if(recordedCassette){
+        fclose(recordedCassette);
+        recordedCassette = NULL;
+    }
+
+    freeInteractions();
+    currentCassetteMode = CASSETTE_MODE_OFF;
+}
+
+static int openCassetteLocked(cassetteMode mode, const char *path, bool replaysLatency){
+    closeCassetteLocked();
+    memset(&statistics, 0, sizeof(statistics));
+    isCassetteInitialized = true;
+    isReplayingLatency = replaysLatency;
+
+    if(mode == CASSETTE_MODE_RECORD){
+        recordedCassette = fopen(path, "wb");
+        if(!recordedCassette){
+            log_message(LOG_ERROR, "Could not create cassette %s", path);
+            return 1;
+        }
+
+        fputs(CASSETTE_HEADER, recordedCassette);
+        fflush(recordedCassette);
+        log_message(LOG_INFO, "Recording HTTP interactions to %s", path);
+    }
+
+    else if(mode == CASSETTE_MODE_REPLAY){
+        if(loadCassette(path) != 0){
+            freeInteractions();
+            return 1;
+        }
+
+        if(!isReportRegisteredAtExit){
+            isReportRegisteredAtExit = true;
+            atexit(reportCassetteReplay);
+        }
+    }
+
+    currentCassetteMode = mode;
+    return 0;
+}
+
+static void initializeCassetteFromEnvironment(){
+    isCassetteInitialized = true;
+
+    const char *mode = getenv("ERTBOT_CASSETTE_MODE");
+    if(!mode || mode[0] == '\0'){
+        return;
+    }
+
+    const char *path = getenv("ERTBOT_CASSETTE_PATH");
+    if(!path || path[0] == '\0'){
+        path = HTTP_CASSETTE_DEFAULT_PATH;
+    }
+
+    const char *latency = getenv("ERTBOT_CASSETTE_LATENCY");
+    bool replaysLatency = latency && strcmp(latency, "recorded") == 0;
+
+    if(strcmp(mode, "record") == 0){
+        (void)openCassetteLocked(CASSETTE_MODE_RECORD, path, replaysLatency);
+    }
+    else if(strcmp(mode, "replay") == 0){
+        (void)openCassetteLocked(CASSETTE_MODE_REPLAY, path, replaysLatency);
+    }
+    else{
+        log_message(LOG_ERROR, "Unknown ERTBOT_CASSETTE_MODE %s, expected record or replay", mode);
+    }
+}
+
+static void recordInteraction(networkEndpoint endpoint, const char *method, unsigned long long requestHash, long httpCode, long long durationMicroseconds, const memory* responseBuffer){
+    const char *response = responseBuffer->response ? responseBuffer->response : "";
+    size_t responseLength = responseBuffer->response ? responseBuffer->size : 0;
+
+    fprintf(recordedCassette, "%s %s %ld %lld %016llx %zu\n", getNetworkEndpointName(endpoint), method, httpCode,
+            durationMicroseconds, requestHash, responseLength);
+    fwrite(response, 1, responseLength, recordedCassette);
+    fputc('\n', recordedCassette);
+
+    // A crash must not lose what was recorded so far
+    fflush(recordedCassette);
+}
+
+static cassetteInteraction* findInteraction(networkEndpoint endpoint, unsigned long long requestHash){
+    // The same request in the same order, then anywhere (e.g. a request sent one page earlier than when recorded)
+    for(size_t i = nextInteraction; i < numberOfInteractions; i++){
+        if(!interactions[i].isUsed && interactions[i].requestHash == requestHash){
+            nextInteraction = i + 1;
+            return &interactions[i];
+        }
+    }
+    for(size_t i = 0; i < nextInteraction && i < numberOfInteractions; i++){
+        if(!interactions[i].isUsed && interactions[i].requestHash == requestHash){
+            return &interactions[i];
+        }
+    }
+
+    // Not recorded, the next response of the same endpoint at least has the shape the caller expects
+    statistics.mismatchedRequests++;
+    for(size_t i = nextInteraction; i < numberOfInteractions; i++){
+        if(!interactions[i].isUsed && interactions[i].endpoint == endpoint){
+            nextInteraction = i + 1;
+            return &interactions[i];
+        }
+    }
+
+    return NULL;
+}
+
+static CURLcode replayInteraction(networkEndpoint endpoint, const char *method, const char *url, const char *body, long *httpCode, memory* responseBuffer){
+    unsigned long long requestHash = hashRequest(method, url, body);
+
+    pthread_mutex_lock(&cassetteMutex);
+
+    cassetteInteraction* interaction = findInteraction(endpoint, requestHash);
+    if(!interaction){
+        pthread_mutex_unlock(&cassetteMutex);
+        log_message(LOG_ERROR, "Cassette has no response left for %s %s", getNetworkEndpointName(endpoint), url);
+        *httpCode = 0;
+        return CURLE_COULDNT_CONNECT;
+    }
+
+    interaction->isUsed = true;
+    statistics.replayedRequests++;
+
+    (void)writeCallback(interaction->response, 1, interaction->responseLength, responseBuffer);
+    *httpCode = interaction->httpCode;
+    long long duration = interaction->durationMicroseconds;
+
+    pthread_mutex_unlock(&cassetteMutex);
+
+    if(isReplayingLatency && duration > 0){
+        struct timespec delay = {(time_t)(duration / 1000000), (long)(duration % 1000000) * 1000L};
+        nanosleep(&delay, NULL);
+    }
+
+    return CURLE_OK;
+}
+
+static cassetteMode getCassetteMode(){
+    pthread_mutex_lock(&cassetteMutex);
+    if(!isCassetteInitialized){
+        initializeCassetteFromEnvironment();
+    }
+    cassetteMode mode = currentCassetteMode;
+    pthread_mutex_unlock(&cassetteMutex);
+
+    return mode;
+}
+
+/**
+ * @brief Checks that a request may be sent and sets its timeouts.
+ *
+ * @return CURLcode `CURLE_OK` if it may be sent, `CURLE_COULDNT_CONNECT` if the circuit of its service is open and
+ *         `CURLE_OPERATION_TIMEDOUT` if the deadline of the command passed.
+ *
+ * @details The request may take at most `HTTP_REQUEST_TIMEOUT_MS`, or until the deadline of the command if it is
+ *          closer.
+ */
+static CURLcode prepareHttpRequest(CURL *curl, networkEndpoint endpoint){
+    long long remainingMicroseconds = getRemainingHttpTime();
+    if(remainingMicroseconds == 0){
+        log_message(LOG_ERROR, "The deadline of the command passed, %s was not sent", getNetworkEndpointName(endpoint));
+        return CURLE_OPERATION_TIMEDOUT;
+    }
+
+    if(!allowCircuitRequest(endpoint)){
+        return CURLE_COULDNT_CONNECT;
+    }
+
+    long timeoutMilliseconds = HTTP_REQUEST_TIMEOUT_MS;
+    if(remainingMicroseconds > 0 && remainingMicroseconds / 1000 + 1 < timeoutMilliseconds){
+        timeoutMilliseconds = (long)(remainingMicroseconds / 1000 + 1);
+    }
+
+    // Timeouts must not be signalled since the log writer and metrics threads could receive the signal. Every request
+    // is sent from the main thread, fetch stages included, which drive theirs with curl multi
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, (long)HTTP_CONNECT_TIMEOUT_MS);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMilliseconds);
+
+    return CURLE_OK;
+}
+
+/**
+ * @brief Records the timings and the outcome of a request curl has completed, and the request itself when recording a
+ *        cassette.
+ */
+static void finishHttpRequest(cassetteMode mode, CURL *curl, networkEndpoint endpoint, const char *method, const char *url, const char *body, CURLcode result, long *httpCode, const memory* responseBuffer){
+    recordCurlTimings(endpoint, curl);
+
+    *httpCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, httpCode);
+    reportCircuitResult(endpoint, result, *httpCode);
+
+    if(mode == CASSETTE_MODE_RECORD){
+        curl_off_t total = 0;
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+        pthread_mutex_lock(&cassetteMutex);
+        if(recordedCassette){
+            recordInteraction(endpoint, method, hashRequest(method, url, body), *httpCode, (long long)total, responseBuffer);
+        }
+        pthread_mutex_unlock(&cassetteMutex);
+    }
+}
+
+/**
+ * @brief Decides whether a request is sent again, and if it is empties its response buffer.
+ *
+ * @param[in] attempt Number of times the request was already retried.
+ *
+ * @return long long -1 if the request is done, otherwise how long to wait before sending it again in microseconds.
+ *
+ * @details A request answered 429 pauses its rate limit tier and is sent again as soon as the tier lets it, at most
+ *          `RATE_LIMIT_MAX_RETRIES` times. Other failures are left to `getHttpRetryDelay`, unless the circuit of the
+ *          service is open. A replay never waits, and a replayed 429 does not pause anything, the retry is served from
+ *          the cassette right away.
+ */
+static long long prepareRetry(cassetteMode mode, CURL *curl, networkEndpoint endpoint, httpIdempotency idempotency, CURLcode result, long httpCode, int attempt, memory* responseBuffer){
+    long long delay;
+
+    if(result == CURLE_OK && httpCode == 429){
+        delay = attempt < RATE_LIMIT_MAX_RETRIES ? 0 : -1;
+        if(delay == 0 && mode != CASSETTE_MODE_REPLAY){
+            curl_off_t retryAfter = 0;
+            curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retryAfter);
+            reportRateLimitedResponse(endpoint, (long)retryAfter);
+        }
+    }
+    // A replayed request only fails this way when the cassette has no response left for it
+    else if(mode == CASSETTE_MODE_REPLAY && result != CURLE_OK){
+        delay = -1;
+    }
+    else if(mode != CASSETTE_MODE_REPLAY && isCircuitOpen(endpoint)){
+        delay = -1;
+    }
+    else{
+        delay = getHttpRetryDelay(endpoint, idempotency, result, httpCode, attempt);
+    }
+
+    if(delay < 0){
+        return -1;
+    }
+
+    free(responseBuffer->response);
+    responseBuffer->response = NULL;
+    responseBuffer->size = 0;
+
+    return mode == CASSETTE_MODE_REPLAY ? 0 : delay;
+}
+
+static double getMonotonicSeconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Sends a request like `performHttpRequest`.
+ *
+ * @param[in] waitsForRateLimit If false no attempt waits: `CURLE_AGAIN` is returned as soon as the rate limit tier has
+ *            no token, and a failure is not retried after a backoff.
+ */
+static CURLcode sendHttpRequest(CURL *curl, networkEndpoint endpoint, const char *method, const char *url, const char *body, long *httpCode, bool waitsForRateLimit){
+    cassetteMode mode = getCassetteMode();
+    CURLcode res;
+
+    for(int attempt = 0; ; attempt++){
+        if(mode == CASSETTE_MODE_REPLAY){
+            res = replayInteraction(endpoint, method, url, body, httpCode, &chunk);
+        }
+        else if((res = prepareHttpRequest(curl, endpoint)) != CURLE_OK){
+            *httpCode = 0;
+            break;
+        }
+        else if(!waitsForRateLimit && tryAcquireRateLimitToken(endpoint) > 0){
+            *httpCode = 0;
+            res = CURLE_AGAIN;
+            break;
+        }
+        else{
+            if(waitsForRateLimit){
+                waitForRateLimitToken(endpoint);
+            }
+            res = curl_easy_perform(curl);
+            finishHttpRequest(mode, curl, endpoint, method, url, body, res, httpCode, &chunk);
+        }
+
+        long long delay = prepareRetry(mode, curl, endpoint, HTTP_IDEMPOTENCY_FROM_ENDPOINT, res, *httpCode, attempt, &chunk);
+        if(delay < 0 || (delay > 0 && !waitsForRateLimit)){
+            break;
+        }
+
+        if(delay > 0){
+            struct timespec wait = {(time_t)(delay / 1000000), (long)(delay % 1000000) * 1000L};
+            nanosleep(&wait, NULL);
+        }
+    }
+
+    return res;
+}
+
+CURLcode performHttpRequest(CURL *curl, networkEndpoint endpoint, const char *method, const char *url, const char *body, long *httpCode){
+    return sendHttpRequest(curl, endpoint, method, url, body, httpCode, true);
+}
+
+CURLcode tryPerformHttpRequest(CURL *curl, networkEndpoint endpoint, const char *method, const char *url, const char *body, long *httpCode){
+    return sendHttpRequest(curl, endpoint, method, url, body, httpCode, false);
+}
+
+void performHttpRequests(httpRequest* requests, int numberOfRequests, int maximumConcurrentRequests){
+    cassetteMode mode = getCassetteMode();
+
+    // Served in order from the cassette, a replay does not depend on which request finished first
+    if(mode == CASSETTE_MODE_REPLAY){
+        for(int i = 0; i < numberOfRequests; i++){
+            httpRequest* request = &requests[i];
+            for(int attempt = 0; ; attempt++){
+                request->result = replayInteraction(request->endpoint, request->method, request->url, request->body,
+                                                    &request->httpCode, &request->response);
+                if(prepareRetry(mode, request->curl, request->endpoint, request->idempotency, request->result,
+                                request->httpCode, attempt, &request->response) < 0){
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    CURLM *multi = curl_multi_init();
+    if(!multi){
+        log_message(LOG_ERROR, "Failed to initialize libcurl");
+        for(int i = 0; i < numberOfRequests; i++){
+            requests[i].result = CURLE_FAILED_INIT;
+            requests[i].httpCode = 0;
+        }
+        return;
+    }
+
+    // Order the requests are sent in, the retried ones are sent again after the others
+    int maximumNumberOfAttempts = (RATE_LIMIT_MAX_RETRIES > HTTP_RETRY_MAX_ATTEMPTS ? RATE_LIMIT_MAX_RETRIES : HTTP_RETRY_MAX_ATTEMPTS) + 1;
+    int* sendOrder = (int*)malloc((size_t)numberOfRequests * (size_t)maximumNumberOfAttempts * sizeof(int) + 1);
+    int* attempts = (int*)calloc((size_t)numberOfRequests + 1, sizeof(int));
+    double* retryTimes = (double*)calloc((size_t)numberOfRequests + 1, sizeof(double));
+    if(!sendOrder || !attempts || !retryTimes){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+    for(int i = 0; i < numberOfRequests; i++){
+        sendOrder[i] = i;
+    }
+
+    int numberOfQueuedRequests = numberOfRequests;
+    int nextRequest = 0;
+    int numberOfRunningRequests = 0;
+    int numberOfFinishedRequests = 0;
+
+    double rateLimitWaitStart = -1;
+
+    while(numberOfFinishedRequests < numberOfRequests){
+        int pollTimeout = 1000;
+        bool isWaiting = false;
+
+        while(nextRequest < numberOfQueuedRequests && numberOfRunningRequests < maximumConcurrentRequests){
+            httpRequest* request = &requests[sendOrder[nextRequest]];
+
+            // Fails without being sent, like the one of performHttpRequest
+            CURLcode result = prepareHttpRequest(request->curl, request->endpoint);
+            if(result != CURLE_OK){
+                request->result = result;
+                request->httpCode = 0;
+                nextRequest++;
+                numberOfFinishedRequests++;
+                continue;
+            }
+
+            // The next requests wait with it, they are usually of the same tier and retried ones are at the end
+            long long waitMicroseconds = (long long)((retryTimes[sendOrder[nextRequest]] - getMonotonicSeconds()) * 1e6);
+            bool isBackingOff = waitMicroseconds > 0;
+            if(!isBackingOff){
+                waitMicroseconds = tryAcquireRateLimitToken(request->endpoint);
+            }
+
+            if(waitMicroseconds > 0){
+                isWaiting = true;
+                if(!isBackingOff && rateLimitWaitStart < 0){
+                    rateLimitWaitStart = getMonotonicSeconds();
+                }
+                if(waitMicroseconds / 1000 + 1 < pollTimeout){
+                    pollTimeout = (int)(waitMicroseconds / 1000 + 1);
+                }
+                break;
+            }
+
+            if(rateLimitWaitStart >= 0){
+                recordRateLimitWaitMetric((long long)((getMonotonicSeconds() - rateLimitWaitStart) * 1e6));
+                rateLimitWaitStart = -1;
+            }
+
+            curl_easy_setopt(request->curl, CURLOPT_PRIVATE, (void*)request);
+            curl_multi_add_handle(multi, request->curl);
+            nextRequest++;
+            numberOfRunningRequests++;
+        }
+
+        int stillRunning = 0;
+        curl_multi_perform(multi, &stillRunning);
+
+        CURLMsg *message;
+        int messagesLeft;
+        while((message = curl_multi_info_read(multi, &messagesLeft))){
+            if(message->msg != CURLMSG_DONE){
+                continue;
+            }
+
+            httpRequest* request = NULL;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (char**)&request);
+
+            request->result = message->data.result;
+            finishHttpRequest(mode, request->curl, request->endpoint, request->method, request->url, request->body,
+                              request->result, &request->httpCode, &request->response);
+
+            curl_multi_remove_handle(multi, request->curl);
+            numberOfRunningRequests--;
+
+            int index = (int)(request - requests);
+            long long delay = prepareRetry(mode, request->curl, request->endpoint, request->idempotency, request->result,
+                                           request->httpCode, attempts[index], &request->response);
+            if(delay >= 0){
+                attempts[index]++;
+                retryTimes[index] = getMonotonicSeconds() + (double)delay / 1e6;
+                sendOrder[numberOfQueuedRequests++] = index;
+                continue;
+            }
+
+            numberOfFinishedRequests++;
+        }
+
+        // Also waits when no request is running, until the next one can be sent
+        if(stillRunning > 0 || isWaiting){
+            curl_multi_poll(multi, NULL, 0, pollTimeout, NULL);
+        }
+    }
+
+    curl_multi_cleanup(multi);
+    free(sendOrder);
+    free(attempts);
+    free(retryTimes);
+}
+
+int openCassette(cassetteMode mode, const char *path, bool replaysLatency){
+    log_message(LOG_DEBUG, "Entering function openCassette");
+
+    pthread_mutex_lock(&cassetteMutex);
+    int result = openCassetteLocked(mode, path, replaysLatency);
+    pthread_mutex_unlock(&cassetteMutex);
+
+    log_message(LOG_DEBUG, "Exiting function openCassette");
+    return result;
+}
+
+void closeCassette(){
+    pthread_mutex_lock(&cassetteMutex);
+    closeCassetteLocked();
+    pthread_mutex_unlock(&cassetteMutex);
+}
+
+void getCassetteStatistics(cassetteStatistics* result){
+    pthread_mutex_lock(&cassetteMutex);
+    countUnusedInteractions();
+    *result = statistics;
+    pthread_mutex_unlock(&cassetteMutex);
+}
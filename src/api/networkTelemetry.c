@@ -0,0 +1,305 @@
+/**
+ * @file networkTelemetry.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the per endpoint histograms of the timings and sizes of every HTTP request.
+ *
+ * @details Each metric has a log2 histogram: bucket i holds the values in [2^i, 2^(i+1)), which is precise enough to
+ *          tell a 50 ms server render from a 500 ms one while costing a few integer operations per request. The
+ *          histograms are read by the metrics listener thread, hence the mutex.
+ */
+
+#define LOG_MODULE LOG_MODULE_API_HELPERS
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "networkTelemetry.h"
+
+#define NETWORK_HISTOGRAM_BUCKETS 40
+
+// Buckets exported to Prometheus, from [512 us, 1 ms) to [33 s, 67 s)
+#define FIRST_EXPORTED_BUCKET 9
+#define LAST_EXPORTED_BUCKET 25
+
+typedef struct networkHistogram {
+    unsigned long buckets[NETWORK_HISTOGRAM_BUCKETS];
+    long long sum;
+    long long maximum;
+} networkHistogram;
+
+typedef struct endpointTelemetry {
+    unsigned long count;
+    networkHistogram metrics[NUMBER_OF_NETWORK_METRICS];
+} endpointTelemetry;
+
+static endpointTelemetry networkTelemetry[NUMBER_OF_NETWORK_ENDPOINTS];
+static time_t lastNetworkTelemetryDump = 0;
+static bool isDumpRegisteredAtExit = false;
+static pthread_mutex_t networkTelemetryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* const networkEndpointNames[NUMBER_OF_NETWORK_ENDPOINTS] = {
+    [NETWORK_ENDPOINT_WIKI_GET_PAGE] = "wiki.getPage",
+    [NETWORK_ENDPOINT_WIKI_LIST_PAGES] = "wiki.listPages",
+    [NETWORK_ENDPOINT_WIKI_UPDATE_PAGE] = "wiki.updatePage",
+    [NETWORK_ENDPOINT_WIKI_RENDER_PAGE] = "wiki.renderPage",
+    [NETWORK_ENDPOINT_WIKI_CREATE_PAGE] = "wiki.createPage",
+    [NETWORK_ENDPOINT_WIKI_MOVE_PAGE] = "wiki.movePage",
+    [NETWORK_ENDPOINT_WIKI_DELETE_PAGE] = "wiki.deletePage",
+    [NETWORK_ENDPOINT_WIKI_MUTATION_BATCH] = "wiki.mutationBatch",
+    [NETWORK_ENDPOINT_WIKI_OTHER] = "wiki.other",
+    [NETWORK_ENDPOINT_SHEET_GET] = "sheet.get",
+    [NETWORK_ENDPOINT_SHEET_UPDATE] = "sheet.update",
+    [NETWORK_ENDPOINT_SHEET_OAUTH] = "sheet.oauth",
+    [NETWORK_ENDPOINT_SLACK_POST] = "slack.postMessage",
+    [NETWORK_ENDPOINT_SLACK_UPDATE] = "slack.update",
+    [NETWORK_ENDPOINT_SLACK_HISTORY] = "slack.history",
+};
+
+networkEndpoint classifyWikiQuery(const char *query){
+    if(!query){
+        return NETWORK_ENDPOINT_WIKI_OTHER;
+    }
+
+    // Only the start of the query is looked at, the page content of a mutation may contain anything
+    char operation[64];
+    snprintf(operation, sizeof(operation), "%s", query);
+
+    if(strstr(operation, "mutation")){
+        if(strstr(operation, " m0: pages { render(")) return NETWORK_ENDPOINT_WIKI_RENDER_PAGE;
+        if(strstr(operation, " m0: pages")) return NETWORK_ENDPOINT_WIKI_MUTATION_BATCH;
+        if(strstr(operation, "update(")) return NETWORK_ENDPOINT_WIKI_UPDATE_PAGE;
+        if(strstr(operation, "render(")) return NETWORK_ENDPOINT_WIKI_RENDER_PAGE;
+        if(strstr(operation, "create(")) return NETWORK_ENDPOINT_WIKI_CREATE_PAGE;
+        if(strstr(operation, "move(")) return NETWORK_ENDPOINT_WIKI_MOVE_PAGE;
+        if(strstr(operation, "delete(")) return NETWORK_ENDPOINT_WIKI_DELETE_PAGE;
+        return NETWORK_ENDPOINT_WIKI_OTHER;
+    }
+
+    if(strstr(operation, "single(")) return NETWORK_ENDPOINT_WIKI_GET_PAGE;
+    if(strstr(operation, "list(")) return NETWORK_ENDPOINT_WIKI_LIST_PAGES;
+
+    return NETWORK_ENDPOINT_WIKI_OTHER;
+}
+
+networkEndpoint classifySlackUrl(const char *url){
+    if(url && strstr(url, "chat.update")){
+        return NETWORK_ENDPOINT_SLACK_UPDATE;
+    }
+
+    if(url && strstr(url, "conversations.history")){
+        return NETWORK_ENDPOINT_SLACK_HISTORY;
+    }
+
+    return NETWORK_ENDPOINT_SLACK_POST;
+}
+
+static int getHistogramBucket(long long value){
+    int bucket = 0;
+
+    while(value > 1 && bucket < NETWORK_HISTOGRAM_BUCKETS - 1){
+        value >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void recordNetworkSample(networkEndpoint endpoint, const long long values[NUMBER_OF_NETWORK_METRICS]){
+    pthread_mutex_lock(&networkTelemetryMutex);
+
+    endpointTelemetry* telemetry = &networkTelemetry[endpoint];
+    telemetry->count++;
+
+    for(int metric = 0; metric < NUMBER_OF_NETWORK_METRICS; metric++){
+        long long value = values[metric] > 0 ? values[metric] : 0;
+        networkHistogram* histogram = &telemetry->metrics[metric];
+
+        histogram->buckets[getHistogramBucket(value)]++;
+        histogram->sum += value;
+        if(value > histogram->maximum){
+            histogram->maximum = value;
+        }
+    }
+
+    pthread_mutex_unlock(&networkTelemetryMutex);
+}
+
+void recordCurlTimings(networkEndpoint endpoint, CURL *curl){
+    curl_off_t nameLookup = 0;
+    curl_off_t connect = 0;
+    curl_off_t appConnect = 0;
+    curl_off_t startTransfer = 0;
+    curl_off_t total = 0;
+    curl_off_t bytesUp = 0;
+    curl_off_t bytesDown = 0;
+
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &nameLookup);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appConnect);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &startTransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &bytesUp);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytesDown);
+
+    // curl gives times since the start of the request, each stage is the difference with the previous one
+    curl_off_t readyToSend = appConnect > 0 ? appConnect : connect;
+
+    long long values[NUMBER_OF_NETWORK_METRICS] = {
+        [NETWORK_METRIC_DNS] = nameLookup,
+        [NETWORK_METRIC_CONNECT] = connect > 0 ? connect - nameLookup : 0,
+        [NETWORK_METRIC_TLS] = appConnect > 0 ? appConnect - connect : 0,
+        [NETWORK_METRIC_FIRST_BYTE] = startTransfer > 0 ? startTransfer - readyToSend : 0,
+        [NETWORK_METRIC_TOTAL] = total,
+        [NETWORK_METRIC_BYTES_UP] = bytesUp,
+        [NETWORK_METRIC_BYTES_DOWN] = bytesDown,
+    };
+
+    recordNetworkSample(endpoint, values);
+
+    if(!isDumpRegisteredAtExit){
+        isDumpRegisteredAtExit = true;
+        lastNetworkTelemetryDump = time(NULL);
+        atexit(dumpNetworkTelemetry);
+    }
+}
+
+static long long computeNetworkPercentile(networkEndpoint endpoint, networkMetric metric, double percentile){
+    const endpointTelemetry* telemetry = &networkTelemetry[endpoint];
+    const networkHistogram* histogram = &telemetry->metrics[metric];
+
+    if(telemetry->count == 0){
+        return 0;
+    }
+
+    unsigned long rank = (unsigned long)(percentile / 100.0 * (double)telemetry->count + 0.5);
+    if(rank < 1){
+        rank = 1;
+    }
+
+    unsigned long seen = 0;
+    for(int bucket = 0; bucket < NETWORK_HISTOGRAM_BUCKETS; bucket++){
+        seen += histogram->buckets[bucket];
+        if(seen >= rank){
+            long long upperBound = 1LL << (bucket + 1);
+            return upperBound < histogram->maximum ? upperBound : histogram->maximum;
+        }
+    }
+
+    return histogram->maximum;
+}
+
+long long getNetworkPercentile(networkEndpoint endpoint, networkMetric metric, double percentile){
+    pthread_mutex_lock(&networkTelemetryMutex);
+    long long value = computeNetworkPercentile(endpoint, metric, percentile);
+    pthread_mutex_unlock(&networkTelemetryMutex);
+
+    return value;
+}
+
+unsigned long getNetworkRequestCount(networkEndpoint endpoint){
+    pthread_mutex_lock(&networkTelemetryMutex);
+    unsigned long count = networkTelemetry[endpoint].count;
+    pthread_mutex_unlock(&networkTelemetryMutex);
+
+    return count;
+}
+
+const char* getNetworkEndpointName(networkEndpoint endpoint){
+    return networkEndpointNames[endpoint];
+}
+
+void dumpNetworkTelemetry(){
+    log_message(LOG_DEBUG, "Entering function dumpNetworkTelemetry");
+
+    pthread_mutex_lock(&networkTelemetryMutex);
+
+    for(int endpoint = 0; endpoint < NUMBER_OF_NETWORK_ENDPOINTS; endpoint++){
+        const endpointTelemetry* telemetry = &networkTelemetry[endpoint];
+        if(telemetry->count == 0){
+            continue;
+        }
+
+        // Median and 90th percentile in ms
+        double stages[NETWORK_METRIC_TOTAL + 1][2];
+        for(int metric = 0; metric <= NETWORK_METRIC_TOTAL; metric++){
+            stages[metric][0] = (double)computeNetworkPercentile(endpoint, metric, 50) / 1000.0;
+            stages[metric][1] = (double)computeNetworkPercentile(endpoint, metric, 90) / 1000.0;
+        }
+
+        log_message(LOG_INFO, "network %s: %lu requests, p50/p90 ms: dns %.1f/%.1f, connect %.1f/%.1f, tls %.1f/%.1f, first byte %.1f/%.1f, total %.1f/%.1f, max %.1f; average kB up %.1f, down %.1f",
+                    networkEndpointNames[endpoint], telemetry->count,
+                    stages[NETWORK_METRIC_DNS][0], stages[NETWORK_METRIC_DNS][1],
+                    stages[NETWORK_METRIC_CONNECT][0], stages[NETWORK_METRIC_CONNECT][1],
+                    stages[NETWORK_METRIC_TLS][0], stages[NETWORK_METRIC_TLS][1],
+                    stages[NETWORK_METRIC_FIRST_BYTE][0], stages[NETWORK_METRIC_FIRST_BYTE][1],
+                    stages[NETWORK_METRIC_TOTAL][0], stages[NETWORK_METRIC_TOTAL][1],
+                    (double)telemetry->metrics[NETWORK_METRIC_TOTAL].maximum / 1000.0,
+                    (double)telemetry->metrics[NETWORK_METRIC_BYTES_UP].sum / 1024.0 / (double)telemetry->count,
+                    (double)telemetry->metrics[NETWORK_METRIC_BYTES_DOWN].sum / 1024.0 / (double)telemetry->count);
+    }
+
+    pthread_mutex_unlock(&networkTelemetryMutex);
+
+    lastNetworkTelemetryDump = time(NULL);
+
+    log_message(LOG_DEBUG, "Exiting function dumpNetworkTelemetry");
+}
+
+void writeNetworkTelemetryMetrics(FILE *out){
+    pthread_mutex_lock(&networkTelemetryMutex);
+
+    fputs("# HELP ertbot_api_request_duration_seconds Total time of each HTTP request.\n", out);
+    fputs("# TYPE ertbot_api_request_duration_seconds histogram\n", out);
+    for(int endpoint = 0; endpoint < NUMBER_OF_NETWORK_ENDPOINTS; endpoint++){
+        const endpointTelemetry* telemetry = &networkTelemetry[endpoint];
+        const networkHistogram* histogram = &telemetry->metrics[NETWORK_METRIC_TOTAL];
+        if(telemetry->count == 0){
+            continue;
+        }
+
+        unsigned long cumulativeCount = 0;
+        for(int bucket = 0; bucket <= LAST_EXPORTED_BUCKET; bucket++){
+            cumulativeCount += histogram->buckets[bucket];
+            if(bucket >= FIRST_EXPORTED_BUCKET){
+                fprintf(out, "ertbot_api_request_duration_seconds_bucket{endpoint=\"%s\",le=\"%g\"} %lu\n",
+                        networkEndpointNames[endpoint], (double)(1LL << (bucket + 1)) / 1e6, cumulativeCount);
+            }
+        }
+        fprintf(out, "ertbot_api_request_duration_seconds_bucket{endpoint=\"%s\",le=\"+Inf\"} %lu\n", networkEndpointNames[endpoint], telemetry->count);
+        fprintf(out, "ertbot_api_request_duration_seconds_sum{endpoint=\"%s\"} %f\n", networkEndpointNames[endpoint], (double)histogram->sum / 1e6);
+        fprintf(out, "ertbot_api_request_duration_seconds_count{endpoint=\"%s\"} %lu\n", networkEndpointNames[endpoint], telemetry->count);
+    }
+
+    fputs("# HELP ertbot_api_first_byte_seconds_total Time spent waiting for the first byte of responses, i.e. server time.\n", out);
+    fputs("# TYPE ertbot_api_first_byte_seconds_total counter\n", out);
+    for(int endpoint = 0; endpoint < NUMBER_OF_NETWORK_ENDPOINTS; endpoint++){
+        if(networkTelemetry[endpoint].count > 0){
+            fprintf(out, "ertbot_api_first_byte_seconds_total{endpoint=\"%s\"} %f\n", networkEndpointNames[endpoint],
+                    (double)networkTelemetry[endpoint].metrics[NETWORK_METRIC_FIRST_BYTE].sum / 1e6);
+        }
+    }
+
+    fputs("# HELP ertbot_api_bytes_total Bytes sent and received in request and response bodies.\n", out);
+    fputs("# TYPE ertbot_api_bytes_total counter\n", out);
+    for(int endpoint = 0; endpoint < NUMBER_OF_NETWORK_ENDPOINTS; endpoint++){
+        if(networkTelemetry[endpoint].count > 0){
+            fprintf(out, "ertbot_api_bytes_total{endpoint=\"%s\",direction=\"up\"} %lld\n", networkEndpointNames[endpoint],
+                    networkTelemetry[endpoint].metrics[NETWORK_METRIC_BYTES_UP].sum);
+            fprintf(out, "ertbot_api_bytes_total{endpoint=\"%s\",direction=\"down\"} %lld\n", networkEndpointNames[endpoint],
+                    networkTelemetry[endpoint].metrics[NETWORK_METRIC_BYTES_DOWN].sum);
+        }
+    }
+
+    pthread_mutex_unlock(&networkTelemetryMutex);
+}
+
+void dumpNetworkTelemetryIfDue(){
+    if(lastNetworkTelemetryDump != 0 && time(NULL) - lastNetworkTelemetryDump >= NETWORK_TELEMETRY_DUMP_PERIOD){
+        dumpNetworkTelemetry();
+    }
+}
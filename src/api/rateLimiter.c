@@ -0,0 +1,242 @@
+/**
+ * @file rateLimiter.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the token buckets which keep the requests of each API under its rate limits.
+ *
+ * @details Every request takes a token from the bucket of its tier before it is sent. A bucket holds up to `burst`
+ *          tokens and is refilled continuously at `requestsPerSecond`, so a tier can send a burst after being idle
+ *          and then goes exactly as fast as its rate. A 429 response pauses the tier for as long as the API asked.
+ */
+
+#define LOG_MODULE LOG_MODULE_API_HELPERS
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "ERTbot_metrics.h"
+#include "rateLimiter.h"
+
+typedef struct tokenBucket {
+    double requestsPerSecond;
+    double burst;
+    double tokens;
+    double lastRefillTime;
+    double pausedUntil;
+} tokenBucket;
+
+static const char* const rateLimitTierNames[] = {
+    [RATE_LIMIT_TIER_WIKI] = "wiki",
+    [RATE_LIMIT_TIER_SHEETS_READ] = "sheets_read",
+    [RATE_LIMIT_TIER_SHEETS_WRITE] = "sheets_write",
+    [RATE_LIMIT_TIER_GOOGLE_OAUTH] = "google_oauth",
+    [RATE_LIMIT_TIER_SLACK_POST] = "slack_post",
+    [RATE_LIMIT_TIER_SLACK_UPDATE] = "slack_update",
+    [RATE_LIMIT_TIER_SLACK_HISTORY] = "slack_history",
+};
+
+static const rateLimitTier endpointTiers[] = {
+    [NETWORK_ENDPOINT_WIKI_GET_PAGE] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_WIKI_LIST_PAGES] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_WIKI_UPDATE_PAGE] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_WIKI_RENDER_PAGE] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_WIKI_CREATE_PAGE] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_WIKI_MOVE_PAGE] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_WIKI_DELETE_PAGE] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_WIKI_MUTATION_BATCH] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_WIKI_OTHER] = RATE_LIMIT_TIER_WIKI,
+    [NETWORK_ENDPOINT_SHEET_GET] = RATE_LIMIT_TIER_SHEETS_READ,
+    [NETWORK_ENDPOINT_SHEET_UPDATE] = RATE_LIMIT_TIER_SHEETS_WRITE,
+    [NETWORK_ENDPOINT_SHEET_OAUTH] = RATE_LIMIT_TIER_GOOGLE_OAUTH,
+    [NETWORK_ENDPOINT_SLACK_POST] = RATE_LIMIT_TIER_SLACK_POST,
+    [NETWORK_ENDPOINT_SLACK_UPDATE] = RATE_LIMIT_TIER_SLACK_UPDATE,
+    [NETWORK_ENDPOINT_SLACK_HISTORY] = RATE_LIMIT_TIER_SLACK_HISTORY,
+};
+
+static tokenBucket buckets[NUMBER_OF_RATE_LIMIT_TIERS];
+static bool isRateLimiterInitialized = false;
+static pthread_mutex_t rateLimiterMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static double getMonotonicSeconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void setRateLimitLocked(rateLimitTier tier, double requestsPerSecond, double burst){
+    tokenBucket* bucket = &buckets[tier];
+
+    bucket->requestsPerSecond = requestsPerSecond;
+    bucket->burst = burst < 1 ? 1 : burst;
+    bucket->tokens = bucket->burst;
+    bucket->lastRefillTime = getMonotonicSeconds();
+}
+
+static int setRateLimitsLocked(const char *settings){
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", settings);
+
+    int result = 0;
+    char *savePointer = NULL;
+
+    for(char *setting = strtok_r(buffer, ",", &savePointer); setting; setting = strtok_r(NULL, ",", &savePointer)){
+        char tierName[32];
+        double requestsPerSecond = 0;
+        double burst = 0;
+
+        if(sscanf(setting, "%31[^=]=%lf/%lf", tierName, &requestsPerSecond, &burst) != 3){
+            log_message(LOG_ERROR, "Invalid rate limit %s, expected tier=requestsPerSecond/burst", setting);
+            result = 1;
+            continue;
+        }
+
+        int tier = 0;
+        while(tier < NUMBER_OF_RATE_LIMIT_TIERS && strcmp(tierName, rateLimitTierNames[tier]) != 0){
+            tier++;
+        }
+
+        if(tier == NUMBER_OF_RATE_LIMIT_TIERS){
+            log_message(LOG_ERROR, "Unknown rate limit tier %s", tierName);
+            result = 1;
+            continue;
+        }
+
+        setRateLimitLocked((rateLimitTier)tier, requestsPerSecond, burst);
+        log_message(LOG_INFO, "Rate limit of %s set to %.2f requests per second, bursts of %.0f", tierName, requestsPerSecond, burst);
+    }
+
+    return result;
+}
+
+static void initializeRateLimiterLocked(){
+    isRateLimiterInitialized = true;
+
+    setRateLimitLocked(RATE_LIMIT_TIER_WIKI, RATE_LIMIT_WIKI_PER_SECOND, RATE_LIMIT_WIKI_BURST);
+    setRateLimitLocked(RATE_LIMIT_TIER_SHEETS_READ, RATE_LIMIT_SHEETS_READ_PER_SECOND, RATE_LIMIT_SHEETS_READ_BURST);
+    setRateLimitLocked(RATE_LIMIT_TIER_SHEETS_WRITE, RATE_LIMIT_SHEETS_WRITE_PER_SECOND, RATE_LIMIT_SHEETS_WRITE_BURST);
+    setRateLimitLocked(RATE_LIMIT_TIER_GOOGLE_OAUTH, RATE_LIMIT_GOOGLE_OAUTH_PER_SECOND, RATE_LIMIT_GOOGLE_OAUTH_BURST);
+    setRateLimitLocked(RATE_LIMIT_TIER_SLACK_POST, RATE_LIMIT_SLACK_POST_PER_SECOND, RATE_LIMIT_SLACK_POST_BURST);
+    setRateLimitLocked(RATE_LIMIT_TIER_SLACK_UPDATE, RATE_LIMIT_SLACK_UPDATE_PER_SECOND, RATE_LIMIT_SLACK_UPDATE_BURST);
+    setRateLimitLocked(RATE_LIMIT_TIER_SLACK_HISTORY, RATE_LIMIT_SLACK_HISTORY_PER_SECOND, RATE_LIMIT_SLACK_HISTORY_BURST);
+
+    const char *settings = getenv("ERTBOT_RATE_LIMITS");
+    if(settings && settings[0] != '\0'){
+        (void)setRateLimitsLocked(settings);
+    }
+}
+
+static void lockRateLimiter(){
+    pthread_mutex_lock(&rateLimiterMutex);
+    if(!isRateLimiterInitialized){
+        initializeRateLimiterLocked();
+    }
+}
+
+rateLimitTier getRateLimitTier(networkEndpoint endpoint){
+    return endpointTiers[endpoint];
+}
+
+const char* getRateLimitTierName(rateLimitTier tier){
+    return rateLimitTierNames[tier];
+}
+
+void setRateLimit(rateLimitTier tier, double requestsPerSecond, double burst){
+    lockRateLimiter();
+    setRateLimitLocked(tier, requestsPerSecond, burst);
+    pthread_mutex_unlock(&rateLimiterMutex);
+}
+
+int setRateLimits(const char *settings){
+    lockRateLimiter();
+    int result = setRateLimitsLocked(settings);
+    pthread_mutex_unlock(&rateLimiterMutex);
+
+    return result;
+}
+
+long long tryAcquireRateLimitToken(networkEndpoint endpoint){
+    lockRateLimiter();
+
+    tokenBucket* bucket = &buckets[endpointTiers[endpoint]];
+    double now = getMonotonicSeconds();
+    double waitSeconds = 0;
+
+    if(now < bucket->pausedUntil){
+        waitSeconds = bucket->pausedUntil - now;
+    }
+
+    else if(bucket->requestsPerSecond > 0){
+        bucket->tokens += (now - bucket->lastRefillTime) * bucket->requestsPerSecond;
+        if(bucket->tokens > bucket->burst){
+            bucket->tokens = bucket->burst;
+        }
+        bucket->lastRefillTime = now;
+
+        if(bucket->tokens >= 1){
+            bucket->tokens -= 1;
+        }
+        else{
+            waitSeconds = (1 - bucket->tokens) / bucket->requestsPerSecond;
+        }
+    }
+
+    pthread_mutex_unlock(&rateLimiterMutex);
+
+    // Rounded up, a caller which waits exactly this long finds a token
+    long long waitMicroseconds = (long long)(waitSeconds * 1e6);
+    return waitSeconds > 0 ? waitMicroseconds + 1 : 0;
+}
+
+void waitForRateLimitToken(networkEndpoint endpoint){
+    long long waitMicroseconds;
+    long long totalWaitMicroseconds = 0;
+
+    while((waitMicroseconds = tryAcquireRateLimitToken(endpoint)) > 0){
+        struct timespec delay = {(time_t)(waitMicroseconds / 1000000), (long)(waitMicroseconds % 1000000) * 1000L};
+        nanosleep(&delay, NULL);
+        totalWaitMicroseconds += waitMicroseconds;
+    }
+
+    if(totalWaitMicroseconds > 0){
+        recordRateLimitWaitMetric(totalWaitMicroseconds);
+        log_message(LOG_DEBUG, "Waited %lld ms for the %s rate limit", totalWaitMicroseconds / 1000, getNetworkEndpointName(endpoint));
+    }
+}
+
+void resetRateLimits(){
+    pthread_mutex_lock(&rateLimiterMutex);
+    memset(buckets, 0, sizeof(buckets));
+    initializeRateLimiterLocked();
+    pthread_mutex_unlock(&rateLimiterMutex);
+}
+
+void reportRateLimitedResponse(networkEndpoint endpoint, long retryAfterSeconds){
+    rateLimitTier tier = endpointTiers[endpoint];
+
+    double pauseSeconds = retryAfterSeconds > 0 ? (double)retryAfterSeconds : RATE_LIMIT_DEFAULT_PAUSE_SECONDS;
+    if(pauseSeconds > RATE_LIMIT_MAX_PAUSE_SECONDS){
+        pauseSeconds = RATE_LIMIT_MAX_PAUSE_SECONDS;
+    }
+
+    lockRateLimiter();
+
+    tokenBucket* bucket = &buckets[tier];
+    double pausedUntil = getMonotonicSeconds() + pauseSeconds;
+    if(pausedUntil > bucket->pausedUntil){
+        bucket->pausedUntil = pausedUntil;
+    }
+
+    // Refilled from the end of the pause on
+    bucket->tokens = 0;
+    bucket->lastRefillTime = bucket->pausedUntil;
+
+    pthread_mutex_unlock(&rateLimiterMutex);
+
+    countRateLimitedResponseMetric();
+    log_message(LOG_ERROR, "%s was rate limited, pausing %s requests for %.0f s", getNetworkEndpointName(endpoint), rateLimitTierNames[tier], pauseSeconds);
+}
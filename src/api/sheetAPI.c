@@ -5,42 +5,42 @@
  *
  */
 
+#define LOG_MODULE LOG_MODULE_SHEET_API
+
 #include <curl/curl.h>
 #include <string.h>
 #include "ERTbot_common.h"
 #include "apiHelpers.h"
 #include "stringHelpers.h"
+#include "ERTbot_trace.h"
+#include "networkTelemetry.h"
+#include "httpTransport.h"
+#include "ERTbot_metrics.h"
+#include "sheetAPI.h"
 
 
 
-char *template_batch_update_url = "https://sheets.googleapis.com/v4/spreadsheets/DefaultSheetID/values:batchUpdate";
-char *template_batch_get_url = "https://sheets.googleapis.com/v4/spreadsheets/DefaultSheetID/values/DefaultRange";
+char *template_batch_update_url = "/spreadsheets/DefaultSheetID/values:batchUpdate";
+char *template_batch_get_url = "/spreadsheets/DefaultSheetID/values/DefaultRange";
+char *template_batch_get_ranges_url = "/spreadsheets/DefaultSheetID/values:batchGet?majorDimension=ROWS";
 char *template_batch_update_query = "{\"valueInputOption\": \"USER_ENTERED\",\"data\": [{\"range\": \"DefaultRange\",\"majorDimension\": \"ROWS\",\"values\": DefaultValues}],\"includeValuesInResponse\": true,\"responseValueRenderOption\": \"FORMATTED_VALUE\",\"responseDateTimeRenderOption\": \"SERIAL_NUMBER\"}";
 
 //char *query = "{\"valueInputOption\": \"USER_ENTERED\",\"data\": [{\"range\": \"Sheet1!A1:C4\",\"majorDimension\": \"ROWS\",\"values\": [[\"Item\", \"Cost\", \"Review\"],[\"Coffee\", 2.50, 5]]}],\"includeValuesInResponse\": true,\"responseValueRenderOption\": \"FORMATTED_VALUE\",\"responseDateTimeRenderOption\": \"SERIAL_NUMBER\"}";
 
-void sheetAPI(char *query, char *url, char *requestType) {
-    log_message(LOG_DEBUG, "Entering function sheetAPI");
-
-    CURL *curl;
-    CURLcode res;
-    struct curl_slist *headers = NULL;
-    // Initialize libcurl
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl = curl_easy_init();
-
-    resetChunkResponse();
+CURL* createSheetRequest(const char *url, const char *requestType, const char *query, memory *response, struct curl_slist **headers){
+    CURL *curl = curl_easy_init();
+    *headers = NULL;
 
     if (curl) {
         // Set the URL for the request
         curl_easy_setopt(curl, CURLOPT_URL, url);
         curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
         // Set the HTTP headers
-        headers = curl_slist_append(headers, "Content-Type: application/json");
+        *headers = curl_slist_append(*headers, "Content-Type: application/json");
         char auth_header[1024];
         snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s ", SHEET_API_TOKEN);
-        headers = curl_slist_append(headers, auth_header);
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        *headers = curl_slist_append(*headers, auth_header);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, *headers);
         // Set the request type to PUT
         curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, requestType);
         // Set the query for the request
@@ -48,10 +48,33 @@ void sheetAPI(char *query, char *url, char *requestType) {
         // Set the callback function to handle the response
         // Send all data to this function
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-        /* we pass our 'chunk' struct to the callback function */
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)response);
+    }
+
+    return curl;
+}
+
+void sheetAPI(char *query, char *url, char *requestType) {
+    log_message(LOG_DEBUG, "Entering function sheetAPI");
+
+    beginTraceSpan(TRACE_CATEGORY_API, "sheetAPI", requestType);
+
+    CURL *curl;
+    CURLcode res;
+    struct curl_slist *headers = NULL;
+    // Initialize libcurl
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    resetChunkResponse();
+
+    /* we pass our 'chunk' struct to the callback function */
+    curl = createSheetRequest(url, requestType, query, &chunk, &headers);
+
+    if (curl) {
         // Perform the request
-        res = curl_easy_perform(curl);
+        long http_code = 0;
+        res = performHttpRequest(curl, strcmp(requestType, "GET") == 0 ? NETWORK_ENDPOINT_SHEET_GET : NETWORK_ENDPOINT_SHEET_UPDATE,
+                                 requestType, url, query, &http_code);
         // Check for errors
         if (res != CURLE_OK) {
             log_message(LOG_ERROR, "sheetAPI: curl_easy_perform() failed: %s", curl_easy_strerror(res));
@@ -63,6 +86,8 @@ void sheetAPI(char *query, char *url, char *requestType) {
 
     curl_global_cleanup();
 
+    endTraceSpan();
+
     log_message(LOG_DEBUG, "Exiting function sheetAPI");
 }
 
@@ -81,6 +106,8 @@ void refreshOAuthToken() {
     char postfields[1024];
     snprintf(postfields, sizeof(postfields), "client_id=%s&client_secret=%s&refresh_token=%s&grant_type=refresh_token", GOOGLE_CLIENT_ID, GOOGLE_CLIENT_SECRET, GOOGLE_REFRESH_TOKEN);
 
+    beginTraceSpan(TRACE_CATEGORY_API, "refreshOAuthToken", NULL);
+
     resetChunkResponse();
 
     curl_global_init(CURL_GLOBAL_ALL);
@@ -88,7 +115,7 @@ void refreshOAuthToken() {
 
     if(curl) {
         // Set the URL for the token request
-        curl_easy_setopt(curl, CURLOPT_URL, "https://oauth2.googleapis.com/token");
+        curl_easy_setopt(curl, CURLOPT_URL, getApiUrl(API_SERVICE_GOOGLE_OAUTH));
         curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
         // Specify that we want to send a POST request
         curl_easy_setopt(curl, CURLOPT_POST, 1L);
@@ -103,7 +130,9 @@ void refreshOAuthToken() {
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
 
         // Perform the request and get the response code
-        res = curl_easy_perform(curl);
+        // The client secret and refresh token are only kept in the cassette as part of the request hash
+        long http_code = 0;
+        res = performHttpRequest(curl, NETWORK_ENDPOINT_SHEET_OAUTH, "POST", getApiUrl(API_SERVICE_GOOGLE_OAUTH), postfields, &http_code);
 
         // Check for errors
         if(res != CURLE_OK) {
@@ -118,6 +147,7 @@ void refreshOAuthToken() {
             }
 
             SHEET_API_TOKEN = jsonParserGetStringValue(chunk.response, "\"access_token\":");
+            countOAuthRefreshMetric();
         }
 
         // Clean up
@@ -127,6 +157,8 @@ void refreshOAuthToken() {
 
     curl_global_cleanup();
 
+    endTraceSpan();
+
     log_message(LOG_DEBUG, "Exiting function refreshOAuthToken");
     return;
 }
@@ -135,7 +167,7 @@ void batchUpdateSheet(const char *sheetId, const char *range, const char *values
     log_message(LOG_DEBUG, "Entering function batchUpdateSheet");
 
     char *requestType = "POST";
-    char *modified_url = duplicate_Malloc(template_batch_update_url); // Make a copy to modify
+    char *modified_url = createCombinedString(getApiUrl(API_SERVICE_SHEETS), template_batch_update_url);
     modified_url = replaceWord_Realloc(modified_url, "DefaultSheetID", sheetId);
     char *modified_query = duplicate_Malloc(template_batch_update_query); // Make a copy to modify
     modified_query = replaceWord_Realloc(modified_query, "DefaultRange", range);
@@ -150,6 +182,14 @@ void batchUpdateSheet(const char *sheetId, const char *range, const char *values
     log_message(LOG_DEBUG, "Exiting function batchUpdateSheet");
 }
 
+char* buildBatchGetSheetUrl(const char *sheetId, const char *range){
+    char *modified_url = createCombinedString(getApiUrl(API_SERVICE_SHEETS), template_batch_get_url);
+    modified_url = replaceWord_Realloc(modified_url, "DefaultSheetID", sheetId);
+    modified_url = replaceWord_Realloc(modified_url, "DefaultRange", range);
+
+    return modified_url;
+}
+
 void batchGetSheet(const char *sheetId, const char *range){
     log_message(LOG_DEBUG, "Entering function batchGetSheet");
 
@@ -157,9 +197,7 @@ void batchGetSheet(const char *sheetId, const char *range){
 
     char *requestType = "GET";
     char *query = "";
-    char *modified_url = duplicate_Malloc(template_batch_get_url); // Make a copy to modify
-    modified_url = replaceWord_Realloc(modified_url, "DefaultSheetID", sheetId);
-    modified_url = replaceWord_Realloc(modified_url, "DefaultRange", range);
+    char *modified_url = buildBatchGetSheetUrl(sheetId, range);
 
     sheetAPI(query, modified_url, requestType);
 
@@ -168,3 +206,29 @@ void batchGetSheet(const char *sheetId, const char *range){
     log_message(LOG_DEBUG, "Exiting function batchGetSheet");
     return;
 }
+
+void batchGetSheetRanges(const char *sheetId, const char* const* ranges, int numberOfRanges){
+    log_message(LOG_DEBUG, "Entering function batchGetSheetRanges");
+
+    refreshOAuthToken();
+
+    char *requestType = "GET";
+    char *query = "";
+    char *modified_url = createCombinedString(getApiUrl(API_SERVICE_SHEETS), template_batch_get_ranges_url);
+    modified_url = replaceWord_Realloc(modified_url, "DefaultSheetID", sheetId);
+
+    for(int i = 0; i < numberOfRanges; i++){
+        // Sheet names may contain spaces, unlike in the path of batchGetSheet the range has to be escaped
+        char *escapedRange = curl_easy_escape(NULL, ranges[i], 0);
+        modified_url = appendToString(modified_url, "&ranges=");
+        modified_url = appendToString(modified_url, escapedRange ? escapedRange : ranges[i]);
+        curl_free(escapedRange);
+    }
+
+    sheetAPI(query, modified_url, requestType);
+
+    free(modified_url);
+
+    log_message(LOG_DEBUG, "Exiting function batchGetSheetRanges");
+    return;
+}
@@ -6,23 +6,49 @@
  * @details Contains all of the functions which are only used to interact with the Slack APIs.
  */
 
+#define LOG_MODULE LOG_MODULE_SLACK_API
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include <curl/curl.h>
+#include <cjson/cJSON.h>
 #include <ERTbot_config.h>
 #include "apiHelpers.h"
 #include "ERTbot_common.h"
 #include "stringHelpers.h"
+#include "slackAPI.h"
+#include "ERTbot_trace.h"
+#include "networkTelemetry.h"
+#include "httpTransport.h"
 
 slackMessage* commandStatusMessage;
 
 #define MAX_MESSAGE_LENGTH 100000
 
-static int slackPostApi(char* url, char* postFields){
+// Returned by slackPostApi when the request was not sent for lack of a rate limit token
+#define SLACK_REQUEST_DEFERRED 2
+
+// Status updates which found no rate limit token, only the latest text of each message is kept
+static slackMessage* deferredStatusUpdates = NULL;
+
+/**
+ * @param[in] waitsForRateLimit If false the request is not sent when its rate limit tier has no token, see
+ *            `tryPerformHttpRequest`.
+ *
+ * @return int 0 on success, 1 on failure, `SLACK_REQUEST_DEFERRED` if the request was not sent.
+ */
+static int slackPostApi(char* url, char* postFields, bool waitsForRateLimit){
     log_message(LOG_DEBUG, "Entering function slackPostApi");
 
     CURL *curl;
     CURLcode res;
     struct curl_slist *headerlist = NULL;
 
+    // Only the method is kept, e.g. chat.update
+    const char *method = strrchr(url, '/');
+    beginTraceSpan(TRACE_CATEGORY_API, "slackAPI", method ? method + 1 : url);
+
     // Initialize libcurl
     curl_global_init(CURL_GLOBAL_ALL);
     curl = curl_easy_init();
@@ -52,24 +78,40 @@ static int slackPostApi(char* url, char* postFields){
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerlist);
 
         // Perform the request
-        res = curl_easy_perform(curl);
+        long http_code = 0;
+        if(waitsForRateLimit){
+            res = performHttpRequest(curl, classifySlackUrl(url), "POST", url, postFields, &http_code);
+        }
+        else{
+            res = tryPerformHttpRequest(curl, classifySlackUrl(url), "POST", url, postFields, &http_code);
+        }
 
         // Clean up
         curl_easy_cleanup(curl);
         curl_slist_free_all(headerlist);
 
+        if(res == CURLE_AGAIN) {
+            log_message(LOG_DEBUG, "No rate limit token left, %s was not sent", method ? method + 1 : url);
+            endTraceSpan();
+            return SLACK_REQUEST_DEFERRED;
+        }
+
         if(res != CURLE_OK) {
             log_message(LOG_ERROR, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
+            endTraceSpan();
             return 1;
         }
     }
     else {
         log_message(LOG_ERROR, "Failed to initialize libcurl");
+        endTraceSpan();
         return 1;
     }
 
     curl_global_cleanup();
 
+    endTraceSpan();
+
     log_message(LOG_DEBUG, "Exiting function slackPostApi");
     return 0;
 }
@@ -77,22 +119,107 @@ static int slackPostApi(char* url, char* postFields){
 int sendMessageToSlackAPI(char *message){
     char postFields[MAX_MESSAGE_LENGTH];
     snprintf(postFields, sizeof(postFields), "{\"channel\":\"%s\",\"text\":\"%s\"}", SLACK_WIKI_TOOLBOX_CHANNEL, message);
-    char *url = "https://slack.com/api/chat.postMessage";
+    char *url = createCombinedString(getApiUrl(API_SERVICE_SLACK), "/chat.postMessage");
 
-    return slackPostApi(url, postFields);
+    int returnValue = slackPostApi(url, postFields, true);
+    free(url);
+    return returnValue;
 }
 
 int updateSlackMessage(slackMessage* slackMessage) {
 #ifndef TESTING
     char postFields[MAX_MESSAGE_LENGTH];
     snprintf(postFields, sizeof(postFields), "{\"channel\":\"%s\",\"ts\":\"%s\",\"text\":\"%s\"}", SLACK_WIKI_TOOLBOX_CHANNEL, slackMessage->timestamp, slackMessage->message);
-    char *url = "https://slack.com/api/chat.update";
-    int returnValue = slackPostApi(url, postFields);
+    char *url = createCombinedString(getApiUrl(API_SERVICE_SLACK), "/chat.update");
+    int returnValue = slackPostApi(url, postFields, true);
+    free(url);
     freeChunkResponse();
     return returnValue;
 #endif
 }
 
+/**
+ * @brief Updates the text of a message without waiting for the rate limit.
+ *
+ * @return int 0 on success, 1 on failure, `SLACK_REQUEST_DEFERRED` if no rate limit token was available.
+ */
+static int trySlackMessageUpdate(const char *timestamp, const char *message){
+#ifndef TESTING
+    char postFields[MAX_MESSAGE_LENGTH];
+    snprintf(postFields, sizeof(postFields), "{\"channel\":\"%s\",\"ts\":\"%s\",\"text\":\"%s\"}", SLACK_WIKI_TOOLBOX_CHANNEL, timestamp, message);
+    char *url = createCombinedString(getApiUrl(API_SERVICE_SLACK), "/chat.update");
+    int returnValue = slackPostApi(url, postFields, false);
+    free(url);
+    freeChunkResponse();
+    return returnValue;
+#else
+    (void)timestamp;
+    (void)message;
+    return 0;
+#endif
+}
+
+static void removeDeferredStatusUpdate(const char *timestamp){
+    for(slackMessage** link = &deferredStatusUpdates; *link; link = &(*link)->next){
+        slackMessage* update = *link;
+        if(strcmp(update->timestamp, timestamp) == 0){
+            *link = update->next;
+            update->next = NULL;
+            freeSlackMessageList(&update);
+            return;
+        }
+    }
+}
+
+static void deferStatusUpdate(const char *timestamp, const char *message){
+    slackMessage** link = &deferredStatusUpdates;
+    while(*link){
+        link = &(*link)->next;
+    }
+
+    slackMessage* update = (slackMessage*)malloc(sizeof(slackMessage));
+    if(!update){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+    update->message = duplicate_Malloc(message);
+    update->sender = NULL;
+    update->timestamp = duplicate_Malloc(timestamp);
+    update->next = NULL;
+    *link = update;
+}
+
+void sendDeferredStatusUpdates(){
+    while(deferredStatusUpdates){
+        if(trySlackMessageUpdate(deferredStatusUpdates->timestamp, deferredStatusUpdates->message) == SLACK_REQUEST_DEFERRED){
+            return;
+        }
+
+        // A failed update is not retried, the next one replaces it anyway
+        slackMessage* sent = deferredStatusUpdates;
+        deferredStatusUpdates = sent->next;
+        sent->next = NULL;
+        freeSlackMessageList(&sent);
+    }
+}
+
+/**
+ * @brief Updates a status message or loading bar without waiting for the rate limit, if no token is available its text
+ *        is kept and sent later by `sendDeferredStatusUpdates`, replacing any older text of the same message.
+ */
+static void updateStatusMessage(const slackMessage* statusMessage){
+    if(!statusMessage->timestamp || !statusMessage->message){
+        return;
+    }
+
+    removeDeferredStatusUpdate(statusMessage->timestamp);
+    sendDeferredStatusUpdates();
+
+    if(deferredStatusUpdates || trySlackMessageUpdate(statusMessage->timestamp, statusMessage->message) == SLACK_REQUEST_DEFERRED){
+        deferStatusUpdate(statusMessage->timestamp, statusMessage->message);
+    }
+}
+
 int sendMessageToSlack(char *message) {
     log_message(LOG_DEBUG, "Entering function sendMessageToSlack");
 
@@ -103,14 +230,16 @@ int sendMessageToSlack(char *message) {
     return returnValue;
 }
 
-void checkLastSlackMessage() {
-    log_message(LOG_DEBUG, "Entering function checkLastSlackMessage");
+static void getSlackHistory(const char *oldestTimestamp, const char *pageCursor) {
+    log_message(LOG_DEBUG, "Entering function getSlackHistory");
 
     CURL *curl;
     CURLcode res;
     struct curl_slist *headers = NULL;
     static  char buf[] = "Expect:";
 
+    beginTraceSpan(TRACE_CATEGORY_API, "slackAPI", "conversations.history");
+
     resetChunkResponse();
 
     // Initialize libcurl
@@ -118,9 +247,13 @@ void checkLastSlackMessage() {
     curl = curl_easy_init();
 
     if (curl) {
-        // Set the URL for Slack API conversation history
-        char url[256];
-        snprintf(url, sizeof(url), "https://slack.com/api/conversations.history?channel=%s&limit=1", SLACK_WIKI_TOOLBOX_CHANNEL);
+        // Set the URL for Slack API conversation history, only messages strictly newer than oldestTimestamp are returned
+        char url[512];
+        int length = snprintf(url, sizeof(url), "%s/conversations.history?channel=%s&oldest=%s&limit=%d",
+                              getApiUrl(API_SERVICE_SLACK), SLACK_WIKI_TOOLBOX_CHANNEL, oldestTimestamp, SLACK_HISTORY_PAGE_SIZE);
+        if (pageCursor && pageCursor[0] != '\0' && length > 0 && (size_t)length < sizeof(url)) {
+            snprintf(url + length, sizeof(url) - length, "&cursor=%s", pageCursor);
+        }
         curl_easy_setopt(curl, CURLOPT_URL, url);
         curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
 
@@ -139,7 +272,8 @@ void checkLastSlackMessage() {
         curl_easy_setopt(curl, CURLOPT_HTTPGET, 1);
 
         // Perform the HTTP request
-        res = curl_easy_perform(curl);
+        long http_code = 0;
+        res = performHttpRequest(curl, NETWORK_ENDPOINT_SLACK_HISTORY, "GET", url, NULL, &http_code);
 
         // Check for errors
         if (res != CURLE_OK) {
@@ -147,10 +281,8 @@ void checkLastSlackMessage() {
         }
 
         // Check the HTTP status code
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
         if (http_code != 200) {
-            log_message(LOG_ERROR, "checkLastSlackMessage: HTTP request failed with status code %ld", http_code);
+            log_message(LOG_ERROR, "getSlackHistory: HTTP request failed with status code %ld", http_code);
             log_message(LOG_ERROR, "chunk.resposnse: %s", chunk.response);
         }
 
@@ -161,23 +293,163 @@ void checkLastSlackMessage() {
 
     curl_global_cleanup();
 
-    log_message(LOG_DEBUG, "Exiting function checkLastSlackMessage");
+    endTraceSpan();
+
+    log_message(LOG_DEBUG, "Exiting function getSlackHistory");
 }
 
-slackMessage* getSlackMessage(slackMessage* slackMsg) {
-    log_message(LOG_DEBUG, "Entering function getSlackMessage");
+static slackMessage* createSlackMessage(const char *message, const char *sender, const char *timestamp){
+    slackMessage* slackMsg = (slackMessage*)malloc(sizeof(slackMessage));
+    if (!slackMsg) {
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
 
-    checkLastSlackMessage();
+    slackMsg->message = duplicate_Malloc(message);
+    slackMsg->sender = duplicate_Malloc(sender);
+    slackMsg->timestamp = duplicate_Malloc(timestamp);
+    slackMsg->next = NULL;
 
-    slackMsg->message = jsonParserGetStringValue(chunk.response, "\"text\"");
-    slackMsg->sender = jsonParserGetStringValue(chunk.response, "\"user\"");
-    slackMsg->timestamp = jsonParserGetStringValue(chunk.response, "\"ts\"");
+    return slackMsg;
+}
 
-    freeChunkResponse();
+slackMessage* parseSlackHistory(const char *response, char **newestTimestamp, char **nextPageCursor){
+    log_message(LOG_DEBUG, "Entering function parseSlackHistory");
 
-    log_message(LOG_DEBUG, "Exiting function getSlackMessage");
+    slackMessage* head = NULL;
 
-    return slackMsg;
+    cJSON *history = cJSON_Parse(response);
+    if (!history) {
+        log_message(LOG_ERROR, "parseSlackHistory: could not parse the conversation history");
+        return NULL;
+    }
+
+    if (!cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(history, "ok"))) {
+        const cJSON *error = cJSON_GetObjectItemCaseSensitive(history, "error");
+        log_message(LOG_ERROR, "parseSlackHistory: Slack returned an error: %s", cJSON_IsString(error) ? error->valuestring : "unknown");
+        cJSON_Delete(history);
+        return NULL;
+    }
+
+    const cJSON *messages = cJSON_GetObjectItemCaseSensitive(history, "messages");
+    const cJSON *message = NULL;
+
+    // Slack lists the newest message first, prepending gives a list ordered from oldest to newest
+    cJSON_ArrayForEach(message, messages) {
+        const cJSON *text = cJSON_GetObjectItemCaseSensitive(message, "text");
+        const cJSON *user = cJSON_GetObjectItemCaseSensitive(message, "user");
+        const cJSON *ts = cJSON_GetObjectItemCaseSensitive(message, "ts");
+
+        if (!cJSON_IsString(ts)) {
+            continue;
+        }
+
+        if (newestTimestamp && (!*newestTimestamp || compareSlackTimestamps(ts->valuestring, *newestTimestamp) > 0)) {
+            free(*newestTimestamp);
+            *newestTimestamp = duplicate_Malloc(ts->valuestring);
+        }
+
+        // Skip bot messages (including ours) and channel events such as joins
+        if (cJSON_HasObjectItem(message, "bot_id") || cJSON_HasObjectItem(message, "subtype")
+            || !cJSON_IsString(text) || !cJSON_IsString(user)) {
+            continue;
+        }
+
+        slackMessage* slackMsg = createSlackMessage(text->valuestring, user->valuestring, ts->valuestring);
+        slackMsg->next = head;
+        head = slackMsg;
+    }
+
+    if (nextPageCursor) {
+        const cJSON *cursor = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(history, "response_metadata"), "next_cursor");
+        bool hasMore = cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(history, "has_more"));
+
+        *nextPageCursor = (hasMore && cJSON_IsString(cursor) && cursor->valuestring[0] != '\0') ? duplicate_Malloc(cursor->valuestring) : NULL;
+    }
+
+    cJSON_Delete(history);
+
+    log_message(LOG_DEBUG, "Exiting function parseSlackHistory");
+    return head;
+}
+
+slackMessage* getNewSlackMessages(char **cursor){
+    log_message(LOG_DEBUG, "Entering function getNewSlackMessages");
+
+    slackMessage* head = NULL;
+    char* newestTimestamp = NULL;
+    char* pageCursor = NULL;
+
+    // Each page is ordered from oldest to newest but Slack returns the newest page first
+    do {
+        getSlackHistory(*cursor, pageCursor);
+
+        free(pageCursor);
+        pageCursor = NULL;
+
+        slackMessage* page = parseSlackHistory(chunk.response, &newestTimestamp, &pageCursor);
+        freeChunkResponse();
+
+        if (page) {
+            slackMessage* pageTail = page;
+            while (pageTail->next) {
+                pageTail = pageTail->next;
+            }
+
+            pageTail->next = head;
+            head = page;
+        }
+    } while (pageCursor);
+
+    if (newestTimestamp) {
+        free(*cursor);
+        *cursor = newestTimestamp;
+    }
+
+    log_message(LOG_DEBUG, "Exiting function getNewSlackMessages");
+    return head;
+}
+
+int compareSlackTimestamps(const char *firstTimestamp, const char *secondTimestamp){
+    // Timestamps look like "1712345678.000100", compare the seconds then the sequence number
+    long long firstSeconds = 0, firstSequence = 0, secondSeconds = 0, secondSequence = 0;
+
+    sscanf(firstTimestamp, "%lld.%lld", &firstSeconds, &firstSequence);
+    sscanf(secondTimestamp, "%lld.%lld", &secondSeconds, &secondSequence);
+
+    if (firstSeconds != secondSeconds) {
+        return firstSeconds < secondSeconds ? -1 : 1;
+    }
+
+    if (firstSequence != secondSequence) {
+        return firstSequence < secondSequence ? -1 : 1;
+    }
+
+    return 0;
+}
+
+char* getCurrentSlackTimestamp(){
+    char timestamp[32];
+    snprintf(timestamp, sizeof(timestamp), "%lld.000000", (long long)time(NULL));
+
+    return duplicate_Malloc(timestamp);
+}
+
+void freeSlackMessageList(slackMessage** head){
+    slackMessage* current = *head;
+
+    while (current) {
+        slackMessage* next = current->next;
+
+        free(current->message);
+        free(current->sender);
+        free(current->timestamp);
+        free(current);
+
+        current = next;
+    }
+
+    *head = NULL;
 }
 
 slackMessage* sendUpdatedableSlackMessage(slackMessage* slackMsg) {
@@ -233,8 +505,11 @@ void sendLoadingBar(const int currentValue, const int totalValue){
 
     commandStatusMessage->message = newMessage;
 
-    if (currentValue % (totalValue / 10) == 0) {
-        updateSlackMessage(commandStatusMessage);
+    // Every tenth of the way, or every step when there are fewer than ten, and every step while an update is waiting
+    // for the rate limit so that the latest progress is the one sent
+    int updatePeriod = totalValue >= 10 ? totalValue / 10 : 1;
+    if (currentValue % updatePeriod == 0 || deferredStatusUpdates) {
+        updateStatusMessage(commandStatusMessage);
     }
 
 #endif
@@ -245,9 +520,11 @@ void sendLoadingBar(const int currentValue, const int totalValue){
 }
 
 void updateCommandStatusMessage(char *newStatusMessage){
+    markTracePhase(newStatusMessage);
+
 #ifndef TESTING
     commandStatusMessage->message = newStatusMessage;
-    updateSlackMessage(commandStatusMessage);
+    updateStatusMessage(commandStatusMessage);
 #endif
 }
 
@@ -260,6 +537,7 @@ void initialiseSlackCommandStatusMessage(){
     commandStatusMessage->message = NULL;
     commandStatusMessage->timestamp = NULL;
     commandStatusMessage->sender = NULL;
+    commandStatusMessage->next = NULL;
 
     
     log_message(LOG_DEBUG, "Exiting function initialiseSlackCommandStatusMessage");
@@ -315,7 +593,7 @@ void sendCompletedStatusMessage(const char *commandName){
     commandStatusMessage->message = duplicate_Malloc("Finished ");
     commandStatusMessage->message = appendToString(commandStatusMessage->message, commandName);
 
-    updateSlackMessage(commandStatusMessage);
+    updateStatusMessage(commandStatusMessage);
     
     freeSlackCommandStatusMessageVariables();
 
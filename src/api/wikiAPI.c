@@ -4,18 +4,30 @@
  * @brief Contains all of the functions which are only used to interact with the wiki APIs.
  */
 
+#define LOG_MODULE LOG_MODULE_WIKI_API
+
 #include <stdbool.h>
 #include <curl/curl.h>
 #include <string.h>
 #include "apiHelpers.h"
 #include "ERTbot_common.h"
+#include "ERTbot_config.h"
 #include "stringHelpers.h"
 #include "timeHelpers.h"
 #include "pageListHelpers.h"
+#include "wikiAPI.h"
+#include "ERTbot_trace.h"
+#include "networkTelemetry.h"
+#include "httpTransport.h"
+#include "ERTbot_metrics.h"
+#include "wikiPageCache.h"
+#include "fetchStage.h"
 
 
 
-char *template_pages_singles_query = "{\"query\":\"{pages {single(id: DefaultID){id, path, title, content, description, updatedAt, createdAt, authorId}}}\"}";
+char *template_pages_singles_query_start = "{\"query\":\"{pages {";
+char *template_pages_singles_query_field = "page%d: single(id: %s){id, path, title, content, description, updatedAt, createdAt, authorId} ";
+char *template_pages_singles_query_end = "}}\"}";
 char *template_list_pages_sortByPath_query = "{\"query\":\"{pages {list(orderBy: PATH){path, title, id, updatedAt}}}\"}";
 char *template_list_pages_sortByTime_query = "{\"query\":\"{pages {list(orderBy: UPDATED, orderByDirection: DESC){path, title, id, updatedAt}}}\"}";
 char *template_update_page_mutation = "{\"query\":\"mutation { pages { update(id: DefaultID, content: \\\"DefaultContent\\\", isPublished: true) { responseResult { succeeded, message } } } }\"}";
@@ -39,51 +51,66 @@ char *template_delete_page_mutation = "{\"query\":\"mutation { pages { delete(id
  * @note Ensure that `WIKI_API_TOKEN` is set correctly and the `writeCallback` function is properly defined to handle the
  *       API response.
  */
-void wikiApi(char *query){
-    log_message(LOG_DEBUG, "Entering function wikiApi");
-    log_message(LOG_DEBUG, "wikiApi query: %s", query);
-
-    CURL *curl;
-    CURLcode res;
-    struct curl_slist *headers = NULL;
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
-
-    resetChunkResponse();
+CURL* createWikiRequest(const char *query, memory *response, struct curl_slist **headers){
+    CURL *curl = curl_easy_init();
+    *headers = NULL;
 
     if (curl) {
         // Set the API URL
-        curl_easy_setopt(curl, CURLOPT_URL, "https://rocket-team.epfl.ch/graphql");
+        curl_easy_setopt(curl, CURLOPT_URL, getApiUrl(API_SERVICE_WIKI));
         curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
         // Set the HTTP method to POST
         curl_easy_setopt(curl, CURLOPT_POST, 1L);
         // Set the Content-Type header
-        headers = curl_slist_append(headers, "Content-Type: application/json");
+        *headers = curl_slist_append(*headers, "Content-Type: application/json");
         // Set the GraphQL query as the request payload
         curl_easy_setopt(curl, CURLOPT_POSTFIELDS, query);
         // Add Authorization header with the API key
         char auth_header[1024];
         snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s ", WIKI_API_TOKEN);
-        headers = curl_slist_append(headers, auth_header);
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        *headers = curl_slist_append(*headers, auth_header);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, *headers);
         // Set the callback function to handle the response
         // Send all data to this function
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-        /* we pass our 'chunk' struct to the callback function */
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)response);
+    }
+
+    return curl;
+}
+
+void wikiApi(char *query){
+    log_message(LOG_DEBUG, "Entering function wikiApi");
+    log_message(LOG_DEBUG, "wikiApi query: %s", query);
+
+    beginTraceSpan(TRACE_CATEGORY_API, "wikiApi", NULL);
+
+    CURL *curl;
+    CURLcode res;
+    struct curl_slist *headers = NULL;
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    resetChunkResponse();
+
+    /* we pass our 'chunk' struct to the callback function */
+    curl = createWikiRequest(query, &chunk, &headers);
+
+    if (curl) {
         // Perform the HTTP request
-        res = curl_easy_perform(curl);
+        long http_code = 0;
+        res = performHttpRequest(curl, classifyWikiQuery(query), "POST", getApiUrl(API_SERVICE_WIKI), query, &http_code);
         // Check for errors
         if (res != CURLE_OK) {
             log_message(LOG_ERROR, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
         }
         // Check the HTTP status code
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-        if (http_code != 200) {
+        else if (http_code != 200) {
             log_message(LOG_ERROR, "wikiApi: HTTP request failed with status code %ld", http_code);
             log_message(LOG_ERROR, "chunk.resposnse: %s", chunk.response);
-            exit(-1);
+        }
+        // The callers find an empty response rather than an error page
+        if (res != CURLE_OK || http_code != 200) {
+            resetChunkResponse();
         }
         // Clean up
         curl_easy_cleanup(curl);
@@ -91,30 +118,35 @@ void wikiApi(char *query){
     }
     curl_global_cleanup();
 
+    endTraceSpan();
+
     log_message(LOG_DEBUG, "Exiting function wikiApi");
 }
 
 /**
- * @brief Constructs and sends a GraphQL query to retrieve the content of a page.
+ * @brief Constructs and sends a single GraphQL query retrieving the content of several pages.
  *
- * @param[in] id Pointer to a string containing the ID of the page to retrieve.
+ * @param[in] pages Pages to retrieve, their id must be set.
  *
- * @details This function creates a query based on a template by replacing a placeholder with the provided page ID. It
- *          then sends the constructed query to the Wiki API using the `wikiApi` function. Memory for the query strings is
- *          dynamically allocated and freed after use.
- *
- * @note Ensure that `template_pages_singles_query` and `default_page.id` are correctly defined and that the `wikiApi`
- *       function is properly set up to handle the API request.
+ * @details Every page is looked up by its own `single(id:)` field, aliased `page0`, `page1`, ... so that the pages can
+ *          be told apart in the response.
  */
-static void getPageContentQuery(const char* id){
-    log_message(LOG_DEBUG, "Entering function getPageContentQuery");
+static void getPagesContentQuery(pageList* const* pages, int numberOfPages){
+    log_message(LOG_DEBUG, "Entering function getPagesContentQuery");
+
+    char* query = duplicate_Malloc(template_pages_singles_query_start);
+
+    for(int i = 0; i < numberOfPages; i++){
+        char field[256];
+        snprintf(field, sizeof(field), template_pages_singles_query_field, i, pages[i]->id);
+        query = appendToString(query, field);
+    }
 
-    char *modified_query = duplicate_Malloc(template_pages_singles_query); // Make a copy to modify
-    modified_query = replaceWord_Realloc(modified_query, default_page.id, id);
-    wikiApi(modified_query);
-    free(modified_query);
+    query = appendToString(query, template_pages_singles_query_end);
+    wikiApi(query);
+    free(query);
 
-    log_message(LOG_DEBUG, "Exiting function getPageContentQuery");
+    log_message(LOG_DEBUG, "Exiting function getPagesContentQuery");
 }
 
 /**
@@ -133,50 +165,142 @@ static void getPageContentQuery(const char* id){
  * @warning Ensure that `template_list_pages_sortByPath_query` and `template_list_pages_sortByTime_query` are correctly
  *          defined, and that the `wikiApi` function is properly set up to handle the API request.
  */
-static void getListQuery(const char *sort){
-    log_message(LOG_DEBUG, "Entering function getListQuery");
-
+static const char* getListQueryTemplate(const char *sort){
     if(strcmp(sort, "path") == 0 || strcmp(sort, "exact path") == 0){
-        char* temp_query = duplicate_Malloc(template_list_pages_sortByPath_query); // Make a copy to modify
-        wikiApi(temp_query);
-        free(temp_query);
+        return template_list_pages_sortByPath_query;
     }
     else if(strcmp(sort, "time") == 0){
-        char *temp_query = duplicate_Malloc(template_list_pages_sortByTime_query); // Make a copy to modify
+        return template_list_pages_sortByTime_query;
+    }
+
+    log_message(LOG_ERROR, "Error: inappropriate sort type in getListQuery function call");
+    return NULL;
+}
+
+static void getListQuery(const char *sort){
+    log_message(LOG_DEBUG, "Entering function getListQuery");
+
+    const char *template = getListQueryTemplate(sort);
+    if(template){
+        char* temp_query = duplicate_Malloc(template); // Make a copy to modify
         wikiApi(temp_query);
         free(temp_query);
     }
-    else{
-        log_message(LOG_ERROR, "Error: inappropriate sort type in getListQuery function call");
-    }
 
     log_message(LOG_DEBUG, "Exiting function getListQuery");
 }
 
+int addPageListFetch(fetchStage* stage, const char *filterType){
+    const char *template = getListQueryTemplate(filterType);
+
+    return addWikiFetch(stage, template ? template : template_list_pages_sortByPath_query);
+}
+
 pageList* getPage(pageList** head){
     log_message(LOG_DEBUG, "Entering function getPage");
 
-    pageList* current = *head;
-    getPageContentQuery(current->id);
-    log_message(LOG_DEBUG, "%s" ,chunk.response);
-    sscanf(chunk.response, "{ \"id\": %s", current->id);
-    current->title = jsonParserGetStringValue(chunk.response, "\"title\"");
-    current->path = jsonParserGetStringValue(chunk.response, "\"path\"");
-    current->description = jsonParserGetStringValue(chunk.response, "\"description\"");
-    current->content = jsonParserGetStringValue(chunk.response, "\"content\"");
-    current->updatedAt = jsonParserGetStringValue(chunk.response, "\"updatedAt\"");
-    current->createdAt = jsonParserGetStringValue(chunk.response, "\"createdAt\"");
-    current->authorId = jsonParserGetIntValue(chunk.response, "\"authorId\"");
+    (void)getPages(*head, 1);
+
+    log_message(LOG_DEBUG, "Exiting function getPage");
+    return *head;
+}
+
+static void replacePageField(char** field, char* value){
+    free(*field);
+    *field = value;
+}
+
+/**
+ * @brief Populates a page from its part of the response of a query aliasing the `single(id:)` fields.
+ *
+ * @param[in] pageStart Where to look for the page's alias `page<index>` in the response.
+ *
+ * @return char* Where to look for the next page's alias.
+ */
+static char* parsePageResponse(pageList* current, int i, char* pageStart){
+    char alias[32];
+    snprintf(alias, sizeof(alias), "\"page%d\":", i);
+    pageStart = pageStart ? strstr(pageStart, alias) : NULL;
+
+    if(!pageStart || strncmp(pageStart + strlen(alias), "null", strlen("null")) == 0){
+        log_message(LOG_ERROR, "Page %s was not returned by the wiki", current->id);
+        return pageStart;
+    }
+
+    // The fields are only looked for in this page's part of the response
+    snprintf(alias, sizeof(alias), "\"page%d\":", i + 1);
+    char* pageEnd = strstr(pageStart, alias);
+    char endCharacter = '\0';
+    if(pageEnd){
+        endCharacter = *pageEnd;
+        *pageEnd = '\0';
+    }
+
+    replacePageField(&current->title, jsonParserGetStringValue(pageStart, "\"title\""));
+    replacePageField(&current->path, jsonParserGetStringValue(pageStart, "\"path\""));
+    replacePageField(&current->description, jsonParserGetStringValue(pageStart, "\"description\""));
+    replacePageField(&current->content, jsonParserGetStringValue(pageStart, "\"content\""));
+    replacePageField(&current->updatedAt, jsonParserGetStringValue(pageStart, "\"updatedAt\""));
+    replacePageField(&current->createdAt, jsonParserGetStringValue(pageStart, "\"createdAt\""));
+    replacePageField(&current->authorId, jsonParserGetIntValue(pageStart, "\"authorId\""));
     log_message(LOG_DEBUG, "title: %s\n, path: %s\n, description: %s\n, content: %s\n, updatedAt: %s\n", current->title, current->path, current->description, current->content, current->updatedAt);
 
-    freeChunkResponse();
+    if(pageEnd){
+        *pageEnd = endCharacter;
+    }
 
-    log_message(LOG_DEBUG, "Exiting function getPage");
+    return pageEnd;
+}
+
+void parsePagesResponse(pageList* head, int numberOfPages, char* response){
+    log_message(LOG_DEBUG, "Entering function parsePagesResponse");
+
+    pageList* current = head;
+    char* pageStart = response;
+
+    for(int i = 0; i < numberOfPages && current; i++){
+        pageStart = parsePageResponse(current, i, pageStart);
+        current = current->next;
+    }
+
+    log_message(LOG_DEBUG, "Exiting function parsePagesResponse");
+}
+
+pageList* getPages(pageList* head, int numberOfPages){
+    log_message(LOG_DEBUG, "Entering function getPages");
+
+    pageList* current = head;
+    while(current && numberOfPages > 0){
+        // Pages which did not change since they were cached are not fetched
+        pageList* pagesToFetch[WIKI_PAGE_FETCH_BATCH_SIZE];
+        int batchSize = 0;
+        while(current && numberOfPages > 0 && batchSize < WIKI_PAGE_FETCH_BATCH_SIZE){
+            if(!readCachedPageContent(current)){
+                pagesToFetch[batchSize++] = current;
+            }
+
+            current = current->next;
+            numberOfPages--;
+        }
+
+        if(batchSize == 0){
+            continue;
+        }
+
+        getPagesContentQuery(pagesToFetch, batchSize);
+        char* pageStart = chunk.response;
+        for(int i = 0; i < batchSize; i++){
+            pageStart = parsePageResponse(pagesToFetch[i], i, pageStart);
+            storePageContent(pagesToFetch[i]);
+        }
+        freeChunkResponse();
+    }
+
+    log_message(LOG_DEBUG, "Exiting function getPages");
     return current;
 }
 
-// Function to filter and parse the JSON string into a Node linked list
-static pageList* parseJSON(pageList** head, const char* jsonString, const char* filterType, const char* filterCondition) {
+pageList* parseJSON(pageList** head, const char* jsonString, const char* filterType, const char* filterCondition) {
     log_message(LOG_DEBUG, "Entering function parseJSON");
 
     if (strstr(filterCondition, "\\") != NULL) {
@@ -328,6 +452,7 @@ void updatePageContentMutation(pageList* head){
 
     log_message(LOG_DEBUG, "About to update send query: %s\n", temp_query);
     wikiApi(temp_query);
+    countPageWriteMetric(true);
 
     freeChunkResponse();
 
@@ -403,6 +528,7 @@ void createPageMutation(const char* path, const char* content, const char* title
     log_message(LOG_DEBUG, "About to call the create page query %s", temp_query);
 
     wikiApi(temp_query);
+    countPageWriteMetric(true);
 
     free(temp_query);
 
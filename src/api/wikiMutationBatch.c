@@ -0,0 +1,696 @@
+/**
+ * @file wikiMutationBatch.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the batcher which sends many page mutations to the wiki in a single request, and the queue of the
+ *        pages to render.
+ *
+ * @details The mutations are appended to the GraphQL document as they are queued, only the page each alias belongs
+ *          to is kept on the side to report the mutations which failed. A full batch is sealed and sent later along
+ *          with the next ones, at most `WIKI_MUTATION_MAX_CONCURRENT_REQUESTS` at the same time. Renders are kept
+ *          apart in a set of page ids so that a page queued several times during a command is rendered once.
+ */
+
+#define LOG_MODULE LOG_MODULE_WIKI_API
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "apiHelpers.h"
+#include "stringHelpers.h"
+#include "wikiAPI.h"
+#include "wikiMutationBatch.h"
+#include "ERTbot_metrics.h"
+#include "httpTransport.h"
+#include "ERTbot_trace.h"
+#include "commandJournalHelpers.h"
+#include "requirementSnapshotHelpers.h"
+
+typedef enum wikiMutationType {
+    WIKI_MUTATION_UPDATE,
+    WIKI_MUTATION_RENDER,   // only sent by flushPageRenders
+    WIKI_MUTATION_CREATE,
+    WIKI_MUTATION_DELETE
+} wikiMutationType;
+
+static const char* const wikiMutationNames[] = {
+    [WIKI_MUTATION_UPDATE] = "update",
+    [WIKI_MUTATION_RENDER] = "render",
+    [WIKI_MUTATION_CREATE] = "creation",
+    [WIKI_MUTATION_DELETE] = "deletion",
+};
+
+/**
+ * @brief A queued mutation, `page` is the id of the page (or its path for a creation) used to report a failure.
+ *        `checkpoint` is journaled once the wiki applied the mutation, it can be NULL. `snapshotKey` is forgotten
+ *        from `snapshot` if the wiki did not apply it, `snapshot` can be NULL.
+ */
+typedef struct pendingWikiMutation {
+    wikiMutationType type;
+    char *page;
+    char *checkpoint;
+    requirementSnapshot *snapshot;
+    char *snapshotKey;
+    struct pendingWikiMutation *next;
+} pendingWikiMutation;
+
+#define MUTATION_DOCUMENT_START "{\"query\":\"mutation {"
+#define MUTATION_DOCUMENT_END " }\"}"
+#define MUTATION_RESPONSE_RESULT ") { responseResult { succeeded, message } } }"
+
+static char* document = NULL;
+static size_t documentLength = 0;
+static size_t documentCapacity = 0;
+
+static pendingWikiMutation* pendingMutationsHead = NULL;
+static pendingWikiMutation* pendingMutationsTail = NULL;
+static int numberOfPendingMutations = 0;
+
+/**
+ * @brief A full batch waiting to be sent with the other sealed batches, `document` is complete.
+ */
+typedef struct sealedWikiMutationBatch {
+    char *document;
+    pendingWikiMutation *mutations;
+    int numberOfMutations;
+    struct sealedWikiMutationBatch *next;
+} sealedWikiMutationBatch;
+
+static sealedWikiMutationBatch* sealedBatchesHead = NULL;
+static sealedWikiMutationBatch* sealedBatchesTail = NULL;
+static int numberOfSealedBatches = 0;
+
+// Failures of the batches sent before flushWikiMutations was called, reported by its next call
+static int numberOfUnreportedFailures = 0;
+
+// Open addressing set of the ids of the pages to render, twice as large as the queue so that it never fills up
+#define RENDER_SET_SIZE (2 * WIKI_RENDER_QUEUE_MAX_PAGES)
+
+static char* renderSet[RENDER_SET_SIZE];
+static char* pendingRenders[WIKI_RENDER_QUEUE_MAX_PAGES]; // same ids in the order they were queued
+static int numberOfPendingRenders = 0;
+
+/**
+ * @brief Everything queued by a command, set aside by `suspendWikiMutations` while a nested command runs.
+ */
+typedef struct wikiMutationQueue {
+    char* document;
+    size_t documentLength;
+    size_t documentCapacity;
+    pendingWikiMutation* pendingMutationsHead;
+    pendingWikiMutation* pendingMutationsTail;
+    int numberOfPendingMutations;
+    sealedWikiMutationBatch* sealedBatchesHead;
+    sealedWikiMutationBatch* sealedBatchesTail;
+    int numberOfSealedBatches;
+    int numberOfUnreportedFailures;
+    char* renderSet[RENDER_SET_SIZE];
+    char* pendingRenders[WIKI_RENDER_QUEUE_MAX_PAGES];
+    int numberOfPendingRenders;
+} wikiMutationQueue;
+
+static wikiMutationQueue suspendedQueue;
+static bool isQueueSuspended = false;
+
+static void sealPendingMutations();
+
+static void sendSealedBatches();
+
+static bool isPageInSealedBatch(const char *page);
+
+static void appendToDocument(const char *text){
+    size_t length = strlen(text);
+
+    if(documentLength + length + 1 > documentCapacity){
+        size_t newCapacity = documentCapacity ? documentCapacity : 4096;
+        while(documentLength + length + 1 > newCapacity){
+            newCapacity *= 2;
+        }
+
+        char* newDocument = (char*)realloc(document, newCapacity);
+        if(!newDocument){
+            log_message(LOG_ERROR, "Memory allocation error");
+            exit(1);
+        }
+        document = newDocument;
+        documentCapacity = newCapacity;
+    }
+
+    memcpy(document + documentLength, text, length + 1);
+    documentLength += length;
+}
+
+/**
+ * @brief Opens the aliased field of a new mutation, its arguments are then appended by the caller.
+ *
+ * @param[in] argumentsLength Length of the arguments the caller will append, to flush the batch first if they would
+ *            not fit in it.
+ */
+static void beginMutation(wikiMutationType type, const char *page, const char *mutation, size_t argumentsLength){
+    // Sealed batches are sent concurrently, a page they mutate must be done with before it is mutated again
+    if(isPageInSealedBatch(page ? page : "")){
+        sendSealedBatches();
+    }
+
+    if(numberOfPendingMutations > 0 && documentLength + argumentsLength + 256 > WIKI_MUTATION_BATCH_MAX_BYTES){
+        sealPendingMutations();
+    }
+
+    if(numberOfPendingMutations == 0){
+        documentLength = 0;
+        appendToDocument(MUTATION_DOCUMENT_START);
+    }
+
+    char field[64];
+    snprintf(field, sizeof(field), " m%d: pages { %s(", numberOfPendingMutations, mutation);
+    appendToDocument(field);
+
+    pendingWikiMutation* pendingMutation = (pendingWikiMutation*)malloc(sizeof(pendingWikiMutation));
+    if(!pendingMutation){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+    pendingMutation->type = type;
+    pendingMutation->page = duplicate_Malloc(page ? page : "");
+    pendingMutation->checkpoint = NULL;
+    pendingMutation->snapshot = NULL;
+    pendingMutation->snapshotKey = NULL;
+    pendingMutation->next = NULL;
+
+    if(pendingMutationsTail){
+        pendingMutationsTail->next = pendingMutation;
+    }
+    else{
+        pendingMutationsHead = pendingMutation;
+    }
+    pendingMutationsTail = pendingMutation;
+}
+
+static void endMutation(){
+    appendToDocument(MUTATION_RESPONSE_RESULT);
+    numberOfPendingMutations++;
+
+    if(numberOfPendingMutations >= WIKI_MUTATION_BATCH_MAX_MUTATIONS){
+        sealPendingMutations();
+    }
+}
+
+void queuePageUpdate(const pageList* page, const char *checkpoint, requirementSnapshot* snapshot, const char *snapshotKey){
+    log_message(LOG_DEBUG, "Entering function queuePageUpdate");
+
+    beginMutation(WIKI_MUTATION_UPDATE, page->id, "update", strlen(page->content));
+    pendingMutationsTail->checkpoint = checkpoint ? duplicate_Malloc(checkpoint) : NULL;
+    if(snapshot){
+        pendingMutationsTail->snapshot = snapshot;
+        pendingMutationsTail->snapshotKey = duplicate_Malloc(snapshotKey);
+    }
+    appendToDocument("id: ");
+    appendToDocument(page->id);
+    appendToDocument(", content: \\\"");
+    appendToDocument(page->content);
+    appendToDocument("\\\", isPublished: true");
+    endMutation();
+
+    log_message(LOG_DEBUG, "Exiting function queuePageUpdate");
+}
+
+#ifndef TESTING
+static unsigned long hashPageId(const char *id){
+    unsigned long hash = 5381;
+    for(const char *c = id; *c; c++){
+        hash = hash * 33 + (unsigned char)*c;
+    }
+
+    return hash;
+}
+#endif
+
+void queuePageRender(const pageList* page){
+#ifndef TESTING
+    unsigned long slot = hashPageId(page->id) % RENDER_SET_SIZE;
+    while(renderSet[slot]){
+        if(strcmp(renderSet[slot], page->id) == 0){
+            return;
+        }
+        slot = (slot + 1) % RENDER_SET_SIZE;
+    }
+
+    char* id = duplicate_Malloc(page->id);
+    renderSet[slot] = id;
+    pendingRenders[numberOfPendingRenders++] = id;
+
+    if(numberOfPendingRenders >= WIKI_RENDER_QUEUE_MAX_PAGES){
+        (void)flushPageRenders();
+    }
+#else
+    (void)page;
+#endif
+}
+
+void queuePageCreation(const char* path, const char* content, const char* title){
+    log_message(LOG_DEBUG, "Entering function queuePageCreation");
+
+    beginMutation(WIKI_MUTATION_CREATE, path, "create", strlen(content) + strlen(path) + strlen(title));
+    appendToDocument("content: \\\"");
+    appendToDocument(content);
+    appendToDocument("\\\", description: \\\"\\\", editor: \\\"markdown\\\", isPublished: true, isPrivate: false, locale: \\\"en\\\", path: \\\"");
+    appendToDocument(path);
+    appendToDocument("\\\", tags: [], title: \\\"");
+    appendToDocument(title);
+    appendToDocument("\\\"");
+    endMutation();
+
+    log_message(LOG_DEBUG, "Exiting function queuePageCreation");
+}
+
+void queuePageDeletion(const char* id){
+    beginMutation(WIKI_MUTATION_DELETE, id, "delete", 0);
+    appendToDocument("id: ");
+    appendToDocument(id);
+    endMutation();
+}
+
+/**
+ * @brief Finds in the response whether the mutation aliased `m<index>` succeeded, and logs it if it did not.
+ *
+ * @param[in,out] cursor Start of the mutation's response in the response of the batch, moved to the next one.
+ *
+ * @return bool true if the wiki applied the mutation.
+ */
+static bool checkMutationResult(char** cursor, int index, wikiMutationType type, const char *page){
+    char alias[32];
+    snprintf(alias, sizeof(alias), "\"m%d\":", index);
+
+    char* result = *cursor ? strstr(*cursor, alias) : NULL;
+    if(!result){
+        log_message(LOG_ERROR, "Wiki %s of page %s failed: no result in the response", wikiMutationNames[type], page);
+        return false;
+    }
+
+    // Only this mutation's part of the response is looked at
+    snprintf(alias, sizeof(alias), "\"m%d\":", index + 1);
+    char* resultEnd = strstr(result, alias);
+    if(resultEnd){
+        *resultEnd = '\0';
+    }
+
+    bool succeeded = strstr(result, "\"succeeded\":true") || strstr(result, "\"succeeded\": true");
+    if(!succeeded){
+        char* message = strstr(result, "\"message\"") ? jsonParserGetStringValue(result, "\"message\"") : NULL;
+        log_message(LOG_ERROR, "Wiki %s of page %s failed: %s", wikiMutationNames[type], page, message ? message : "no message");
+        free(message);
+    }
+
+    if(resultEnd){
+        *resultEnd = '"';
+    }
+    *cursor = resultEnd;
+
+    return succeeded;
+}
+
+static void freePendingMutations(pendingWikiMutation* mutation){
+    while(mutation){
+        pendingWikiMutation* next = mutation->next;
+        free(mutation->page);
+        free(mutation->checkpoint);
+        free(mutation->snapshotKey);
+        free(mutation);
+        mutation = next;
+    }
+}
+
+/**
+ * @brief Checks the result of every mutation of a sent batch.
+ *
+ * @return int Number of mutations the wiki did not apply.
+ */
+static int checkBatchResults(const httpRequest* request, const sealedWikiMutationBatch* batch){
+    if(request->result != CURLE_OK || request->httpCode != 200){
+        log_message(LOG_ERROR, "Wiki batch of %d mutations failed: %s, HTTP status code %ld", batch->numberOfMutations,
+                    curl_easy_strerror(request->result), request->httpCode);
+        for(const pendingWikiMutation* mutation = batch->mutations; mutation; mutation = mutation->next){
+            if(mutation->snapshot){
+                forgetRequirement(mutation->snapshot, mutation->snapshotKey);
+            }
+        }
+        return batch->numberOfMutations;
+    }
+
+    int numberOfFailedMutations = 0;
+    char* cursor = request->response.response;
+    const pendingWikiMutation* mutation = batch->mutations;
+    for(int i = 0; i < batch->numberOfMutations && mutation; i++, mutation = mutation->next){
+        bool succeeded = checkMutationResult(&cursor, i, mutation->type, mutation->page);
+        if(!succeeded){
+            numberOfFailedMutations++;
+        }
+
+        if(!succeeded && mutation->snapshot){
+            forgetRequirement(mutation->snapshot, mutation->snapshotKey);
+        }
+
+        if(succeeded && (mutation->type == WIKI_MUTATION_UPDATE || mutation->type == WIKI_MUTATION_CREATE)){
+            countPageWriteMetric(true);
+        }
+
+        if(succeeded && mutation->checkpoint){
+            journalCheckpoint(mutation->checkpoint);
+        }
+    }
+
+    return numberOfFailedMutations;
+}
+
+/**
+ * @brief A batch of updates only can be sent again after a failure, its pages end up with the same content.
+ */
+static httpIdempotency getBatchIdempotency(const sealedWikiMutationBatch* batch){
+    for(const pendingWikiMutation* mutation = batch->mutations; mutation; mutation = mutation->next){
+        if(mutation->type != WIKI_MUTATION_UPDATE){
+            return HTTP_IDEMPOTENCY_NOT_IDEMPOTENT;
+        }
+    }
+
+    return HTTP_IDEMPOTENCY_IDEMPOTENT;
+}
+
+static void sendSealedBatches(){
+    if(numberOfSealedBatches == 0){
+        return;
+    }
+
+    log_message(LOG_DEBUG, "Entering function sendSealedBatches");
+    log_message(LOG_DEBUG, "Sending %d wiki mutation batches", numberOfSealedBatches);
+
+    beginTraceSpan(TRACE_CATEGORY_API, "sendSealedBatches", NULL);
+
+    int numberOfRequests = numberOfSealedBatches;
+    httpRequest* requests = (httpRequest*)calloc((size_t)numberOfRequests, sizeof(httpRequest));
+    struct curl_slist** headers = (struct curl_slist**)calloc((size_t)numberOfRequests, sizeof(struct curl_slist*));
+    if(!requests || !headers){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    sealedWikiMutationBatch* batch = sealedBatchesHead;
+    for(int i = 0; i < numberOfRequests; i++, batch = batch->next){
+        requests[i].endpoint = NETWORK_ENDPOINT_WIKI_MUTATION_BATCH;
+        requests[i].idempotency = getBatchIdempotency(batch);
+        requests[i].method = "POST";
+        requests[i].url = getApiUrl(API_SERVICE_WIKI);
+        requests[i].body = batch->document;
+        requests[i].curl = createWikiRequest(batch->document, &requests[i].response, &headers[i]);
+        if(!requests[i].curl){
+            log_message(LOG_ERROR, "Failed to initialize libcurl");
+            exit(1);
+        }
+    }
+
+    performHttpRequests(requests, numberOfRequests, WIKI_MUTATION_MAX_CONCURRENT_REQUESTS);
+
+    batch = sealedBatchesHead;
+    for(int i = 0; i < numberOfRequests; i++){
+        numberOfUnreportedFailures += checkBatchResults(&requests[i], batch);
+
+        curl_easy_cleanup(requests[i].curl);
+        curl_slist_free_all(headers[i]);
+        free(requests[i].response.response);
+
+        sealedWikiMutationBatch* sentBatch = batch;
+        batch = batch->next;
+        freePendingMutations(sentBatch->mutations);
+        free(sentBatch->document);
+        free(sentBatch);
+    }
+
+    curl_global_cleanup();
+
+    free(requests);
+    free(headers);
+
+    sealedBatchesHead = NULL;
+    sealedBatchesTail = NULL;
+    numberOfSealedBatches = 0;
+
+    endTraceSpan();
+
+    log_message(LOG_DEBUG, "Exiting function sendSealedBatches");
+}
+
+static void sealPendingMutations(){
+    if(numberOfPendingMutations == 0){
+        return;
+    }
+
+    log_message(LOG_DEBUG, "Sealing a batch of %d wiki mutations (%zu bytes)", numberOfPendingMutations, documentLength);
+
+    appendToDocument(MUTATION_DOCUMENT_END);
+
+    sealedWikiMutationBatch* batch = (sealedWikiMutationBatch*)malloc(sizeof(sealedWikiMutationBatch));
+    if(!batch){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    // The batch takes the document over, the next one starts in a new buffer
+    batch->document = document;
+    batch->mutations = pendingMutationsHead;
+    batch->numberOfMutations = numberOfPendingMutations;
+    batch->next = NULL;
+
+    document = NULL;
+    documentLength = 0;
+    documentCapacity = 0;
+
+    pendingMutationsHead = NULL;
+    pendingMutationsTail = NULL;
+    numberOfPendingMutations = 0;
+
+    if(sealedBatchesTail){
+        sealedBatchesTail->next = batch;
+    }
+    else{
+        sealedBatchesHead = batch;
+    }
+    sealedBatchesTail = batch;
+    numberOfSealedBatches++;
+
+    if(numberOfSealedBatches >= WIKI_MUTATION_MAX_CONCURRENT_REQUESTS){
+        sendSealedBatches();
+    }
+}
+
+static bool isPageInSealedBatch(const char *page){
+    for(const sealedWikiMutationBatch* batch = sealedBatchesHead; batch; batch = batch->next){
+        for(const pendingWikiMutation* mutation = batch->mutations; mutation; mutation = mutation->next){
+            if(strcmp(mutation->page, page) == 0){
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void countSkippedWikiMutation(requirementSnapshot* snapshot, const char *snapshotKey){
+    if(snapshot){
+        forgetRequirement(snapshot, snapshotKey);
+    }
+
+    numberOfUnreportedFailures++;
+}
+
+int flushWikiMutations(){
+    if(numberOfPendingMutations == 0 && numberOfSealedBatches == 0 && numberOfUnreportedFailures == 0){
+        return 0;
+    }
+
+    log_message(LOG_DEBUG, "Entering function flushWikiMutations");
+
+    sealPendingMutations();
+    sendSealedBatches();
+
+    int numberOfFailedMutations = numberOfUnreportedFailures;
+    numberOfUnreportedFailures = 0;
+
+    log_message(LOG_DEBUG, "Exiting function flushWikiMutations");
+    return numberOfFailedMutations;
+}
+
+/**
+ * @brief Builds the document rendering the pages `pendingRenders[first]` to `pendingRenders[first + numberOfPages - 1]`.
+ */
+static char* buildRenderDocument(int first, int numberOfPages){
+    documentLength = 0;
+    appendToDocument(MUTATION_DOCUMENT_START);
+
+    for(int i = 0; i < numberOfPages; i++){
+        char field[64];
+        snprintf(field, sizeof(field), " m%d: pages { render(id: ", i);
+        appendToDocument(field);
+        appendToDocument(pendingRenders[first + i]);
+        appendToDocument(MUTATION_RESPONSE_RESULT);
+    }
+
+    appendToDocument(MUTATION_DOCUMENT_END);
+
+    char* renderDocument = duplicate_Malloc(document);
+    documentLength = 0;
+    return renderDocument;
+}
+
+int flushPageRenders(){
+    // The pages must hold their new content before they are rendered
+    int numberOfFailedRenders = flushWikiMutations();
+
+    if(numberOfPendingRenders == 0){
+        return numberOfFailedRenders;
+    }
+
+    log_message(LOG_DEBUG, "Entering function flushPageRenders");
+    log_message(LOG_DEBUG, "Rendering %d wiki pages", numberOfPendingRenders);
+
+    beginTraceSpan(TRACE_CATEGORY_API, "flushPageRenders", NULL);
+
+    int numberOfRequests = (numberOfPendingRenders + WIKI_RENDER_BATCH_SIZE - 1) / WIKI_RENDER_BATCH_SIZE;
+    httpRequest* requests = (httpRequest*)calloc((size_t)numberOfRequests, sizeof(httpRequest));
+    struct curl_slist** headers = (struct curl_slist**)calloc((size_t)numberOfRequests, sizeof(struct curl_slist*));
+    if(!requests || !headers){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    for(int i = 0; i < numberOfRequests; i++){
+        int first = i * WIKI_RENDER_BATCH_SIZE;
+        int numberOfPages = numberOfPendingRenders - first < WIKI_RENDER_BATCH_SIZE ? numberOfPendingRenders - first : WIKI_RENDER_BATCH_SIZE;
+
+        requests[i].endpoint = NETWORK_ENDPOINT_WIKI_RENDER_PAGE;
+        requests[i].method = "POST";
+        requests[i].url = getApiUrl(API_SERVICE_WIKI);
+        requests[i].body = buildRenderDocument(first, numberOfPages);
+        requests[i].curl = createWikiRequest(requests[i].body, &requests[i].response, &headers[i]);
+        if(!requests[i].curl){
+            log_message(LOG_ERROR, "Failed to initialize libcurl");
+            exit(1);
+        }
+    }
+
+    performHttpRequests(requests, numberOfRequests, WIKI_RENDER_MAX_CONCURRENT_REQUESTS);
+
+    for(int i = 0; i < numberOfRequests; i++){
+        int first = i * WIKI_RENDER_BATCH_SIZE;
+        int numberOfPages = numberOfPendingRenders - first < WIKI_RENDER_BATCH_SIZE ? numberOfPendingRenders - first : WIKI_RENDER_BATCH_SIZE;
+
+        if(requests[i].result != CURLE_OK || requests[i].httpCode != 200){
+            log_message(LOG_ERROR, "Wiki render of %d pages failed: %s, HTTP status code %ld", numberOfPages,
+                        curl_easy_strerror(requests[i].result), requests[i].httpCode);
+            numberOfFailedRenders += numberOfPages;
+        }
+        else{
+            char* cursor = requests[i].response.response;
+            for(int j = 0; j < numberOfPages; j++){
+                if(!checkMutationResult(&cursor, j, WIKI_MUTATION_RENDER, pendingRenders[first + j])){
+                    numberOfFailedRenders++;
+                }
+            }
+        }
+
+        curl_easy_cleanup(requests[i].curl);
+        curl_slist_free_all(headers[i]);
+        free((char*)requests[i].body);
+        free(requests[i].response.response);
+    }
+
+    curl_global_cleanup();
+
+    free(requests);
+    free(headers);
+
+    for(int i = 0; i < numberOfPendingRenders; i++){
+        free(pendingRenders[i]);
+    }
+    memset(renderSet, 0, sizeof(renderSet));
+    numberOfPendingRenders = 0;
+
+    endTraceSpan();
+
+    log_message(LOG_DEBUG, "Exiting function flushPageRenders");
+    return numberOfFailedRenders;
+}
+
+void suspendWikiMutations(){
+    if(isQueueSuspended){
+        log_message(LOG_ERROR, "suspendWikiMutations: the wiki mutations of a command are already suspended");
+        return;
+    }
+
+    log_message(LOG_DEBUG, "Suspending %d wiki mutations, %d sealed batches and %d renders", numberOfPendingMutations,
+                numberOfSealedBatches, numberOfPendingRenders);
+
+    suspendedQueue.document = document;
+    suspendedQueue.documentLength = documentLength;
+    suspendedQueue.documentCapacity = documentCapacity;
+    suspendedQueue.pendingMutationsHead = pendingMutationsHead;
+    suspendedQueue.pendingMutationsTail = pendingMutationsTail;
+    suspendedQueue.numberOfPendingMutations = numberOfPendingMutations;
+    suspendedQueue.sealedBatchesHead = sealedBatchesHead;
+    suspendedQueue.sealedBatchesTail = sealedBatchesTail;
+    suspendedQueue.numberOfSealedBatches = numberOfSealedBatches;
+    suspendedQueue.numberOfUnreportedFailures = numberOfUnreportedFailures;
+    memcpy(suspendedQueue.renderSet, renderSet, sizeof(renderSet));
+    memcpy(suspendedQueue.pendingRenders, pendingRenders, sizeof(pendingRenders));
+    suspendedQueue.numberOfPendingRenders = numberOfPendingRenders;
+    isQueueSuspended = true;
+
+    document = NULL;
+    documentLength = 0;
+    documentCapacity = 0;
+    pendingMutationsHead = NULL;
+    pendingMutationsTail = NULL;
+    numberOfPendingMutations = 0;
+    sealedBatchesHead = NULL;
+    sealedBatchesTail = NULL;
+    numberOfSealedBatches = 0;
+    numberOfUnreportedFailures = 0;
+    memset(renderSet, 0, sizeof(renderSet));
+    numberOfPendingRenders = 0;
+}
+
+void resumeWikiMutations(){
+    if(!isQueueSuspended){
+        log_message(LOG_ERROR, "resumeWikiMutations: no wiki mutations are suspended");
+        return;
+    }
+
+    // Whatever the nested commands left queued is theirs, it is neither resumed with nor reported to the command
+    int numberOfFailedMutations = flushPageRenders();
+    if(numberOfFailedMutations != 0){
+        log_message(LOG_ERROR, "%d wiki mutations of the nested commands failed", numberOfFailedMutations);
+    }
+    free(document);
+
+    document = suspendedQueue.document;
+    documentLength = suspendedQueue.documentLength;
+    documentCapacity = suspendedQueue.documentCapacity;
+    pendingMutationsHead = suspendedQueue.pendingMutationsHead;
+    pendingMutationsTail = suspendedQueue.pendingMutationsTail;
+    numberOfPendingMutations = suspendedQueue.numberOfPendingMutations;
+    sealedBatchesHead = suspendedQueue.sealedBatchesHead;
+    sealedBatchesTail = suspendedQueue.sealedBatchesTail;
+    numberOfSealedBatches = suspendedQueue.numberOfSealedBatches;
+    numberOfUnreportedFailures = suspendedQueue.numberOfUnreportedFailures;
+    memcpy(renderSet, suspendedQueue.renderSet, sizeof(renderSet));
+    memcpy(pendingRenders, suspendedQueue.pendingRenders, sizeof(pendingRenders));
+    numberOfPendingRenders = suspendedQueue.numberOfPendingRenders;
+    isQueueSuspended = false;
+
+    log_message(LOG_DEBUG, "Resumed %d wiki mutations, %d sealed batches and %d renders", numberOfPendingMutations,
+                numberOfSealedBatches, numberOfPendingRenders);
+}
@@ -0,0 +1,438 @@
+/**
+ * @file wikiPageCache.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the on-disk cache of the content of wiki pages, keyed by page id and `updatedAt`.
+ *
+ * @details The cache is a single append-only data file: a text header followed by one record per stored page, a line
+ *          with the page id, its `updatedAt` and the length of the content, then the raw content. Storing a newer
+ *          version of a page appends a record, the index kept in memory points to the last record of every page.
+ *          Contents are read from a read-only mapping of the file, so only the index is loaded when the bot starts.
+ */
+
+#define LOG_MODULE LOG_MODULE_WIKI_API
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "stringHelpers.h"
+#include "wikiPageCache.h"
+
+#define PAGE_CACHE_HEADER "ERTBOT_PAGE_CACHE 1\n"
+
+typedef struct cachedPage {
+    char *id;
+    char *updatedAt;
+    size_t offset;          // of the content in the data file
+    size_t length;
+    size_t recordLength;    // of the whole record, counted in liveBytes
+    struct cachedPage *next;
+} cachedPage;
+
+static pthread_mutex_t pageCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int cacheFile = -1;
+static char* cachePath = NULL;
+static const char* mapping = NULL;
+static size_t mappedBytes = 0;
+static size_t fileBytes = 0;
+static size_t liveBytes = 0;
+
+static cachedPage** buckets = NULL;
+static size_t numberOfBuckets = 0;
+static pageCacheStatistics statistics;
+
+static unsigned long hashPageId(const char *id){
+    unsigned long hash = 5381;
+    for(const char *c = id; *c; c++){
+        hash = hash * 33 + (unsigned char)*c;
+    }
+
+    return hash;
+}
+
+static cachedPage* findCachedPage(const char *id){
+    if(numberOfBuckets == 0){
+        return NULL;
+    }
+
+    cachedPage* current = buckets[hashPageId(id) % numberOfBuckets];
+    while(current && strcmp(current->id, id) != 0){
+        current = current->next;
+    }
+
+    return current;
+}
+
+static void growIndex(){
+    size_t newNumberOfBuckets = numberOfBuckets ? 2 * numberOfBuckets : 1024;
+    cachedPage** newBuckets = (cachedPage**)calloc(newNumberOfBuckets, sizeof(cachedPage*));
+    if(!newBuckets){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    for(size_t i = 0; i < numberOfBuckets; i++){
+        cachedPage* current = buckets[i];
+        while(current){
+            cachedPage* next = current->next;
+            size_t bucket = hashPageId(current->id) % newNumberOfBuckets;
+            current->next = newBuckets[bucket];
+            newBuckets[bucket] = current;
+            current = next;
+        }
+    }
+
+    free(buckets);
+    buckets = newBuckets;
+    numberOfBuckets = newNumberOfBuckets;
+}
+
+/**
+ * @brief Points the index entry of a page to a record, replacing the record it pointed to.
+ */
+static void indexRecord(const char *id, const char *updatedAt, size_t offset, size_t length, size_t recordLength){
+    cachedPage* page = findCachedPage(id);
+
+    if(page){
+        liveBytes -= page->recordLength;
+        free(page->updatedAt);
+    }
+    else{
+        if(statistics.cachedPages >= 2 * numberOfBuckets){
+            growIndex();
+        }
+
+        page = (cachedPage*)malloc(sizeof(cachedPage));
+        if(!page){
+            log_message(LOG_ERROR, "Memory allocation error");
+            exit(1);
+        }
+        page->id = duplicate_Malloc(id);
+
+        size_t bucket = hashPageId(id) % numberOfBuckets;
+        page->next = buckets[bucket];
+        buckets[bucket] = page;
+        statistics.cachedPages++;
+    }
+
+    page->updatedAt = duplicate_Malloc(updatedAt);
+    page->offset = offset;
+    page->length = length;
+    page->recordLength = recordLength;
+    liveBytes += recordLength;
+}
+
+static void freeIndex(){
+    for(size_t i = 0; i < numberOfBuckets; i++){
+        cachedPage* current = buckets[i];
+        while(current){
+            cachedPage* next = current->next;
+            free(current->id);
+            free(current->updatedAt);
+            free(current);
+            current = next;
+        }
+    }
+
+    free(buckets);
+    buckets = NULL;
+    numberOfBuckets = 0;
+    liveBytes = 0;
+    statistics.cachedPages = 0;
+}
+
+/**
+ * @brief Maps the whole data file again if records were appended since it was last mapped.
+ */
+static bool mapCacheFile(){
+    if(mapping && mappedBytes == fileBytes){
+        return true;
+    }
+
+    if(mapping){
+        munmap((void*)mapping, mappedBytes);
+        mapping = NULL;
+        mappedBytes = 0;
+    }
+
+    void* newMapping = mmap(NULL, fileBytes, PROT_READ, MAP_SHARED, cacheFile, 0);
+    if(newMapping == MAP_FAILED){
+        log_message(LOG_ERROR, "Could not map page cache %s", cachePath);
+        return false;
+    }
+
+    mapping = (const char*)newMapping;
+    mappedBytes = fileBytes;
+    return true;
+}
+
+/**
+ * @brief Builds the index from the records of the data file, and drops a last record cut short by a crash.
+ */
+static int loadIndex(){
+    size_t headerLength = strlen(PAGE_CACHE_HEADER);
+
+    if(fileBytes == 0){
+        if(write(cacheFile, PAGE_CACHE_HEADER, headerLength) != (ssize_t)headerLength){
+            log_message(LOG_ERROR, "Could not write page cache %s", cachePath);
+            return 1;
+        }
+        fileBytes = headerLength;
+    }
+
+    if(!mapCacheFile()){
+        return 1;
+    }
+
+    if(fileBytes < headerLength || memcmp(mapping, PAGE_CACHE_HEADER, headerLength) != 0){
+        log_message(LOG_ERROR, "%s is not a page cache", cachePath);
+        return 1;
+    }
+
+    size_t position = headerLength;
+    while(position < fileBytes){
+        const char* lineEnd = memchr(mapping + position, '\n', fileBytes - position);
+        if(!lineEnd || lineEnd - (mapping + position) >= 256){
+            break;
+        }
+
+        char line[256];
+        size_t lineLength = (size_t)(lineEnd - (mapping + position));
+        memcpy(line, mapping + position, lineLength);
+        line[lineLength] = '\0';
+
+        char id[64];
+        char updatedAt[64];
+        size_t length;
+        if(sscanf(line, "%63s %63s %zu", id, updatedAt, &length) != 3){
+            break;
+        }
+
+        size_t offset = position + lineLength + 1;
+        if(offset + length + 1 > fileBytes || mapping[offset + length] != '\n'){
+            break;
+        }
+
+        indexRecord(id, updatedAt, offset, length, lineLength + 1 + length + 1);
+        position = offset + length + 1;
+    }
+
+    if(position < fileBytes){
+        log_message(LOG_INFO, "Dropping the last %zu bytes of page cache %s", fileBytes - position, cachePath);
+        if(ftruncate(cacheFile, (off_t)position) != 0){
+            log_message(LOG_ERROR, "Could not truncate page cache %s", cachePath);
+            return 1;
+        }
+        fileBytes = position;
+    }
+
+    return 0;
+}
+
+static void closePageCacheLocked(){
+    if(mapping){
+        munmap((void*)mapping, mappedBytes);
+    }
+    if(cacheFile >= 0){
+        close(cacheFile);
+    }
+
+    mapping = NULL;
+    mappedBytes = 0;
+    fileBytes = 0;
+    cacheFile = -1;
+
+    freeIndex();
+}
+
+static int openPageCacheLocked(const char *path){
+    closePageCacheLocked();
+
+    if(path != cachePath){
+        free(cachePath);
+        cachePath = duplicate_Malloc(path);
+    }
+
+    cacheFile = open(cachePath, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if(cacheFile < 0){
+        log_message(LOG_ERROR, "Could not open page cache %s", cachePath);
+        return 1;
+    }
+
+    struct stat fileStatus;
+    if(fstat(cacheFile, &fileStatus) != 0){
+        log_message(LOG_ERROR, "Could not read page cache %s", cachePath);
+        closePageCacheLocked();
+        return 1;
+    }
+    fileBytes = (size_t)fileStatus.st_size;
+
+    if(loadIndex() != 0){
+        closePageCacheLocked();
+        return 1;
+    }
+
+    statistics.fileBytes = fileBytes;
+    return 0;
+}
+
+/**
+ * @brief Rewrites the data file with only the last record of every page, once stale records take most of it.
+ */
+static int compactPageCache(){
+    size_t headerLength = strlen(PAGE_CACHE_HEADER);
+    if(fileBytes < WIKI_PAGE_CACHE_COMPACTION_MIN_BYTES || 2 * (liveBytes + headerLength) > fileBytes){
+        return 0;
+    }
+
+    log_message(LOG_INFO, "Compacting page cache %s, %zu of its %zu bytes are up to date", cachePath, liveBytes, fileBytes);
+
+    char* temporaryPath = createCombinedString(cachePath, ".compacting");
+    FILE* file = fopen(temporaryPath, "wb");
+    if(!file){
+        log_message(LOG_ERROR, "Could not create %s", temporaryPath);
+        free(temporaryPath);
+        return 1;
+    }
+
+    bool succeeded = fputs(PAGE_CACHE_HEADER, file) >= 0;
+    for(size_t i = 0; i < numberOfBuckets && succeeded; i++){
+        for(const cachedPage* page = buckets[i]; page && succeeded; page = page->next){
+            succeeded = fprintf(file, "%s %s %zu\n", page->id, page->updatedAt, page->length) > 0 &&
+                        fwrite(mapping + page->offset, 1, page->length, file) == page->length &&
+                        fputc('\n', file) != EOF;
+        }
+    }
+
+    succeeded = fclose(file) == 0 && succeeded;
+    succeeded = succeeded && rename(temporaryPath, cachePath) == 0;
+    if(!succeeded){
+        log_message(LOG_ERROR, "Could not compact page cache %s", cachePath);
+        remove(temporaryPath);
+        free(temporaryPath);
+        return 1;
+    }
+
+    free(temporaryPath);
+    return openPageCacheLocked(cachePath);
+}
+
+int openPageCache(const char *path){
+    log_message(LOG_DEBUG, "Entering function openPageCache");
+
+    pthread_mutex_lock(&pageCacheMutex);
+    memset(&statistics, 0, sizeof(statistics));
+    int result = openPageCacheLocked(path);
+    if(result == 0){
+        // The cache stays usable as it is if it cannot be compacted
+        (void)compactPageCache();
+        statistics.fileBytes = fileBytes;
+    }
+    pthread_mutex_unlock(&pageCacheMutex);
+
+    log_message(LOG_DEBUG, "Exiting function openPageCache");
+    return result;
+}
+
+void closePageCache(){
+    pthread_mutex_lock(&pageCacheMutex);
+    closePageCacheLocked();
+    pthread_mutex_unlock(&pageCacheMutex);
+}
+
+bool readCachedPageContent(pageList* page){
+    if(!page->id || !page->updatedAt){
+        return false;
+    }
+
+    pthread_mutex_lock(&pageCacheMutex);
+
+    bool isCached = false;
+    const cachedPage* cached = cacheFile >= 0 ? findCachedPage(page->id) : NULL;
+    if(cached && strcmp(cached->updatedAt, page->updatedAt) == 0 && mapCacheFile()){
+        char* content = (char*)malloc(cached->length + 1);
+        if(!content){
+            log_message(LOG_ERROR, "Memory allocation error");
+            exit(1);
+        }
+        memcpy(content, mapping + cached->offset, cached->length);
+        content[cached->length] = '\0';
+
+        free(page->content);
+        page->content = content;
+        isCached = true;
+    }
+
+    if(cacheFile >= 0){
+        if(isCached){
+            statistics.hits++;
+        }
+        else{
+            statistics.misses++;
+        }
+    }
+
+    pthread_mutex_unlock(&pageCacheMutex);
+    return isCached;
+}
+
+void storePageContent(const pageList* page){
+    if(!page->id || !page->updatedAt || !page->content){
+        return;
+    }
+
+    pthread_mutex_lock(&pageCacheMutex);
+
+    const cachedPage* cached = cacheFile >= 0 ? findCachedPage(page->id) : NULL;
+    if(cacheFile < 0 || (cached && strcmp(cached->updatedAt, page->updatedAt) == 0)){
+        pthread_mutex_unlock(&pageCacheMutex);
+        return;
+    }
+
+    size_t length = strlen(page->content);
+    char recordHeader[256];
+    int recordHeaderLength = snprintf(recordHeader, sizeof(recordHeader), "%s %s %zu\n", page->id, page->updatedAt, length);
+    if(recordHeaderLength <= 0 || (size_t)recordHeaderLength >= sizeof(recordHeader)){
+        pthread_mutex_unlock(&pageCacheMutex);
+        return;
+    }
+
+    struct iovec record[] = {
+        {.iov_base = recordHeader, .iov_len = (size_t)recordHeaderLength},
+        {.iov_base = page->content, .iov_len = length},
+        {.iov_base = "\n", .iov_len = 1},
+    };
+    size_t recordLength = (size_t)recordHeaderLength + length + 1;
+
+    if(writev(cacheFile, record, 3) != (ssize_t)recordLength){
+        // A record written in part would be dropped when the cache is opened again, it is dropped now instead
+        log_message(LOG_ERROR, "Could not write page %s to page cache %s", page->id, cachePath);
+        if(ftruncate(cacheFile, (off_t)fileBytes) != 0){
+            log_message(LOG_ERROR, "Could not truncate page cache %s, closing it", cachePath);
+            closePageCacheLocked();
+        }
+        pthread_mutex_unlock(&pageCacheMutex);
+        return;
+    }
+
+    indexRecord(page->id, page->updatedAt, fileBytes + (size_t)recordHeaderLength, length, recordLength);
+    fileBytes += recordLength;
+    statistics.fileBytes = fileBytes;
+
+    pthread_mutex_unlock(&pageCacheMutex);
+}
+
+void getPageCacheStatistics(pageCacheStatistics* result){
+    pthread_mutex_lock(&pageCacheMutex);
+    *result = statistics;
+    pthread_mutex_unlock(&pageCacheMutex);
+}
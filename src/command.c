@@ -4,6 +4,7 @@
  * @brief Contains functions used to handle commands.
  */
 #include <stdio.h>
+#include <stdbool.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
@@ -12,16 +13,27 @@
 #include "sheetAPI.h"
 #include "ERTbot_common.h"
 #include "ERTbot_features.h"
+#include "ERTbot_commandRegistry.h"
 #include "pageListHelpers.h"
 #include "timeHelpers.h"
 #include "ERTbot_command.h"
 #include "stringHelpers.h"
+#include "commandQueueHelpers.h"
+#include "requirementsHelpers.h"
+#include "apiHelpers.h"
+#include "ERTbot_config.h"
+#include "ERTbot_trace.h"
+#include "ERTbot_metrics.h"
+#include "ERTbot_allocationProfiler.h"
+#include "wikiMutationBatch.h"
+#include "requirementSnapshotHelpers.h"
+#include "commandJournalHelpers.h"
+#include "httpRetry.h"
+#include "circuitBreaker.h"
 
 
 #define MAX_ARGUMENTS 10
 
-static void setCommandArgument(char** dest, const char* src, const char* argName);
-
 static PeriodicCommand* addPeriodicCommand(PeriodicCommand** headOfPeriodicCommands_Global, command* command, int period) {
     log_message(LOG_DEBUG, "Entering function addPeriodicCommand");
 
@@ -50,135 +62,7 @@ static PeriodicCommand* addPeriodicCommand(PeriodicCommand** headOfPeriodicComma
     return *headOfPeriodicCommands_Global;
 }
 
-static PeriodicCommand* addDailyCommand(PeriodicCommand** headOfPeriodicCommands_Global, command* command, const char* time_str) {
-    log_message(LOG_DEBUG, "Entering function scheduleDailyCommand");
-
-    int hours;
-    int minutes;
-    sscanf(time_str, "%d:%d", &hours, &minutes); // Parse the time string
-
-
-    PeriodicCommand* newCommand = (PeriodicCommand*)malloc(sizeof(PeriodicCommand));
-    newCommand->command = command;  // Duplicate the command string
-    newCommand->period = 86400;
-    newCommand->next = NULL;
-
-    time_t now = time(NULL);
-    const struct tm* now_tm = localtime(&now);
-
-    struct tm next_execution = *now_tm;
-    next_execution.tm_hour = hours;
-    next_execution.tm_min = minutes;
-    next_execution.tm_sec = 0;
-
-    time_t next_execution_time = mktime(&next_execution);
-
-    // If the execution time has already passed today, schedule it for tomorrow
-    if (next_execution_time <= now) {
-        next_execution_time += 24 * 60 * 60; // Add 24 hours in seconds
-    }
-
-    newCommand->next_time = next_execution_time;  // Set the next execution time
-
-    // If the list is empty, make the new node the first node
-    if (*headOfPeriodicCommands_Global == NULL) {
-        *headOfPeriodicCommands_Global = newCommand;
-        return *headOfPeriodicCommands_Global;
-    }
-
-    // Traverse the list to find the last node
-    PeriodicCommand* lastNode = *headOfPeriodicCommands_Global;
-    while (lastNode->next != NULL) {
-        lastNode = lastNode->next;
-    }
-
-    // Link the new node after the last node
-    lastNode->next = newCommand;
-
-    log_message(LOG_DEBUG, "Exiting function scheduleDailyCommand");
-
-    return *headOfPeriodicCommands_Global;
-}
-
-static command* addCommandToQueue(command** head, const char *function, const char *argument) {
-    log_message(LOG_DEBUG, "Entering function addCommandToQueue");
-
-    command* newNode = (command *)malloc(sizeof(command));
-    if (!newNode) {
-        log_message(LOG_ERROR, "Memory allocation error");
-        exit(1);
-    }
-
-    // Initialize all pointers to NULL
-    newNode->function = NULL;
-    newNode->argument = NULL;
-
-     // Set function and arguments using the helper function
-    setCommandArgument(&newNode->function, function, "function");
-    setCommandArgument(&newNode->argument, argument, "argument");
-
-    log_message(LOG_DEBUG, "All arguments added to command struct");
-    newNode->next = NULL;  // New node will be the last node
-
-    // If the list is empty, make the new node the first node
-    if (*head == NULL) {
-        *head = newNode;
-        return *head;
-    }
-
-    // Traverse the list to find the last node
-    command* lastNode = *head;
-    while (lastNode->next != NULL) {
-        lastNode = lastNode->next;
-    }
-
-    // Link the new node after the last node
-    lastNode->next = newNode;
-
-    log_message(LOG_DEBUG, "Command added to queue");
-
-    log_message(LOG_DEBUG, "Exiting function addCommandToQueue");
-    return *head;
-}
-
-void removeFirstCommand(command **head) {
-    log_message(LOG_DEBUG, "Entering function removeFirstCommand");
-
-    log_message(LOG_DEBUG, "About to remove first command");
-
-    if (*head == NULL) {
-        // The list is already empty, nothing to remove
-        return;
-    }
-
-    log_message(LOG_DEBUG, "Creating a temporary pointer to a command");
-    // Save the current head node to free it later
-    command* temp = *head;
-
-    log_message(LOG_DEBUG, "Placing the head on to the next command");
-    // Update the head to point to the next node
-    *head = (*head)->next;
-
-    // Free the memory of the removed node
-
-    if (temp->function && temp->function != NULL){
-        free(temp->function);
-    }
-
-    if (temp->argument && temp->argument != NULL){
-        free(temp->argument);
-    }
-
-    log_message(LOG_DEBUG, "freed all variables");
-
-    free(temp);
-
-    log_message(LOG_DEBUG, "freed struct");
-
-    log_message(LOG_DEBUG, "Exiting function removeFirstCommand");
-}
-
-static command** checkAndEnqueuePeriodicCommands(command** commandQueue, PeriodicCommand** headOfPeriodicCommands_Global) {
+static commandQueue* checkAndEnqueuePeriodicCommands(commandQueue* queue, PeriodicCommand** headOfPeriodicCommands_Global) {
     log_message(LOG_DEBUG, "Entering function checkAndEnqueuePeriodicCommands");
 
     time_t currentTime = time(NULL);
@@ -190,7 +74,8 @@ static command** checkAndEnqueuePeriodicCommands(command** commandQueue, Periodi
         if (periodicCommand->next_time <= currentTime) {
             // Enqueue the command into the commandQueue
             command cmd = *periodicCommand->command;
-            *commandQueue = addCommandToQueue(commandQueue, cmd.function, cmd.argument);
+            (void)enqueueCommand(queue, cmd.function, cmd.argument, COMMAND_PRIORITY_SCHEDULED);
+            recordSchedulerLagMetric((long)(currentTime - periodicCommand->next_time));
 
             log_message(LOG_DEBUG, "Periodic command added to queue:%s", cmd.function);
 
@@ -201,67 +86,55 @@ static command** checkAndEnqueuePeriodicCommands(command** commandQueue, Periodi
     }
 
     log_message(LOG_DEBUG, "Exiting function checkAndEnquePeriodicCommands");
-    return commandQueue;
+    return queue;
 }
 
-static command** lookForCommandOnSlack(command** headOfPeriodicCommands_Global){
-    log_message(LOG_DEBUG, "Entering function lookForCommandonSlack");
+/**
+ * @brief Timestamp of the newest Slack message seen, only messages posted after it are fetched.
+ */
+static char* slackHistoryCursor = NULL;
 
-    command cmd;
-    slackMessage* slackMsg = (slackMessage*)malloc(sizeof(slackMessage));
+static commandQueue* lookForCommandOnSlack(commandQueue* queue){
+    log_message(LOG_DEBUG, "Entering function lookForCommandonSlack");
 
-    if (chunk.response) {
-        chunk.response = NULL;
-        chunk.size = 0;
+    // Messages posted while the bot was offline are ignored
+    if(!slackHistoryCursor){
+        slackHistoryCursor = getCurrentSlackTimestamp();
     }
 
-    slackMsg = getSlackMessage(slackMsg);
+    slackMessage* newMessages = getNewSlackMessages(&slackHistoryCursor);
 
+    if(!newMessages){
+        log_message(LOG_DEBUG, "No commands sent on slack");
+    }
 
+    //Breakdown every message which was not sent by bot into a command structure and queue it, oldest first
+    for(slackMessage* slackMsg = newMessages; slackMsg; slackMsg = slackMsg->next){
+        if(!slackMsg->message || !slackMsg->sender || strcmp(slackMsg->sender, "U06RQCAT0H1") == 0){
+            continue;
+        }
 
-    //If received a message which was not sent by bot, breakdown message into command structure and return command
-    if(slackMsg->message && slackMsg->timestamp && slackMsg->sender  && strcmp(slackMsg->sender, "U06RQCAT0H1") != 0){
+        command cmd;
         breakdownCommand(slackMsg->message, &cmd);
         log_message(LOG_DEBUG, "Command broke down");
-        *headOfPeriodicCommands_Global = addCommandToQueue(headOfPeriodicCommands_Global, cmd.function, cmd.argument);
-        log_message(LOG_INFO, "Received a %s command on slack", cmd.function);
-        log_message(LOG_DEBUG, "Command added to queue");
-    }
-
-    //If last message was sent by bot, free allocated memory and return emtpy command
-    else{log_message(LOG_DEBUG, "No commands sent on slack"); }//log.info
-
-    if (chunk.response) {
-        chunk.response = NULL;
-        chunk.size = 0;
-    }
-
-    if(slackMsg->message){
-        free(slackMsg->message);
-        slackMsg->message = NULL;
-    }
 
-    if(slackMsg->sender){
-        free(slackMsg->sender);
-        slackMsg->sender = NULL;
-    }
-
-    if(slackMsg->timestamp){
-        free(slackMsg->timestamp);
-        slackMsg->timestamp = NULL;
-    }
+        if(cmd.function){
+            (void)enqueueCommand(queue, cmd.function, cmd.argument, COMMAND_PRIORITY_INTERACTIVE);
+            log_message(LOG_INFO, "Received a %s command on slack", cmd.function);
+            log_message(LOG_DEBUG, "Command added to queue");
+        }
 
-    if(slackMsg){
-        free(slackMsg);
+        freeCommand(&cmd);
     }
 
+    freeSlackMessageList(&newMessages);
 
     log_message(LOG_DEBUG, "Exiting function lookForCommandOnSlack");
-    return headOfPeriodicCommands_Global;
+    return queue;
 
 }
 
-static command** lookForNewlyUpdatedPages(command** commandQueue){
+static commandQueue* lookForNewlyUpdatedPages(commandQueue* queue){
     log_message(LOG_DEBUG, "Entering function lookForNewlyUpdatedPages");
 
     pageList* updatedPages = NULL;
@@ -271,7 +144,7 @@ static command** lookForNewlyUpdatedPages(command** commandQueue){
 
     while(updatedPages){
 
-        *commandQueue = addCommandToQueue(commandQueue, "onPageUpdate", updatedPages->id);
+        (void)enqueueCommand(queue, "onPageUpdate", updatedPages->id, COMMAND_PRIORITY_BACKGROUND);
         log_message(LOG_INFO, "onPageUpdate command has been added to queue for page id: %s", updatedPages->id);
         updatedPages = updatedPages->next;
     }
@@ -280,124 +153,40 @@ static command** lookForNewlyUpdatedPages(command** commandQueue){
     lastPageRefreshCheck = getCurrentEDTTimeString();
 
     log_message(LOG_DEBUG, "Exiting function lookForNewlyUpdatedPages");
-    return commandQueue;
+    return queue;
 }
 
-command** checkForCommand(command** headOfCommandQueue_Global, PeriodicCommand** headOfPeriodicCommands_Global){
+commandQueue* checkForCommand(commandQueue* commandQueue_Global, PeriodicCommand** headOfPeriodicCommands_Global){
     log_message(LOG_DEBUG, "Entering function checkForCommand");
 
-    headOfCommandQueue_Global = lookForCommandOnSlack(headOfCommandQueue_Global);
-    //headOfCommandQueue_Global = checkAndEnqueuePeriodicCommands(headOfCommandQueue_Global, headOfPeriodicCommands_Global);
+    commandQueue_Global = lookForCommandOnSlack(commandQueue_Global);
+    commandQueue_Global = checkAndEnqueuePeriodicCommands(commandQueue_Global, headOfPeriodicCommands_Global);
 
     log_message(LOG_DEBUG, "Exiting function checkForCommand");
-    return headOfCommandQueue_Global;
+    return commandQueue_Global;
 }
 
 PeriodicCommand** initalizePeriodicCommands(PeriodicCommand** headOfPeriodicCommands_Global){
     log_message(LOG_DEBUG, "Entering function initializePeriodicCommands");
 
-    command* getRyansHomePage = (command*)malloc(sizeof(command));
-    breakdownCommand("updateStatsPage", getRyansHomePage);
-
-    command* updateVCD_ST =(command*)malloc(sizeof(command));
-    breakdownCommand("updateVCD ST", updateVCD_ST);
-
-    command* updateVCD_GE =(command*)malloc(sizeof(command));
-    breakdownCommand("updateVCD GE", updateVCD_GE);
-
-    command* updateVCD_PR =(command*)malloc(sizeof(command));
-    breakdownCommand("updateVCD PR", updateVCD_PR);
-
-    command* updateVCD_FD =(command*)malloc(sizeof(command));
-    breakdownCommand("updateVCD FD", updateVCD_FD);
-
-    command* updateVCD_RE =(command*)malloc(sizeof(command));
-    breakdownCommand("updateVCD RE", updateVCD_RE);
-
-    command* updateVCD_GS =(command*)malloc(sizeof(command));
-    breakdownCommand("updateVCD GS", updateVCD_GS);
-
-    command* updateVCD_AV =(command*)malloc(sizeof(command));
-    breakdownCommand("updateVCD AV", updateVCD_AV);
-
-    command* updateVCD_PL =(command*)malloc(sizeof(command));
-    breakdownCommand("updateVCD PL", updateVCD_PL);
-
-    command* updateReq_ST =(command*)malloc(sizeof(command));
-    breakdownCommand("updateReq ST", updateReq_ST);
-
-    command* updateReq_GE =(command*)malloc(sizeof(command));
-    breakdownCommand("updateReq GE", updateReq_GE);
-
-    command* updateReq_PR =(command*)malloc(sizeof(command));
-    breakdownCommand("updateReq PR", updateReq_PR);
-
-    command* updateReq_FD =(command*)malloc(sizeof(command));
-    breakdownCommand("updateReq FD", updateReq_FD);
-
-    command* updateReq_RE =(command*)malloc(sizeof(command));
-    breakdownCommand("updateReq RE", updateReq_RE);
-
-    command* updateReq_GS =(command*)malloc(sizeof(command));
-    breakdownCommand("updateReq GS", updateReq_GS);
-
-    command* updateReq_AV =(command*)malloc(sizeof(command));
-    breakdownCommand("updateReq AV", updateReq_AV);
-
-    command* updateReq_PL =(command*)malloc(sizeof(command));
-    breakdownCommand("updateReq PL", updateReq_PL);
-
-    command* updateDRL_ST =(command*)malloc(sizeof(command));
-    breakdownCommand("updateDRL ST", updateDRL_ST);
-
-    command* updateDRL_GE =(command*)malloc(sizeof(command));
-    breakdownCommand("updateDRL GE", updateDRL_GE);
-
-    command* updateDRL_PR =(command*)malloc(sizeof(command));
-    breakdownCommand("updateDRL PR", updateDRL_PR);
-
-    command* updateDRL_FD =(command*)malloc(sizeof(command));
-    breakdownCommand("updateDRL FD", updateDRL_FD);
-
-    command* updateDRL_RE =(command*)malloc(sizeof(command));
-    breakdownCommand("updateDRL RE", updateDRL_RE);
-
-    command* updateDRL_GS =(command*)malloc(sizeof(command));
-    breakdownCommand("updateDRL GS", updateDRL_GS);
-
-    command* updateDRL_AV =(command*)malloc(sizeof(command));
-    breakdownCommand("updateDRL AV", updateDRL_AV);
-
-    command* updateDRL_PL =(command*)malloc(sizeof(command));
-    breakdownCommand("updateDRL PL", updateDRL_PL);
+    // Subsystems are synced when their sheets change instead of all of them every morning
+    command* checkForChanges = (command*)malloc(sizeof(command));
+    if(!checkForChanges){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+    breakdownCommand("checkForChanges", checkForChanges);
 
     headOfPeriodicCommands_Global = (PeriodicCommand**)malloc(sizeof(PeriodicCommand*));
+    if(!headOfPeriodicCommands_Global){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
     *headOfPeriodicCommands_Global = NULL;
-    *headOfPeriodicCommands_Global = addPeriodicCommand(headOfPeriodicCommands_Global, getRyansHomePage, 3600);
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateVCD_ST, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateVCD_GE, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateVCD_PR, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateVCD_FD, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateVCD_RE, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateVCD_GS, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateVCD_AV, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateVCD_PL, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateReq_ST, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateReq_GE, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateReq_PR, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateReq_FD, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateReq_RE, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateReq_GS, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateReq_AV, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateReq_PL, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateDRL_ST, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateDRL_GE, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateDRL_PR, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateDRL_FD, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateDRL_RE, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateDRL_GS, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateDRL_AV, "06:00");
-    *headOfPeriodicCommands_Global = addDailyCommand(headOfPeriodicCommands_Global, updateDRL_PL, "06:00");
+    *headOfPeriodicCommands_Global = addPeriodicCommand(headOfPeriodicCommands_Global, checkForChanges, REQUIREMENT_CHANGE_PROBE_PERIOD);
+
+    // The first probe runs right away, it catches up on the changes made while the bot was offline
+    (*headOfPeriodicCommands_Global)->next_time = time(NULL);
 
     log_message(LOG_DEBUG, "Exiting function initializePeriodicCommands");
     return headOfPeriodicCommands_Global;
@@ -450,120 +239,286 @@ void breakdownCommand(const char* sentence, command* cmd) {
     log_message(LOG_DEBUG, "Exiting function breakdownCommand");
 }
 
-command** executeCommand(command** commandQueue){
-    log_message(LOG_DEBUG, "Entering function executeCommand");
+static void shutdownBot(command cmd){
+    sendMessageToSlack("Shutting down");
 
-    if((*commandQueue)->function && strcmp((*commandQueue)->function, "shutdown") == 0){ //works
-        sendMessageToSlack("Shutting down");
+    // runCommand does not get to journal that the command finished, it would otherwise be resumed at the next start
+    journalFinishedCommand(&cmd);
+    closeCommandJournal();
 
-        exit(0);
-    }
+    exit(0);
+}
+
+static void sendHelpMessage(command cmd){
+    (void)cmd;
+    char* helpMessage = buildHelpMessage();
+
+    sendMessageToSlack(helpMessage);
 
-    else if ((*commandQueue)->function && strcmp((*commandQueue)->function, "updateDRL") == 0){
-        sendStartingStatusMessage("updateDRL");
+    free(helpMessage);
+}
 
-        syncDrlToSheet(**commandQueue);
+static void setLogLevelCommand(command cmd){
+    if(setLogLevels(cmd.argument) == 0){
+        sendMessageToSlack("Log levels updated");
+    }
+    else{
+        sendMessageToSlack("Invalid log level, expected e.g. info or wikiAPI=debug,features=info (levels: debug, info, error)");
+    }
+}
 
-        sendCompletedStatusMessage("updateDRL");
+static void sendLastTraceSummary(command cmd){
+    if(strcmp(cmd.argument, "last") != 0){
+        sendMessageToSlack("Invalid argument, expected: last");
+        return;
     }
 
-    else if ((*commandQueue)->function && strcmp((*commandQueue)->function, "updateReq") == 0){
-        sendStartingStatusMessage("updateReq");
+    char* summary = buildLastTraceSummary();
+
+    sendMessageToSlack(summary ? summary : "No command has been traced yet");
+
+    free(summary);
+}
+
+static void resetSnapshots(command cmd){
+    int numberOfDeletedSnapshots = resetRequirementSnapshots(cmd.argument);
+
+    char message[256];
+    snprintf(message, sizeof(message), "Deleted %d snapshots of %s, its next sync will rebuild every page", numberOfDeletedSnapshots, cmd.argument);
+    sendMessageToSlack(message);
+}
+
+const commandDefinition shutdownCommandDefinition = {
+    .name = "shutdown",
+    .argumentType = COMMAND_ARGUMENT_NONE,
+    .concurrencyClass = COMMAND_CONCURRENCY_EXCLUSIVE,
+    .reportsStatus = false,
+    .description = "Will shutdown the ERTbot once all of the commands in the queue are complete.",
+    .argumentDescription = NULL,
+    .example = NULL,
+    .handler = shutdownBot,
+};
+
+const commandDefinition helpCommandDefinition = {
+    .name = "help",
+    .argumentType = COMMAND_ARGUMENT_NONE,
+    .concurrencyClass = COMMAND_CONCURRENCY_READ_ONLY,
+    .reportsStatus = false,
+    .description = "Lists every command.",
+    .argumentDescription = NULL,
+    .example = NULL,
+    .handler = sendHelpMessage,
+};
+
+const commandDefinition setLogLevelCommandDefinition = {
+    .name = "setLogLevel",
+    .argumentType = COMMAND_ARGUMENT_TEXT,
+    .concurrencyClass = COMMAND_CONCURRENCY_READ_ONLY,
+    .reportsStatus = false,
+    .description = "Changes which log lines are written, for every module or for some of them (core, wikiAPI, sheetAPI, slackAPI, apiHelpers, features, helpers).",
+    .argumentDescription = "level (debug, info or error) or comma separated module=level",
+    .example = "setLogLevel info,wikiAPI=debug",
+    .handler = setLogLevelCommand,
+};
+
+const commandDefinition traceCommandDefinition = {
+    .name = "trace",
+    .argumentType = COMMAND_ARGUMENT_TEXT,
+    .concurrencyClass = COMMAND_CONCURRENCY_READ_ONLY,
+    .reportsStatus = false,
+    .description = "Shows where the last traced command spent its time, the full trace is in logs/traces (open it with ui.perfetto.dev).",
+    .argumentDescription = "last",
+    .example = "trace last",
+    .handler = sendLastTraceSummary,
+};
+
+const commandDefinition resetSnapshotsCommandDefinition = {
+    .name = "resetSnapshots",
+    .argumentType = COMMAND_ARGUMENT_SUBSYSTEM,
+    .concurrencyClass = COMMAND_CONCURRENCY_SUBSYSTEM,
+    .reportsStatus = false,
+    .description = "Forgets which requirements were already synchronised, so that the next sync rebuilds every page even if the sheet did not change (e.g. after pages were edited by hand).",
+    .argumentDescription = "acronym of the subsystem you want to reset",
+    .example = "resetSnapshots ST",
+    .handler = resetSnapshots,
+};
+
+/**
+ * @brief Runs a command from start to end.
+ *
+ * @return bool true if the command did not get through to a service which is down and should be run again once the
+ *         service is back. Read only commands are not, they are quick to ask for again.
+ */
+static bool runCommand(command cmd){
+    log_message(LOG_DEBUG, "Entering function runCommand");
+
+    journalStartedCommand(&cmd);
+    beginHttpRequestBudget();
+
+    unsigned long circuitBreakerEvents = getCircuitBreakerEventCount();
+    bool isInterrupted = false;
 
-        updateRequirementPage(**commandQueue);
+    const commandDefinition* definition = findCommandDefinition(cmd.function);
 
-        sendCompletedStatusMessage("updateReq");
+    if(!definition){
+        sendMessageToSlack("Unknown Command :rayane_side_eyeing:");
+    }
+
+    else if(!isCommandArgumentValid(definition, cmd.argument)){
+        char* message = createCombinedString("Invalid argument, expected: ", definition->argumentDescription ? definition->argumentDescription : "no argument");
+        sendMessageToSlack(message);
+        free(message);
     }
 
-    else if ((*commandQueue)->function && strcmp((*commandQueue)->function, "updateVCD") == 0){
-        sendStartingStatusMessage("updateVCD");
+    else{
+        // Read only commands are quick, tracing them would only replace the trace of the last real command
+        bool isTraced = definition->concurrencyClass != COMMAND_CONCURRENCY_READ_ONLY;
+        if(isTraced){
+            beginTraceSpan(TRACE_CATEGORY_COMMAND, definition->name, cmd.argument);
+        }
+
+        struct timespec startTime;
+        clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+        if(definition->reportsStatus){
+            sendStartingStatusMessage(definition->name);
+        }
+
+        definition->handler(cmd);
+
+        // Pages touched by several steps of the command are rendered once, after all of them
+        (void)flushPageRenders();
+
+        if(definition->reportsStatus){
+            sendCompletedStatusMessage(definition->name);
+        }
+
+        struct timespec endTime;
+        clock_gettime(CLOCK_MONOTONIC, &endTime);
+        recordCommandDurationMetric(definition->name, (double)(endTime.tv_sec - startTime.tv_sec) + (double)(endTime.tv_nsec - startTime.tv_nsec) / 1e9);
 
-        updateVcdPage(**commandQueue);
+        if(isTraced){
+            endTraceSpan();
+        }
 
-        sendCompletedStatusMessage("updateVCD");
+        isInterrupted = definition->concurrencyClass != COMMAND_CONCURRENCY_READ_ONLY && getCircuitBreakerEventCount() != circuitBreakerEvents;
     }
 
-    else if ((*commandQueue)->function && strcmp((*commandQueue)->function, "createMissingRequirementPages") == 0){
-        sendStartingStatusMessage("createMissingRequirementPages");
+    endHttpRequestBudget();
+    journalFinishedCommand(&cmd);
+
+    log_message(LOG_DEBUG, "Exiting function runCommand");
+    return isInterrupted;
+}
+
+/**
+ * @brief Whether commands must wait for a service which is down to be tried again before being run, instead of each
+ *        of their requests failing.
+ */
+static bool isCommandQueuePaused(){
+    static bool isPaused = false;
 
-        createMissingRequirementPages(**commandQueue);
+    long long pauseMicroseconds = getCircuitBreakerPause();
 
-        sendCompletedStatusMessage("createMissingRequirementPages");
+    if(pauseMicroseconds > 0 && !isPaused){
+        log_message(LOG_INFO, "A service is down, commands are paused for %lld s", pauseMicroseconds / 1000000 + 1);
+    }
+    else if(pauseMicroseconds == 0 && isPaused){
+        log_message(LOG_INFO, "Resuming commands");
     }
 
-    else if ((*commandQueue)->function && strcmp((*commandQueue)->function, "sync") == 0){
-        sendStartingStatusMessage("sync");
+    isPaused = pauseMicroseconds > 0;
+    return isPaused;
+}
 
-        updateCommandStatusMessage("Starting createMissingRequirementPages");
-        createMissingRequirementPages(**commandQueue);
-        updateCommandStatusMessage("finished createMissingRequirementPages");
+static void resumeCommandLater(commandQueue* queue, const command* cmd, commandPriority priority){
+    log_message(LOG_INFO, "%s %s did not get through to a service which is down, it will run again once the service is back",
+                cmd->function, cmd->argument ? cmd->argument : "");
+    (void)enqueueCommand(queue, cmd->function, cmd->argument, priority);
+}
 
-        updateCommandStatusMessage("Starting updateDRL");
-        syncDrlToSheet(**commandQueue);
-        updateCommandStatusMessage("finished updateDRL");
+commandQueue* executeCommand(commandQueue* queue){
+    log_message(LOG_DEBUG, "Entering function executeCommand");
 
-        updateCommandStatusMessage("Starting updateReq");
-        updateRequirementPage(**commandQueue);
-        updateCommandStatusMessage("finished updateReq");
+    if(isCommandQueuePaused()){
+        log_message(LOG_DEBUG, "Exiting function executeCommand");
+        return queue;
+    }
 
-        updateCommandStatusMessage("Starting updateVCD");
-        updateVcdPage(**commandQueue);
-        updateCommandStatusMessage("finished updateVCD");
+    int priority = 0;
+    while(priority < NUMBER_OF_COMMAND_PRIORITIES && !peekCommand(queue, (commandPriority)priority)){
+        priority++;
+    }
 
-        sendCompletedStatusMessage("sync");
+    command cmd;
+    if(priority < NUMBER_OF_COMMAND_PRIORITIES && dequeueCommandFromLane(queue, (commandPriority)priority, &cmd)){
+        beginAllocationProfile(cmd.function);
+        if(runCommand(cmd)){
+            resumeCommandLater(queue, &cmd, (commandPriority)priority);
+        }
+        freeCommand(&cmd);
+        endAllocationProfile();
     }
 
-    else if ((*commandQueue)->function && strcmp((*commandQueue)->function, "help") == 0){
-        sendMessageToSlack("Here is a list of commands: ");
-        sendMessageToSlack("shutdown");
-        sendMessageToSlack("-> Description: Will shutdown the ERTbot once all of the commands in the queue are complete.");
-        sendMessageToSlack("-----------------");
-        sendMessageToSlack("updateVCD");
-        sendMessageToSlack("-> Argument (1) (oligatory): acronym of the subsystem you want to update");
-        sendMessageToSlack("-> example: updateVCD ST");
-        sendMessageToSlack("-----------------");
-        sendMessageToSlack("updateReq");
-        sendMessageToSlack("-> Argument (1) (oligatory): acronym of the subsystem you want to update (will update all of the requirement pages of the subsystem)");
-        sendMessageToSlack("-> or");
-        sendMessageToSlack("-> Argument (oligatory): ID of the requirement you want to update");
-        sendMessageToSlack("-> example 1: updateReq ST");
-        sendMessageToSlack("-> example 2: updateReq 2024_C_SE_ST_REQ_01");
-        sendMessageToSlack("-----------------");
-        sendMessageToSlack("updateDRL");
-        sendMessageToSlack("-> Argument (1) (oligatory): acronym of the subsystem you want to update");
-        sendMessageToSlack("-> example: updateDRL ST");
-        sendMessageToSlack("-----------------");
-        sendMessageToSlack("createMissingRequirementPages");
-        sendMessageToSlack("-> Argument (1) (oligatory): acronym of the subsystem you want to update");
-        sendMessageToSlack("-> example: updateDRL ST");
-        sendMessageToSlack("-----------------");
-        sendMessageToSlack("sync");
-        sendMessageToSlack("-> Description: Fully synchronises all of the requirements by running createMissingRequirementPages, updateDRL, updateReq and updateVCD on its own.");
-        sendMessageToSlack("-> Argument (1) (oligatory): acronym of the subsystem you want to update");
-        sendMessageToSlack("-> example: sync ST");
+    log_message(LOG_DEBUG, "Exiting function executeCommand");
+    return queue;
+}
+
+void yieldToInteractiveCommands(){
+    static bool isYielding = false;
+    static time_t lastSlackPoll = 0;
+
+    if(isYielding || !mainCommandQueue){
+        return;
     }
 
-    else{
-        sendMessageToSlack("Unknown Command :rayane_side_eyeing:");
+    time_t currentTime = time(NULL);
+    bool shouldPollSlack = currentTime - lastSlackPoll >= INTERACTIVE_COMMAND_POLL_PERIOD;
+
+    if(!shouldPollSlack && !isLightweightCommand(peekCommand(mainCommandQueue, COMMAND_PRIORITY_INTERACTIVE))){
+        return;
     }
 
-    removeFirstCommand(commandQueue);
+    log_message(LOG_DEBUG, "Entering function yieldToInteractiveCommands");
+    isYielding = true;
 
+    // The interrupted command may still be using the response buffer and its status message
+    memory interruptedChunk = chunk;
+    chunk.response = NULL;
+    chunk.size = 0;
 
-    log_message(LOG_DEBUG, "Exiting function executeCommand");
-    return commandQueue;
+    slackMessage* interruptedStatusMessage = commandStatusMessage;
 
-}
+    // Its queued wiki mutations must neither be sent nor have their failures reported by another command
+    suspendWikiMutations();
+
+    if(shouldPollSlack){
+        lastSlackPoll = currentTime;
+        mainCommandQueue = lookForCommandOnSlack(mainCommandQueue);
+    }
+
+    while(isLightweightCommand(peekCommand(mainCommandQueue, COMMAND_PRIORITY_INTERACTIVE)) && !isCommandQueuePaused()){
+        command cmd;
+        (void)dequeueCommandFromLane(mainCommandQueue, COMMAND_PRIORITY_INTERACTIVE, &cmd);
 
-static void setCommandArgument(char** dest, const char* src, const char* argName) {
-    if (src && src[0] != '\0') {
-        log_message(LOG_DEBUG, "%s added to command", argName);
-        size_t len = strlen(src) + 1;
-        *dest = malloc(len);
-        if (*dest) {
-            strlcpy(*dest, src, len);
-        } else {
-            log_message(LOG_ERROR, "Memory allocation failed for %s", argName);
+        log_message(LOG_INFO, "Running %s %s in between the pages of the current command", cmd.function, cmd.argument ? cmd.argument : "");
+
+        initialiseSlackCommandStatusMessage();
+        if(runCommand(cmd)){
+            resumeCommandLater(mainCommandQueue, &cmd, COMMAND_PRIORITY_INTERACTIVE);
         }
+        freeSlackCommandStatusMessageVariables();
+        free(commandStatusMessage);
+
+        commandStatusMessage = interruptedStatusMessage;
+        freeCommand(&cmd);
     }
+
+    resumeWikiMutations();
+
+    freeChunkResponse();
+    chunk = interruptedChunk;
+
+    isYielding = false;
+    log_message(LOG_DEBUG, "Exiting function yieldToInteractiveCommands");
 }
@@ -0,0 +1,179 @@
+/**
+ * @file commandRegistry.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the table of every command the bot understands.
+ *
+ * @details To add a command, define its `commandDefinition` next to its feature, declare it in ERTbot_features.h and
+ *          add it to `registeredCommands`.
+ */
+#include <stdbool.h>
+#include <string.h>
+#include "ERTbot_common.h"
+#include "ERTbot_commandRegistry.h"
+#include "ERTbot_command.h"
+#include "ERTbot_features.h"
+#include "requirementsHelpers.h"
+#include "stringHelpers.h"
+
+#define COMMAND_REGISTRY_TABLE_SIZE 32
+#define MAXIMUM_PERFECT_HASH_SEED 100000
+
+/**
+ * @brief Every command, in the order they are listed in the help.
+ */
+static const commandDefinition* const registeredCommands[] = {
+    &helpCommandDefinition,
+    &shutdownCommandDefinition,
+    &setLogLevelCommandDefinition,
+    &traceCommandDefinition,
+    &syncCommandDefinition,
+    &resetSnapshotsCommandDefinition,
+    &checkForChangesCommandDefinition,
+    &createMissingRequirementPagesCommandDefinition,
+    &updateDrlCommandDefinition,
+    &updateReqCommandDefinition,
+    &updateVcdCommandDefinition,
+};
+
+#define NUMBER_OF_REGISTERED_COMMANDS (sizeof(registeredCommands) / sizeof(registeredCommands[0]))
+
+static const commandDefinition* commandTable[COMMAND_REGISTRY_TABLE_SIZE];
+static unsigned int commandTableSeed = 0;
+static bool isCommandRegistryInitialized = false;
+
+static unsigned int hashCommandName(const char *name, unsigned int seed){
+    // FNV-1a, the seed is mixed into the offset basis
+    unsigned int hash = 2166136261u ^ seed;
+
+    for(const char *c = name; *c; c++){
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+
+    return hash % COMMAND_REGISTRY_TABLE_SIZE;
+}
+
+static bool tryBuildCommandTable(unsigned int seed){
+    memset(commandTable, 0, sizeof(commandTable));
+
+    for(size_t i = 0; i < NUMBER_OF_REGISTERED_COMMANDS; i++){
+        unsigned int slot = hashCommandName(registeredCommands[i]->name, seed);
+
+        if(commandTable[slot]){
+            return false;
+        }
+
+        commandTable[slot] = registeredCommands[i];
+    }
+
+    return true;
+}
+
+void initializeCommandRegistry(){
+    log_message(LOG_DEBUG, "Entering function initializeCommandRegistry");
+
+    for(unsigned int seed = 0; seed < MAXIMUM_PERFECT_HASH_SEED; seed++){
+        if(tryBuildCommandTable(seed)){
+            commandTableSeed = seed;
+            isCommandRegistryInitialized = true;
+
+            log_message(LOG_DEBUG, "Command registry built with seed %u", seed);
+            log_message(LOG_DEBUG, "Exiting function initializeCommandRegistry");
+            return;
+        }
+    }
+
+    // Only happens if two commands share a name or the table is too small for the number of commands
+    log_message(LOG_ERROR, "Could not build the command registry, are two commands registered with the same name?");
+    exit(1);
+}
+
+const commandDefinition* findCommandDefinition(const char *name){
+    if(!name){
+        return NULL;
+    }
+
+    if(!isCommandRegistryInitialized){
+        initializeCommandRegistry();
+    }
+
+    const commandDefinition* definition = commandTable[hashCommandName(name, commandTableSeed)];
+
+    if(!definition || strcmp(definition->name, name) != 0){
+        return NULL;
+    }
+
+    return definition;
+}
+
+bool isCommandArgumentValid(const commandDefinition* definition, const char *argument){
+    bool hasArgument = argument && argument[0] != '\0';
+
+    switch(definition->argumentType){
+        case COMMAND_ARGUMENT_NONE:
+            return true;
+
+        case COMMAND_ARGUMENT_SUBSYSTEM:
+            return hasArgument && !isRequirementId(argument);
+
+        // "all" or comma separated acronyms, e.g. "ST,GE"
+        case COMMAND_ARGUMENT_SUBSYSTEM_LIST:
+            return hasArgument && !isRequirementId(argument) && argument[0] != ',' &&
+                   argument[strlen(argument) - 1] != ',' && !strstr(argument, ",,");
+
+        case COMMAND_ARGUMENT_SUBSYSTEM_OR_REQUIREMENT_ID:
+        case COMMAND_ARGUMENT_PAGE_ID:
+        case COMMAND_ARGUMENT_TEXT:
+            return hasArgument;
+    }
+
+    return false;
+}
+
+bool isLightweightCommand(const command* cmd){
+    if(!cmd){
+        return false;
+    }
+
+    const commandDefinition* definition = findCommandDefinition(cmd->function);
+    if(!definition){
+        return false;
+    }
+
+    if(definition->concurrencyClass == COMMAND_CONCURRENCY_READ_ONLY){
+        return true;
+    }
+
+    return definition->argumentType == COMMAND_ARGUMENT_SUBSYSTEM_OR_REQUIREMENT_ID && isRequirementId(cmd->argument);
+}
+
+char* buildHelpMessage(){
+    log_message(LOG_DEBUG, "Entering function buildHelpMessage");
+
+    // The message is sent as a JSON string, hence the escaped new lines
+    char* helpMessage = duplicate_Malloc("Here is a list of commands:\\n");
+
+    for(size_t i = 0; i < NUMBER_OF_REGISTERED_COMMANDS; i++){
+        const commandDefinition* definition = registeredCommands[i];
+
+        helpMessage = appendToString(helpMessage, "-----------------\\n*");
+        helpMessage = appendToString(helpMessage, definition->name);
+        helpMessage = appendToString(helpMessage, "*\\n-> Description: ");
+        helpMessage = appendToString(helpMessage, definition->description);
+        helpMessage = appendToString(helpMessage, "\\n");
+
+        if(definition->argumentDescription){
+            helpMessage = appendToString(helpMessage, "-> Argument (obligatory): ");
+            helpMessage = appendToString(helpMessage, definition->argumentDescription);
+            helpMessage = appendToString(helpMessage, "\\n");
+        }
+
+        if(definition->example){
+            helpMessage = appendToString(helpMessage, "-> example: ");
+            helpMessage = appendToString(helpMessage, definition->example);
+            helpMessage = appendToString(helpMessage, "\\n");
+        }
+    }
+
+    log_message(LOG_DEBUG, "Exiting function buildHelpMessage");
+    return helpMessage;
+}
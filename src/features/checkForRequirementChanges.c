@@ -0,0 +1,237 @@
+/**
+ * @file checkForRequirementChanges.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the change probe which queues a sync for every subsystem whose sheets changed.
+ *
+ * @details The probe fetches the INFO sheet and the Req_DB range of every subsystem, with one `values:batchGet` per
+ *          Req_DB spreadsheet, and keeps a fingerprint of each subsystem in memory. A subsystem is synced until a sync
+ *          of it succeeded with the fingerprint it has now, every subsystem is synced after a restart.
+ */
+
+#define LOG_MODULE LOG_MODULE_FEATURES
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cjson/cJSON.h>
+#include "ERTbot_common.h"
+#include "ERTbot_features.h"
+#include "sheetAPI.h"
+#include "apiHelpers.h"
+#include "requirementsHelpers.h"
+#include "requirementSnapshotHelpers.h"
+#include "commandQueueHelpers.h"
+#include "stringHelpers.h"
+
+/**
+ * @details `probedHash` is the fingerprint seen by the last probe, `syncedHash` the one a sync last succeeded with
+ *          (only meaningful if `isSynced`).
+ */
+typedef struct subsystemFingerprint {
+    char *acronym;
+    unsigned long long probedHash;
+    unsigned long long syncedHash;
+    bool isSynced;
+    struct subsystemFingerprint *next;
+} subsystemFingerprint;
+
+static subsystemFingerprint* subsystemFingerprints = NULL;
+
+static subsystemFingerprint* findSubsystemFingerprint(const char *acronym){
+    subsystemFingerprint* current = subsystemFingerprints;
+    while(current && strcmp(current->acronym, acronym) != 0){
+        current = current->next;
+    }
+
+    return current;
+}
+
+/**
+ * @brief Records the fingerprint of a subsystem.
+ *
+ * @return bool true if no sync of the subsystem succeeded with this fingerprint yet.
+ *
+ * @details The synced fingerprint is only moved by `confirmSubsystemSync`, a sync which fails or is dropped is queued
+ *          again by the next probe.
+ */
+static bool updateSubsystemFingerprint(const char *acronym, unsigned long long hash){
+    subsystemFingerprint* fingerprint = findSubsystemFingerprint(acronym);
+
+    if(!fingerprint){
+        fingerprint = (subsystemFingerprint*)malloc(sizeof(subsystemFingerprint));
+        if(!fingerprint){
+            log_message(LOG_ERROR, "Memory allocation error");
+            exit(1);
+        }
+
+        fingerprint->acronym = duplicate_Malloc(acronym);
+        fingerprint->isSynced = false;
+        fingerprint->syncedHash = 0;
+        fingerprint->next = subsystemFingerprints;
+        subsystemFingerprints = fingerprint;
+    }
+
+    fingerprint->probedHash = hash;
+
+    return !fingerprint->isSynced || fingerprint->syncedHash != hash;
+}
+
+void confirmSubsystemSync(const char *acronym){
+    subsystemFingerprint* fingerprint = findSubsystemFingerprint(acronym);
+
+    // Never probed, the first probe syncs it anyway
+    if(fingerprint){
+        fingerprint->syncedHash = fingerprint->probedHash;
+        fingerprint->isSynced = true;
+    }
+}
+
+static unsigned long long hashValueRange(const cJSON* valueRange, unsigned long long hash){
+    const cJSON* row;
+    cJSON_ArrayForEach(row, cJSON_GetObjectItemCaseSensitive(valueRange, "values")){
+        const cJSON* cell;
+        cJSON_ArrayForEach(cell, row){
+            hash = hashRequirementText(cJSON_IsString(cell) ? cell->valuestring : "", hash);
+        }
+
+        // Row separator, so that moving a cell to the next row changes the hash
+        hash = hashRequirementText("\n", hash);
+    }
+
+    return hash;
+}
+
+static const char* getSubsystemValue(const cJSON* subsystem, const char *column){
+    const cJSON* value = cJSON_GetObjectItem(subsystem, column);
+
+    return cJSON_IsString(value) ? value->valuestring : NULL;
+}
+
+/**
+ * @brief Fetches the Req_DB ranges of every subsystem stored in the spreadsheet of `subsystems[first]` and queues a
+ *        sync for each of them whose fingerprint changed.
+ *
+ * @param[in, out] isProbed Set for every subsystem which was probed.
+ *
+ * @return int Number of syncs queued.
+ */
+static int probeReqDbSpreadsheet(const cJSON* subsystems, int first, bool* isProbed){
+    int numberOfSubsystems = cJSON_GetArraySize(subsystems);
+    const char *spreadsheetId = getSubsystemValue(cJSON_GetArrayItem(subsystems, first), "Req_DB Spreadsheet ID");
+
+    const cJSON** probedSubsystems = (const cJSON**)malloc((size_t)numberOfSubsystems * sizeof(const cJSON*));
+    const char** ranges = (const char**)malloc((size_t)numberOfSubsystems * sizeof(const char*));
+    if(!probedSubsystems || !ranges){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    int numberOfRanges = 0;
+    for(int i = first; i < numberOfSubsystems; i++){
+        const cJSON* subsystem = cJSON_GetArrayItem(subsystems, i);
+        const char *otherSpreadsheetId = getSubsystemValue(subsystem, "Req_DB Spreadsheet ID");
+        const char *range = getSubsystemValue(subsystem, "Req_DB Sheet Acronym and Range");
+
+        if(isProbed[i] || !otherSpreadsheetId || strcmp(otherSpreadsheetId, spreadsheetId) != 0){
+            continue;
+        }
+
+        isProbed[i] = true;
+        if(!range || !getSubsystemValue(subsystem, "Acronym")){
+            log_message(LOG_ERROR, "A subsystem of spreadsheet %s has no acronym or range in the INFO sheet", spreadsheetId);
+            continue;
+        }
+
+        probedSubsystems[numberOfRanges] = subsystem;
+        ranges[numberOfRanges] = range;
+        numberOfRanges++;
+    }
+
+    int numberOfQueuedSyncs = 0;
+
+    batchGetSheetRanges(spreadsheetId, ranges, numberOfRanges);
+
+    cJSON* response = cJSON_Parse(chunk.response);
+    const cJSON* valueRanges = cJSON_GetObjectItemCaseSensitive(response, "valueRanges");
+
+    // The fingerprints are left as they were, the subsystems are probed again next time
+    if(!cJSON_IsArray(valueRanges) || cJSON_GetArraySize(valueRanges) != numberOfRanges){
+        log_message(LOG_ERROR, "Could not fetch the Req_DB ranges of spreadsheet %s", spreadsheetId);
+        numberOfRanges = 0;
+    }
+
+    const cJSON* valueRange = cJSON_IsArray(valueRanges) ? valueRanges->child : NULL;
+    for(int i = 0; i < numberOfRanges; i++, valueRange = valueRange->next){
+        const char *acronym = getSubsystemValue(probedSubsystems[i], "Acronym");
+
+        // The INFO row is hashed too, the DRL and VCD pages depend on it
+        unsigned long long hash = hashRequirementRow(probedSubsystems[i], NULL, REQUIREMENT_HASH_SEED);
+        hash = hashValueRange(valueRange, hash);
+
+        if(updateSubsystemFingerprint(acronym, hash)){
+            log_message(LOG_INFO, "The sheets of %s changed since it was last synced, queuing a sync", acronym);
+            numberOfQueuedSyncs += enqueueCommand(mainCommandQueue, "sync", acronym, COMMAND_PRIORITY_SCHEDULED);
+        }
+    }
+
+    cJSON_Delete(response);
+    freeChunkResponse();
+    free(probedSubsystems);
+    free(ranges);
+
+    return numberOfQueuedSyncs;
+}
+
+void checkForRequirementChanges(command cmd){
+    log_message(LOG_DEBUG, "Entering function checkForRequirementChanges");
+    (void)cmd;
+
+    cJSON* subsystems = getSubsystemsInfo();
+    freeChunkResponse();
+
+    if(!subsystems){
+        log_message(LOG_ERROR, "Could not fetch the INFO sheet, skipping this change probe");
+        log_message(LOG_DEBUG, "Exiting function checkForRequirementChanges");
+        return;
+    }
+
+    int numberOfSubsystems = cJSON_GetArraySize(subsystems);
+    bool* isProbed = (bool*)calloc((size_t)numberOfSubsystems + 1, sizeof(bool));
+    if(!isProbed){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    int numberOfQueuedSyncs = 0;
+    for(int i = 0; i < numberOfSubsystems; i++){
+        if(isProbed[i]){
+            continue;
+        }
+
+        if(!getSubsystemValue(cJSON_GetArrayItem(subsystems, i), "Req_DB Spreadsheet ID")){
+            log_message(LOG_ERROR, "A subsystem has no Req_DB spreadsheet in the INFO sheet");
+            isProbed[i] = true;
+            continue;
+        }
+
+        numberOfQueuedSyncs += probeReqDbSpreadsheet(subsystems, i, isProbed);
+    }
+
+    log_message(LOG_DEBUG, "Change probe queued %d syncs", numberOfQueuedSyncs);
+
+    free(isProbed);
+    cJSON_Delete(subsystems);
+
+    log_message(LOG_DEBUG, "Exiting function checkForRequirementChanges");
+}
+
+const commandDefinition checkForChangesCommandDefinition = {
+    .name = "checkForChanges",
+    .argumentType = COMMAND_ARGUMENT_NONE,
+    .concurrencyClass = COMMAND_CONCURRENCY_PROBE,
+    .reportsStatus = false,
+    .description = "Queues a sync for every subsystem whose INFO row or requirement sheet changed since the last check, it also runs on its own every few minutes.",
+    .argumentDescription = NULL,
+    .example = NULL,
+    .handler = checkForRequirementChanges,
+};
@@ -1,12 +1,19 @@
+#define LOG_MODULE LOG_MODULE_FEATURES
+
+#include <stdbool.h>
 #include <string.h>
 #include <cjson/cJSON.h>
 #include "ERTbot_common.h"
+#include "ERTbot_features.h"
 #include "sheetAPI.h"
 #include "wikiAPI.h"
+#include "wikiMutationBatch.h"
 #include "requirementsHelpers.h"
 #include "stringHelpers.h"
 #include "slackAPI.h"
 #include "pageListHelpers.h"
+#include "ERTbot_command.h"
+#include "fetchStage.h"
 
 void createMissingRequirementPages(command cmd){
     log_message(LOG_DEBUG, "Entering function createMissingRequirementPages");
@@ -15,14 +22,54 @@ void createMissingRequirementPages(command cmd){
 
     updateCommandStatusMessage("fetching subsystem info");
     cJSON* subsystem = getSubsystemInfo(cmd.argument);
+    if(!subsystem){
+        sendMessageToSlack("Subsystem was not found, check the acronym in the INFO sheet");
+        log_message(LOG_DEBUG, "Exiting function createMissingRequirementPages");
+        return;
+    }
     const char *path = cJSON_GetObjectItem(subsystem, "Requirement Pages Directory")->valuestring;
 
-    updateCommandStatusMessage("fetching existing requirements pages");
-    requirementPagesHead = populatePageList(&requirementPagesHead, "path", path);
+    // The existing pages and the requirements are fetched at the same time
+    updateCommandStatusMessage("fetching existing requirements pages and requirements");
+    fetchStage stage;
+    initializeFetchStage(&stage);
+    int pageListFetch = addPageListFetch(&stage, "path");
+    int requirementsFetch = addRequirementsFetch(&stage, subsystem);
+    runFetchStage(&stage);
+
+    const char *pageListResponse = getFetchResponse(&stage, pageListFetch);
+    const char *requirementsResponse = getFetchResponse(&stage, requirementsFetch);
+    if(!pageListResponse || !requirementsResponse){
+        sendMessageToSlack("Could not fetch the requirement pages or the requirements, try again later");
+        freeFetchStage(&stage);
+        cJSON_Delete(subsystem);
+        log_message(LOG_DEBUG, "Exiting function createMissingRequirementPages");
+        return;
+    }
+
+    requirementPagesHead = parseJSON(&requirementPagesHead, pageListResponse, "path", path);
+    cJSON *requirementList = parseArrayIntoJSONRequirementList(requirementsResponse);
+    freeFetchStage(&stage);
+
+    updateCommandStatusMessage("finding missing requirement pages");
+    (void)queueMissingRequirementPages(subsystem, requirementList, requirementPagesHead, true);
+
+    (void)flushWikiMutations();
+
+    cJSON_Delete(requirementList);
+    cJSON_Delete(subsystem);
+    freePageList(&requirementPagesHead);
+
+    log_message(LOG_DEBUG, "Exiting function createMissingRequirementPages");
+    return;
+}
+
+int queueMissingRequirementPages(const cJSON* subsystem, const cJSON* requirementList, const pageList* requirementPages, bool reportsProgress){
+    log_message(LOG_DEBUG, "Entering function queueMissingRequirementPages");
+
+    const char *path = cJSON_GetObjectItem(subsystem, "Requirement Pages Directory")->valuestring;
+    int numberOfQueuedPages = 0;
 
-    updateCommandStatusMessage("fetching requirements");
-    cJSON *requirementList = getRequirements(subsystem);
-    
     // Get the requirements array from the requirementList object
     const cJSON *requirements = cJSON_GetObjectItemCaseSensitive(requirementList, "requirements");
     if (!cJSON_IsArray(requirements)) {
@@ -32,7 +79,6 @@ void createMissingRequirementPages(command cmd){
     // Iterate over each requirement object in the requirements array
     int num_reqs = cJSON_GetArraySize(requirements);
 
-    updateCommandStatusMessage("finding missing requirement pages");
     for (int i = 0; i < num_reqs; i++) {
         const cJSON *requirement = cJSON_GetArrayItem(requirements, i);
 
@@ -43,7 +89,7 @@ void createMissingRequirementPages(command cmd){
 
         // Get and print each item of the requirement object
         cJSON *id = cJSON_GetObjectItemCaseSensitive(requirement, "ID");
-        pageList* currentReqPage = requirementPagesHead;
+        const pageList* currentReqPage = requirementPages;
         int foundPage = 0;
 
         log_message(LOG_DEBUG, "Looking for page corresponding to requiremet: %s", id->valuestring);
@@ -74,21 +120,35 @@ void createMissingRequirementPages(command cmd){
             reqContent = appendToString(reqContent, id->valuestring);
             reqContent = appendToString(reqContent, "-->");
             log_message(LOG_DEBUG, "About to create new page path:%s\nTitle:%s", reqPath, id->valuestring);
-            
-            updateCommandStatusMessage("creating a new page");
-            createPageMutation(reqPath, reqContent, id->valuestring);
+
+            if(reportsProgress){
+                updateCommandStatusMessage("creating a new page");
+            }
+            queuePageCreation(reqPath, reqContent, id->valuestring);
+            numberOfQueuedPages++;
 
             free(reqPath);
             free(reqContent);
         }
 
-        sendLoadingBar(i, num_reqs);
-    }
+        if(reportsProgress){
+            sendLoadingBar(i, num_reqs);
+        }
 
-    cJSON_Delete(requirementList);
-    cJSON_Delete(subsystem);
-    freePageList(&requirementPagesHead);
+        yieldToInteractiveCommands();
+    }
 
-    log_message(LOG_DEBUG, "Exiting function createMissingRequirementPages");
-    return;
+    log_message(LOG_DEBUG, "Exiting function queueMissingRequirementPages");
+    return numberOfQueuedPages;
 }
+
+const commandDefinition createMissingRequirementPagesCommandDefinition = {
+    .name = "createMissingRequirementPages",
+    .argumentType = COMMAND_ARGUMENT_SUBSYSTEM,
+    .concurrencyClass = COMMAND_CONCURRENCY_SUBSYSTEM,
+    .reportsStatus = true,
+    .description = "Creates a page for every requirement of the subsystem which does not have one yet.",
+    .argumentDescription = "acronym of the subsystem you want to update",
+    .example = "createMissingRequirementPages ST",
+    .handler = createMissingRequirementPages,
+};
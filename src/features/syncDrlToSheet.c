@@ -1,13 +1,19 @@
+#define LOG_MODULE LOG_MODULE_FEATURES
+
 #include <stdbool.h>
 #include <string.h>
 #include <cjson/cJSON.h>
 #include "ERTbot_common.h"
+#include "ERTbot_features.h"
 #include "sheetAPI.h"
 #include "requirementsHelpers.h"
 #include "stringHelpers.h"
 #include "wikiAPI.h"
+#include "wikiMutationBatch.h"
 #include "pageListHelpers.h"
 #include "slackAPI.h"
+#include "requirementSnapshotHelpers.h"
+#include "commandJournalHelpers.h"
 
 
 #define DRL_TABSET_TITLE_TEMPLATE "\n\n\n## $ID$\n"
@@ -19,27 +25,9 @@
 
 char *template_DRL = "# $SubSystem$ Design Requirements List\n# table {.tabset}";
 
-/**
- * @brief Builds a DRL (Design Requirements List) string from a JSON object containing requirements.
- *
- * This function constructs a DRL string by iterating over a JSON array of requirement objects. Each requirement
- * object is expected to contain specific fields such as "ID", "Path", "Title", and "Description". The resulting
- * DRL string is built by appending formatted information from each requirement to a template DRL string.
- *
- * @param requirementList A `cJSON` object containing an array of requirement objects under the "requirements" key.
- *
- * @return A dynamically allocated string containing the formatted DRL. The caller is responsible for freeing this memory. If the input JSON is not properly formatted or if memory allocation fails, the function may return an incorrect or partially filled string.
- *
- * @details
- * - The function first retrieves the "requirements" array from the `requirementList` object.
- * - It initializes the DRL string using a predefined template.
- * - For each requirement object in the array, it extracts the fields "ID", "Path", "Title", and "Description".
- * - These fields are appended to the DRL string in a specific format, including separators and markers.
- * - After processing all requirements, the function appends "{.links-list}" to the end of the DRL string.
- * - If any errors are encountered (e.g., missing "requirements" array or incorrect object format), appropriate error messages are printed.
- * - The function returns the final DRL string.
- */
-static char *buildDrlFromJSONRequirementList(const cJSON *requirementList, const cJSON* subsystem);
+// Everything buildDrlFromJSONRequirementList reads, the DRL is only rebuilt when one of them changed
+static const char* const drlRequirementColumns[] = {"ID", "Title", "Description", NULL};
+static const char* const drlSubsystemColumns[] = {"Name", "Requirement Pages Directory", "DRL Page ID", NULL};
 
 
 void syncDrlToSheet(command cmd){
@@ -47,11 +35,54 @@ void syncDrlToSheet(command cmd){
 
     updateCommandStatusMessage("fetching subsystem info");
     cJSON* subsystem = getSubsystemInfo(cmd.argument);
+    if(!subsystem){
+        sendMessageToSlack("Subsystem was not found, check the acronym in the INFO sheet");
+        log_message(LOG_DEBUG, "Exiting function syncDrlToSheet");
+        return;
+    }
 
     updateCommandStatusMessage("fetching requirements");
     cJSON *requirementList = getRequirements(subsystem);
 
-    updateCommandStatusMessage("building DRL page content");
+    updateCommandStatusMessage("updating DRL page");
+    requirementSnapshot* snapshot = queueDrlUpdate(subsystem, requirementList);
+    if(!snapshot){
+        updateCommandStatusMessage("DRL page is already up to date");
+    }
+    else{
+        (void)flushWikiMutations();
+        (void)saveRequirementSnapshot(snapshot);
+    }
+    freeRequirementSnapshot(snapshot);
+
+    cJSON_Delete(requirementList);
+    cJSON_Delete(subsystem);
+
+    log_message(LOG_DEBUG, "Exiting function syncDrlToSheet");
+    return;
+}
+
+requirementSnapshot* queueDrlUpdate(const cJSON* subsystem, const cJSON* requirementList){
+    log_message(LOG_DEBUG, "Entering function queueDrlUpdate");
+
+    unsigned long long hash = hashRequirementRow(subsystem, drlSubsystemColumns, REQUIREMENT_HASH_SEED);
+    hash = hashRequirementList(cJSON_GetObjectItemCaseSensitive(requirementList, "requirements"), drlRequirementColumns, hash);
+    const char *acronym = cJSON_GetObjectItem(subsystem, "Acronym")->valuestring;
+    requirementSnapshot* snapshot = loadRequirementSnapshot(acronym, "drl");
+    if(!isRequirementChanged(snapshot, "DRL", hash)){
+        freeRequirementSnapshot(snapshot);
+        log_message(LOG_DEBUG, "Exiting function queueDrlUpdate");
+        return NULL;
+    }
+
+    // Already updated before the bot stopped, only the snapshot is left to save
+    char* checkpoint = buildCheckpointKey("drl", acronym, hash);
+    if(isCommandCheckpointed(checkpoint)){
+        free(checkpoint);
+        log_message(LOG_DEBUG, "Exiting function queueDrlUpdate");
+        return snapshot;
+    }
+
     char *DRL = buildDrlFromJSONRequirementList(requirementList, subsystem);
 
     pageList* drlPage = NULL;
@@ -63,20 +94,28 @@ void syncDrlToSheet(command cmd){
 
     drlPage = addPageToList(&drlPage, drlPageId, NULL, NULL, NULL, DRL, NULL);
 
-    updateCommandStatusMessage("updating DRL page");
-    updatePageContentMutation(drlPage);
-    renderMutation(&drlPage, false);
+    queuePageUpdate(drlPage, checkpoint, snapshot, "DRL");
+    queuePageRender(drlPage);
     freePageList(&drlPage);
-
-    cJSON_Delete(requirementList);
-    cJSON_Delete(subsystem);
+    free(checkpoint);
 
     free(DRL);
-    log_message(LOG_DEBUG, "Exiting function syncDrlToSheet");
-    return;
+    log_message(LOG_DEBUG, "Exiting function queueDrlUpdate");
+    return snapshot;
 }
 
-static char *buildDrlFromJSONRequirementList(const cJSON *requirementList, const cJSON* subsystem){
+const commandDefinition updateDrlCommandDefinition = {
+    .name = "updateDRL",
+    .argumentType = COMMAND_ARGUMENT_SUBSYSTEM,
+    .concurrencyClass = COMMAND_CONCURRENCY_SUBSYSTEM,
+    .reportsStatus = true,
+    .description = "Rebuilds the DRL page of the subsystem from its requirement sheet.",
+    .argumentDescription = "acronym of the subsystem you want to update",
+    .example = "updateDRL ST",
+    .handler = syncDrlToSheet,
+};
+
+char *buildDrlFromJSONRequirementList(const cJSON *requirementList, const cJSON* subsystem){
     log_message(LOG_DEBUG, "Entering function buildDrlFromJSONRequirementList");
 
     // Get the requirements array from the requirementList object
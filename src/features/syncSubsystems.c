@@ -0,0 +1,376 @@
+/**
+ * @file syncSubsystems.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the `sync` command, which syncs one, several or every subsystem in stages.
+ *
+ * @details Syncing the subsystems one after the other repeats the same requests for each of them: the INFO sheet, the
+ *          listing of every wiki page and a flush per feature. Here each stage is run once for all of the subsystems:
+ *          1. The INFO sheet and the wiki page list are fetched at the same time.
+ *          2. The Req_DB ranges of every subsystem are fetched, `FETCH_STAGE_MAX_REQUESTS` at the same time.
+ *          3. The missing requirement pages of every subsystem are created, the pages are listed again if any was.
+ *          4. The DRL, requirement and VCD pages of every subsystem are rebuilt and written with a single flush,
+ *             the full mutation batches being sent concurrently while the next pages are built.
+ */
+
+#define LOG_MODULE LOG_MODULE_FEATURES
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cjson/cJSON.h>
+#include "ERTbot_common.h"
+#include "ERTbot_features.h"
+#include "ERTbot_command.h"
+#include "ERTbot_trace.h"
+#include "wikiAPI.h"
+#include "wikiMutationBatch.h"
+#include "requirementsHelpers.h"
+#include "requirementSnapshotHelpers.h"
+#include "pageListHelpers.h"
+#include "stringHelpers.h"
+#include "slackAPI.h"
+#include "fetchStage.h"
+
+/**
+ * @brief Everything the stages of a sync need to know about a subsystem.
+ *
+ * @details `subsystem` is a row of the INFO sheet, owned by the array it was read from. `requirementList` is NULL if
+ *          the Req_DB range of the subsystem could not be fetched, the subsystem is then skipped. `hasFailedMutations`
+ *          is set if a page of the subsystem may not have been created or updated.
+ */
+typedef struct subsystemData {
+    const cJSON *subsystem;
+    cJSON *requirementList;
+    pageList *requirementPages;
+    int numberOfCreatedPages;
+    bool hasFailedMutations;
+    struct subsystemData *next;
+} subsystemData;
+
+static const char* getAcronym(const cJSON* subsystem){
+    const cJSON* acronym = cJSON_GetObjectItem(subsystem, "Acronym");
+
+    return cJSON_IsString(acronym) ? acronym->valuestring : NULL;
+}
+
+static const cJSON* findSubsystem(const cJSON* subsystems, const char *acronym){
+    const cJSON* subsystem;
+    cJSON_ArrayForEach(subsystem, subsystems){
+        const char *subsystemAcronym = getAcronym(subsystem);
+        if(subsystemAcronym && strcmp(subsystemAcronym, acronym) == 0){
+            return subsystem;
+        }
+    }
+
+    return NULL;
+}
+
+static subsystemData* addSubsystemData(subsystemData** tail, const cJSON* subsystem){
+    subsystemData* data = (subsystemData*)calloc(1, sizeof(subsystemData));
+    if(!data){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    data->subsystem = subsystem;
+
+    if(*tail){
+        (*tail)->next = data;
+    }
+    *tail = data;
+
+    return data;
+}
+
+/**
+ * @brief Selects the subsystems named by the argument of `sync`, in the order of the argument or of the INFO sheet
+ *        for "all".
+ *
+ * @return subsystemData* Head of the list, NULL if none of the subsystems was found.
+ */
+static subsystemData* selectSubsystems(const cJSON* subsystems, const char *argument){
+    subsystemData* head = NULL;
+    subsystemData* tail = NULL;
+
+    if(strcmp(argument, "all") == 0){
+        const cJSON* subsystem;
+        cJSON_ArrayForEach(subsystem, subsystems){
+            if(!getAcronym(subsystem)){
+                continue;
+            }
+
+            subsystemData* data = addSubsystemData(&tail, subsystem);
+            head = head ? head : data;
+        }
+
+        return head;
+    }
+
+    char* acronyms = duplicate_Malloc(argument);
+    char* savePointer = NULL;
+    for(char* acronym = strtok_r(acronyms, ",", &savePointer); acronym; acronym = strtok_r(NULL, ",", &savePointer)){
+        const cJSON* subsystem = findSubsystem(subsystems, acronym);
+        if(!subsystem){
+            char* message = createCombinedString("Subsystem was not found, check the acronym in the INFO sheet: ", acronym);
+            sendMessageToSlack(message);
+            free(message);
+            continue;
+        }
+
+        bool isAlreadySelected = false;
+        for(const subsystemData* data = head; data; data = data->next){
+            isAlreadySelected = isAlreadySelected || data->subsystem == subsystem;
+        }
+        if(isAlreadySelected){
+            continue;
+        }
+
+        subsystemData* data = addSubsystemData(&tail, subsystem);
+        head = head ? head : data;
+    }
+
+    free(acronyms);
+    return head;
+}
+
+static void freeSubsystemData(subsystemData* head){
+    while(head){
+        subsystemData* next = head->next;
+        cJSON_Delete(head->requirementList);
+        freePageList(&head->requirementPages);
+        free(head);
+        head = next;
+    }
+}
+
+/**
+ * @brief Parses the listing of every wiki page into the requirement pages of each subsystem.
+ */
+static void parseRequirementPages(subsystemData* head, const char *pageListResponse){
+    for(subsystemData* data = head; data; data = data->next){
+        const char *path = cJSON_GetObjectItem(data->subsystem, "Requirement Pages Directory")->valuestring;
+
+        freePageList(&data->requirementPages);
+        data->requirementPages = parseJSON(&data->requirementPages, pageListResponse, "path", path);
+    }
+}
+
+/**
+ * @brief Fetches the Req_DB range of every subsystem, `FETCH_STAGE_MAX_REQUESTS` at the same time.
+ *
+ * @return int Number of subsystems whose requirements could not be fetched.
+ */
+static int fetchRequirementLists(subsystemData* head){
+    int numberOfFailedFetches = 0;
+
+    subsystemData* first = head;
+    while(first){
+        fetchStage stage;
+        initializeFetchStage(&stage);
+
+        subsystemData* last = first;
+        int fetches[FETCH_STAGE_MAX_REQUESTS];
+        int numberOfFetches = 0;
+        for(subsystemData* data = first; data && numberOfFetches < FETCH_STAGE_MAX_REQUESTS; data = data->next){
+            fetches[numberOfFetches++] = addRequirementsFetch(&stage, data->subsystem);
+            last = data;
+        }
+
+        runFetchStage(&stage);
+
+        int i = 0;
+        for(subsystemData* data = first; i < numberOfFetches; data = data->next, i++){
+            const char *response = getFetchResponse(&stage, fetches[i]);
+            data->requirementList = response ? parseArrayIntoJSONRequirementList(response) : NULL;
+            if(!data->requirementList){
+                log_message(LOG_ERROR, "Could not fetch the requirements of %s, skipping it", getAcronym(data->subsystem));
+                numberOfFailedFetches++;
+            }
+        }
+
+        freeFetchStage(&stage);
+        first = last->next;
+    }
+
+    return numberOfFailedFetches;
+}
+
+/**
+ * @brief Lists every wiki page again, to get the ids of the pages which were just created.
+ *
+ * @return int 0 on success, 1 if the pages could not be listed.
+ */
+static int refreshRequirementPages(subsystemData* head){
+    fetchStage stage;
+    initializeFetchStage(&stage);
+    int pageListFetch = addPageListFetch(&stage, "path");
+    runFetchStage(&stage);
+
+    const char *pageListResponse = getFetchResponse(&stage, pageListFetch);
+    int result = pageListResponse ? 0 : 1;
+    if(pageListResponse){
+        parseRequirementPages(head, pageListResponse);
+    }
+
+    freeFetchStage(&stage);
+    return result;
+}
+
+/**
+ * @brief Queues the creation of the missing requirement pages of every subsystem.
+ *
+ * @return int Number of mutations the wiki did not apply, or 1 if the pages could not be listed again.
+ *
+ * @details A failed creation cannot be traced back to its subsystem, every subsystem which created pages is marked as
+ *          failed then.
+ */
+static int createMissingPages(subsystemData* head){
+    int numberOfCreatedPages = 0;
+
+    for(subsystemData* data = head; data; data = data->next){
+        if(data->requirementList){
+            data->numberOfCreatedPages = queueMissingRequirementPages(data->subsystem, data->requirementList, data->requirementPages, false);
+            numberOfCreatedPages += data->numberOfCreatedPages;
+        }
+    }
+
+    int numberOfFailedMutations = flushWikiMutations();
+
+    if(numberOfCreatedPages > 0){
+        log_message(LOG_INFO, "sync: created %d requirement pages", numberOfCreatedPages);
+        numberOfFailedMutations += refreshRequirementPages(head);
+    }
+
+    for(subsystemData* data = head; data && numberOfFailedMutations > 0; data = data->next){
+        data->hasFailedMutations = data->hasFailedMutations || data->numberOfCreatedPages > 0;
+    }
+
+    return numberOfFailedMutations;
+}
+
+/**
+ * @brief Rebuilds the DRL, requirement and VCD pages of every subsystem and saves their snapshots.
+ *
+ * @return int Number of mutations the wiki did not apply.
+ *
+ * @details The flush forgets the requirements whose mutation failed from the snapshots, so only they are retried by
+ *          the next sync. A subsystem with a forgotten requirement is marked as failed.
+ */
+static int updatePages(subsystemData* head, int numberOfSubsystems){
+    // Three snapshots per subsystem: DRL, requirement pages and VCD, NULL when a page is up to date
+    requirementSnapshot** snapshots = (requirementSnapshot**)calloc((size_t)numberOfSubsystems * 3, sizeof(requirementSnapshot*));
+    if(!snapshots){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    int numberOfUpdatedSubsystems = 0;
+    requirementSnapshot** subsystemSnapshots = snapshots;
+    for(subsystemData* data = head; data; data = data->next, subsystemSnapshots += 3){
+        if(data->requirementList){
+            subsystemSnapshots[0] = queueDrlUpdate(data->subsystem, data->requirementList);
+            subsystemSnapshots[1] = queueRequirementPageUpdates(data->subsystem, data->requirementList, &data->requirementPages, false);
+            subsystemSnapshots[2] = queueVcdUpdate(data->subsystem, data->requirementList);
+        }
+
+        numberOfUpdatedSubsystems++;
+        sendLoadingBar(numberOfUpdatedSubsystems, numberOfSubsystems);
+    }
+
+    int numberOfFailedMutations = flushWikiMutations();
+
+    subsystemSnapshots = snapshots;
+    for(subsystemData* data = head; data; data = data->next, subsystemSnapshots += 3){
+        for(int i = 0; i < 3; i++){
+            if(!subsystemSnapshots[i]){
+                continue;
+            }
+
+            data->hasFailedMutations = data->hasFailedMutations || countForgottenRequirements(subsystemSnapshots[i]) > 0;
+            (void)saveRequirementSnapshot(subsystemSnapshots[i]);
+            freeRequirementSnapshot(subsystemSnapshots[i]);
+        }
+    }
+
+    free(snapshots);
+
+    return numberOfFailedMutations;
+}
+
+void syncSubsystems(command cmd){
+    log_message(LOG_DEBUG, "Entering function syncSubsystems");
+
+    beginTraceSpan(TRACE_CATEGORY_FEATURE, "fetchSubsystems", cmd.argument);
+    updateCommandStatusMessage("fetching subsystem info and wiki pages");
+
+    fetchStage stage;
+    initializeFetchStage(&stage);
+    int subsystemsInfoFetch = addSubsystemsInfoFetch(&stage);
+    int pageListFetch = addPageListFetch(&stage, "path");
+    runFetchStage(&stage);
+
+    const char *subsystemsInfoResponse = getFetchResponse(&stage, subsystemsInfoFetch);
+    const char *pageListResponse = getFetchResponse(&stage, pageListFetch);
+    cJSON* subsystems = subsystemsInfoResponse ? parseSubsystemsInfo(subsystemsInfoResponse) : NULL;
+    if(!subsystems || !pageListResponse){
+        sendMessageToSlack("Could not fetch the INFO sheet or the wiki pages, try again later");
+        freeFetchStage(&stage);
+        cJSON_Delete(subsystems);
+        endTraceSpan();
+        log_message(LOG_DEBUG, "Exiting function syncSubsystems");
+        return;
+    }
+
+    subsystemData* head = selectSubsystems(subsystems, cmd.argument);
+    parseRequirementPages(head, pageListResponse);
+    freeFetchStage(&stage);
+
+    int numberOfSubsystems = 0;
+    for(const subsystemData* data = head; data; data = data->next){
+        numberOfSubsystems++;
+    }
+
+    updateCommandStatusMessage("fetching requirements");
+    int numberOfFailedFetches = fetchRequirementLists(head);
+    endTraceSpan();
+
+    beginTraceSpan(TRACE_CATEGORY_FEATURE, "createMissingRequirementPages", cmd.argument);
+    updateCommandStatusMessage("creating missing requirement pages");
+    int numberOfFailedMutations = createMissingPages(head);
+    endTraceSpan();
+
+    beginTraceSpan(TRACE_CATEGORY_FEATURE, "updatePages", cmd.argument);
+    updateCommandStatusMessage("updating DRL, requirement and VCD pages");
+    numberOfFailedMutations += updatePages(head, numberOfSubsystems);
+    endTraceSpan();
+
+    // The change probe stops queuing the subsystems whose every page was synced
+    for(const subsystemData* data = head; data; data = data->next){
+        if(data->requirementList && !data->hasFailedMutations && getAcronym(data->subsystem)){
+            confirmSubsystemSync(getAcronym(data->subsystem));
+        }
+    }
+
+    log_message(LOG_INFO, "sync %s: %d subsystems, %d could not be fetched, %d mutations failed", cmd.argument,
+                numberOfSubsystems, numberOfFailedFetches, numberOfFailedMutations);
+
+    if(numberOfFailedFetches > 0 || numberOfFailedMutations > 0){
+        sendMessageToSlack("Some pages could not be synced, they will be retried by the next sync");
+    }
+
+    freeSubsystemData(head);
+    cJSON_Delete(subsystems);
+
+    log_message(LOG_DEBUG, "Exiting function syncSubsystems");
+}
+
+const commandDefinition syncCommandDefinition = {
+    .name = "sync",
+    .argumentType = COMMAND_ARGUMENT_SUBSYSTEM_LIST,
+    .concurrencyClass = COMMAND_CONCURRENCY_SUBSYSTEM,
+    .reportsStatus = true,
+    .description = "Fully synchronises the requirements of the subsystems: creates the missing requirement pages, then updates the DRL, requirement and VCD pages.",
+    .argumentDescription = "acronym of the subsystem you want to update, comma separated acronyms or all",
+    .example = "sync ST or sync ST,GE or sync all",
+    .handler = syncSubsystems,
+};
@@ -1,15 +1,24 @@
+#define LOG_MODULE LOG_MODULE_FEATURES
+
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 #include <cjson/cJSON.h>
 #include "ERTbot_config.h"
 #include "ERTbot_common.h"
+#include "ERTbot_features.h"
 #include "sheetAPI.h"
 #include "stringHelpers.h"
 #include "wikiAPI.h"
+#include "wikiMutationBatch.h"
 #include "requirementsHelpers.h"
 #include "pageListHelpers.h"
 #include "slackAPI.h"
+#include "ERTbot_command.h"
+#include "ERTbot_metrics.h"
+#include "requirementSnapshotHelpers.h"
+#include "fetchStage.h"
+#include "commandJournalHelpers.h"
 
 #define ID_BLOCK_TEMPLATE "\n# $ID$: "
 #define TITLE_BLOCK_TEMPLATE "$Title$\n"
@@ -56,37 +65,103 @@
  */
 static char *buildRequirementPageFromJSONRequirementList(const cJSON *requirement);
 
-static void updateRequirementPageContent(pageList* reqPage, const cJSON *requirement);
+static void updateRequirementPageContent(pageList* reqPage, const cJSON *requirement, const char *checkpoint, requirementSnapshot* snapshot);
 
 static void addVerificationInformationToPageContent(char** pageContent, const cJSON* requirement);
 
+static void updateSingleRequirementPage(const char* requirementId);
+
+static pageList* removeUnchangedRequirementPages(pageList* head, const cJSON* requirements, requirementSnapshot* snapshot);
+
+static unsigned long long hashRequirementPage(const pageList* page, const cJSON* requirement);
+
 void updateRequirementPage(command cmd){
     log_message(LOG_DEBUG, "Entering function updateRequirementPages");
 
+    if(isRequirementId(cmd.argument)){
+        updateSingleRequirementPage(cmd.argument);
+
+        log_message(LOG_DEBUG, "Exiting function updateRequirementPage");
+        return;
+    }
+
     updateCommandStatusMessage("fetching subsystem info");
     cJSON* subsystem = getSubsystemInfo(cmd.argument);
+    if(!subsystem){
+        sendMessageToSlack("Subsystem was not found, check the acronym in the INFO sheet");
+        log_message(LOG_DEBUG, "Exiting function updateRequirementPage");
+        return;
+    }
     const char *path = cJSON_GetObjectItem(subsystem, "Requirement Pages Directory")->valuestring;
     
-    updateCommandStatusMessage("fetching requirements");
-    cJSON *requirementList = getRequirements(subsystem);
+    // The requirements and the requirement pages are fetched at the same time
+    updateCommandStatusMessage("fetching requirements and requirement pages");
+    fetchStage stage;
+    initializeFetchStage(&stage);
+    int requirementsFetch = addRequirementsFetch(&stage, subsystem);
+    int pageListFetch = addPageListFetch(&stage, "path");
+    runFetchStage(&stage);
+
+    const char *requirementsResponse = getFetchResponse(&stage, requirementsFetch);
+    const char *pageListResponse = getFetchResponse(&stage, pageListFetch);
+    if(!requirementsResponse || !pageListResponse){
+        sendMessageToSlack("Could not fetch the requirements or the requirement pages, try again later");
+        freeFetchStage(&stage);
+        cJSON_Delete(subsystem);
+        log_message(LOG_DEBUG, "Exiting function updateRequirementPage");
+        return;
+    }
 
-    updateCommandStatusMessage("fetching requirement pages");
+    cJSON *requirementList = parseArrayIntoJSONRequirementList(requirementsResponse);
     pageList* requirementPagesHead = NULL;
-    requirementPagesHead = populatePageList(&requirementPagesHead, "path", path);
-    pageList* currentReqPage = requirementPagesHead;
+    requirementPagesHead = parseJSON(&requirementPagesHead, pageListResponse, "path", path);
+    freeFetchStage(&stage);
 
-    const cJSON *requirements = cJSON_GetObjectItemCaseSensitive(requirementList, "requirements");
+    updateCommandStatusMessage("updating requirement pages");
+    requirementSnapshot* snapshot = queueRequirementPageUpdates(subsystem, requirementList, &requirementPagesHead, true);
 
+    // The requirements whose update failed are forgotten by the flush, the next run retries them
+    (void)flushWikiMutations();
+    (void)saveRequirementSnapshot(snapshot);
+    freeRequirementSnapshot(snapshot);
+
+    cJSON_Delete(requirementList);
+    cJSON_Delete(subsystem);
+    freePageList(&requirementPagesHead);
+
+    log_message(LOG_DEBUG, "Exiting function updateRequirementPage");
+    return;
+}
+
+requirementSnapshot* queueRequirementPageUpdates(const cJSON* subsystem, const cJSON* requirementList, pageList** requirementPages, bool reportsProgress){
+    log_message(LOG_DEBUG, "Entering function queueRequirementPageUpdates");
+
+    const char *acronym = cJSON_GetObjectItem(subsystem, "Acronym")->valuestring;
+    const cJSON *requirements = cJSON_GetObjectItemCaseSensitive(requirementList, "requirements");
 
     if (!cJSON_IsArray(requirements)) {
         log_message(LOG_ERROR, "Error: requirements is not a JSON array");
     }
 
-    updateCommandStatusMessage("updating requirement pages");
+    // Only the pages of the requirements which changed since the last run are fetched and rebuilt
+    requirementSnapshot* snapshot = loadRequirementSnapshot(acronym, "req");
+    *requirementPages = removeUnchangedRequirementPages(*requirementPages, requirements, snapshot);
+    pageList* currentReqPage = *requirementPages;
+
     int cnt = 0;
-    int num_reqs = cJSON_GetArraySize(requirements);
+    int num_reqs = 0;
+    for(const pageList* page = *requirementPages; page; page = page->next){
+        num_reqs++;
+    }
+    log_message(LOG_INFO, "updateReq %s: %d requirement pages to update, %d requirements removed since the last run", acronym, num_reqs, countRemovedRequirements(snapshot));
+    pageList* nextPageToFetch = *requirementPages;
     while (currentReqPage){
-        for (int i = 0; i < num_reqs; i++) {
+        // The content of the next pages is fetched in one request, each page's content is freed once it is updated
+        if(currentReqPage == nextPageToFetch){
+            nextPageToFetch = getPages(currentReqPage, WIKI_PAGE_FETCH_BATCH_SIZE);
+        }
+
+        for (int i = 0; i < cJSON_GetArraySize(requirements); i++) {
             const cJSON *requirement = cJSON_GetArrayItem(requirements, i);
 
             if (!cJSON_IsObject(requirement)) {
@@ -100,56 +175,225 @@ void updateRequirementPage(command cmd){
                 continue;
             }
 
-            updateRequirementPageContent(currentReqPage, requirement);
+            char* checkpoint = buildCheckpointKey("req", id->valuestring, hashRequirementPage(currentReqPage, requirement));
+            updateRequirementPageContent(currentReqPage, requirement, checkpoint, snapshot);
+            free(checkpoint);
 
             break;
         }
 
+        free(currentReqPage->content);
+        currentReqPage->content = NULL;
+
         cnt++;
-        sendLoadingBar(cnt, num_reqs);
+        if(reportsProgress){
+            sendLoadingBar(cnt, num_reqs);
+        }
 
         currentReqPage = currentReqPage->next;
+
+        yieldToInteractiveCommands();
     }
 
-    cJSON_Delete(requirementList);
-    cJSON_Delete(subsystem);
-    freePageList(&requirementPagesHead);
+    log_message(LOG_DEBUG, "Exiting function queueRequirementPageUpdates");
+    return snapshot;
+}
 
-    log_message(LOG_DEBUG, "Exiting function updateRequirementPage");
-    return;
+/**
+ * @brief Hashes a requirement row with the id of its page, so that a page which was deleted and created again is
+ *        rebuilt.
+ */
+static unsigned long long hashRequirementPage(const pageList* page, const cJSON* requirement){
+    return hashRequirementRow(requirement, NULL, hashRequirementText(page->id, REQUIREMENT_HASH_SEED));
 }
 
-static void updateRequirementPageContent(pageList* reqPage, const cJSON *requirement){
+/**
+ * @brief Removes from a list of requirement pages the pages whose requirement row did not change since the last run,
+ *        the pages already updated by this command before the bot stopped, and the pages of no requirement.
+ *
+ * @details A requirement is keyed by its ID and hashed with `hashRequirementPage`.
+ *
+ * @return pageList* The head of the list.
+ */
+static pageList* removeUnchangedRequirementPages(pageList* head, const cJSON* requirements, requirementSnapshot* snapshot){
+    log_message(LOG_DEBUG, "Entering function removeUnchangedRequirementPages");
 
-    free(reqPage->title);
-    reqPage->title = NULL;
+    pageList** link = &head;
+    while(*link){
+        pageList* page = *link;
+        bool isChanged = false;
 
-    free(reqPage->path);
-    reqPage->path = NULL;
+        const cJSON *requirement;
+        cJSON_ArrayForEach(requirement, requirements){
+            const cJSON *id = cJSON_GetObjectItem(requirement, "ID");
+            if(cJSON_IsString(id) && page->title && strcmp(id->valuestring, page->title) == 0){
+                unsigned long long hash = hashRequirementPage(page, requirement);
+                isChanged = isRequirementChanged(snapshot, id->valuestring, hash);
+
+                // Still added to the snapshot above, so that it is saved once the rest of the pages are updated
+                if(isChanged){
+                    char* checkpoint = buildCheckpointKey("req", id->valuestring, hash);
+                    isChanged = !isCommandCheckpointed(checkpoint);
+                    free(checkpoint);
+                }
+                break;
+            }
+        }
 
-    free(reqPage->updatedAt);
-    reqPage->updatedAt = NULL;
+        if(isChanged){
+            link = &page->next;
+            continue;
+        }
 
-    reqPage = getPage(&reqPage);
-    reqPage->content = replaceWord_Realloc(reqPage->content, "\\n", "\n");
+        *link = page->next;
+        page->next = NULL;
+        freePageList(&page);
+    }
 
-    char* importedRequirementInformation = buildRequirementPageFromJSONRequirementList(requirement);
+    log_message(LOG_DEBUG, "Exiting function removeUnchangedRequirementPages");
+    return head;
+}
+
+const commandDefinition updateReqCommandDefinition = {
+    .name = "updateReq",
+    .argumentType = COMMAND_ARGUMENT_SUBSYSTEM_OR_REQUIREMENT_ID,
+    .concurrencyClass = COMMAND_CONCURRENCY_SUBSYSTEM,
+    .reportsStatus = true,
+    .description = "Updates the requirement pages of the subsystem, or the page of a single requirement, from the requirement sheet.",
+    .argumentDescription = "acronym of the subsystem you want to update (will update all of the requirement pages of the subsystem) or ID of the requirement you want to update",
+    .example = "updateReq ST or updateReq 2024_C_SE_ST_REQ_01",
+    .handler = updateRequirementPage,
+};
+
+/**
+ * @brief Updates the page of a single requirement, e.g. `updateReq 2024_C_SE_ST_REQ_01`.
+ *
+ * @details Only the requirement's own page is listed (by exact path) and rewritten, so this is cheap enough to be run
+ *          from `yieldToInteractiveCommands` in between the pages of a bulk command. The bulk command's queued mutations
+ *          are suspended meanwhile, so flushing here only sends and reports this page's update.
+ */
+static void updateSingleRequirementPage(const char* requirementId){
+    log_message(LOG_DEBUG, "Entering function updateSingleRequirementPage");
+
+    char* acronym = getSubsystemAcronymFromRequirementId(requirementId);
+    if(!acronym){
+        sendMessageToSlack("Could not find the subsystem acronym in the requirement ID");
+        log_message(LOG_DEBUG, "Exiting function updateSingleRequirementPage");
+        return;
+    }
+
+    updateCommandStatusMessage("fetching subsystem info");
+    cJSON* subsystem = getSubsystemInfo(acronym);
+    free(acronym);
+    if(!subsystem){
+        sendMessageToSlack("Subsystem was not found, check the acronym in the INFO sheet");
+        log_message(LOG_DEBUG, "Exiting function updateSingleRequirementPage");
+        return;
+    }
+
+    const char *path = cJSON_GetObjectItem(subsystem, "Requirement Pages Directory")->valuestring;
+
+    updateCommandStatusMessage("fetching requirements");
+    cJSON *requirementList = getRequirements(subsystem);
+    const cJSON *requirements = cJSON_GetObjectItemCaseSensitive(requirementList, "requirements");
+
+    const cJSON *requirement = NULL;
+    int num_reqs = cJSON_GetArraySize(requirements);
+    for (int i = 0; i < num_reqs; i++) {
+        const cJSON *id = cJSON_GetObjectItem(cJSON_GetArrayItem(requirements, i), "ID");
+
+        if (cJSON_IsString(id) && strcmp(id->valuestring, requirementId) == 0){
+            requirement = cJSON_GetArrayItem(requirements, i);
+            break;
+        }
+    }
+
+    if(!requirement){
+        sendMessageToSlack("Requirement was not found in the requirement sheet");
+    }
+    else{
+        updateCommandStatusMessage("fetching requirement page");
+        char* reqPath = createCombinedString(path, requirementId);
+        pageList* reqPage = NULL;
+        reqPage = populatePageList(&reqPage, "exact path", reqPath);
+        free(reqPath);
+
+        if(!reqPage){
+            sendMessageToSlack("Requirement page does not exist yet, run createMissingRequirementPages first");
+        }
+        else{
+            updateCommandStatusMessage("updating requirement page");
+            updateRequirementPageContent(reqPage, requirement, NULL, NULL);
+            if(flushWikiMutations() != 0){
+                sendMessageToSlack("The requirement page could not be updated, try again later");
+            }
+        }
+
+        freePageList(&reqPage);
+    }
+
+    cJSON_Delete(requirementList);
+    cJSON_Delete(subsystem);
+
+    log_message(LOG_DEBUG, "Exiting function updateSingleRequirementPage");
+}
+
+/**
+ * @param[in] checkpoint Journaled once the page is up to date, can be NULL.
+ * @param[in, out] snapshot Snapshot the requirement is forgotten from if its page is not updated, can be NULL.
+ *
+ * @details A page which could not be fetched, or whose `<!--ID-->` flags are missing, is counted as a failed mutation
+ *          and its checkpoint is not journaled, so that the next run retries it.
+ */
+static void updateRequirementPageContent(pageList* reqPage, const cJSON *requirement, const char *checkpoint, requirementSnapshot* snapshot){
 
     const cJSON *id = cJSON_GetObjectItem(requirement, "ID");
 
+    // Already fetched with the other pages of its batch when updating a whole subsystem
+    if(!reqPage->content){
+        reqPage = getPage(&reqPage);
+    }
+
+    if(!reqPage->content){
+        log_message(LOG_ERROR, "updateRequirementPageContent: could not fetch the content of page %s", reqPage->id);
+        countSkippedWikiMutation(snapshot, id->valuestring);
+        return;
+    }
+
+    reqPage->content = replaceWord_Realloc(reqPage->content, "\\n", "\n");
+
     char* flag = createCombinedString("<!--", id->valuestring);
     flag = appendToString(flag, "-->");
 
-    char* start = reqPage->content;
-    start = strstr(start, flag);
-    start = start + strlen(flag);
+    // The requirement's information is in between two flags
+    char* start = strstr(reqPage->content, flag);
+    char* end = start ? strstr(start + strlen(flag), flag) : NULL;
+
+    if(!end){
+        log_message(LOG_ERROR, "updateRequirementPageContent: page %s does not hold the %s flags", reqPage->id, flag);
+        free(reqPage->content);
+        reqPage->content = NULL;
+        free(flag);
+        countSkippedWikiMutation(snapshot, id->valuestring);
+        return;
+    }
 
-    char* end;
-    end = strstr(start + 1, flag);
+    start = start + strlen(flag);
     end--;
 
+    char* importedRequirementInformation = buildRequirementPageFromJSONRequirementList(requirement);
+
     char *newContent = replaceParagraph(reqPage->content, importedRequirementInformation, start, end);
-    
+
+    if (newContent == NULL) {
+        free(reqPage->content);
+        reqPage->content = NULL;
+        free(importedRequirementInformation);
+        free(flag);
+        countSkippedWikiMutation(snapshot, id->valuestring);
+        return;
+    }
+
     if(strcmp(newContent, reqPage->content)==0){
         free(newContent);
         free(reqPage->content);
@@ -157,13 +401,15 @@ static void updateRequirementPageContent(pageList* reqPage, const cJSON *require
         free(importedRequirementInformation);
         free(flag);
         log_message(LOG_DEBUG, "updateRequirementPageContent: Requirement Page is already up to date.");
+        countPageWriteMetric(false);
+        if(checkpoint){
+            journalCheckpoint(checkpoint);
+        }
         return;
     }
 
-    if (newContent != NULL) {
-        free(reqPage->content);  // Free the old content
-        reqPage->content = newContent;  // Update to point to the new content
-    }
+    free(reqPage->content);  // Free the old content
+    reqPage->content = newContent;  // Update to point to the new content
 
     reqPage->content = replaceWord_Realloc(reqPage->content, "\n", "\\\\n");
     reqPage->content = replaceWord_Realloc(reqPage->content, "\"", "\\\\\\\"");
@@ -171,8 +417,8 @@ static void updateRequirementPageContent(pageList* reqPage, const cJSON *require
     reqPage->content = replaceWord_Realloc(reqPage->content, "\t", "");
     reqPage->content = replaceWord_Realloc(reqPage->content, "   ", "");
 
-    updatePageContentMutation(reqPage);
-    renderMutation(&reqPage, false);
+    queuePageUpdate(reqPage, checkpoint, snapshot, id->valuestring);
+    queuePageRender(reqPage);
 
     free(reqPage->content);
     reqPage->content = NULL;
@@ -188,9 +434,11 @@ static char* buildRequirementPageFromJSONRequirementList(const cJSON *requiremen
 
     char* pageContent = duplicate_Malloc("");
 
-    char* requirement_print = cJSON_Print(requirement);
-    log_message(LOG_DEBUG, "buildRequirementPageFromJSONRequirementList: requirement: %s", requirement_print);
-    free(requirement_print);
+    if(LOG_ENABLED(LOG_DEBUG)){
+        char* requirement_print = cJSON_Print(requirement);
+        log_message(LOG_DEBUG, "buildRequirementPageFromJSONRequirementList: requirement: %s", requirement_print);
+        free(requirement_print);
+    }
 
 
     log_message(LOG_DEBUG, "buildRequirementPageFromJSONRequirementList: starting to append standard block");
@@ -1,3 +1,5 @@
+#define LOG_MODULE LOG_MODULE_FEATURES
+
 #include <float.h>
 #include <stdbool.h>
 #include <string.h>
@@ -5,12 +7,16 @@
 #include <cjson/cJSON.h>
 #include "sheetAPI.h"
 #include "ERTbot_common.h"
+#include "ERTbot_features.h"
 #include "ERTbot_config.h"
 #include "requirementsHelpers.h"
 #include "stringHelpers.h"
 #include "wikiAPI.h"
+#include "wikiMutationBatch.h"
 #include "pageListHelpers.h"
 #include "slackAPI.h"
+#include "requirementSnapshotHelpers.h"
+#include "commandJournalHelpers.h"
 
 #define VCD_TITLE_TEMPLATE "# Verification Statuses per Deadline\n"
 #define DEADLINE_SUBSECTION_TITLE_TEMPLATE "\n## $Deadline Name$"
@@ -23,8 +29,6 @@
 #define VCD_PAGE_NAME "$ID$) **"
 #define VCD_TITLE_BLOCK_TEMPLATE "$Title$**\n"
 
-static char* buildVCD(const cJSON* verificationInformation, const cJSON* requirements, const cJSON* subsystem);
-
 static int parseDeadlineBlock(const cJSON* verificationInformation, char** pageContent, const char* deadlineItemName, const cJSON* requirements, const cJSON* subsystem);
 
 static int parseStatusBlock(char** pageContent, const cJSON* deadlineObject, const char* statusName, const cJSON* requirements, const cJSON* subsystem);
@@ -51,23 +55,67 @@ static bool verificationMethodAlreadyExists(const cJSON* deadlineObject, const c
 
 static bool verificationDeadlineEmpty(const cJSON* requirement, const char* JsonItemNameDeadline);
 
-static cJSON* parseVerificationInformation(const cJSON* requirements);
+// Everything buildVCD reads, the VCD is only rebuilt when one of them changed
+static const char* const vcdRequirementColumns[] = {"ID", "Title", "Verification *", NULL};
+static const char* const vcdSubsystemColumns[] = {"Requirement Pages Directory", "VCD Page ID", NULL};
 
 void updateVcdPage(command cmd){
     log_message(LOG_DEBUG, "Entering function updateVcdPage");
 
     updateCommandStatusMessage("fetching subsystem info");
     cJSON* subsystem = getSubsystemInfo(cmd.argument);
-    const char *vcdPageId = cJSON_GetObjectItem(subsystem, "VCD Page ID")->valuestring;
+    if(!subsystem){
+        sendMessageToSlack("Subsystem was not found, check the acronym in the INFO sheet");
+        log_message(LOG_DEBUG, "Exiting function updateVcdPage");
+        return;
+    }
 
     updateCommandStatusMessage("fetching requirements");
     cJSON *requirementList = getRequirements(subsystem);
+
+    updateCommandStatusMessage("updating VCD page content");
+    requirementSnapshot* snapshot = queueVcdUpdate(subsystem, requirementList);
+    if(!snapshot){
+        updateCommandStatusMessage("VCD page is already up to date");
+    }
+    else{
+        (void)flushWikiMutations();
+        (void)saveRequirementSnapshot(snapshot);
+    }
+    freeRequirementSnapshot(snapshot);
+
+    cJSON_Delete(requirementList);
+    cJSON_Delete(subsystem);
+    log_message(LOG_DEBUG, "Exiting function updateVcdPage");
+    return;
+}
+
+requirementSnapshot* queueVcdUpdate(const cJSON* subsystem, const cJSON* requirementList){
+    log_message(LOG_DEBUG, "Entering function queueVcdUpdate");
+
+    const char *vcdPageId = cJSON_GetObjectItem(subsystem, "VCD Page ID")->valuestring;
     const cJSON *requirements = cJSON_GetObjectItemCaseSensitive(requirementList, "requirements");
 
-    updateCommandStatusMessage("parsing requirement verification information");
+    unsigned long long hash = hashRequirementRow(subsystem, vcdSubsystemColumns, REQUIREMENT_HASH_SEED);
+    hash = hashRequirementList(requirements, vcdRequirementColumns, hash);
+    const char *acronym = cJSON_GetObjectItem(subsystem, "Acronym")->valuestring;
+    requirementSnapshot* snapshot = loadRequirementSnapshot(acronym, "vcd");
+    if(!isRequirementChanged(snapshot, "VCD", hash)){
+        freeRequirementSnapshot(snapshot);
+        log_message(LOG_DEBUG, "Exiting function queueVcdUpdate");
+        return NULL;
+    }
+
+    // Already updated before the bot stopped, only the snapshot is left to save
+    char* checkpoint = buildCheckpointKey("vcd", acronym, hash);
+    if(isCommandCheckpointed(checkpoint)){
+        free(checkpoint);
+        log_message(LOG_DEBUG, "Exiting function queueVcdUpdate");
+        return snapshot;
+    }
+
     cJSON* verificationInformation = parseVerificationInformation(requirements);
 
-    updateCommandStatusMessage("building VCD page content");
     char* pageContent = buildVCD(verificationInformation, requirements, subsystem);
 
     log_message(LOG_DEBUG, "pageContent after buildVCD:\n%s\n", pageContent);
@@ -81,20 +129,29 @@ void updateVcdPage(command cmd){
     vcdPage->content = replaceWord_Realloc(vcdPage->content, "\n", "\\\\n");
     vcdPage->content = replaceWord_Realloc(vcdPage->content, "\"", "\\\\\\\"");
 
-    updateCommandStatusMessage("updating VCD page content");
-    updatePageContentMutation(vcdPage);
-    renderMutation(&vcdPage, false);
+    queuePageUpdate(vcdPage, checkpoint, snapshot, "VCD");
+    queuePageRender(vcdPage);
     freePageList(&vcdPage);
+    free(checkpoint);
 
-    cJSON_Delete(requirementList);
-    cJSON_Delete(subsystem);
     cJSON_Delete(verificationInformation);
     free(pageContent);
-    log_message(LOG_DEBUG, "Exiting function updateVcdPage");
-    return;
+    log_message(LOG_DEBUG, "Exiting function queueVcdUpdate");
+    return snapshot;
 }
 
-static char* buildVCD(const cJSON* verificationInformation, const cJSON* requirements, const cJSON* subsystem){
+const commandDefinition updateVcdCommandDefinition = {
+    .name = "updateVCD",
+    .argumentType = COMMAND_ARGUMENT_SUBSYSTEM,
+    .concurrencyClass = COMMAND_CONCURRENCY_SUBSYSTEM,
+    .reportsStatus = true,
+    .description = "Rebuilds the VCD page of the subsystem from its requirement sheet.",
+    .argumentDescription = "acronym of the subsystem you want to update",
+    .example = "updateVCD ST",
+    .handler = updateVcdPage,
+};
+
+char* buildVCD(const cJSON* verificationInformation, const cJSON* requirements, const cJSON* subsystem){
     log_message(LOG_DEBUG, "Entering function buildVCD");
 
     int amountOfDifferentDeadlines = cJSON_GetArraySize(verificationInformation);
@@ -354,7 +411,7 @@ static bool verificationDeadlineEmpty(const cJSON* requirement, const char* Json
     return false;
 }
 
-static cJSON* parseVerificationInformation(const cJSON* requirements){
+cJSON* parseVerificationInformation(const cJSON* requirements){
     log_message(LOG_DEBUG, "Entering function parseVerificationInformation");
 
     int num_reqs = cJSON_GetArraySize(requirements);
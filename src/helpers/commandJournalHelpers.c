@@ -0,0 +1,474 @@
+/**
+ * @file commandJournalHelpers.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the command journal, which lets the bot restore its command queue and resume the command it was
+ *        running after it stopped.
+ *
+ * @details The journal is an append only text file: a header followed by one record per line.
+ *          - `Q <priority> <function> <argument>`: `enqueueCommand` was called on the main queue.
+ *          - `S <function> <argument>`: the command was taken from the queue and started.
+ *          - `D <function> <argument>`: the command finished.
+ *          - `R <function> <argument>`: the command was restored after it was interrupted.
+ *          - `C <key>`: a checkpoint of the running command.
+ *          A missing argument is written "-". The journal is replayed through `enqueueCommand` so that the commands are
+ *          merged exactly as they were. Each record is flushed to the kernel as it is written, which is enough to
+ *          survive the bot exiting or crashing, while the journal is only synced to the disk every
+ *          `COMMAND_JOURNAL_FSYNC_BATCH` records and when a command finishes.
+ */
+
+#define LOG_MODULE LOG_MODULE_HELPERS
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "stringHelpers.h"
+#include "commandQueueHelpers.h"
+#include "commandJournalHelpers.h"
+#include "ERTbot_commandRegistry.h"
+
+#define JOURNAL_HEADER "ERTBOT_JOURNAL 1\n"
+#define JOURNAL_NO_ARGUMENT "-"
+#define CHECKPOINT_BUCKETS 1024
+
+/**
+ * @brief A command the journal keeps track of: one which is running during a replay, or one which was restored.
+ */
+typedef struct journaledCommand {
+    char *function;
+    char *argument;
+    struct journaledCommand *next;
+} journaledCommand;
+
+typedef struct checkpoint {
+    char *key;
+    struct checkpoint *next;
+} checkpoint;
+
+static FILE* journalFile = NULL;
+static char* journalPath = NULL;
+static commandQueue* journaledQueue = NULL;
+static int numberOfUnsyncedRecords = 0;
+static int numberOfRunningCommands = 0;
+
+static journaledCommand* restoredCommands = NULL;
+static checkpoint* checkpoints[CHECKPOINT_BUCKETS];
+
+static bool stringsAreEqual(const char *a, const char *b){
+    return strcmp(a ? a : "", b ? b : "") == 0;
+}
+
+static void pushJournaledCommand(journaledCommand** head, const char *function, const char *argument){
+    journaledCommand* journaled = (journaledCommand*)malloc(sizeof(journaledCommand));
+    if(!journaled){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    journaled->function = duplicate_Malloc(function);
+    journaled->argument = argument ? duplicate_Malloc(argument) : NULL;
+    journaled->next = *head;
+    *head = journaled;
+}
+
+/**
+ * @return bool true if a command with this function and argument was in the list and was removed.
+ */
+static bool removeJournaledCommand(journaledCommand** head, const char *function, const char *argument){
+    for(journaledCommand** link = head; *link; link = &(*link)->next){
+        journaledCommand* journaled = *link;
+        if(stringsAreEqual(journaled->function, function) && stringsAreEqual(journaled->argument, argument)){
+            *link = journaled->next;
+            free(journaled->function);
+            free(journaled->argument);
+            free(journaled);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void freeJournaledCommands(journaledCommand** head){
+    while(*head){
+        journaledCommand* next = (*head)->next;
+        free((*head)->function);
+        free((*head)->argument);
+        free(*head);
+        *head = next;
+    }
+}
+
+static unsigned long hashKey(const char *key){
+    unsigned long hash = 5381;
+    for(const char *c = key; *c; c++){
+        hash = hash * 33 + (unsigned char)*c;
+    }
+
+    return hash % CHECKPOINT_BUCKETS;
+}
+
+static void addCheckpoint(const char *key){
+    if(isCommandCheckpointed(key)){
+        return;
+    }
+
+    checkpoint* newCheckpoint = (checkpoint*)malloc(sizeof(checkpoint));
+    if(!newCheckpoint){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    unsigned long bucket = hashKey(key);
+    newCheckpoint->key = duplicate_Malloc(key);
+    newCheckpoint->next = checkpoints[bucket];
+    checkpoints[bucket] = newCheckpoint;
+}
+
+static void clearCheckpoints(){
+    for(int i = 0; i < CHECKPOINT_BUCKETS; i++){
+        while(checkpoints[i]){
+            checkpoint* next = checkpoints[i]->next;
+            free(checkpoints[i]->key);
+            free(checkpoints[i]);
+            checkpoints[i] = next;
+        }
+    }
+}
+
+bool isCommandCheckpointed(const char *key){
+    for(const checkpoint* current = checkpoints[hashKey(key)]; current; current = current->next){
+        if(strcmp(current->key, key) == 0){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+char* buildCheckpointKey(const char *name, const char *id, unsigned long long hash){
+    char hashText[32];
+    snprintf(hashText, sizeof(hashText), " %016llx", hash);
+
+    char* key = createCombinedString(name, " ");
+    key = appendToString(key, id);
+    key = appendToString(key, hashText);
+
+    return key;
+}
+
+static void syncJournal(){
+    if(journalFile && numberOfUnsyncedRecords > 0){
+        fsync(fileno(journalFile));
+        numberOfUnsyncedRecords = 0;
+    }
+}
+
+static void writeCommandRecord(FILE* file, char type, const char *function, const char *argument){
+    fprintf(file, "%c %s %s\n", type, function, argument ? argument : JOURNAL_NO_ARGUMENT);
+}
+
+static void writeQueuedRecord(FILE* file, int priority, const char *function, const char *argument){
+    fprintf(file, "Q %d %s %s\n", priority, function, argument ? argument : JOURNAL_NO_ARGUMENT);
+}
+
+static void appendRecord(){
+    fflush(journalFile);
+
+    numberOfUnsyncedRecords++;
+    if(numberOfUnsyncedRecords >= COMMAND_JOURNAL_FSYNC_BATCH){
+        syncJournal();
+    }
+}
+
+void journalQueuedCommand(const char *function, const char *argument, commandPriority priority){
+    if(!journalFile){
+        return;
+    }
+
+    writeQueuedRecord(journalFile, (int)priority, function, argument);
+    appendRecord();
+}
+
+void journalStartedCommand(const command* cmd){
+    if(!journalFile){
+        return;
+    }
+
+    writeCommandRecord(journalFile, 'S', cmd->function, cmd->argument);
+    appendRecord();
+    numberOfRunningCommands++;
+}
+
+void journalCheckpoint(const char *key){
+    if(!journalFile || numberOfRunningCommands == 0){
+        return;
+    }
+
+    fprintf(journalFile, "C %s\n", key);
+    appendRecord();
+}
+
+/**
+ * @brief Rewrites the journal with only the pending commands of the queue, the restored commands and their
+ *        checkpoints, then reopens it for appending.
+ *
+ * @return int 0 on success, 1 if the journal could not be rewritten, it is then left as it was.
+ */
+static int compactJournal(){
+    // Written next to the journal then renamed, a crash never leaves half a journal
+    char* temporaryPath = createCombinedString(journalPath, ".tmp");
+    FILE* file = fopen(temporaryPath, "w");
+    if(!file){
+        log_message(LOG_ERROR, "Could not write command journal %s", temporaryPath);
+        free(temporaryPath);
+        return 1;
+    }
+
+    fputs(JOURNAL_HEADER, file);
+
+    // Lanes are independent, queuing each lane in order again gives the same queue
+    for(int priority = 0; priority < NUMBER_OF_COMMAND_PRIORITIES; priority++){
+        for(const commandQueueNode* node = journaledQueue->lanes[priority].head; node; node = node->next){
+            writeQueuedRecord(file, priority, node->cmd.function, node->cmd.argument);
+        }
+    }
+
+    for(const journaledCommand* restored = restoredCommands; restored; restored = restored->next){
+        writeCommandRecord(file, 'R', restored->function, restored->argument);
+    }
+
+    for(int i = 0; i < CHECKPOINT_BUCKETS; i++){
+        for(const checkpoint* current = checkpoints[i]; current; current = current->next){
+            fprintf(file, "C %s\n", current->key);
+        }
+    }
+
+    bool succeeded = fflush(file) == 0 && fsync(fileno(file)) == 0;
+    succeeded = fclose(file) == 0 && succeeded;
+    succeeded = succeeded && rename(temporaryPath, journalPath) == 0;
+    if(!succeeded){
+        log_message(LOG_ERROR, "Could not write command journal %s", journalPath);
+        remove(temporaryPath);
+    }
+    free(temporaryPath);
+
+    if(journalFile){
+        fclose(journalFile);
+    }
+    journalFile = fopen(journalPath, "a");
+    numberOfUnsyncedRecords = 0;
+
+    return succeeded ? 0 : 1;
+}
+
+void journalFinishedCommand(const command* cmd){
+    if(!journalFile){
+        return;
+    }
+
+    writeCommandRecord(journalFile, 'D', cmd->function, cmd->argument);
+    appendRecord();
+    syncJournal();
+
+    if(numberOfRunningCommands > 0){
+        numberOfRunningCommands--;
+    }
+
+    // The checkpoints only matter to the commands which were restored
+    (void)removeJournaledCommand(&restoredCommands, cmd->function, cmd->argument);
+    if(!restoredCommands){
+        clearCheckpoints();
+    }
+
+    long size = ftell(journalFile);
+    if(numberOfRunningCommands == 0 && !restoredCommands && size > COMMAND_JOURNAL_COMPACTION_BYTES){
+        log_message(LOG_DEBUG, "Compacting the command journal (%ld bytes)", size);
+        (void)compactJournal();
+    }
+}
+
+/**
+ * @brief Splits a record "<function> <argument>" in place, the argument is the rest of the line.
+ *
+ * @return bool false if the record is malformed.
+ */
+static bool parseCommandRecord(char *record, char **function, char **argument){
+    char* separator = strchr(record, ' ');
+    if(!separator || separator == record || separator[1] == '\0'){
+        return false;
+    }
+
+    *separator = '\0';
+    *function = record;
+    *argument = strcmp(separator + 1, JOURNAL_NO_ARGUMENT) == 0 ? NULL : separator + 1;
+
+    return true;
+}
+
+/**
+ * @brief Replays the journal into the queue.
+ *
+ * @param[out] runningCommands The commands which were started but did not finish.
+ */
+static void replayJournal(FILE* file, journaledCommand** runningCommands){
+    char line[1024];
+    if(!fgets(line, sizeof(line), file)){
+        return;
+    }
+
+    if(strcmp(line, JOURNAL_HEADER) != 0){
+        log_message(LOG_ERROR, "%s is not a command journal, ignoring it", journalPath);
+        return;
+    }
+
+    while(fgets(line, sizeof(line), file)){
+        size_t length = strlen(line);
+
+        // The last record may have been cut short when the bot stopped
+        if(length < 3 || line[length - 1] != '\n' || line[1] != ' '){
+            continue;
+        }
+        line[length - 1] = '\0';
+
+        char* record = line + 2;
+        char* function = NULL;
+        char* argument = NULL;
+
+        switch(line[0]){
+            case 'Q': {
+                int priority = -1;
+                int commandStart = 0;
+                if(sscanf(record, "%d %n", &priority, &commandStart) == 1 && commandStart > 0 &&
+                   priority >= 0 && priority < NUMBER_OF_COMMAND_PRIORITIES &&
+                   parseCommandRecord(record + commandStart, &function, &argument)){
+                    (void)enqueueCommand(journaledQueue, function, argument, (commandPriority)priority);
+                }
+                break;
+            }
+
+            case 'S':
+                if(parseCommandRecord(record, &function, &argument)){
+                    (void)removePendingCommand(journaledQueue, function, argument);
+                    pushJournaledCommand(runningCommands, function, argument);
+                }
+                break;
+
+            case 'D':
+                if(parseCommandRecord(record, &function, &argument)){
+                    (void)removeJournaledCommand(runningCommands, function, argument);
+                    (void)removeJournaledCommand(&restoredCommands, function, argument);
+                    if(!*runningCommands && !restoredCommands){
+                        clearCheckpoints();
+                    }
+                }
+                break;
+
+            case 'R':
+                if(parseCommandRecord(record, &function, &argument)){
+                    pushJournaledCommand(&restoredCommands, function, argument);
+                }
+                break;
+
+            case 'C':
+                addCheckpoint(record);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Tells whether an interrupted command is worth resuming. Exclusive commands such as `shutdown` and commands
+ *        without an argument such as `help` are not.
+ */
+static bool isResumableCommand(const char *function){
+    const commandDefinition* definition = findCommandDefinition(function);
+
+    return definition && definition->concurrencyClass != COMMAND_CONCURRENCY_EXCLUSIVE &&
+           definition->argumentType != COMMAND_ARGUMENT_NONE;
+}
+
+int openCommandJournal(const char *path, commandQueue* queue){
+    log_message(LOG_DEBUG, "Entering function openCommandJournal");
+
+    closeCommandJournal();
+
+    journalPath = duplicate_Malloc(path);
+    journaledQueue = queue;
+
+    int numberOfPendingCommands = queue->size;
+    journaledCommand* runningCommands = NULL;
+
+    FILE* file = fopen(path, "r");
+    if(file){
+        replayJournal(file, &runningCommands);
+        fclose(file);
+    }
+
+    // The interrupted commands are resumed before anything else, newest first like they were nested
+    int numberOfInterruptedCommands = 0;
+    for(const journaledCommand* running = runningCommands; running; running = running->next){
+        // A command which stops the bot every time it runs must not be resumed forever
+        if(removeJournaledCommand(&restoredCommands, running->function, running->argument)){
+            log_message(LOG_ERROR, "%s %s was interrupted again after being resumed, dropping it", running->function, running->argument ? running->argument : "");
+            continue;
+        }
+
+        if(!isResumableCommand(running->function)){
+            log_message(LOG_INFO, "%s %s was interrupted when the bot stopped, not resuming it", running->function, running->argument ? running->argument : "");
+            continue;
+        }
+
+        log_message(LOG_INFO, "Resuming %s %s, interrupted when the bot stopped", running->function, running->argument ? running->argument : "");
+        (void)enqueueCommand(queue, running->function, running->argument, COMMAND_PRIORITY_INTERACTIVE);
+        pushJournaledCommand(&restoredCommands, running->function, running->argument);
+        numberOfInterruptedCommands++;
+    }
+    freeJournaledCommands(&runningCommands);
+
+    if(!restoredCommands){
+        clearCheckpoints();
+    }
+
+    int numberOfRestoredCommands = queue->size - numberOfPendingCommands;
+    log_message(LOG_INFO, "Restored %d commands from the command journal, %d of them were interrupted", numberOfRestoredCommands, numberOfInterruptedCommands);
+
+    if(compactJournal() != 0 || !journalFile){
+        log_message(LOG_ERROR, "Could not open command journal %s, commands will not be restored after a restart", path);
+        closeCommandJournal();
+        log_message(LOG_DEBUG, "Exiting function openCommandJournal");
+        return -1;
+    }
+
+    queue->isJournaled = true;
+
+    log_message(LOG_DEBUG, "Exiting function openCommandJournal");
+    return numberOfRestoredCommands;
+}
+
+void closeCommandJournal(){
+    if(journalFile){
+        syncJournal();
+        fclose(journalFile);
+        journalFile = NULL;
+    }
+
+    if(journaledQueue){
+        journaledQueue->isJournaled = false;
+        journaledQueue = NULL;
+    }
+
+    free(journalPath);
+    journalPath = NULL;
+    numberOfRunningCommands = 0;
+    numberOfUnsyncedRecords = 0;
+
+    freeJournaledCommands(&restoredCommands);
+    clearCheckpoints();
+}
@@ -0,0 +1,370 @@
+/**
+ * @file commandQueueHelpers.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the command queue used to store the commands waiting to be executed.
+ */
+
+#define LOG_MODULE LOG_MODULE_HELPERS
+
+#include <stdbool.h>
+#include <string.h>
+#include "ERTbot_common.h"
+#include "stringHelpers.h"
+#include "commandQueueHelpers.h"
+#include "commandJournalHelpers.h"
+
+/**
+ * @brief Pairs of commands where a pending `absorbingFunction X` makes `absorbedFunction X` redundant.
+ */
+static const struct {
+    const char *absorbingFunction;
+    const char *absorbedFunction;
+} commandAbsorptionRules[] = {
+    {"sync", "createMissingRequirementPages"},
+    {"sync", "updateDRL"},
+    {"sync", "updateReq"},
+    {"sync", "updateVCD"},
+};
+
+#define NUMBER_OF_ABSORPTION_RULES (sizeof(commandAbsorptionRules) / sizeof(commandAbsorptionRules[0]))
+
+static unsigned int hashCommand(const char *function, const char *argument){
+    // FNV-1a over "function\0argument"
+    unsigned int hash = 2166136261u;
+
+    for(const char *c = function ? function : ""; *c; c++){
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+
+    hash = (hash ^ 0u) * 16777619u;
+
+    for(const char *c = argument ? argument : ""; *c; c++){
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+
+    return hash % COMMAND_QUEUE_INDEX_SIZE;
+}
+
+static bool stringsAreEqual(const char *a, const char *b){
+    return strcmp(a ? a : "", b ? b : "") == 0;
+}
+
+static commandQueueNode* findPendingCommand(const commandQueue* queue, const char *function, const char *argument){
+    commandQueueNode* node = queue->index[hashCommand(function, argument)];
+
+    while(node){
+        if(stringsAreEqual(node->cmd.function, function) && stringsAreEqual(node->cmd.argument, argument)){
+            return node;
+        }
+        node = node->nextInIndex;
+    }
+
+    return NULL;
+}
+
+static void addNodeToIndex(commandQueue* queue, commandQueueNode* node){
+    unsigned int bucket = hashCommand(node->cmd.function, node->cmd.argument);
+    node->nextInIndex = queue->index[bucket];
+    queue->index[bucket] = node;
+}
+
+static void removeNodeFromIndex(commandQueue* queue, const commandQueueNode* node){
+    commandQueueNode** current = &queue->index[hashCommand(node->cmd.function, node->cmd.argument)];
+
+    while(*current){
+        if(*current == node){
+            *current = node->nextInIndex;
+            return;
+        }
+        current = &(*current)->nextInIndex;
+    }
+}
+
+static void unlinkNode(commandQueue* queue, commandQueueNode* node){
+    commandQueueLane* lane = &queue->lanes[node->priority];
+
+    removeNodeFromIndex(queue, node);
+
+    if(node->previous){
+        node->previous->next = node->next;
+    }
+    else{
+        lane->head = node->next;
+    }
+
+    if(node->next){
+        node->next->previous = node->previous;
+    }
+    else{
+        lane->tail = node->previous;
+    }
+
+    node->previous = NULL;
+    node->next = NULL;
+
+    lane->size--;
+    queue->size--;
+}
+
+static void appendNodeToLane(commandQueue* queue, commandQueueNode* node, commandPriority priority){
+    commandQueueLane* lane = &queue->lanes[priority];
+
+    node->priority = priority;
+    node->sequenceNumber = queue->nextSequenceNumber++;
+    node->next = NULL;
+    node->previous = lane->tail;
+
+    // New node will be the last node of its lane
+    if(lane->tail){
+        lane->tail->next = node;
+    }
+    else{
+        lane->head = node;
+    }
+    lane->tail = node;
+
+    lane->size++;
+    queue->size++;
+
+    addNodeToIndex(queue, node);
+}
+
+static void freeNode(commandQueueNode* node){
+    freeCommand(&node->cmd);
+    free(node);
+}
+
+/**
+ * @brief Drops the pending commands absorbed by `absorbingFunction argument`, except the oldest one.
+ *
+ * @details Only commands in the lane of `priority` or in a lower priority lane are absorbed, so a scheduled `sync X`
+ *          never delays a command a user is waiting for.
+ *
+ * @return commandQueueNode* The oldest absorbed node, still linked in the queue, or NULL if none was pending.
+ */
+static commandQueueNode* absorbPendingCommands(commandQueue* queue, const char *absorbingFunction, const char *argument, commandPriority priority){
+    commandQueueNode* oldestAbsorbedNode = NULL;
+
+    for(size_t i = 0; i < NUMBER_OF_ABSORPTION_RULES; i++){
+        if(strcmp(commandAbsorptionRules[i].absorbingFunction, absorbingFunction) != 0){
+            continue;
+        }
+
+        commandQueueNode* absorbedNode = findPendingCommand(queue, commandAbsorptionRules[i].absorbedFunction, argument);
+        if(!absorbedNode || absorbedNode->priority < priority){
+            continue;
+        }
+
+        log_message(LOG_INFO, "%s %s absorbed pending %s %s", absorbingFunction, argument ? argument : "", absorbedNode->cmd.function, argument ? argument : "");
+
+        if(!oldestAbsorbedNode){
+            oldestAbsorbedNode = absorbedNode;
+            continue;
+        }
+
+        // Keep whichever node is closer to the head, so the merged command does not lose its turn
+        commandQueueNode* nodeToDrop = absorbedNode;
+        if(absorbedNode->priority < oldestAbsorbedNode->priority
+            || (absorbedNode->priority == oldestAbsorbedNode->priority && absorbedNode->sequenceNumber < oldestAbsorbedNode->sequenceNumber)){
+            nodeToDrop = oldestAbsorbedNode;
+            oldestAbsorbedNode = absorbedNode;
+        }
+
+        unlinkNode(queue, nodeToDrop);
+        freeNode(nodeToDrop);
+    }
+
+    return oldestAbsorbedNode;
+}
+
+static void setNodeCommand(commandQueueNode* node, const char *function, const char *argument){
+    node->cmd.function = NULL;
+    node->cmd.argument = NULL;
+    node->cmd.next = NULL;
+
+    allocateAndCopy(&node->cmd.function, function, "function");
+    allocateAndCopy(&node->cmd.argument, argument, "argument");
+}
+
+commandQueue* createCommandQueue(){
+    log_message(LOG_DEBUG, "Entering function createCommandQueue");
+
+    commandQueue* queue = (commandQueue*)malloc(sizeof(commandQueue));
+    if (!queue) {
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    memset(queue, 0, sizeof(commandQueue));
+
+    log_message(LOG_DEBUG, "Exiting function createCommandQueue");
+    return queue;
+}
+
+int enqueueCommand(commandQueue* queue, const char *function, const char *argument, commandPriority priority){
+    log_message(LOG_DEBUG, "Entering function enqueueCommand");
+
+    if(argument && argument[0] == '\0'){
+        argument = NULL;
+    }
+
+    if(queue->isJournaled){
+        journalQueuedCommand(function, argument, priority);
+    }
+
+    commandQueueNode* pendingNode = findPendingCommand(queue, function, argument);
+    if(pendingNode){
+        if(priority < pendingNode->priority){
+            unlinkNode(queue, pendingNode);
+            appendNodeToLane(queue, pendingNode, priority);
+            log_message(LOG_INFO, "%s %s is already pending, promoted it to lane %d", function, argument ? argument : "", priority);
+        }
+        else{
+            log_message(LOG_INFO, "%s %s is already pending, merged duplicate", function, argument ? argument : "");
+        }
+
+        log_message(LOG_DEBUG, "Exiting function enqueueCommand");
+        return 0;
+    }
+
+    for(size_t i = 0; i < NUMBER_OF_ABSORPTION_RULES; i++){
+        if(!stringsAreEqual(commandAbsorptionRules[i].absorbedFunction, function)){
+            continue;
+        }
+
+        commandQueueNode* absorbingNode = findPendingCommand(queue, commandAbsorptionRules[i].absorbingFunction, argument);
+        if(absorbingNode && absorbingNode->priority <= priority){
+            log_message(LOG_INFO, "%s %s is covered by pending %s, merged", function, argument ? argument : "", commandAbsorptionRules[i].absorbingFunction);
+
+            log_message(LOG_DEBUG, "Exiting function enqueueCommand");
+            return 0;
+        }
+    }
+
+    commandQueueNode* absorbedNode = absorbPendingCommands(queue, function, argument, priority);
+    if(absorbedNode){
+        // Take over the slot of the oldest absorbed command, or move to the tail of our own lane if it was in a lower one
+        if(absorbedNode->priority != priority){
+            unlinkNode(queue, absorbedNode);
+            freeCommand(&absorbedNode->cmd);
+            setNodeCommand(absorbedNode, function, argument);
+            appendNodeToLane(queue, absorbedNode, priority);
+        }
+        else{
+            removeNodeFromIndex(queue, absorbedNode);
+            freeCommand(&absorbedNode->cmd);
+            setNodeCommand(absorbedNode, function, argument);
+            addNodeToIndex(queue, absorbedNode);
+        }
+
+        log_message(LOG_DEBUG, "Exiting function enqueueCommand");
+        return 1;
+    }
+
+    commandQueueNode* newNode = (commandQueueNode*)malloc(sizeof(commandQueueNode));
+    if (!newNode) {
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    setNodeCommand(newNode, function, argument);
+    newNode->nextInIndex = NULL;
+    appendNodeToLane(queue, newNode, priority);
+
+    log_message(LOG_DEBUG, "Exiting function enqueueCommand");
+    return 1;
+}
+
+bool removePendingCommand(commandQueue* queue, const char *function, const char *argument){
+    log_message(LOG_DEBUG, "Entering function removePendingCommand");
+
+    if(argument && argument[0] == '\0'){
+        argument = NULL;
+    }
+
+    commandQueueNode* node = findPendingCommand(queue, function, argument);
+    if(node){
+        unlinkNode(queue, node);
+        freeNode(node);
+    }
+
+    log_message(LOG_DEBUG, "Exiting function removePendingCommand");
+    return node != NULL;
+}
+
+bool dequeueCommandFromLane(commandQueue* queue, commandPriority priority, command* cmd){
+    log_message(LOG_DEBUG, "Entering function dequeueCommandFromLane");
+
+    commandQueueNode* node = queue->lanes[priority].head;
+    if(!node){
+        log_message(LOG_DEBUG, "Exiting function dequeueCommandFromLane");
+        return false;
+    }
+
+    unlinkNode(queue, node);
+
+    cmd->function = node->cmd.function;
+    cmd->argument = node->cmd.argument;
+    cmd->next = NULL;
+
+    free(node);
+
+    log_message(LOG_DEBUG, "Exiting function dequeueCommandFromLane");
+    return true;
+}
+
+bool dequeueCommand(commandQueue* queue, command* cmd){
+    for(int priority = 0; priority < NUMBER_OF_COMMAND_PRIORITIES; priority++){
+        if(dequeueCommandFromLane(queue, (commandPriority)priority, cmd)){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const command* peekCommand(const commandQueue* queue, commandPriority priority){
+    if(!queue || !queue->lanes[priority].head){
+        return NULL;
+    }
+
+    return &queue->lanes[priority].head->cmd;
+}
+
+bool isCommandQueueEmpty(const commandQueue* queue){
+    return queue == NULL || queue->size == 0;
+}
+
+void freeCommand(command* cmd){
+    if(cmd->function){
+        free(cmd->function);
+        cmd->function = NULL;
+    }
+
+    if(cmd->argument){
+        free(cmd->argument);
+        cmd->argument = NULL;
+    }
+}
+
+void freeCommandQueue(commandQueue** queue){
+    log_message(LOG_DEBUG, "Entering function freeCommandQueue");
+
+    if(!*queue){
+        return;
+    }
+
+    for(int priority = 0; priority < NUMBER_OF_COMMAND_PRIORITIES; priority++){
+        commandQueueNode* node = (*queue)->lanes[priority].head;
+        while(node){
+            commandQueueNode* next = node->next;
+            freeNode(node);
+            node = next;
+        }
+    }
+
+    free(*queue);
+    *queue = NULL;
+
+    log_message(LOG_DEBUG, "Exiting function freeCommandQueue");
+}
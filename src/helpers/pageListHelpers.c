@@ -1,3 +1,5 @@
+#define LOG_MODULE LOG_MODULE_HELPERS
+
 #include <string.h>
 #include "ERTbot_common.h"
 #include "stringHelpers.h"
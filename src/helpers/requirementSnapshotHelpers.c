@@ -0,0 +1,358 @@
+/**
+ * @file requirementSnapshotHelpers.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the snapshots of the requirement rows each feature processed, used to only process the rows which
+ *        changed since its last run.
+ *
+ * @details A snapshot is a text file per subsystem and feature: a header followed by one line per requirement with
+ *          the hash of the requirement and its key. It is rewritten as a whole at the end of a run, without the
+ *          requirements whose change could not be applied.
+ */
+
+#define LOG_MODULE LOG_MODULE_HELPERS
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "stringHelpers.h"
+#include "requirementSnapshotHelpers.h"
+
+#define SNAPSHOT_HEADER "ERTBOT_SNAPSHOT 1\n"
+#define SNAPSHOT_EXTENSION ".snapshot"
+#define SNAPSHOT_BUCKETS 1024
+
+typedef struct requirementHash {
+    char *id;
+    unsigned long long hash;
+    bool isInCurrentRun;
+    bool isForgotten;                               // not saved, its change was not applied
+    struct requirementHash *next;
+} requirementHash;
+
+struct requirementSnapshot {
+    char *path;                                     // NULL when snapshots are disabled
+    requirementHash *lastRun[SNAPSHOT_BUCKETS];     // hash table of the last snapshot
+    requirementHash *currentRunHead;                // requirements of this run, in the order they were added
+    requirementHash *currentRunTail;
+    int numberOfForgottenRequirements;
+};
+
+#ifdef TESTING
+static const char* snapshotDirectory = NULL;
+#else
+static const char* snapshotDirectory = REQUIREMENT_SNAPSHOT_DIRECTORY;
+#endif
+static char* allocatedSnapshotDirectory = NULL;
+
+void setRequirementSnapshotDirectory(const char *directory){
+    free(allocatedSnapshotDirectory);
+
+    allocatedSnapshotDirectory = directory ? duplicate_Malloc(directory) : NULL;
+    snapshotDirectory = allocatedSnapshotDirectory;
+}
+
+unsigned long long hashRequirementText(const char *text, unsigned long long hash){
+    for(const char *c = text ? text : ""; *c; c++){
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+    }
+
+    // Separator, so that moving a character from one string to the next changes the hash
+    return (hash ^ 0xff) * 1099511628211ULL;
+}
+
+static bool isColumnHashed(const char *column, const char* const* columns){
+    if(!columns){
+        return true;
+    }
+
+    for(int i = 0; columns[i]; i++){
+        size_t length = strlen(columns[i]);
+        if(length > 0 && columns[i][length - 1] == '*'){
+            if(strncmp(column, columns[i], length - 1) == 0){
+                return true;
+            }
+        }
+        else if(strcmp(column, columns[i]) == 0){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unsigned long long hashRequirementRow(const cJSON* requirement, const char* const* columns, unsigned long long hash){
+    const cJSON* cell;
+    cJSON_ArrayForEach(cell, requirement){
+        if(!cell->string || !isColumnHashed(cell->string, columns)){
+            continue;
+        }
+
+        hash = hashRequirementText(cell->string, hash);
+        hash = hashRequirementText(cJSON_IsString(cell) ? cell->valuestring : "", hash);
+    }
+
+    return hash;
+}
+
+unsigned long long hashRequirementList(const cJSON* requirements, const char* const* columns, unsigned long long hash){
+    const cJSON* requirement;
+    cJSON_ArrayForEach(requirement, requirements){
+        hash = hashRequirementRow(requirement, columns, hash);
+    }
+
+    return hash;
+}
+
+static unsigned long hashId(const char *id){
+    unsigned long hash = 5381;
+    for(const char *c = id; *c; c++){
+        hash = hash * 33 + (unsigned char)*c;
+    }
+
+    return hash % SNAPSHOT_BUCKETS;
+}
+
+static requirementHash* createRequirementHash(const char *id, unsigned long long hash){
+    requirementHash* requirement = (requirementHash*)malloc(sizeof(requirementHash));
+    if(!requirement){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    requirement->id = duplicate_Malloc(id);
+    requirement->hash = hash;
+    requirement->isInCurrentRun = false;
+    requirement->isForgotten = false;
+    requirement->next = NULL;
+
+    return requirement;
+}
+
+static requirementHash* findLastRunRequirement(const requirementSnapshot* snapshot, const char *id){
+    requirementHash* current = snapshot->lastRun[hashId(id)];
+    while(current && strcmp(current->id, id) != 0){
+        current = current->next;
+    }
+
+    return current;
+}
+
+static void readSnapshot(requirementSnapshot* snapshot){
+    FILE* file = fopen(snapshot->path, "r");
+    if(!file){
+        // Never ran on this subsystem, every requirement is new
+        return;
+    }
+
+    char line[1024];
+    if(!fgets(line, sizeof(line), file) || strcmp(line, SNAPSHOT_HEADER) != 0){
+        log_message(LOG_ERROR, "%s is not a requirement snapshot, ignoring it", snapshot->path);
+        fclose(file);
+        return;
+    }
+
+    while(fgets(line, sizeof(line), file)){
+        line[strcspn(line, "\n")] = '\0';
+
+        unsigned long long hash;
+        int idStart = 0;
+        if(sscanf(line, "%llx %n", &hash, &idStart) != 1 || idStart == 0 || line[idStart] == '\0'){
+            continue;
+        }
+
+        const char *id = line + idStart;
+        if(findLastRunRequirement(snapshot, id)){
+            continue;
+        }
+
+        requirementHash* requirement = createRequirementHash(id, hash);
+        unsigned long bucket = hashId(id);
+        requirement->next = snapshot->lastRun[bucket];
+        snapshot->lastRun[bucket] = requirement;
+    }
+
+    fclose(file);
+}
+
+static char* getSnapshotPath(const char *acronym, const char *name){
+    char* path = createCombinedString(snapshotDirectory, "/");
+    path = appendToString(path, acronym);
+    path = appendToString(path, ".");
+    path = appendToString(path, name);
+    path = appendToString(path, SNAPSHOT_EXTENSION);
+
+    return path;
+}
+
+requirementSnapshot* loadRequirementSnapshot(const char *acronym, const char *name){
+    log_message(LOG_DEBUG, "Entering function loadRequirementSnapshot");
+
+    requirementSnapshot* snapshot = (requirementSnapshot*)calloc(1, sizeof(requirementSnapshot));
+    if(!snapshot){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    if(snapshotDirectory){
+        snapshot->path = getSnapshotPath(acronym, name);
+        readSnapshot(snapshot);
+    }
+
+    log_message(LOG_DEBUG, "Exiting function loadRequirementSnapshot");
+    return snapshot;
+}
+
+bool isRequirementChanged(requirementSnapshot* snapshot, const char *id, unsigned long long hash){
+    requirementHash* currentRunRequirement = createRequirementHash(id, hash);
+    if(snapshot->currentRunTail){
+        snapshot->currentRunTail->next = currentRunRequirement;
+    }
+    else{
+        snapshot->currentRunHead = currentRunRequirement;
+    }
+    snapshot->currentRunTail = currentRunRequirement;
+
+    requirementHash* lastRunRequirement = findLastRunRequirement(snapshot, id);
+    if(!lastRunRequirement){
+        return true;
+    }
+
+    lastRunRequirement->isInCurrentRun = true;
+    return lastRunRequirement->hash != hash;
+}
+
+int countRemovedRequirements(const requirementSnapshot* snapshot){
+    int numberOfRemovedRequirements = 0;
+
+    for(int i = 0; i < SNAPSHOT_BUCKETS; i++){
+        for(const requirementHash* current = snapshot->lastRun[i]; current; current = current->next){
+            if(!current->isInCurrentRun){
+                numberOfRemovedRequirements++;
+            }
+        }
+    }
+
+    return numberOfRemovedRequirements;
+}
+
+void forgetRequirement(requirementSnapshot* snapshot, const char *id){
+    for(requirementHash* current = snapshot->currentRunHead; current; current = current->next){
+        if(!current->isForgotten && strcmp(current->id, id) == 0){
+            current->isForgotten = true;
+            snapshot->numberOfForgottenRequirements++;
+        }
+    }
+}
+
+int countForgottenRequirements(const requirementSnapshot* snapshot){
+    return snapshot->numberOfForgottenRequirements;
+}
+
+int saveRequirementSnapshot(const requirementSnapshot* snapshot){
+    if(!snapshot->path){
+        return 0;
+    }
+
+    log_message(LOG_DEBUG, "Entering function saveRequirementSnapshot");
+
+    mkdir(snapshotDirectory, 0755);
+
+    // Written next to the snapshot then renamed, a crash never leaves half a snapshot
+    char* temporaryPath = createCombinedString(snapshot->path, ".tmp");
+    FILE* file = fopen(temporaryPath, "w");
+    if(!file){
+        log_message(LOG_ERROR, "Could not write requirement snapshot %s", temporaryPath);
+        free(temporaryPath);
+        return 1;
+    }
+
+    bool succeeded = fputs(SNAPSHOT_HEADER, file) >= 0;
+    for(const requirementHash* current = snapshot->currentRunHead; current && succeeded; current = current->next){
+        if(!current->isForgotten){
+            succeeded = fprintf(file, "%016llx %s\n", current->hash, current->id) > 0;
+        }
+    }
+
+    succeeded = fclose(file) == 0 && succeeded;
+    succeeded = succeeded && rename(temporaryPath, snapshot->path) == 0;
+    if(!succeeded){
+        log_message(LOG_ERROR, "Could not write requirement snapshot %s", snapshot->path);
+        remove(temporaryPath);
+    }
+
+    free(temporaryPath);
+
+    log_message(LOG_DEBUG, "Exiting function saveRequirementSnapshot");
+    return succeeded ? 0 : 1;
+}
+
+static void freeRequirementHashes(requirementHash* head){
+    while(head){
+        requirementHash* next = head->next;
+        free(head->id);
+        free(head);
+        head = next;
+    }
+}
+
+void freeRequirementSnapshot(requirementSnapshot* snapshot){
+    if(!snapshot){
+        return;
+    }
+
+    for(int i = 0; i < SNAPSHOT_BUCKETS; i++){
+        freeRequirementHashes(snapshot->lastRun[i]);
+    }
+    freeRequirementHashes(snapshot->currentRunHead);
+
+    free(snapshot->path);
+    free(snapshot);
+}
+
+int resetRequirementSnapshots(const char *acronym){
+    log_message(LOG_DEBUG, "Entering function resetRequirementSnapshots");
+
+    if(!snapshotDirectory){
+        log_message(LOG_DEBUG, "Exiting function resetRequirementSnapshots");
+        return 0;
+    }
+
+    DIR* directory = opendir(snapshotDirectory);
+    if(!directory){
+        log_message(LOG_DEBUG, "Exiting function resetRequirementSnapshots");
+        return 0;
+    }
+
+    // Every snapshot of the subsystem is named "<acronym>.<feature>.snapshot"
+    char* prefix = createCombinedString(acronym, ".");
+    size_t prefixLength = strlen(prefix);
+    size_t extensionLength = strlen(SNAPSHOT_EXTENSION);
+
+    int numberOfDeletedSnapshots = 0;
+    const struct dirent* entry;
+    while((entry = readdir(directory))){
+        size_t nameLength = strlen(entry->d_name);
+        if(nameLength <= prefixLength + extensionLength || strncmp(entry->d_name, prefix, prefixLength) != 0 ||
+           strcmp(entry->d_name + nameLength - extensionLength, SNAPSHOT_EXTENSION) != 0){
+            continue;
+        }
+
+        char* path = createCombinedString(snapshotDirectory, "/");
+        path = appendToString(path, entry->d_name);
+        if(remove(path) == 0){
+            numberOfDeletedSnapshots++;
+        }
+        free(path);
+    }
+
+    closedir(directory);
+    free(prefix);
+
+    log_message(LOG_DEBUG, "Exiting function resetRequirementSnapshots");
+    return numberOfDeletedSnapshots;
+}
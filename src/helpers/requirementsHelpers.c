@@ -1,3 +1,6 @@
+#define LOG_MODULE LOG_MODULE_HELPERS
+
+#include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 #include <cjson/cJSON.h>
@@ -6,9 +9,11 @@
 #include "sheetAPI.h"
 #include "apiHelpers.h"
 #include "stringHelpers.h"
+#include "fetchStage.h"
 #include "requirementsHelpers.h"
 
-static cJSON* parseSheet(const cJSON* values_array);
+#define INFO_SHEET_ID "1iB1yl2Nre95kD1g6TFDYvvLe0g5QzghtAHdnxNTD4tg"
+#define INFO_SHEET_RANGE "INFO!A2:H30"
 
 cJSON* parseArrayIntoJSONRequirementList(const char *input_str) {
     log_message(LOG_DEBUG, "Entering function parseArrayIntoJSONRequirementList");
@@ -51,19 +56,15 @@ cJSON* parseArrayIntoJSONRequirementList(const char *input_str) {
 
     log_message(LOG_DEBUG, "Exiting function parseArrayIntoJSONRequirementList");
 
-    freeChunkResponse();
-
     cJSON_Delete(input_json);
 
     return json;
 }
 
-cJSON* getSubsystemInfo(const char* acronym){
-    log_message(LOG_DEBUG, "Entering function getSubsystemInfo");
-
-    batchGetSheet("1iB1yl2Nre95kD1g6TFDYvvLe0g5QzghtAHdnxNTD4tg", "INFO!A2:H30");
+cJSON* parseSubsystemsInfo(const char *response){
+    log_message(LOG_DEBUG, "Entering function parseSubsystemsInfo");
 
-    cJSON *input_json = cJSON_Parse(chunk.response);
+    cJSON *input_json = cJSON_Parse(response);
     if (!input_json) {
         log_message(LOG_ERROR, "Error parsing input string as JSON object");
         return NULL;
@@ -80,6 +81,32 @@ cJSON* getSubsystemInfo(const char* acronym){
     // Create a JSON array to hold the requirement objects
     cJSON *subsystemsInfo = parseSheet(values_array);
 
+    cJSON_Delete(input_json);
+
+    log_message(LOG_DEBUG, "Exiting function parseSubsystemsInfo");
+    return subsystemsInfo;
+}
+
+cJSON* getSubsystemsInfo(){
+    log_message(LOG_DEBUG, "Entering function getSubsystemsInfo");
+
+    batchGetSheet(INFO_SHEET_ID, INFO_SHEET_RANGE);
+
+    cJSON *subsystemsInfo = chunk.response ? parseSubsystemsInfo(chunk.response) : NULL;
+
+    log_message(LOG_DEBUG, "Exiting function getSubsystemsInfo");
+    return subsystemsInfo;
+}
+
+int addSubsystemsInfoFetch(fetchStage* stage){
+    return addSheetFetch(stage, INFO_SHEET_ID, INFO_SHEET_RANGE);
+}
+
+cJSON* getSubsystemInfo(const char* acronym){
+    log_message(LOG_DEBUG, "Entering function getSubsystemInfo");
+
+    cJSON *subsystemsInfo = getSubsystemsInfo();
+
     int numberOfSubsystems = cJSON_GetArraySize(subsystemsInfo);
 
     for(int i = 0; i< numberOfSubsystems; i++){
@@ -87,7 +114,6 @@ cJSON* getSubsystemInfo(const char* acronym){
 
         if(strcmp(cJSON_GetObjectItem(subsystem, "Acronym")->valuestring, acronym) == 0){
             cJSON* result = cJSON_DetachItemFromArray(subsystemsInfo, i);
-            cJSON_Delete(input_json);
             cJSON_Delete(subsystemsInfo);
 
             log_message(LOG_DEBUG, "Exiting function getSubsystemInfo");
@@ -95,11 +121,51 @@ cJSON* getSubsystemInfo(const char* acronym){
         }
     }
 
-    log_message(LOG_ERROR, "Subsystem was not found");
-    exit(1);
+    log_message(LOG_ERROR, "Subsystem %s was not found", acronym ? acronym : "(null)");
+
+    cJSON_Delete(subsystemsInfo);
+
+    log_message(LOG_DEBUG, "Exiting function getSubsystemInfo");
+    return NULL;
+}
+
+bool isRequirementId(const char* argument){
+    return argument && strstr(argument, REQUIREMENT_ID_MARKER) != NULL;
+}
+
+char* getSubsystemAcronymFromRequirementId(const char* requirementId){
+    log_message(LOG_DEBUG, "Entering function getSubsystemAcronymFromRequirementId");
+
+    // Requirement IDs look like 2024_C_SE_ST_REQ_01, the acronym is between the third '_' and "_REQ_"
+    const char* acronymStart = requirementId;
+    for(int i = 0; i < 3 && acronymStart; i++){
+        acronymStart = strchr(acronymStart, '_');
+        if(acronymStart){
+            acronymStart++;
+        }
+    }
+
+    const char* acronymEnd = acronymStart ? strstr(acronymStart, REQUIREMENT_ID_MARKER) : NULL;
+    if(!acronymEnd || acronymEnd == acronymStart){
+        log_message(LOG_ERROR, "Could not find the subsystem acronym in requirement ID %s", requirementId);
+        return NULL;
+    }
+
+    size_t length = (size_t)(acronymEnd - acronymStart);
+    char* acronym = (char*)malloc(length + 1);
+    if (!acronym) {
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    memcpy(acronym, acronymStart, length);
+    acronym[length] = '\0';
+
+    log_message(LOG_DEBUG, "Exiting function getSubsystemAcronymFromRequirementId");
+    return acronym;
 }
 
-static cJSON* parseSheet(const cJSON* values_array){
+cJSON* parseSheet(const cJSON* values_array){
     log_message(LOG_DEBUG, "Entering function parseSheet");
 
     int numberOfRows = cJSON_GetArraySize(values_array);
@@ -147,8 +213,18 @@ cJSON* getRequirements(const cJSON* subsystem){
 
     batchGetSheet(reqDbId, sheetId);
 
+    cJSON* requirementList = parseArrayIntoJSONRequirementList(chunk.response);
+    freeChunkResponse();
+
     log_message(LOG_DEBUG, "Exiting function getRequirements");
-    return parseArrayIntoJSONRequirementList(chunk.response);
+    return requirementList;
+}
+
+int addRequirementsFetch(fetchStage* stage, const cJSON* subsystem){
+    const char *sheetId = cJSON_GetObjectItem(subsystem, "Req_DB Sheet Acronym and Range")->valuestring;
+    const char *reqDbId = cJSON_GetObjectItem(subsystem, "Req_DB Spreadsheet ID")->valuestring;
+
+    return addSheetFetch(stage, reqDbId, sheetId);
 }
 
 char* addDollarSigns(const char* characteristic){
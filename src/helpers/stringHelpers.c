@@ -4,6 +4,8 @@
  * @brief This file contains all of the helper functions which do string manipulations
  */
 
+#define LOG_MODULE LOG_MODULE_HELPERS
+
 #include <stdbool.h>
 #include <string.h>
 #include "ERTbot_common.h"
@@ -1,3 +1,5 @@
+#define LOG_MODULE LOG_MODULE_HELPERS
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -1,53 +1,394 @@
+/**
+ * @file log.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the logger.
+ *
+ * @details `log_message` never touches a file: the line is formatted into a per-thread buffer and copied into a
+ *          lock-free ring buffer, a background thread then writes the lines in batches to log files which are kept
+ *          open. If the ring is full the line is dropped (and counted) rather than blocking the caller. Log files are
+ *          rotated once they reach `LOG_MAX_FILE_SIZE`. The ring is drained when the program exits.
+ *
+ *          `log_message` itself is a macro (see ERTbot_common.h) which skips disabled levels before calling
+ *          `logMessage`, the levels of each module can be changed at runtime with `setLogModuleLevel`.
+ */
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "ERTbot_config.h"
 #include "ERTbot_common.h"
 
+#define NUMBER_OF_LOG_LEVELS 3
 
-void log_message(int level, const char *format, ...) {
-    FILE *log_file;
-    const char *filename;
+// Zero is LOG_DEBUG: by default every line which is compiled in is written
+int logModuleLevels[NUMBER_OF_LOG_MODULES];
 
-    // If debug logging is disabled, skip debug messages
-    #ifndef DEBUG
-    if (level == LOG_DEBUG) {
+static const char* const logModuleNames[NUMBER_OF_LOG_MODULES] = {
+    [LOG_MODULE_CORE] = "core",
+    [LOG_MODULE_WIKI_API] = "wikiAPI",
+    [LOG_MODULE_SHEET_API] = "sheetAPI",
+    [LOG_MODULE_SLACK_API] = "slackAPI",
+    [LOG_MODULE_API_HELPERS] = "apiHelpers",
+    [LOG_MODULE_FEATURES] = "features",
+    [LOG_MODULE_HELPERS] = "helpers",
+};
+
+static const char* const logLevelNames[NUMBER_OF_LOG_LEVELS] = {
+    [LOG_DEBUG] = "debug",
+    [LOG_INFO] = "info",
+    [LOG_ERROR] = "error",
+};
+
+/**
+ * @brief A slot of the ring buffer.
+ *
+ * @details `sequence` tells who owns the slot: producers may write it when it equals the write position they claimed,
+ *          the writer thread may read it when it equals that position + 1.
+ */
+typedef struct logRingSlot {
+    atomic_size_t sequence;
+    int level;
+    time_t time;
+    size_t length;
+    char text[LOG_MAX_LINE_LENGTH];
+} logRingSlot;
+
+typedef struct logFile {
+    const char *path;
+    FILE *file;
+    long size;
+} logFile;
+
+static logRingSlot logRing[LOG_RING_SIZE];
+static atomic_size_t logRingWritePosition;
+static atomic_size_t logRingReadPosition;
+static atomic_ulong droppedLogLines;
+
+static logFile logFiles[NUMBER_OF_LOG_LEVELS] = {
+    {"logs/debug.log", NULL, 0},
+    {"logs/info.log", NULL, 0},
+    {"logs/error.log", NULL, 0},
+};
+
+static pthread_t logWriterThread;
+static pthread_once_t loggerInitialisation = PTHREAD_ONCE_INIT;
+static atomic_bool isLoggerRunning;
+static atomic_bool isLoggerStopping;
+static atomic_bool isLogWriterSleeping;
+static sem_t logWriterWakeUp;
+
+static _Thread_local char logFormatBuffer[LOG_MAX_LINE_LENGTH];
+
+static void openLogFile(logFile* log){
+    log->file = fopen(log->path, "a");
+    if (log->file == NULL) {
+        perror("Failed to open log file");
         return;
     }
-    #endif
 
-    // Set the file name based on log level
-    switch(level) {
-        case LOG_DEBUG:
-            filename = "logs/debug.log";
-            break;
-        case LOG_INFO:
-            filename = "logs/info.log";
-            break;
-        case LOG_ERROR:
-            filename = "logs/error.log";
+    fseek(log->file, 0, SEEK_END);
+    log->size = ftell(log->file);
+}
+
+static void rotateLogFile(logFile* log){
+    fclose(log->file);
+    log->file = NULL;
+
+    // debug.log.(n-1) -> debug.log.n, ..., debug.log -> debug.log.1
+    char olderPath[256];
+    char newerPath[256];
+    for (int i = LOG_MAX_ROTATED_FILES - 1; i >= 1; i--) {
+        snprintf(newerPath, sizeof(newerPath), "%s.%d", log->path, i);
+        snprintf(olderPath, sizeof(olderPath), "%s.%d", log->path, i + 1);
+        rename(newerPath, olderPath);
+    }
+
+    snprintf(olderPath, sizeof(olderPath), "%s.1", log->path);
+    rename(log->path, olderPath);
+
+    openLogFile(log);
+}
+
+static void writeLogLine(int level, time_t lineTime, const char *text, size_t length){
+    static time_t cachedTime = 0;
+    static char cachedTimestamp[32];
+
+    logFile* log = &logFiles[level];
+    if (!log->file) {
+        return;
+    }
+
+    // localtime is only called once per second instead of once per line
+    if (lineTime != cachedTime) {
+        struct tm tm_info;
+        localtime_r(&lineTime, &tm_info);
+        strftime(cachedTimestamp, sizeof(cachedTimestamp), "[%d-%m-%Y %H:%M:%S] ", &tm_info);
+        cachedTime = lineTime;
+    }
+
+    fputs(cachedTimestamp, log->file);
+    fwrite(text, 1, length, log->file);
+    fputc('\n', log->file);
+
+    log->size += (long)(strlen(cachedTimestamp) + length + 1);
+
+    if (log->size >= LOG_MAX_FILE_SIZE) {
+        rotateLogFile(log);
+    }
+}
+
+/**
+ * @brief Writes every line currently in the ring.
+ *
+ * @return size_t Number of lines written.
+ */
+static size_t drainLogRing(){
+    size_t numberOfLines = 0;
+    size_t readPosition = atomic_load_explicit(&logRingReadPosition, memory_order_relaxed);
+
+    while (1) {
+        logRingSlot* slot = &logRing[readPosition & (LOG_RING_SIZE - 1)];
+
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != readPosition + 1) {
             break;
-        default:
+        }
+
+        writeLogLine(slot->level, slot->time, slot->text, slot->length);
+
+        // Hand the slot back to the producers for the next lap
+        atomic_store_explicit(&slot->sequence, readPosition + LOG_RING_SIZE, memory_order_release);
+        readPosition++;
+        numberOfLines++;
+    }
+
+    static unsigned long reportedDroppedLogLines = 0;
+    unsigned long dropped = atomic_load_explicit(&droppedLogLines, memory_order_relaxed);
+    if (dropped != reportedDroppedLogLines) {
+        char message[96];
+        int length = snprintf(message, sizeof(message), "Logger: ring buffer was full, dropped %lu log lines", dropped - reportedDroppedLogLines);
+        writeLogLine(LOG_ERROR, time(NULL), message, (size_t)length);
+        reportedDroppedLogLines = dropped;
+    }
+
+    if (numberOfLines > 0) {
+        for (int level = 0; level < NUMBER_OF_LOG_LEVELS; level++) {
+            if (logFiles[level].file) {
+                fflush(logFiles[level].file);
+            }
+        }
+    }
+
+    atomic_store_explicit(&logRingReadPosition, readPosition, memory_order_release);
+
+    return numberOfLines;
+}
+
+static void* runLogWriter(void* unused){
+    (void)unused;
+
+    while (!atomic_load(&isLoggerStopping)) {
+        if (drainLogRing() > 0) {
+            continue;
+        }
+
+        // Announce the nap before checking one last time, a producer seeing the flag posts the semaphore
+        atomic_store(&isLogWriterSleeping, true);
+
+        if (drainLogRing() == 0) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += LOG_WRITER_IDLE_DELAY_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+
+            (void)sem_timedwait(&logWriterWakeUp, &deadline);
+        }
+
+        atomic_store(&isLogWriterSleeping, false);
+    }
+
+    // Producers may still have been writing when stop was requested
+    drainLogRing();
+
+    return NULL;
+}
+
+static void stopLogger(){
+    if (!atomic_load(&isLoggerRunning)) {
+        return;
+    }
+
+    atomic_store(&isLoggerStopping, true);
+    sem_post(&logWriterWakeUp);
+    pthread_join(logWriterThread, NULL);
+    atomic_store(&isLoggerRunning, false);
+
+    for (int level = 0; level < NUMBER_OF_LOG_LEVELS; level++) {
+        if (logFiles[level].file) {
+            fclose(logFiles[level].file);
+            logFiles[level].file = NULL;
+        }
+    }
+}
+
+static void startLogger(){
+    for (size_t i = 0; i < LOG_RING_SIZE; i++) {
+        atomic_init(&logRing[i].sequence, i);
+    }
+    atomic_init(&logRingWritePosition, 0);
+    atomic_init(&logRingReadPosition, 0);
+    atomic_init(&droppedLogLines, 0);
+    atomic_init(&isLoggerStopping, false);
+    atomic_init(&isLogWriterSleeping, false);
+    sem_init(&logWriterWakeUp, 0, 0);
+
+    for (int level = 0; level < NUMBER_OF_LOG_LEVELS; level++) {
+        openLogFile(&logFiles[level]);
+    }
+
+    if (pthread_create(&logWriterThread, NULL, runLogWriter, NULL) != 0) {
+        perror("Failed to start the log writer thread");
+        return;
+    }
+
+    atomic_store(&isLoggerRunning, true);
+    atexit(stopLogger);
+}
+
+void flushLogs(){
+    if (!atomic_load(&isLoggerRunning)) {
+        return;
+    }
+
+    // Wait (bounded) until the writer thread caught up with every line queued so far
+    size_t writePosition = atomic_load(&logRingWritePosition);
+    const struct timespec delay = {0, 1000000L};
+
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        if (atomic_load_explicit(&logRingReadPosition, memory_order_acquire) >= writePosition) {
             return;
+        }
+        nanosleep(&delay, NULL);
     }
+}
 
-    log_file = fopen(filename, "a");
-    if (log_file == NULL) {
-        perror("Failed to open log file");
+void logMessage(int level, const char *format, ...) {
+    if (level < 0 || level >= NUMBER_OF_LOG_LEVELS) {
         return;
     }
 
-    // Log timestamp
-    time_t now = time(NULL);
-    const struct tm *tm_info = localtime(&now);
-    fprintf(log_file, "[%02d-%02d-%d %02d:%02d:%02d] ",
-            tm_info->tm_mday, tm_info->tm_mon + 1, tm_info->tm_year + 1900,
-            tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec);
+    pthread_once(&loggerInitialisation, startLogger);
 
-    // Log message
+    // Format into this thread's buffer first, the ring slot is only claimed once the length is known
     va_list args;
     va_start(args, format);
-    vfprintf(log_file, format, args);
+    int length = vsnprintf(logFormatBuffer, sizeof(logFormatBuffer), format, args);
     va_end(args);
 
-    fprintf(log_file, "\n");
-    fclose(log_file);
+    if (length < 0) {
+        return;
+    }
+    if ((size_t)length >= sizeof(logFormatBuffer)) {
+        length = sizeof(logFormatBuffer) - 1;
+    }
+
+    // Claim a slot, drop the line if the writer thread is a whole lap behind
+    logRingSlot* slot;
+    size_t position = atomic_load_explicit(&logRingWritePosition, memory_order_relaxed);
+    while (1) {
+        slot = &logRing[position & (LOG_RING_SIZE - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+        if (sequence == position) {
+            if (atomic_compare_exchange_weak_explicit(&logRingWritePosition, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if ((long)(sequence - position) < 0) {
+            atomic_fetch_add_explicit(&droppedLogLines, 1, memory_order_relaxed);
+            return;
+        }
+        else {
+            position = atomic_load_explicit(&logRingWritePosition, memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    slot->time = time(NULL);
+    slot->length = (size_t)length;
+    memcpy(slot->text, logFormatBuffer, (size_t)length);
+
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+
+    // Only the first line logged while the writer thread sleeps pays for waking it up
+    if (atomic_load_explicit(&isLogWriterSleeping, memory_order_relaxed) && atomic_exchange(&isLogWriterSleeping, false)) {
+        sem_post(&logWriterWakeUp);
+    }
+}
+
+int setLogModuleLevel(const char *moduleName, const char *levelName){
+    int level = -1;
+    for (int i = 0; i < NUMBER_OF_LOG_LEVELS; i++) {
+        if (strcmp(levelName, logLevelNames[i]) == 0) {
+            level = i;
+        }
+    }
+
+    if (level < 0) {
+        log_message(LOG_ERROR, "Unknown log level %s", levelName);
+        return 1;
+    }
+
+    bool isAllModules = strcmp(moduleName, "all") == 0;
+    bool found = false;
+    for (int module = 0; module < NUMBER_OF_LOG_MODULES; module++) {
+        if (isAllModules || strcmp(moduleName, logModuleNames[module]) == 0) {
+            logModuleLevels[module] = level;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        log_message(LOG_ERROR, "Unknown log module %s", moduleName);
+        return 1;
+    }
+
+    log_message(LOG_INFO, "Log level of %s set to %s", moduleName, levelName);
+    return 0;
+}
+
+int setLogLevels(const char *settings){
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", settings);
+
+    int result = 0;
+    char *savePointer = NULL;
+
+    for (char *setting = strtok_r(buffer, ",", &savePointer); setting; setting = strtok_r(NULL, ",", &savePointer)) {
+        char *separator = strchr(setting, '=');
+
+        if (!separator) {
+            result |= setLogModuleLevel("all", setting);
+            continue;
+        }
+
+        *separator = '\0';
+        result |= setLogModuleLevel(setting, separator + 1);
+    }
+
+    return result;
+}
+
+void initializeLogLevels(){
+    const char *settings = getenv("ERTBOT_LOG_LEVEL");
+
+    if (settings && settings[0] != '\0') {
+        (void)setLogLevels(settings);
+    }
 }
@@ -11,12 +11,21 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include "ERTbot_common.h"
 #include "ERTbot_command.h"
 #include "apiHelpers.h"
 #include "timeHelpers.h"
 #include "slackAPI.h"
+#include "commandQueueHelpers.h"
+#include "ERTbot_commandRegistry.h"
+#include "networkTelemetry.h"
+#include "ERTbot_metrics.h"
+#include "ERTbot_allocationProfiler.h"
+#include "ERTbot_config.h"
+#include "wikiPageCache.h"
+#include "commandJournalHelpers.h"
 
 
 memory chunk;
@@ -27,33 +36,43 @@ char *lastPageRefreshCheck;
 
 PeriodicCommand** headOfPeriodicCommands;
 
-command** headOfCommandQueue;
+commandQueue* mainCommandQueue;
 
-#ifndef TESTING
+#if !defined(TESTING) && !defined(BENCHMARK) && !defined(LOAD_TEST)
 int main(){
+    initializeAllocationProfiler();
+    initializeLogLevels();
     log_message(LOG_DEBUG, "\n\nStarting program\n\n");
 
     //initalise
     initializeApiTokenVariables();
     initialiseSlackCommandStatusMessage();
+    const char* pageCachePath = getenv("ERTBOT_PAGE_CACHE_PATH");
+    (void)openPageCache(pageCachePath ? pageCachePath : WIKI_PAGE_CACHE_DEFAULT_PATH);
     lastPageRefreshCheck = getCurrentEDTTimeString();
     headOfPeriodicCommands = initalizePeriodicCommands(headOfPeriodicCommands);
+    initializeCommandRegistry();
     //declare command queue variable
-    headOfCommandQueue = (command**)malloc(sizeof(command*));
-    *headOfCommandQueue = NULL;
+    mainCommandQueue = createCommandQueue();
+    const char* commandJournalPath = getenv("ERTBOT_COMMAND_JOURNAL_PATH");
+    (void)openCommandJournal(commandJournalPath ? commandJournalPath : COMMAND_JOURNAL_DEFAULT_PATH, mainCommandQueue);
+    startMetricsServer();
     int cyclesSinceLastCommand = 0; //reduce number of API calls when "Idling"
 
     sendMessageToSlack("Wiki-Toolbox is Online");
 
     while(1){
 
-        headOfCommandQueue = checkForCommand(headOfCommandQueue, headOfPeriodicCommands);
+        mainCommandQueue = checkForCommand(mainCommandQueue, headOfPeriodicCommands);
+        setQueueDepthMetric(mainCommandQueue);
+        sendDeferredStatusUpdates();
         sleep(1);
 
-        if(*headOfCommandQueue){
+        if(!isCommandQueueEmpty(mainCommandQueue)){
             cyclesSinceLastCommand = 0;
             log_message(LOG_DEBUG, "command received");
-            headOfCommandQueue = executeCommand(headOfCommandQueue);
+            mainCommandQueue = executeCommand(mainCommandQueue);
+            setQueueDepthMetric(mainCommandQueue);
         }
 
         else{
@@ -61,6 +80,8 @@ int main(){
             log_message(LOG_DEBUG, "No command received.");
         }
 
+        dumpNetworkTelemetryIfDue();
+
         if(cyclesSinceLastCommand>20){
             sleep(1);
         }
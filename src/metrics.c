@@ -0,0 +1,331 @@
+/**
+ * @file metrics.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the metrics and the local HTTP listener exposing them in the Prometheus text format.
+ *
+ * @details Metrics are updated by the main thread and read by the listener thread: counters and gauges are atomics,
+ *          the command duration table is protected by a mutex. Request counts and latencies come from
+ *          networkTelemetry.c.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "ERTbot_metrics.h"
+#include "networkTelemetry.h"
+
+#define MAXIMUM_NUMBER_OF_MEASURED_COMMANDS 32
+#define COMMAND_NAME_LENGTH 64
+
+static const double commandDurationBuckets[] = {0.1, 1, 10, 60, 300, 900, 1800, 3600};
+
+#define NUMBER_OF_COMMAND_DURATION_BUCKETS (sizeof(commandDurationBuckets) / sizeof(commandDurationBuckets[0]))
+
+typedef struct commandDurationMetric {
+    char name[COMMAND_NAME_LENGTH];
+    unsigned long buckets[NUMBER_OF_COMMAND_DURATION_BUCKETS];
+    unsigned long count;
+    double sum;
+} commandDurationMetric;
+
+static const char* const commandPriorityNames[NUMBER_OF_COMMAND_PRIORITIES] = {
+    [COMMAND_PRIORITY_INTERACTIVE] = "interactive",
+    [COMMAND_PRIORITY_SCHEDULED] = "scheduled",
+    [COMMAND_PRIORITY_BACKGROUND] = "background",
+};
+
+static atomic_size_t queueDepths[NUMBER_OF_COMMAND_PRIORITIES];
+static atomic_ulong pagesWritten;
+static atomic_ulong pagesSkipped;
+static atomic_ulong oauthRefreshes;
+static atomic_long lastSchedulerLag;
+static atomic_long maximumSchedulerLag;
+static atomic_ulong scheduledCommands;
+static atomic_ulong rateLimitedResponses;
+static atomic_llong rateLimitWaitMicroseconds;
+
+static commandDurationMetric commandDurations[MAXIMUM_NUMBER_OF_MEASURED_COMMANDS];
+static int numberOfMeasuredCommands = 0;
+static pthread_mutex_t commandDurationsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static time_t processStartTime = 0;
+
+void setQueueDepthMetric(const commandQueue* queue){
+    for(int priority = 0; priority < NUMBER_OF_COMMAND_PRIORITIES; priority++){
+        atomic_store_explicit(&queueDepths[priority], queue ? queue->lanes[priority].size : 0, memory_order_relaxed);
+    }
+}
+
+void recordCommandDurationMetric(const char *commandName, double seconds){
+    pthread_mutex_lock(&commandDurationsMutex);
+
+    commandDurationMetric* metric = NULL;
+    for(int i = 0; i < numberOfMeasuredCommands; i++){
+        if(strcmp(commandDurations[i].name, commandName) == 0){
+            metric = &commandDurations[i];
+            break;
+        }
+    }
+
+    if(!metric && numberOfMeasuredCommands < MAXIMUM_NUMBER_OF_MEASURED_COMMANDS){
+        metric = &commandDurations[numberOfMeasuredCommands++];
+        snprintf(metric->name, sizeof(metric->name), "%s", commandName);
+    }
+
+    if(metric){
+        for(size_t bucket = 0; bucket < NUMBER_OF_COMMAND_DURATION_BUCKETS; bucket++){
+            if(seconds <= commandDurationBuckets[bucket]){
+                metric->buckets[bucket]++;
+            }
+        }
+        metric->count++;
+        metric->sum += seconds;
+    }
+
+    pthread_mutex_unlock(&commandDurationsMutex);
+}
+
+void countPageWriteMetric(bool wasWritten){
+    atomic_fetch_add_explicit(wasWritten ? &pagesWritten : &pagesSkipped, 1, memory_order_relaxed);
+}
+
+void countOAuthRefreshMetric(){
+    atomic_fetch_add_explicit(&oauthRefreshes, 1, memory_order_relaxed);
+}
+
+void countRateLimitedResponseMetric(){
+    atomic_fetch_add_explicit(&rateLimitedResponses, 1, memory_order_relaxed);
+}
+
+void recordRateLimitWaitMetric(long long microseconds){
+    atomic_fetch_add_explicit(&rateLimitWaitMicroseconds, microseconds, memory_order_relaxed);
+}
+
+void recordSchedulerLagMetric(long lagInSeconds){
+    atomic_store_explicit(&lastSchedulerLag, lagInSeconds, memory_order_relaxed);
+    atomic_fetch_add_explicit(&scheduledCommands, 1, memory_order_relaxed);
+
+    long maximum = atomic_load_explicit(&maximumSchedulerLag, memory_order_relaxed);
+    while(lagInSeconds > maximum && !atomic_compare_exchange_weak(&maximumSchedulerLag, &maximum, lagInSeconds)){
+    }
+}
+
+static long getResidentSetSize(){
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if(!statm){
+        return 0;
+    }
+
+    long totalPages = 0;
+    long residentPages = 0;
+    if(fscanf(statm, "%ld %ld", &totalPages, &residentPages) != 2){
+        residentPages = 0;
+    }
+    fclose(statm);
+
+    return residentPages * sysconf(_SC_PAGESIZE);
+}
+
+static void writeCommandDurationMetrics(FILE *out){
+    fputs("# HELP ertbot_command_duration_seconds Wall time of each command run.\n", out);
+    fputs("# TYPE ertbot_command_duration_seconds histogram\n", out);
+
+    pthread_mutex_lock(&commandDurationsMutex);
+
+    for(int i = 0; i < numberOfMeasuredCommands; i++){
+        const commandDurationMetric* metric = &commandDurations[i];
+
+        for(size_t bucket = 0; bucket < NUMBER_OF_COMMAND_DURATION_BUCKETS; bucket++){
+            fprintf(out, "ertbot_command_duration_seconds_bucket{command=\"%s\",le=\"%g\"} %lu\n", metric->name, commandDurationBuckets[bucket], metric->buckets[bucket]);
+        }
+        fprintf(out, "ertbot_command_duration_seconds_bucket{command=\"%s\",le=\"+Inf\"} %lu\n", metric->name, metric->count);
+        fprintf(out, "ertbot_command_duration_seconds_sum{command=\"%s\"} %f\n", metric->name, metric->sum);
+        fprintf(out, "ertbot_command_duration_seconds_count{command=\"%s\"} %lu\n", metric->name, metric->count);
+    }
+
+    pthread_mutex_unlock(&commandDurationsMutex);
+}
+
+char* buildMetricsText(){
+    char *text = NULL;
+    size_t length = 0;
+
+    FILE *out = open_memstream(&text, &length);
+    if(!out){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    fputs("# HELP ertbot_queue_depth Commands waiting in each lane of the command queue.\n", out);
+    fputs("# TYPE ertbot_queue_depth gauge\n", out);
+    for(int priority = 0; priority < NUMBER_OF_COMMAND_PRIORITIES; priority++){
+        fprintf(out, "ertbot_queue_depth{lane=\"%s\"} %zu\n", commandPriorityNames[priority], atomic_load_explicit(&queueDepths[priority], memory_order_relaxed));
+    }
+
+    writeCommandDurationMetrics(out);
+    writeNetworkTelemetryMetrics(out);
+
+    fputs("# HELP ertbot_pages_total Wiki pages written, or skipped because they were already up to date.\n", out);
+    fputs("# TYPE ertbot_pages_total counter\n", out);
+    fprintf(out, "ertbot_pages_total{result=\"written\"} %lu\n", atomic_load(&pagesWritten));
+    fprintf(out, "ertbot_pages_total{result=\"skipped\"} %lu\n", atomic_load(&pagesSkipped));
+
+    fputs("# HELP ertbot_oauth_refreshes_total Refreshes of the Google OAuth token.\n", out);
+    fputs("# TYPE ertbot_oauth_refreshes_total counter\n", out);
+    fprintf(out, "ertbot_oauth_refreshes_total %lu\n", atomic_load(&oauthRefreshes));
+
+    fputs("# HELP ertbot_rate_limited_responses_total Requests an API answered with 429 Too Many Requests.\n", out);
+    fputs("# TYPE ertbot_rate_limited_responses_total counter\n", out);
+    fprintf(out, "ertbot_rate_limited_responses_total %lu\n", atomic_load(&rateLimitedResponses));
+
+    fputs("# HELP ertbot_rate_limit_wait_seconds_total Time spent waiting for a rate limit before sending a request.\n", out);
+    fputs("# TYPE ertbot_rate_limit_wait_seconds_total counter\n", out);
+    fprintf(out, "ertbot_rate_limit_wait_seconds_total %.3f\n", (double)atomic_load(&rateLimitWaitMicroseconds) / 1e6);
+
+    fputs("# HELP ertbot_scheduler_lag_seconds Delay between the scheduled time of the last periodic command and the time it was queued.\n", out);
+    fputs("# TYPE ertbot_scheduler_lag_seconds gauge\n", out);
+    fprintf(out, "ertbot_scheduler_lag_seconds %ld\n", atomic_load(&lastSchedulerLag));
+
+    fputs("# HELP ertbot_scheduler_lag_max_seconds Largest scheduler lag since the bot started.\n", out);
+    fputs("# TYPE ertbot_scheduler_lag_max_seconds gauge\n", out);
+    fprintf(out, "ertbot_scheduler_lag_max_seconds %ld\n", atomic_load(&maximumSchedulerLag));
+
+    fputs("# HELP ertbot_scheduled_commands_total Periodic commands queued.\n", out);
+    fputs("# TYPE ertbot_scheduled_commands_total counter\n", out);
+    fprintf(out, "ertbot_scheduled_commands_total %lu\n", atomic_load(&scheduledCommands));
+
+    fputs("# HELP process_resident_memory_bytes Resident memory size in bytes.\n", out);
+    fputs("# TYPE process_resident_memory_bytes gauge\n", out);
+    fprintf(out, "process_resident_memory_bytes %ld\n", getResidentSetSize());
+
+    if(processStartTime != 0){
+        fputs("# HELP process_start_time_seconds Start time of the process since unix epoch in seconds.\n", out);
+        fputs("# TYPE process_start_time_seconds gauge\n", out);
+        fprintf(out, "process_start_time_seconds %ld\n", (long)processStartTime);
+    }
+
+    fclose(out);
+
+    return text;
+}
+
+static void sendAll(int client, const char *data, size_t length){
+    while(length > 0){
+        ssize_t sent = send(client, data, length, MSG_NOSIGNAL);
+        if(sent <= 0){
+            return;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+}
+
+static void answerMetricsRequest(int client){
+    // A scraper which never sends its request must not block the listener
+    struct timeval timeout = {1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request[1024];
+    ssize_t length = recv(client, request, sizeof(request) - 1, 0);
+    if(length <= 0){
+        return;
+    }
+    request[length] = '\0';
+
+    if(strncmp(request, "GET /metrics", strlen("GET /metrics")) != 0){
+        const char *notFound = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        sendAll(client, notFound, strlen(notFound));
+        return;
+    }
+
+    char* body = buildMetricsText();
+    size_t bodyLength = strlen(body);
+
+    char header[256];
+    int headerLength = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", bodyLength);
+
+    sendAll(client, header, (size_t)headerLength);
+    sendAll(client, body, bodyLength);
+
+    free(body);
+}
+
+static void* runMetricsServer(void* listener){
+    int serverSocket = *(int*)listener;
+    free(listener);
+
+    while(1){
+        int client = accept(serverSocket, NULL, NULL);
+        if(client < 0){
+            continue;
+        }
+
+        answerMetricsRequest(client);
+        close(client);
+    }
+
+    return NULL;
+}
+
+void startMetricsServer(){
+    log_message(LOG_DEBUG, "Entering function startMetricsServer");
+
+    processStartTime = time(NULL);
+
+    const char *port = getenv("ERTBOT_METRICS_PORT");
+    if(!port || port[0] == '\0'){
+        log_message(LOG_DEBUG, "ERTBOT_METRICS_PORT not set, metrics listener disabled");
+        log_message(LOG_DEBUG, "Exiting function startMetricsServer");
+        return;
+    }
+
+    int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if(serverSocket < 0){
+        log_message(LOG_ERROR, "Metrics listener: could not create socket");
+        return;
+    }
+
+    int reuseAddress = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)atoi(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(bind(serverSocket, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(serverSocket, 8) != 0){
+        log_message(LOG_ERROR, "Metrics listener: could not listen on 127.0.0.1:%s", port);
+        close(serverSocket);
+        return;
+    }
+
+    int* listener = (int*)malloc(sizeof(int));
+    if(!listener){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+    *listener = serverSocket;
+
+    pthread_t metricsThread;
+    if(pthread_create(&metricsThread, NULL, runMetricsServer, listener) != 0){
+        log_message(LOG_ERROR, "Metrics listener: could not start thread");
+        free(listener);
+        close(serverSocket);
+        return;
+    }
+    pthread_detach(metricsThread);
+
+    log_message(LOG_INFO, "Serving metrics on http://127.0.0.1:%s/metrics", port);
+    log_message(LOG_DEBUG, "Exiting function startMetricsServer");
+}
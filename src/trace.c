@@ -0,0 +1,458 @@
+/**
+ * @file trace.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains the tracer used to find where a command spends its time.
+ *
+ * @details Every traced command, the phases between its status messages and every HTTP request are recorded as
+ *          spans. The spans are kept in memory while the command runs and written in one go once it finishes, as a
+ *          Chrome trace event JSON file in `TRACE_DIRECTORY` (see `setTraceDirectory`), which keeps the last `TRACE_MAX_FILES` of them. Only the
+ *          main thread may open spans.
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "ERTbot_trace.h"
+#include "stringHelpers.h"
+
+#define TRACE_NAME_LENGTH 96
+#define TRACE_MAX_SUMMARY_ENTRIES 64
+
+typedef struct traceSpan {
+    traceCategory category;
+    char name[TRACE_NAME_LENGTH];
+    char detail[TRACE_NAME_LENGTH];
+    long long start;
+    long long duration;
+} traceSpan;
+
+typedef struct traceSummaryEntry {
+    const char *name;
+    long long totalDuration;
+    int count;
+} traceSummaryEntry;
+
+static const char* const traceCategoryNames[NUMBER_OF_TRACE_CATEGORIES] = {
+    [TRACE_CATEGORY_COMMAND] = "command",
+    [TRACE_CATEGORY_FEATURE] = "feature",
+    [TRACE_CATEGORY_PHASE] = "phase",
+    [TRACE_CATEGORY_API] = "api",
+};
+
+static traceSpan openSpans[TRACE_MAX_DEPTH];
+static int numberOfOpenSpans = 0;
+
+// Spans which are not recorded (no command traced or too deeply nested) still have to be matched with their end
+static int numberOfIgnoredSpans = 0;
+
+static traceSpan* recordedSpans = NULL;
+static size_t numberOfRecordedSpans = 0;
+static size_t recordedSpansCapacity = 0;
+static unsigned long numberOfDroppedSpans = 0;
+
+static long long traceStartTime = 0;
+static char* lastTraceSummary = NULL;
+
+#ifdef TESTING
+static const char* traceDirectory = NULL;
+#else
+static const char* traceDirectory = TRACE_DIRECTORY;
+#endif
+static char* allocatedTraceDirectory = NULL;
+
+void setTraceDirectory(const char *directory){
+    free(allocatedTraceDirectory);
+
+    allocatedTraceDirectory = directory ? duplicate_Malloc(directory) : NULL;
+    traceDirectory = allocatedTraceDirectory;
+}
+
+static long long getMonotonicMicroseconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+static void copyTraceName(char *destination, const char *source){
+    snprintf(destination, TRACE_NAME_LENGTH, "%s", source ? source : "");
+}
+
+static void writeJsonEscapedString(FILE *file, const char *text){
+    for(const char *c = text; *c; c++){
+        if(*c == '"' || *c == '\\'){
+            fputc('\\', file);
+            fputc(*c, file);
+        }
+        else if((unsigned char)*c < 0x20){
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        }
+        else{
+            fputc(*c, file);
+        }
+    }
+}
+
+static char* appendJsonEscapedString(char *message, const char *text){
+    char escaped[2 * TRACE_NAME_LENGTH];
+    size_t length = 0;
+
+    for(const char *c = text; *c && length < sizeof(escaped) - 2; c++){
+        if(*c == '"' || *c == '\\'){
+            escaped[length++] = '\\';
+            escaped[length++] = *c;
+        }
+        else if((unsigned char)*c >= 0x20){
+            escaped[length++] = *c;
+        }
+    }
+    escaped[length] = '\0';
+
+    return appendToString(message, escaped);
+}
+
+static void recordSpan(const traceSpan* span){
+    if(numberOfRecordedSpans >= TRACE_MAX_EVENTS){
+        numberOfDroppedSpans++;
+        return;
+    }
+
+    if(numberOfRecordedSpans == recordedSpansCapacity){
+        size_t newCapacity = recordedSpansCapacity ? 2 * recordedSpansCapacity : 256;
+        traceSpan* newSpans = (traceSpan*)realloc(recordedSpans, newCapacity * sizeof(traceSpan));
+        if(!newSpans){
+            log_message(LOG_ERROR, "Memory allocation error");
+            exit(1);
+        }
+
+        recordedSpans = newSpans;
+        recordedSpansCapacity = newCapacity;
+    }
+
+    recordedSpans[numberOfRecordedSpans++] = *span;
+}
+
+static traceSpan closeInnermostSpan(){
+    traceSpan* span = &openSpans[--numberOfOpenSpans];
+    span->duration = getMonotonicMicroseconds() - traceStartTime - span->start;
+
+    recordSpan(span);
+
+    return *span;
+}
+
+static traceSummaryEntry* findSummaryEntry(traceSummaryEntry* entries, int* numberOfEntries, const char *name){
+    for(int i = 0; i < *numberOfEntries; i++){
+        if(strcmp(entries[i].name, name) == 0){
+            return &entries[i];
+        }
+    }
+
+    if(*numberOfEntries == TRACE_MAX_SUMMARY_ENTRIES){
+        return NULL;
+    }
+
+    traceSummaryEntry* entry = &entries[(*numberOfEntries)++];
+    entry->name = name;
+    entry->totalDuration = 0;
+    entry->count = 0;
+
+    return entry;
+}
+
+static int summarizeSpans(traceCategory category, traceSummaryEntry* entries){
+    int numberOfEntries = 0;
+
+    for(size_t i = 0; i < numberOfRecordedSpans; i++){
+        if(recordedSpans[i].category != category){
+            continue;
+        }
+
+        traceSummaryEntry* entry = findSummaryEntry(entries, &numberOfEntries, recordedSpans[i].name);
+        if(entry){
+            entry->totalDuration += recordedSpans[i].duration;
+            entry->count++;
+        }
+    }
+
+    // Longest first, there are only a handful of distinct phases
+    for(int i = 1; i < numberOfEntries; i++){
+        traceSummaryEntry entry = entries[i];
+        int j = i - 1;
+        while(j >= 0 && entries[j].totalDuration < entry.totalDuration){
+            entries[j + 1] = entries[j];
+            j--;
+        }
+        entries[j + 1] = entry;
+    }
+
+    return numberOfEntries;
+}
+
+static char* appendSeconds(char *message, long long microseconds){
+    char seconds[32];
+    snprintf(seconds, sizeof(seconds), "%.1f s", (double)microseconds / 1e6);
+
+    return appendToString(message, seconds);
+}
+
+static char* buildTraceSummary(const traceSpan* commandSpan, const char *path){
+    char* summary = duplicate_Malloc("Last trace: *");
+    summary = appendJsonEscapedString(summary, commandSpan->name);
+    if(commandSpan->detail[0]){
+        summary = appendToString(summary, " ");
+        summary = appendJsonEscapedString(summary, commandSpan->detail);
+    }
+    summary = appendToString(summary, "* took ");
+    summary = appendSeconds(summary, commandSpan->duration);
+    summary = appendToString(summary, " (");
+    summary = appendToString(summary, path);
+    summary = appendToString(summary, ")\\n");
+
+    traceSummaryEntry entries[TRACE_MAX_SUMMARY_ENTRIES];
+    char count[32];
+
+    int numberOfPhases = summarizeSpans(TRACE_CATEGORY_PHASE, entries);
+    if(numberOfPhases > 0){
+        summary = appendToString(summary, "Top phases:\\n");
+    }
+    for(int i = 0; i < numberOfPhases && i < TRACE_SUMMARY_TOP_PHASES; i++){
+        summary = appendToString(summary, "- ");
+        summary = appendJsonEscapedString(summary, entries[i].name);
+        summary = appendToString(summary, ": ");
+        summary = appendSeconds(summary, entries[i].totalDuration);
+        snprintf(count, sizeof(count), " (%dx)\\n", entries[i].count);
+        summary = appendToString(summary, count);
+    }
+
+    int numberOfApis = summarizeSpans(TRACE_CATEGORY_API, entries);
+    if(numberOfApis > 0){
+        summary = appendToString(summary, "API calls:");
+    }
+    for(int i = 0; i < numberOfApis; i++){
+        summary = appendToString(summary, i == 0 ? " " : ", ");
+        summary = appendJsonEscapedString(summary, entries[i].name);
+        snprintf(count, sizeof(count), " %dx ", entries[i].count);
+        summary = appendToString(summary, count);
+        summary = appendSeconds(summary, entries[i].totalDuration);
+    }
+    if(numberOfApis > 0){
+        summary = appendToString(summary, "\\n");
+    }
+
+    if(numberOfDroppedSpans > 0){
+        snprintf(count, sizeof(count), "%lu", numberOfDroppedSpans);
+        summary = appendToString(summary, "Spans dropped: ");
+        summary = appendToString(summary, count);
+        summary = appendToString(summary, "\\n");
+    }
+
+    return summary;
+}
+
+static void writeTraceFile(const char *path){
+    FILE *file = fopen(path, "w");
+    if(!file){
+        log_message(LOG_ERROR, "Could not open trace file %s", path);
+        return;
+    }
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+
+    for(size_t i = 0; i < numberOfRecordedSpans; i++){
+        const traceSpan* span = &recordedSpans[i];
+
+        fputs(i == 0 ? "\n{\"name\":\"" : ",\n{\"name\":\"", file);
+        writeJsonEscapedString(file, span->name);
+        fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":1",
+                traceCategoryNames[span->category], span->start, span->duration);
+
+        if(span->detail[0]){
+            fputs(",\"args\":{\"detail\":\"", file);
+            writeJsonEscapedString(file, span->detail);
+            fputs("\"}", file);
+        }
+
+        fputc('}', file);
+    }
+
+    fputs("\n]}\n", file);
+    fclose(file);
+}
+
+static int isTraceFile(const struct dirent* entry){
+    size_t length = strlen(entry->d_name);
+    return strncmp(entry->d_name, "trace_", strlen("trace_")) == 0 && length > strlen(".json") &&
+           strcmp(entry->d_name + length - strlen(".json"), ".json") == 0;
+}
+
+/**
+ * @brief Deletes the oldest trace files so that at most `TRACE_MAX_FILES` are left.
+ *
+ * @details The names start with the time the trace was written, sorting them sorts the traces from oldest to newest.
+ */
+static void removeOldTraceFiles(){
+    struct dirent** entries = NULL;
+    int numberOfEntries = scandir(traceDirectory, &entries, isTraceFile, alphasort);
+    if(numberOfEntries < 0){
+        return;
+    }
+
+    for(int i = 0; i < numberOfEntries; i++){
+        if(i < numberOfEntries - TRACE_MAX_FILES){
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", traceDirectory, entries[i]->d_name);
+            remove(path);
+        }
+        free(entries[i]);
+    }
+    free(entries);
+}
+
+/**
+ * @brief Copies a span name or detail in a form which can be part of a file name.
+ */
+static void copyTraceFileNamePart(char* destination, size_t size, const char *source){
+    size_t i = 0;
+    for(; source[i] && i + 1 < size; i++){
+        char c = source[i];
+        destination[i] = isalnum((unsigned char)c) || c == '-' ? c : '_';
+    }
+    destination[i] = '\0';
+}
+
+/**
+ * @brief Writes the trace of the command which just finished and keeps its summary for "trace last".
+ */
+static void finishTrace(const traceSpan* commandSpan){
+    log_message(LOG_DEBUG, "Entering function finishTrace");
+
+    static unsigned int numberOfWrittenTraces = 0;
+
+    // Trace files are disabled, only the summary is kept
+    if(!traceDirectory){
+        free(lastTraceSummary);
+        lastTraceSummary = buildTraceSummary(commandSpan, "no trace file");
+
+        numberOfRecordedSpans = 0;
+        numberOfDroppedSpans = 0;
+
+        log_message(LOG_DEBUG, "Exiting function finishTrace");
+        return;
+    }
+
+    mkdir(traceDirectory, 0755);
+
+    char timestamp[32];
+    time_t now = time(NULL);
+    struct tm tm_info;
+    localtime_r(&now, &tm_info);
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", &tm_info);
+
+    // Two runs of the same command in the same second, e.g. sync of two subsystems, each get their own file
+    char name[TRACE_NAME_LENGTH];
+    char argument[32];
+    copyTraceFileNamePart(name, sizeof(name), commandSpan->name);
+    copyTraceFileNamePart(argument, sizeof(argument), commandSpan->detail);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/trace_%s-%06u_%s%s%s.json", traceDirectory, timestamp, numberOfWrittenTraces++ % 1000000,
+             name, argument[0] ? "_" : "", argument);
+
+    writeTraceFile(path);
+    removeOldTraceFiles();
+
+    free(lastTraceSummary);
+    lastTraceSummary = buildTraceSummary(commandSpan, path);
+
+    log_message(LOG_INFO, "Trace of %s written to %s", commandSpan->name, path);
+
+    numberOfRecordedSpans = 0;
+    numberOfDroppedSpans = 0;
+
+    log_message(LOG_DEBUG, "Exiting function finishTrace");
+}
+
+void beginTraceSpan(traceCategory category, const char *name, const char *detail){
+    bool isTracing = numberOfOpenSpans > 0;
+
+    if(numberOfIgnoredSpans > 0 || (!isTracing && category != TRACE_CATEGORY_COMMAND) || numberOfOpenSpans == TRACE_MAX_DEPTH){
+        numberOfIgnoredSpans++;
+        return;
+    }
+
+    if(!isTracing){
+        traceStartTime = getMonotonicMicroseconds();
+        numberOfRecordedSpans = 0;
+        numberOfDroppedSpans = 0;
+    }
+
+    traceSpan* span = &openSpans[numberOfOpenSpans++];
+    span->category = category;
+    copyTraceName(span->name, name);
+    copyTraceName(span->detail, detail);
+    span->start = getMonotonicMicroseconds() - traceStartTime;
+    span->duration = 0;
+}
+
+void endTraceSpan(){
+    if(numberOfIgnoredSpans > 0){
+        numberOfIgnoredSpans--;
+        return;
+    }
+
+    if(numberOfOpenSpans == 0){
+        return;
+    }
+
+    // A phase ends with the span it belongs to
+    if(openSpans[numberOfOpenSpans - 1].category == TRACE_CATEGORY_PHASE){
+        (void)closeInnermostSpan();
+    }
+
+    if(numberOfOpenSpans == 0){
+        return;
+    }
+
+    traceSpan closedSpan = closeInnermostSpan();
+
+    if(numberOfOpenSpans == 0){
+        finishTrace(&closedSpan);
+    }
+}
+
+void markTracePhase(const char *phaseName){
+    if(numberOfOpenSpans == 0 || numberOfIgnoredSpans > 0){
+        return;
+    }
+
+    if(openSpans[numberOfOpenSpans - 1].category == TRACE_CATEGORY_PHASE){
+        (void)closeInnermostSpan();
+    }
+
+    beginTraceSpan(TRACE_CATEGORY_PHASE, phaseName, NULL);
+}
+
+const char* getCurrentTracePhaseName(){
+    for(int i = numberOfOpenSpans - 1; i >= 0; i--){
+        if(openSpans[i].category != TRACE_CATEGORY_API){
+            return openSpans[i].name;
+        }
+    }
+
+    return NULL;
+}
+
+char* buildLastTraceSummary(){
+    if(!lastTraceSummary){
+        return NULL;
+    }
+
+    return duplicate_Malloc(lastTraceSummary);
+}
@@ -0,0 +1,100 @@
+#include <check.h>
+#include <curl/curl.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "apiHelpers.h"
+#include "httpTransport.h"
+#include "circuitBreaker.h"
+
+START_TEST(test_circuitOpensAfterConsecutiveFailures) {
+    resetCircuitBreakers();
+    unsigned long events = getCircuitBreakerEventCount();
+
+    // Client errors and rate limits show that the service is up
+    for(int i = 0; i < CIRCUIT_BREAKER_FAILURE_THRESHOLD; i++){
+        reportCircuitResult(NETWORK_ENDPOINT_WIKI_GET_PAGE, CURLE_OK, i % 2 ? 404 : 429);
+    }
+    ck_assert(!isCircuitOpen(NETWORK_ENDPOINT_WIKI_GET_PAGE));
+
+    // A success in between starts the count again
+    for(int i = 0; i < CIRCUIT_BREAKER_FAILURE_THRESHOLD - 1; i++){
+        reportCircuitResult(NETWORK_ENDPOINT_WIKI_GET_PAGE, CURLE_OPERATION_TIMEDOUT, 0);
+    }
+    reportCircuitResult(NETWORK_ENDPOINT_WIKI_LIST_PAGES, CURLE_OK, 200);
+    reportCircuitResult(NETWORK_ENDPOINT_WIKI_GET_PAGE, CURLE_OK, 503);
+    ck_assert(!isCircuitOpen(NETWORK_ENDPOINT_WIKI_GET_PAGE));
+    ck_assert_int_eq(getCircuitBreakerPause(), 0);
+
+    for(int i = 0; i < CIRCUIT_BREAKER_FAILURE_THRESHOLD - 1; i++){
+        reportCircuitResult(NETWORK_ENDPOINT_WIKI_UPDATE_PAGE, CURLE_COULDNT_CONNECT, 0);
+    }
+    ck_assert(isCircuitOpen(NETWORK_ENDPOINT_WIKI_GET_PAGE));
+    ck_assert(!allowCircuitRequest(NETWORK_ENDPOINT_WIKI_CREATE_PAGE));
+    ck_assert_uint_eq(getCircuitBreakerEventCount(), events + 2);
+
+    long long pause = getCircuitBreakerPause();
+    ck_assert_int_gt(pause, 0);
+    ck_assert_int_le(pause, (long long)CIRCUIT_BREAKER_OPEN_SECONDS * 1000000 + 1);
+
+    // Every service has its own circuit
+    ck_assert(!isCircuitOpen(NETWORK_ENDPOINT_SHEET_GET));
+    ck_assert(allowCircuitRequest(NETWORK_ENDPOINT_SLACK_POST));
+
+    resetCircuitBreakers();
+    ck_assert(allowCircuitRequest(NETWORK_ENDPOINT_WIKI_CREATE_PAGE));
+    ck_assert_int_eq(getCircuitBreakerPause(), 0);
+}
+END_TEST
+
+START_TEST(test_openCircuitFailsRequestsWithoutSendingThem) {
+    resetCircuitBreakers();
+
+    const char *url = "file:///tmp/ERTbot_circuitBreaker.json";
+    FILE *file = fopen("/tmp/ERTbot_circuitBreaker.json", "w");
+    ck_assert_ptr_nonnull(file);
+    fputs("{}", file);
+    fclose(file);
+
+    CURL *curl = curl_easy_init();
+    ck_assert_ptr_nonnull(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+
+    for(int i = 0; i < CIRCUIT_BREAKER_FAILURE_THRESHOLD; i++){
+        reportCircuitResult(NETWORK_ENDPOINT_SHEET_GET, CURLE_OK, 502);
+    }
+
+    long httpCode = -1;
+    resetChunkResponse();
+    ck_assert_int_eq(performHttpRequest(curl, NETWORK_ENDPOINT_SHEET_GET, "GET", url, NULL, &httpCode), CURLE_COULDNT_CONNECT);
+    ck_assert_int_eq(httpCode, 0);
+    ck_assert_uint_eq(chunk.size, 0);
+
+    resetCircuitBreakers();
+    resetChunkResponse();
+    ck_assert_int_eq(performHttpRequest(curl, NETWORK_ENDPOINT_SHEET_GET, "GET", url, NULL, &httpCode), CURLE_OK);
+    ck_assert_str_eq(chunk.response, "{}");
+
+    curl_easy_cleanup(curl);
+    resetChunkResponse();
+    remove("/tmp/ERTbot_circuitBreaker.json");
+}
+END_TEST
+
+// Test suite setup
+Suite *circuitBreaker_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("circuitBreaker");
+
+    // Core test case
+    tc_core = tcase_create("circuitBreaker");
+
+    tcase_add_test(tc_core, test_circuitOpensAfterConsecutiveFailures);
+    tcase_add_test(tc_core, test_openCircuitFailsRequestsWithoutSendingThem);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -0,0 +1,84 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ERTbot_common.h"
+#include "apiHelpers.h"
+#include "pageListHelpers.h"
+#include "httpTransport.h"
+#include "wikiAPI.h"
+#include "fetchStage.h"
+
+static void addInteraction(FILE *file, const char *endpoint, const char *method, int httpCode, const char *response){
+    fprintf(file, "%s %s %d 0 0000000000000000 %zu\n%s\n", endpoint, method, httpCode, strlen(response), response);
+}
+
+START_TEST(test_runFetchStage) {
+    char cassettePath[] = "/tmp/ERTbot_fetchStageXXXXXX";
+    int descriptor = mkstemp(cassettePath);
+    ck_assert_int_ge(descriptor, 0);
+
+    FILE *file = fdopen(descriptor, "w");
+    ck_assert_ptr_nonnull(file);
+    fputs("ERTBOT_CASSETTE 1\n", file);
+    addInteraction(file, "sheet.oauth", "POST", 200, "{\n  \"access_token\": \"test-access-token\",\n  \"expires_in\": 3599\n}");
+    addInteraction(file, "wiki.listPages", "POST", 200, "{\"data\":{\"pages\":{\"list\":["
+                   "{\"path\":\"req/ST/2024_C_SE_ST_REQ_01\",\"title\":\"2024_C_SE_ST_REQ_01\",\"id\":12,\"updatedAt\":\"2024-05-01T10:00:00.000Z\"},"
+                   "{\"path\":\"req/PR/2024_C_SE_PR_REQ_01\",\"title\":\"2024_C_SE_PR_REQ_01\",\"id\":13,\"updatedAt\":\"2024-05-01T10:00:00.000Z\"}]}}}");
+    addInteraction(file, "sheet.get", "GET", 503, "{\"error\":{\"code\":503,\"message\":\"The service is currently unavailable.\"}}");
+    fclose(file);
+
+    setenv("GOOGLE_CLIENT_ID", "test", 1);
+    setenv("GOOGLE_CLIENT_SECRET", "test", 1);
+    setenv("GOOGLE_REFRESH_TOKEN", "test", 1);
+    initializeApiTokenVariables();
+
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+
+    fetchStage stage;
+    initializeFetchStage(&stage);
+    int pageListFetch = addPageListFetch(&stage, "path");
+    int sheetFetch = addSheetFetch(&stage, "spreadsheet", "ST!A1:Z");
+    ck_assert_int_ne(pageListFetch, sheetFetch);
+    runFetchStage(&stage);
+
+    // Each request has its own response, a failed one has none
+    const char *pageListResponse = getFetchResponse(&stage, pageListFetch);
+    ck_assert_ptr_nonnull(pageListResponse);
+    ck_assert_ptr_null(getFetchResponse(&stage, sheetFetch));
+
+    pageList* pages = NULL;
+    pages = parseJSON(&pages, pageListResponse, "path", "req/ST/");
+    ck_assert_ptr_nonnull(pages);
+    ck_assert_str_eq(pages->id, "12");
+    ck_assert_ptr_null(pages->next);
+
+    freePageList(&pages);
+    freeFetchStage(&stage);
+
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+    ck_assert_uint_eq(statistics.replayedRequests, 3);
+    ck_assert_uint_eq(statistics.unusedInteractions, 0);
+
+    closeCassette();
+    remove(cassettePath);
+}
+END_TEST
+
+// Test suite setup
+Suite *fetchStage_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("fetchStage");
+
+    // Core test case
+    tc_core = tcase_create("fetchStage");
+
+    tcase_add_test(tc_core, test_runFetchStage);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -0,0 +1,94 @@
+#include <check.h>
+#include <curl/curl.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "httpRetry.h"
+
+START_TEST(test_getHttpRetryDelay_followsIdempotency) {
+    beginHttpRequestBudget();
+
+    ck_assert_int_eq(getEndpointIdempotency(NETWORK_ENDPOINT_WIKI_GET_PAGE), HTTP_IDEMPOTENCY_IDEMPOTENT);
+    ck_assert_int_eq(getEndpointIdempotency(NETWORK_ENDPOINT_WIKI_UPDATE_PAGE), HTTP_IDEMPOTENCY_IDEMPOTENT);
+    ck_assert_int_eq(getEndpointIdempotency(NETWORK_ENDPOINT_WIKI_CREATE_PAGE), HTTP_IDEMPOTENCY_NOT_IDEMPOTENT);
+
+    // A query is retried after any transient failure, with a backoff bounded by the attempt
+    long long delay = getHttpRetryDelay(NETWORK_ENDPOINT_WIKI_GET_PAGE, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_OK, 503, 0);
+    ck_assert_int_ge(delay, 0);
+    ck_assert_int_lt(delay, HTTP_RETRY_BASE_DELAY_MS * 1000);
+
+    delay = getHttpRetryDelay(NETWORK_ENDPOINT_SHEET_GET, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_RECV_ERROR, 0, 2);
+    ck_assert_int_ge(delay, 0);
+    ck_assert_int_lt(delay, HTTP_RETRY_BASE_DELAY_MS * 1000 * 4);
+
+    ck_assert_int_eq(getHttpRetryDelay(NETWORK_ENDPOINT_WIKI_GET_PAGE, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_OK, 503, HTTP_RETRY_MAX_ATTEMPTS - 1), -1);
+    ck_assert_int_eq(getHttpRetryDelay(NETWORK_ENDPOINT_WIKI_GET_PAGE, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_OK, 400, 0), -1);
+
+    // A creation which may have reached the wiki is not sent twice
+    ck_assert_int_eq(getHttpRetryDelay(NETWORK_ENDPOINT_WIKI_CREATE_PAGE, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_OK, 503, 0), -1);
+    ck_assert_int_eq(getHttpRetryDelay(NETWORK_ENDPOINT_WIKI_CREATE_PAGE, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_RECV_ERROR, 0, 0), -1);
+    ck_assert_int_ge(getHttpRetryDelay(NETWORK_ENDPOINT_WIKI_CREATE_PAGE, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_COULDNT_CONNECT, 0, 0), 0);
+
+    // The request can say better than its endpoint
+    ck_assert_int_ge(getHttpRetryDelay(NETWORK_ENDPOINT_WIKI_MUTATION_BATCH, HTTP_IDEMPOTENCY_IDEMPOTENT, CURLE_OK, 502, 0), 0);
+    ck_assert_int_eq(getHttpRetryDelay(NETWORK_ENDPOINT_WIKI_MUTATION_BATCH, HTTP_IDEMPOTENCY_NOT_IDEMPOTENT, CURLE_OK, 502, 0), -1);
+
+    endHttpRequestBudget();
+}
+END_TEST
+
+START_TEST(test_getHttpRetryDelay_stopsOnceBudgetIsExhausted) {
+    beginHttpRequestBudget();
+
+    for(int i = 0; i < HTTP_RETRY_BUDGET_PER_COMMAND; i++){
+        ck_assert_int_ge(getHttpRetryDelay(NETWORK_ENDPOINT_SHEET_GET, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_OPERATION_TIMEDOUT, 0, 0), 0);
+    }
+    ck_assert_int_eq(getRemainingHttpRetries(), 0);
+    ck_assert_int_eq(getHttpRetryDelay(NETWORK_ENDPOINT_SHEET_GET, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_OPERATION_TIMEDOUT, 0, 0), -1);
+
+    // A command run in between gets its own budget, the interrupted one gets its own back
+    beginHttpRequestBudget();
+    ck_assert_int_eq(getRemainingHttpRetries(), HTTP_RETRY_BUDGET_PER_COMMAND);
+    ck_assert_int_ge(getHttpRetryDelay(NETWORK_ENDPOINT_SHEET_GET, HTTP_IDEMPOTENCY_FROM_ENDPOINT, CURLE_OPERATION_TIMEDOUT, 0, 0), 0);
+    endHttpRequestBudget();
+    ck_assert_int_eq(getRemainingHttpRetries(), 0);
+
+    endHttpRequestBudget();
+    ck_assert_int_eq(getRemainingHttpRetries(), HTTP_RETRY_BUDGET_PER_COMMAND);
+}
+END_TEST
+
+START_TEST(test_getRemainingHttpTime_followsCommandDeadline) {
+    ck_assert_int_eq(getRemainingHttpTime(), -1);
+
+    beginHttpRequestBudget();
+    long long remaining = getRemainingHttpTime();
+    ck_assert_int_gt(remaining, 0);
+    ck_assert_int_le(remaining, (long long)HTTP_COMMAND_DEADLINE_SECONDS * 1000000);
+
+    // The interrupted command does not lose the time the other one took
+    beginHttpRequestBudget();
+    endHttpRequestBudget();
+    ck_assert_int_ge(getRemainingHttpTime(), remaining - 1000000);
+
+    endHttpRequestBudget();
+    ck_assert_int_eq(getRemainingHttpTime(), -1);
+}
+END_TEST
+
+// Test suite setup
+Suite *httpRetry_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("httpRetry");
+
+    // Core test case
+    tc_core = tcase_create("httpRetry");
+
+    tcase_add_test(tc_core, test_getHttpRetryDelay_followsIdempotency);
+    tcase_add_test(tc_core, test_getHttpRetryDelay_stopsOnceBudgetIsExhausted);
+    tcase_add_test(tc_core, test_getRemainingHttpTime_followsCommandDeadline);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
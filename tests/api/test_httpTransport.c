@@ -0,0 +1,286 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <curl/curl.h>
+#include "ERTbot_common.h"
+#include "apiHelpers.h"
+#include "httpTransport.h"
+#include "rateLimiter.h"
+#include "ERTbot_config.h"
+
+static void createFile(const char *path, const char *content){
+    FILE *file = fopen(path, "w");
+    ck_assert_ptr_nonnull(file);
+    fputs(content, file);
+    fclose(file);
+}
+
+static CURLcode getFile(const char *url, long *httpCode){
+    CURL *curl = curl_easy_init();
+    ck_assert_ptr_nonnull(curl);
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+
+    resetChunkResponse();
+    CURLcode res = performHttpRequest(curl, NETWORK_ENDPOINT_SHEET_GET, "GET", url, NULL, httpCode);
+
+    curl_easy_cleanup(curl);
+    return res;
+}
+
+START_TEST(test_replayRecordedResponse) {
+    char cassettePath[] = "/tmp/ERTbot_cassetteXXXXXX";
+    int descriptor = mkstemp(cassettePath);
+    ck_assert_int_ge(descriptor, 0);
+    close(descriptor);
+
+    const char *responsePath = "/tmp/ERTbot_cassette_response.json";
+    createFile(responsePath, "{\"values\": [[\"ERT_REQ_1\"]]}");
+
+    long httpCode = -1;
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_RECORD, cassettePath, false), 0);
+    ck_assert_int_eq(getFile("file:///tmp/ERTbot_cassette_response.json", &httpCode), CURLE_OK);
+    closeCassette();
+
+    // Nothing is read from the file any more
+    remove(responsePath);
+
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+    ck_assert_int_eq(getFile("file:///tmp/ERTbot_cassette_response.json", &httpCode), CURLE_OK);
+    ck_assert_str_eq(chunk.response, "{\"values\": [[\"ERT_REQ_1\"]]}");
+
+    // Every interaction has been used, a second request cannot be answered
+    ck_assert_int_eq(getFile("file:///tmp/ERTbot_cassette_response.json", &httpCode), CURLE_COULDNT_CONNECT);
+    ck_assert_int_eq(httpCode, 0);
+
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+    ck_assert_uint_eq(statistics.replayedRequests, 1);
+    ck_assert_uint_eq(statistics.mismatchedRequests, 1);
+    ck_assert_uint_eq(statistics.unusedInteractions, 0);
+
+    closeCassette();
+    resetChunkResponse();
+    remove(cassettePath);
+}
+END_TEST
+
+START_TEST(test_replayMismatchedRequest) {
+    char cassettePath[] = "/tmp/ERTbot_cassetteXXXXXX";
+    int descriptor = mkstemp(cassettePath);
+    ck_assert_int_ge(descriptor, 0);
+    close(descriptor);
+
+    createFile(cassettePath, "ERTBOT_CASSETTE 1\n"
+                             "sheet.get GET 200 1500 0000000000000001 5\nfirst\n"
+                             "wiki.getPage POST 200 1500 0000000000000002 4\nwiki\n"
+                             "sheet.get GET 200 1500 0000000000000003 6\nsecond\n");
+
+    long httpCode = 0;
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+
+    // No recorded hash matches, the next response of the same endpoint is served
+    ck_assert_int_eq(getFile("file:///tmp/not_recorded", &httpCode), CURLE_OK);
+    ck_assert_int_eq(httpCode, 200);
+    ck_assert_str_eq(chunk.response, "first");
+
+    ck_assert_int_eq(getFile("file:///tmp/not_recorded", &httpCode), CURLE_OK);
+    ck_assert_str_eq(chunk.response, "second");
+
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+    ck_assert_uint_eq(statistics.replayedRequests, 2);
+    ck_assert_uint_eq(statistics.mismatchedRequests, 2);
+    ck_assert_uint_eq(statistics.unusedInteractions, 1);
+
+    closeCassette();
+    resetChunkResponse();
+    remove(cassettePath);
+}
+END_TEST
+
+static void getFiles(httpRequest* requests, const char** urls, int numberOfRequests){
+    for(int i = 0; i < numberOfRequests; i++){
+        requests[i] = (httpRequest){.endpoint = NETWORK_ENDPOINT_SHEET_GET, .method = "GET", .url = urls[i]};
+        requests[i].curl = curl_easy_init();
+        ck_assert_ptr_nonnull(requests[i].curl);
+
+        curl_easy_setopt(requests[i].curl, CURLOPT_URL, urls[i]);
+        curl_easy_setopt(requests[i].curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(requests[i].curl, CURLOPT_WRITEDATA, (void *)&requests[i].response);
+    }
+
+    performHttpRequests(requests, numberOfRequests, 2);
+
+    for(int i = 0; i < numberOfRequests; i++){
+        curl_easy_cleanup(requests[i].curl);
+    }
+}
+
+START_TEST(test_replayConcurrentRequests) {
+    char cassettePath[] = "/tmp/ERTbot_cassetteXXXXXX";
+    int descriptor = mkstemp(cassettePath);
+    ck_assert_int_ge(descriptor, 0);
+    close(descriptor);
+
+    const char* paths[] = {"/tmp/ERTbot_cassette_first.json", "/tmp/ERTbot_cassette_second.json", "/tmp/ERTbot_cassette_third.json"};
+    const char* urls[] = {"file:///tmp/ERTbot_cassette_first.json", "file:///tmp/ERTbot_cassette_second.json", "file:///tmp/ERTbot_cassette_third.json"};
+    const char* contents[] = {"first", "second", "third"};
+    for(int i = 0; i < 3; i++){
+        createFile(paths[i], contents[i]);
+    }
+
+    httpRequest requests[3];
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_RECORD, cassettePath, false), 0);
+    getFiles(requests, urls, 3);
+    closeCassette();
+
+    // Every request has its own response, whatever order they finished in
+    for(int i = 0; i < 3; i++){
+        ck_assert_int_eq(requests[i].result, CURLE_OK);
+        ck_assert_str_eq(requests[i].response.response, contents[i]);
+        free(requests[i].response.response);
+        remove(paths[i]);
+    }
+
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+    getFiles(requests, urls, 3);
+
+    for(int i = 0; i < 3; i++){
+        ck_assert_int_eq(requests[i].result, CURLE_OK);
+        ck_assert_str_eq(requests[i].response.response, contents[i]);
+        free(requests[i].response.response);
+    }
+
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+    ck_assert_uint_eq(statistics.replayedRequests, 3);
+    ck_assert_uint_eq(statistics.mismatchedRequests, 0);
+
+    closeCassette();
+    remove(cassettePath);
+}
+END_TEST
+
+START_TEST(test_replayRateLimitedRequest) {
+    char cassettePath[] = "/tmp/ERTbot_cassetteXXXXXX";
+    int descriptor = mkstemp(cassettePath);
+    ck_assert_int_ge(descriptor, 0);
+    close(descriptor);
+
+    createFile(cassettePath, "ERTBOT_CASSETTE 1\n"
+                             "sheet.get GET 429 1500 0000000000000001 7\nlimited\n"
+                             "sheet.get GET 200 1500 0000000000000002 2\nok\n");
+
+    // The request answered 429 is sent again, only the response of the retry is kept
+    long httpCode = -1;
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+    ck_assert_int_eq(getFile("file:///tmp/ERTbot_rate_limited.json", &httpCode), CURLE_OK);
+    ck_assert_int_eq(httpCode, 200);
+    ck_assert_str_eq(chunk.response, "ok");
+
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+    ck_assert_uint_eq(statistics.replayedRequests, 2);
+    ck_assert_uint_eq(statistics.unusedInteractions, 0);
+
+    closeCassette();
+    resetChunkResponse();
+    remove(cassettePath);
+}
+END_TEST
+
+START_TEST(test_replayTransientFailures) {
+    char cassettePath[] = "/tmp/ERTbot_cassetteXXXXXX";
+    int descriptor = mkstemp(cassettePath);
+    ck_assert_int_ge(descriptor, 0);
+    close(descriptor);
+
+    createFile(cassettePath, "ERTBOT_CASSETTE 1\n"
+                             "sheet.get GET 503 1500 0000000000000001 11\nunavailable\n"
+                             "sheet.get GET 200 1500 0000000000000002 2\nok\n"
+                             "wiki.createPage POST 503 1500 0000000000000003 11\nunavailable\n"
+                             "wiki.createPage POST 200 1500 0000000000000004 7\ncreated\n");
+
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+    beginHttpRequestBudget();
+
+    // A query is sent again
+    long httpCode = -1;
+    ck_assert_int_eq(getFile("file:///tmp/ERTbot_unavailable.json", &httpCode), CURLE_OK);
+    ck_assert_int_eq(httpCode, 200);
+    ck_assert_str_eq(chunk.response, "ok");
+    ck_assert_int_eq(getRemainingHttpRetries(), HTTP_RETRY_BUDGET_PER_COMMAND - 1);
+
+    // A creation is not, the wiki may have created the page before failing
+    httpRequest request = {.endpoint = NETWORK_ENDPOINT_WIKI_CREATE_PAGE, .method = "POST", .url = "https://wiki/graphql", .body = "create"};
+    performHttpRequests(&request, 1, 1);
+    ck_assert_int_eq(request.result, CURLE_OK);
+    ck_assert_int_eq(request.httpCode, 503);
+    ck_assert_str_eq(request.response.response, "unavailable");
+    free(request.response.response);
+
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+    ck_assert_uint_eq(statistics.replayedRequests, 3);
+    ck_assert_uint_eq(statistics.unusedInteractions, 1);
+
+    endHttpRequestBudget();
+    closeCassette();
+    resetChunkResponse();
+    remove(cassettePath);
+}
+END_TEST
+
+START_TEST(test_tryPerformHttpRequest_doesNotWaitForRateLimit) {
+    createFile("/tmp/ERTbot_status.json", "status");
+    setRateLimit(RATE_LIMIT_TIER_SHEETS_READ, 0.001, 1);
+
+    CURL *curl = curl_easy_init();
+    ck_assert_ptr_nonnull(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, "file:///tmp/ERTbot_status.json");
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+
+    long httpCode = -1;
+    resetChunkResponse();
+    ck_assert_int_eq(tryPerformHttpRequest(curl, NETWORK_ENDPOINT_SHEET_GET, "GET", "file:///tmp/ERTbot_status.json", NULL, &httpCode), CURLE_OK);
+    ck_assert_str_eq(chunk.response, "status");
+
+    // The only token was taken, the request is not sent instead of waiting about 1000 s for the next one
+    resetChunkResponse();
+    ck_assert_int_eq(tryPerformHttpRequest(curl, NETWORK_ENDPOINT_SHEET_GET, "GET", "file:///tmp/ERTbot_status.json", NULL, &httpCode), CURLE_AGAIN);
+    ck_assert_int_eq(httpCode, 0);
+    ck_assert_uint_eq(chunk.size, 0);
+
+    curl_easy_cleanup(curl);
+    resetRateLimits();
+    resetChunkResponse();
+    remove("/tmp/ERTbot_status.json");
+}
+END_TEST
+
+// Test suite setup
+Suite *httpTransport_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("httpTransport");
+
+    // Core test case
+    tc_core = tcase_create("httpTransport");
+
+    tcase_add_test(tc_core, test_replayRecordedResponse);
+    tcase_add_test(tc_core, test_replayMismatchedRequest);
+    tcase_add_test(tc_core, test_replayConcurrentRequests);
+    tcase_add_test(tc_core, test_replayRateLimitedRequest);
+    tcase_add_test(tc_core, test_replayTransientFailures);
+    tcase_add_test(tc_core, test_tryPerformHttpRequest_doesNotWaitForRateLimit);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -0,0 +1,59 @@
+#include <check.h>
+#include "ERTbot_common.h"
+#include "networkTelemetry.h"
+
+START_TEST(test_classifyWikiQuery) {
+    ck_assert_int_eq(classifyWikiQuery("{\"query\":\"{pages {single(id: 12){id, path, title, content}}}\"}"), NETWORK_ENDPOINT_WIKI_GET_PAGE);
+    ck_assert_int_eq(classifyWikiQuery("{\"query\":\"{pages {list(orderBy: PATH){path, title, id, updatedAt}}}\"}"), NETWORK_ENDPOINT_WIKI_LIST_PAGES);
+    ck_assert_int_eq(classifyWikiQuery("{\"query\":\"mutation { pages { render(id: 12) { responseResult { succeeded } } } }\"}"), NETWORK_ENDPOINT_WIKI_RENDER_PAGE);
+
+    // The page content must not change the classification
+    ck_assert_int_eq(classifyWikiQuery("{\"query\":\"mutation { pages { update(id: 12, content: \\\"delete(everything) render(\\\") } }\"}"), NETWORK_ENDPOINT_WIKI_UPDATE_PAGE);
+
+    ck_assert_int_eq(classifySlackUrl("https://slack.com/api/chat.update"), NETWORK_ENDPOINT_SLACK_UPDATE);
+    ck_assert_int_eq(classifySlackUrl("https://slack.com/api/chat.postMessage"), NETWORK_ENDPOINT_SLACK_POST);
+}
+END_TEST
+
+START_TEST(test_getNetworkPercentile) {
+    long long fastRequest[NUMBER_OF_NETWORK_METRICS] = {10, 20, 30, 400, 1000, 200, 5000};
+    long long slowRequest[NUMBER_OF_NETWORK_METRICS] = {10, 20, 30, 99000, 100000, 200, 5000};
+
+    ck_assert_int_eq(getNetworkPercentile(NETWORK_ENDPOINT_WIKI_OTHER, NETWORK_METRIC_TOTAL, 50), 0);
+
+    for(int i = 0; i < 90; i++){
+        recordNetworkSample(NETWORK_ENDPOINT_WIKI_OTHER, fastRequest);
+    }
+    for(int i = 0; i < 10; i++){
+        recordNetworkSample(NETWORK_ENDPOINT_WIKI_OTHER, slowRequest);
+    }
+
+    ck_assert_uint_eq(getNetworkRequestCount(NETWORK_ENDPOINT_WIKI_OTHER), 100);
+
+    // 1000 us falls in the [512, 1024) bucket, percentiles are reported as the bucket's upper bound
+    ck_assert_int_eq(getNetworkPercentile(NETWORK_ENDPOINT_WIKI_OTHER, NETWORK_METRIC_TOTAL, 50), 1024);
+    ck_assert_int_eq(getNetworkPercentile(NETWORK_ENDPOINT_WIKI_OTHER, NETWORK_METRIC_TOTAL, 90), 1024);
+
+    // Never above the largest value seen
+    ck_assert_int_eq(getNetworkPercentile(NETWORK_ENDPOINT_WIKI_OTHER, NETWORK_METRIC_TOTAL, 99), 100000);
+
+    dumpNetworkTelemetry();
+}
+END_TEST
+
+// Test suite setup
+Suite *networkTelemetry_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("networkTelemetry");
+
+    // Core test case
+    tc_core = tcase_create("networkTelemetry");
+
+    tcase_add_test(tc_core, test_classifyWikiQuery);
+    tcase_add_test(tc_core, test_getNetworkPercentile);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -0,0 +1,88 @@
+#include <check.h>
+#include "ERTbot_common.h"
+#include "rateLimiter.h"
+
+START_TEST(test_tryAcquireRateLimitToken_allowsBurstThenRate) {
+    setRateLimit(RATE_LIMIT_TIER_SLACK_UPDATE, 10, 2);
+
+    ck_assert_int_eq(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SLACK_UPDATE), 0);
+    ck_assert_int_eq(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SLACK_UPDATE), 0);
+
+    // The bucket is empty, the next token comes in at most 100 ms
+    long long waitMicroseconds = tryAcquireRateLimitToken(NETWORK_ENDPOINT_SLACK_UPDATE);
+    ck_assert_int_gt(waitMicroseconds, 0);
+    ck_assert_int_le(waitMicroseconds, 100001);
+
+    // Other tiers have their own bucket
+    setRateLimit(RATE_LIMIT_TIER_WIKI, 10, 1);
+    ck_assert_int_eq(tryAcquireRateLimitToken(NETWORK_ENDPOINT_WIKI_MUTATION_BATCH), 0);
+    ck_assert_int_gt(tryAcquireRateLimitToken(NETWORK_ENDPOINT_WIKI_GET_PAGE), 0);
+
+    waitForRateLimitToken(NETWORK_ENDPOINT_SLACK_UPDATE);
+
+    // A rate of 0 disables the limit
+    setRateLimit(RATE_LIMIT_TIER_WIKI, 0, 1);
+    for(int i = 0; i < 100; i++){
+        ck_assert_int_eq(tryAcquireRateLimitToken(NETWORK_ENDPOINT_WIKI_GET_PAGE), 0);
+    }
+
+    resetRateLimits();
+}
+END_TEST
+
+START_TEST(test_reportRateLimitedResponse_pausesTier) {
+    setRateLimit(RATE_LIMIT_TIER_SHEETS_READ, 0, 1);
+    setRateLimit(RATE_LIMIT_TIER_SHEETS_WRITE, 0, 1);
+
+    reportRateLimitedResponse(NETWORK_ENDPOINT_SHEET_GET, 2);
+
+    long long waitMicroseconds = tryAcquireRateLimitToken(NETWORK_ENDPOINT_SHEET_GET);
+    ck_assert_int_gt(waitMicroseconds, 1900000);
+    ck_assert_int_le(waitMicroseconds, 2000001);
+    ck_assert_int_eq(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SHEET_UPDATE), 0);
+
+    // Setting the rate again does not lift the pause the API asked for
+    setRateLimit(RATE_LIMIT_TIER_SHEETS_READ, 100, 100);
+    ck_assert_int_gt(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SHEET_GET), 1000000);
+
+    resetRateLimits();
+    ck_assert_int_eq(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SHEET_GET), 0);
+}
+END_TEST
+
+START_TEST(test_setRateLimits_parsesSettings) {
+    ck_assert_int_eq(setRateLimits("slack_post=10/1,slack_history=0.5/3"), 0);
+    ck_assert_int_eq(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SLACK_POST), 0);
+    ck_assert_int_gt(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SLACK_POST), 0);
+
+    for(int i = 0; i < 3; i++){
+        ck_assert_int_eq(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SLACK_HISTORY), 0);
+    }
+    ck_assert_int_gt(tryAcquireRateLimitToken(NETWORK_ENDPOINT_SLACK_HISTORY), 1000000);
+
+    ck_assert_int_eq(setRateLimits("unknown=1/1"), 1);
+    ck_assert_int_eq(setRateLimits("wiki=fast"), 1);
+
+    ck_assert_str_eq(getRateLimitTierName(getRateLimitTier(NETWORK_ENDPOINT_SHEET_OAUTH)), "google_oauth");
+
+    resetRateLimits();
+}
+END_TEST
+
+// Test suite setup
+Suite *rateLimiter_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("rateLimiter");
+
+    // Core test case
+    tc_core = tcase_create("rateLimiter");
+
+    tcase_add_test(tc_core, test_tryAcquireRateLimitToken_allowsBurstThenRate);
+    tcase_add_test(tc_core, test_reportRateLimitedResponse_pausesTier);
+    tcase_add_test(tc_core, test_setRateLimits_parsesSettings);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
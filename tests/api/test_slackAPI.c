@@ -0,0 +1,69 @@
+#include <check.h>
+#include <stdlib.h>
+#include "ERTbot_common.h"
+#include "slackAPI.h"
+
+#define SLACK_HISTORY_RESPONSE "{\"ok\":true,\"messages\":[" \
+    "{\"type\":\"message\",\"user\":\"U01\",\"text\":\"updateReq 2024_C_SE_ST_REQ_01\",\"ts\":\"1712345680.000300\"}," \
+    "{\"type\":\"message\",\"bot_id\":\"B01\",\"user\":\"U06RQCAT0H1\",\"text\":\"Starting sync\",\"ts\":\"1712345679.000200\"}," \
+    "{\"type\":\"message\",\"subtype\":\"channel_join\",\"user\":\"U02\",\"text\":\"joined\",\"ts\":\"1712345678.000150\"}," \
+    "{\"type\":\"message\",\"user\":\"U02\",\"text\":\"sync ST\",\"ts\":\"1712345678.000100\"}]," \
+    "\"has_more\":true,\"response_metadata\":{\"next_cursor\":\"bmV4dA==\"}}"
+
+START_TEST(test_parseSlackHistory) {
+    char* newestTimestamp = NULL;
+    char* nextPageCursor = NULL;
+
+    slackMessage* messages = parseSlackHistory(SLACK_HISTORY_RESPONSE, &newestTimestamp, &nextPageCursor);
+
+    // Oldest first, bot messages and channel events left out
+    ck_assert_ptr_nonnull(messages);
+    ck_assert_str_eq(messages->message, "sync ST");
+    ck_assert_str_eq(messages->sender, "U02");
+    ck_assert_ptr_nonnull(messages->next);
+    ck_assert_str_eq(messages->next->message, "updateReq 2024_C_SE_ST_REQ_01");
+    ck_assert_ptr_null(messages->next->next);
+
+    ck_assert_str_eq(newestTimestamp, "1712345680.000300");
+    ck_assert_str_eq(nextPageCursor, "bmV4dA==");
+
+    freeSlackMessageList(&messages);
+    ck_assert_ptr_null(messages);
+    free(newestTimestamp);
+    free(nextPageCursor);
+}
+END_TEST
+
+START_TEST(test_parseSlackHistory_error) {
+    char* newestTimestamp = NULL;
+
+    ck_assert_ptr_null(parseSlackHistory("{\"ok\":false,\"error\":\"ratelimited\"}", &newestTimestamp, NULL));
+    ck_assert_ptr_null(parseSlackHistory("not json", &newestTimestamp, NULL));
+    ck_assert_ptr_null(newestTimestamp);
+}
+END_TEST
+
+START_TEST(test_compareSlackTimestamps) {
+    ck_assert_int_eq(compareSlackTimestamps("1712345678.000100", "1712345678.000100"), 0);
+    ck_assert_int_eq(compareSlackTimestamps("1712345678.000100", "1712345678.000200"), -1);
+    ck_assert_int_eq(compareSlackTimestamps("1712345679.000000", "1712345678.999999"), 1);
+}
+END_TEST
+
+// Test suite setup
+Suite *slackAPI_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("slackAPI");
+
+    // Core test case
+    tc_core = tcase_create("slackHistory");
+
+    tcase_add_test(tc_core, test_parseSlackHistory);
+    tcase_add_test(tc_core, test_parseSlackHistory_error);
+    tcase_add_test(tc_core, test_compareSlackTimestamps);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -72,11 +72,40 @@ START_TEST(test_fetchAndModifyPageContent) {
 }
 END_TEST
 
+START_TEST(test_parsePagesResponse) {
+    pageList* pages = NULL;
+    pages = addPageToList(&pages, "12", NULL, NULL, NULL, NULL, NULL);
+    pages = addPageToList(&pages, "13", NULL, NULL, NULL, NULL, NULL);
+    pages = addPageToList(&pages, "14", NULL, NULL, NULL, NULL, NULL);
+
+    char response[] = "{\"data\":{\"pages\":{"
+                      "\"page0\":{\"id\":12,\"path\":\"req/A\",\"title\":\"A\",\"content\":\"first \\\"page1\\\":\",\"description\":\"\",\"updatedAt\":\"2024-01-01\",\"createdAt\":\"2023-01-01\",\"authorId\":1},"
+                      "\"page1\":null,"
+                      "\"page2\":{\"id\":14,\"path\":\"req/C\",\"title\":\"C\",\"content\":\"third\",\"description\":\"\",\"updatedAt\":\"2024-01-03\",\"createdAt\":\"2023-01-03\",\"authorId\":2}}}}";
+
+    parsePagesResponse(pages, 3, response);
+
+    ck_assert_str_eq(pages->path, "req/A");
+    ck_assert_str_eq(pages->content, "first \\\"page1\\\":");
+    ck_assert_str_eq(pages->updatedAt, "2024-01-01");
+
+    // A page the wiki did not return is left empty
+    ck_assert_ptr_null(pages->next->content);
+
+    ck_assert_str_eq(pages->next->next->title, "C");
+    ck_assert_str_eq(pages->next->next->content, "third");
+    ck_assert_str_eq(pages->next->next->authorId, "2");
+
+    freePageList(&pages);
+}
+END_TEST
+
 // Test suite setup
 Suite *wikiAPI_suite(void) {
     Suite *s;
     TCase *tc_core1;
     TCase *tc_core2;
+    TCase *tc_core3;
 
     s = suite_create("wikiAPI");
 
@@ -91,5 +120,9 @@ Suite *wikiAPI_suite(void) {
     tcase_add_test(tc_core2, test_fetchAndModifyPageContent);
     suite_add_tcase(s, tc_core2);
 
+    tc_core3 = tcase_create("parsePagesResponse");
+    tcase_add_test(tc_core3, test_parsePagesResponse);
+    suite_add_tcase(s, tc_core3);
+
     return s;
 }
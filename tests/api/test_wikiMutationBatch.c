@@ -0,0 +1,250 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "apiHelpers.h"
+#include "pageListHelpers.h"
+#include "httpTransport.h"
+#include "wikiMutationBatch.h"
+#include "requirementSnapshotHelpers.h"
+
+static void createCassette(char *path, const char *response){
+    int descriptor = mkstemp(path);
+    ck_assert_int_ge(descriptor, 0);
+
+    FILE *file = fdopen(descriptor, "w");
+    ck_assert_ptr_nonnull(file);
+    fprintf(file, "ERTBOT_CASSETTE 1\nwiki.mutationBatch POST 200 0 0000000000000000 %zu\n%s\n", strlen(response), response);
+    fclose(file);
+}
+
+START_TEST(test_flushWikiMutations) {
+    char cassettePath[] = "/tmp/ERTbot_mutationsXXXXXX";
+    createCassette(cassettePath, "{\"data\":{"
+                                 "\"m0\":{\"update\":{\"responseResult\":{\"succeeded\":true,\"message\":\"Page has been updated.\"}}},"
+                                 "\"m1\":{\"create\":{\"responseResult\":{\"succeeded\":false,\"message\":\"Cannot create this page because an entity already exists at the same path.\"}}},"
+                                 "\"m2\":{\"delete\":{\"responseResult\":{\"succeeded\":true,\"message\":\"Page has been deleted.\"}}}}}");
+
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+
+    // Nothing is sent until the batch is flushed
+    ck_assert_int_eq(flushWikiMutations(), 0);
+
+    pageList* page = NULL;
+    page = addPageToList(&page, "12", NULL, NULL, NULL, "new content", NULL);
+
+    queuePageUpdate(page, NULL, NULL, NULL);
+    queuePageCreation("req/ST/2024_C_SE_ST_REQ_01", "<!--2024_C_SE_ST_REQ_01-->", "2024_C_SE_ST_REQ_01");
+    queuePageDeletion("13");
+
+    // Only the creation failed
+    ck_assert_int_eq(flushWikiMutations(), 1);
+
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+    ck_assert_uint_eq(statistics.replayedRequests, 1);
+    ck_assert_uint_eq(statistics.unusedInteractions, 0);
+
+    // The batch is empty again
+    ck_assert_int_eq(flushWikiMutations(), 0);
+
+    freePageList(&page);
+    closeCassette();
+    remove(cassettePath);
+}
+END_TEST
+
+/**
+ * @brief Builds the response of a batch of `numberOfMutations` deletions, `failedMutation` being the only one which
+ *        failed (-1 for none).
+ */
+static char* buildDeletionResponse(int numberOfMutations, int failedMutation){
+    char* response = (char*)malloc((size_t)numberOfMutations * 96 + 32);
+    ck_assert_ptr_nonnull(response);
+
+    size_t length = (size_t)sprintf(response, "{\"data\":{");
+    for(int i = 0; i < numberOfMutations; i++){
+        length += (size_t)sprintf(response + length, "%s\"m%d\":{\"delete\":{\"responseResult\":{\"succeeded\":%s}}}",
+                                  i == 0 ? "" : ",", i, i == failedMutation ? "false" : "true");
+    }
+    sprintf(response + length, "}}");
+
+    return response;
+}
+
+static void addCassetteRecord(FILE *file, int numberOfMutations, int failedMutation){
+    char* response = buildDeletionResponse(numberOfMutations, failedMutation);
+    fprintf(file, "wiki.mutationBatch POST 200 0 0000000000000000 %zu\n%s\n", strlen(response), response);
+    free(response);
+}
+
+static unsigned long getReplayedRequests(){
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+
+    return statistics.replayedRequests;
+}
+
+START_TEST(test_flushWikiMutations_fullBatches) {
+    char cassettePath[] = "/tmp/ERTbot_mutationsXXXXXX";
+    int descriptor = mkstemp(cassettePath);
+    ck_assert_int_ge(descriptor, 0);
+
+    FILE *file = fdopen(descriptor, "w");
+    ck_assert_ptr_nonnull(file);
+    fprintf(file, "ERTBOT_CASSETTE 1\n");
+    addCassetteRecord(file, WIKI_MUTATION_BATCH_MAX_MUTATIONS, 3);
+    addCassetteRecord(file, 1, -1);
+    addCassetteRecord(file, WIKI_MUTATION_BATCH_MAX_MUTATIONS, -1);
+    addCassetteRecord(file, 10, -1);
+    fclose(file);
+
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+
+    // A full batch is sealed, not sent
+    char id[16];
+    for(int i = 0; i < WIKI_MUTATION_BATCH_MAX_MUTATIONS; i++){
+        snprintf(id, sizeof(id), "%d", i);
+        queuePageDeletion(id);
+    }
+    ck_assert_uint_eq(getReplayedRequests(), 0);
+
+    // A page of the sealed batch is mutated again, the batch is sent first
+    queuePageDeletion("0");
+    ck_assert_uint_eq(getReplayedRequests(), 1);
+
+    // The failure of the batch sent on its own is reported by the next flush
+    ck_assert_int_eq(flushWikiMutations(), 1);
+    ck_assert_uint_eq(getReplayedRequests(), 2);
+
+    // Pages of no sealed batch do not wait, both batches are sent by the flush
+    for(int i = 0; i < WIKI_MUTATION_BATCH_MAX_MUTATIONS + 10; i++){
+        snprintf(id, sizeof(id), "%d", 100 + i);
+        queuePageDeletion(id);
+    }
+    ck_assert_uint_eq(getReplayedRequests(), 2);
+    ck_assert_int_eq(flushWikiMutations(), 0);
+    ck_assert_uint_eq(getReplayedRequests(), 4);
+
+    cassetteStatistics statistics;
+    getCassetteStatistics(&statistics);
+    ck_assert_uint_eq(statistics.unusedInteractions, 0);
+
+    closeCassette();
+    remove(cassettePath);
+}
+END_TEST
+
+START_TEST(test_countSkippedWikiMutation) {
+    // A page which could not be fetched is reported by the next flush, without anything being sent
+    countSkippedWikiMutation(NULL, NULL);
+    ck_assert_int_eq(flushWikiMutations(), 1);
+    ck_assert_int_eq(flushWikiMutations(), 0);
+}
+END_TEST
+
+START_TEST(test_flushWikiMutations_forgetsFailedUpdates) {
+    char cassettePath[] = "/tmp/ERTbot_mutationsXXXXXX";
+    createCassette(cassettePath, "{\"data\":{"
+                                 "\"m0\":{\"update\":{\"responseResult\":{\"succeeded\":true}}},"
+                                 "\"m1\":{\"update\":{\"responseResult\":{\"succeeded\":false,\"message\":\"This page does not exist.\"}}}}}");
+
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+
+    char directory[] = "/tmp/ERTbot_snapshotsXXXXXX";
+    ck_assert_ptr_nonnull(mkdtemp(directory));
+    setRequirementSnapshotDirectory(directory);
+
+    requirementSnapshot* snapshot = loadRequirementSnapshot("ST", "req");
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_01", 1));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_02", 2));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_03", 3));
+
+    pageList* pages = NULL;
+    addPageToList(&pages, "12", NULL, NULL, NULL, "first content", NULL);
+    addPageToList(&pages, "13", NULL, NULL, NULL, "second content", NULL);
+
+    // The update of the second page fails and the page of the third requirement could not be fetched
+    queuePageUpdate(pages, NULL, snapshot, "2024_C_SE_ST_REQ_01");
+    queuePageUpdate(pages->next, NULL, snapshot, "2024_C_SE_ST_REQ_02");
+    countSkippedWikiMutation(snapshot, "2024_C_SE_ST_REQ_03");
+    ck_assert_int_eq(flushWikiMutations(), 2);
+    ck_assert_int_eq(countForgottenRequirements(snapshot), 2);
+    ck_assert_int_eq(saveRequirementSnapshot(snapshot), 0);
+    freeRequirementSnapshot(snapshot);
+
+    // Only the requirements whose page was not updated are retried by the next run
+    snapshot = loadRequirementSnapshot("ST", "req");
+    ck_assert(!isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_01", 1));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_02", 2));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_03", 3));
+    freeRequirementSnapshot(snapshot);
+
+    ck_assert_int_eq(resetRequirementSnapshots("ST"), 1);
+    setRequirementSnapshotDirectory(NULL);
+    rmdir(directory);
+
+    freePageList(&pages);
+    closeCassette();
+    remove(cassettePath);
+}
+END_TEST
+
+START_TEST(test_suspendWikiMutations) {
+    char cassettePath[] = "/tmp/ERTbot_mutationsXXXXXX";
+    int descriptor = mkstemp(cassettePath);
+    ck_assert_int_ge(descriptor, 0);
+
+    FILE *file = fdopen(descriptor, "w");
+    ck_assert_ptr_nonnull(file);
+    fprintf(file, "ERTBOT_CASSETTE 1\n");
+    addCassetteRecord(file, 1, 0);
+    addCassetteRecord(file, 1, -1);
+    fclose(file);
+
+    ck_assert_int_eq(openCassette(CASSETTE_MODE_REPLAY, cassettePath, false), 0);
+
+    // The command being interrupted has a mutation queued and a failure not reported yet
+    queuePageDeletion("1");
+    countSkippedWikiMutation(NULL, NULL);
+
+    // The nested command only sends and reports its own mutation, which fails
+    suspendWikiMutations();
+    queuePageDeletion("2");
+    ck_assert_int_eq(flushPageRenders(), 1);
+    ck_assert_uint_eq(getReplayedRequests(), 1);
+    resumeWikiMutations();
+
+    // The interrupted command still reports its failure once its mutation is sent
+    ck_assert_uint_eq(getReplayedRequests(), 1);
+    ck_assert_int_eq(flushWikiMutations(), 1);
+    ck_assert_uint_eq(getReplayedRequests(), 2);
+    ck_assert_int_eq(flushWikiMutations(), 0);
+
+    closeCassette();
+    remove(cassettePath);
+}
+END_TEST
+
+// Test suite setup
+Suite *wikiMutationBatch_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("wikiMutationBatch");
+
+    // Core test case
+    tc_core = tcase_create("wikiMutationBatch");
+
+    tcase_add_test(tc_core, test_flushWikiMutations);
+    tcase_add_test(tc_core, test_flushWikiMutations_fullBatches);
+    tcase_add_test(tc_core, test_countSkippedWikiMutation);
+    tcase_add_test(tc_core, test_flushWikiMutations_forgetsFailedUpdates);
+    tcase_add_test(tc_core, test_suspendWikiMutations);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
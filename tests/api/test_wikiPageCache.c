@@ -0,0 +1,106 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ERTbot_common.h"
+#include "pageListHelpers.h"
+#include "stringHelpers.h"
+#include "wikiPageCache.h"
+
+START_TEST(test_readCachedPageContent) {
+    char cachePath[] = "/tmp/ERTbot_pageCacheXXXXXX";
+    int descriptor = mkstemp(cachePath);
+    ck_assert_int_ge(descriptor, 0);
+    close(descriptor);
+
+    ck_assert_int_eq(openPageCache(cachePath), 0);
+
+    pageList* page = NULL;
+    page = addPageToList(&page, "12", "2024_C_SE_ST_REQ_01", NULL, NULL, "<!--2024_C_SE_ST_REQ_01-->\\nfirst", "2024-01-01T10:00:00.000Z");
+    storePageContent(page);
+
+    page->content = replaceWord_Realloc(page->content, "first", "second");
+    free(page->updatedAt);
+    page->updatedAt = duplicate_Malloc("2024-01-02T10:00:00.000Z");
+    storePageContent(page);
+    closePageCache();
+
+    // The last version stored is the one read back, and only while the page was not updated since
+    ck_assert_int_eq(openPageCache(cachePath), 0);
+    free(page->content);
+    page->content = NULL;
+    ck_assert(readCachedPageContent(page));
+    ck_assert_str_eq(page->content, "<!--2024_C_SE_ST_REQ_01-->\\nsecond");
+
+    free(page->updatedAt);
+    page->updatedAt = duplicate_Malloc("2024-01-03T10:00:00.000Z");
+    ck_assert(!readCachedPageContent(page));
+
+    pageCacheStatistics statistics;
+    getPageCacheStatistics(&statistics);
+    ck_assert_uint_eq(statistics.hits, 1);
+    ck_assert_uint_eq(statistics.misses, 1);
+    ck_assert_uint_eq(statistics.cachedPages, 1);
+
+    freePageList(&page);
+    closePageCache();
+    remove(cachePath);
+}
+END_TEST
+
+START_TEST(test_openPageCache_dropsTruncatedRecord) {
+    char cachePath[] = "/tmp/ERTbot_pageCacheXXXXXX";
+    int descriptor = mkstemp(cachePath);
+    ck_assert_int_ge(descriptor, 0);
+
+    const char* content = "ERTBOT_PAGE_CACHE 1\n"
+                          "12 2024-01-01T10:00:00.000Z 5\nfirst\n"
+                          "13 2024-01-01T10:00:00.000Z 6\nsec";
+    ck_assert_int_eq(write(descriptor, content, strlen(content)), (ssize_t)strlen(content));
+    close(descriptor);
+
+    ck_assert_int_eq(openPageCache(cachePath), 0);
+
+    pageList* page = NULL;
+    page = addPageToList(&page, "13", NULL, NULL, NULL, NULL, "2024-01-01T10:00:00.000Z");
+    ck_assert(!readCachedPageContent(page));
+
+    // The page is appended after the last complete record
+    free(page->content);
+    page->content = duplicate_Malloc("second");
+    storePageContent(page);
+    closePageCache();
+
+    ck_assert_int_eq(openPageCache(cachePath), 0);
+    free(page->content);
+    page->content = NULL;
+    ck_assert(readCachedPageContent(page));
+    ck_assert_str_eq(page->content, "second");
+
+    pageCacheStatistics statistics;
+    getPageCacheStatistics(&statistics);
+    ck_assert_uint_eq(statistics.cachedPages, 2);
+
+    freePageList(&page);
+    closePageCache();
+    remove(cachePath);
+}
+END_TEST
+
+// Test suite setup
+Suite *wikiPageCache_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("wikiPageCache");
+
+    // Core test case
+    tc_core = tcase_create("wikiPageCache");
+
+    tcase_add_test(tc_core, test_readCachedPageContent);
+    tcase_add_test(tc_core, test_openPageCache_dropsTruncatedRecord);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
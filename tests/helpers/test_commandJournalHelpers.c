@@ -0,0 +1,178 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ERTbot_common.h"
+#include "commandQueueHelpers.h"
+#include "commandJournalHelpers.h"
+
+/**
+ * @brief Dequeues the next command, checks it is the expected one and journals that it ran.
+ */
+static void runNextCommand(commandQueue* queue, const char *function, const char *argument){
+    command cmd;
+    ck_assert(dequeueCommand(queue, &cmd));
+    journalStartedCommand(&cmd);
+    journalFinishedCommand(&cmd);
+    ck_assert_str_eq(cmd.function, function);
+    if(argument){
+        ck_assert_str_eq(cmd.argument, argument);
+    }
+    else{
+        ck_assert_ptr_null(cmd.argument);
+    }
+    freeCommand(&cmd);
+}
+
+START_TEST(test_openCommandJournal_resumesInterruptedCommand) {
+    char journalPath[] = "/tmp/ERTbot_commandJournalXXXXXX";
+    int descriptor = mkstemp(journalPath);
+    ck_assert_int_ge(descriptor, 0);
+    close(descriptor);
+
+    commandQueue* queue = createCommandQueue();
+    ck_assert_int_eq(openCommandJournal(journalPath, queue), 0);
+    ck_assert(queue->isJournaled);
+
+    ck_assert_int_eq(enqueueCommand(queue, "sync", "all", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "updateDRL", "PR", COMMAND_PRIORITY_BACKGROUND), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "sync", "all", COMMAND_PRIORITY_SCHEDULED), 0);
+
+    command running;
+    ck_assert(dequeueCommand(queue, &running));
+    journalStartedCommand(&running);
+
+    char* checkpoint = buildCheckpointKey("req", "2024_C_SE_ST_REQ_01", 42);
+    ck_assert_str_eq(checkpoint, "req 2024_C_SE_ST_REQ_01 000000000000002a");
+    journalCheckpoint(checkpoint);
+
+    // The bot stops in the middle of the sync, the journal is left as it is
+    closeCommandJournal();
+    ck_assert(!queue->isJournaled);
+    freeCommand(&running);
+    freeCommandQueue(&queue);
+
+    queue = createCommandQueue();
+    ck_assert_int_eq(openCommandJournal(journalPath, queue), 2);
+    ck_assert(isCommandCheckpointed(checkpoint));
+
+    command resumed;
+    ck_assert(dequeueCommand(queue, &resumed));
+    ck_assert_str_eq(resumed.function, "sync");
+    ck_assert_str_eq(resumed.argument, "all");
+    ck_assert(queue->lanes[COMMAND_PRIORITY_BACKGROUND].size == 1);
+
+    // The checkpoints are kept until the resumed command finished
+    journalStartedCommand(&resumed);
+    ck_assert(isCommandCheckpointed(checkpoint));
+    journalFinishedCommand(&resumed);
+    ck_assert(!isCommandCheckpointed(checkpoint));
+    freeCommand(&resumed);
+
+    closeCommandJournal();
+    freeCommandQueue(&queue);
+
+    // Only the command which never ran is left
+    queue = createCommandQueue();
+    ck_assert_int_eq(openCommandJournal(journalPath, queue), 1);
+    runNextCommand(queue, "updateDRL", "PR");
+    ck_assert(isCommandQueueEmpty(queue));
+
+    closeCommandJournal();
+    freeCommandQueue(&queue);
+    free(checkpoint);
+    remove(journalPath);
+}
+END_TEST
+
+START_TEST(test_openCommandJournal_ignoresTornRecord) {
+    char journalPath[] = "/tmp/ERTbot_commandJournalXXXXXX";
+    int descriptor = mkstemp(journalPath);
+    ck_assert_int_ge(descriptor, 0);
+
+    // The bot stopped while writing the last record
+    const char *journal = "ERTBOT_JOURNAL 1\n"
+                          "Q 1 updateReq 2024_C_SE_ST_REQ_01\n"
+                          "Q 0 help -\n"
+                          "S help -\n"
+                          "D help -\n"
+                          "Q 2 updateV";
+    ck_assert_int_eq(write(descriptor, journal, strlen(journal)), (ssize_t)strlen(journal));
+    close(descriptor);
+
+    commandQueue* queue = createCommandQueue();
+    ck_assert_int_eq(openCommandJournal(journalPath, queue), 1);
+    runNextCommand(queue, "updateReq", "2024_C_SE_ST_REQ_01");
+    ck_assert(isCommandQueueEmpty(queue));
+
+    // A command interrupted again after it was resumed is dropped
+    ck_assert_int_eq(enqueueCommand(queue, "updateDRL", "ST", COMMAND_PRIORITY_SCHEDULED), 1);
+    command cmd;
+    ck_assert(dequeueCommand(queue, &cmd));
+    journalStartedCommand(&cmd);
+    freeCommand(&cmd);
+    closeCommandJournal();
+    freeCommandQueue(&queue);
+
+    queue = createCommandQueue();
+    ck_assert_int_eq(openCommandJournal(journalPath, queue), 1);
+    ck_assert_ptr_nonnull(peekCommand(queue, COMMAND_PRIORITY_INTERACTIVE));
+    ck_assert(dequeueCommand(queue, &cmd));
+    journalStartedCommand(&cmd);
+    freeCommand(&cmd);
+    closeCommandJournal();
+    freeCommandQueue(&queue);
+
+    queue = createCommandQueue();
+    ck_assert_int_eq(openCommandJournal(journalPath, queue), 0);
+
+    closeCommandJournal();
+    freeCommandQueue(&queue);
+    remove(journalPath);
+}
+END_TEST
+
+START_TEST(test_openCommandJournal_doesNotResumeShutdown) {
+    char journalPath[] = "/tmp/ERTbot_commandJournalXXXXXX";
+    int descriptor = mkstemp(journalPath);
+    ck_assert_int_ge(descriptor, 0);
+
+    // shutdown exits the bot before runCommand journals that it finished
+    const char *journal = "ERTBOT_JOURNAL 1\n"
+                          "Q 2 updateDRL PR\n"
+                          "Q 0 shutdown -\n"
+                          "S shutdown -\n";
+    ck_assert_int_eq(write(descriptor, journal, strlen(journal)), (ssize_t)strlen(journal));
+    close(descriptor);
+
+    // Only the pending command is restored, the bot does not shut down again right after it started
+    commandQueue* queue = createCommandQueue();
+    ck_assert_int_eq(openCommandJournal(journalPath, queue), 1);
+    ck_assert_ptr_null(peekCommand(queue, COMMAND_PRIORITY_INTERACTIVE));
+    runNextCommand(queue, "updateDRL", "PR");
+    ck_assert(isCommandQueueEmpty(queue));
+
+    closeCommandJournal();
+    freeCommandQueue(&queue);
+    remove(journalPath);
+}
+END_TEST
+
+// Test suite setup
+Suite *commandJournalHelpers_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("commandJournalHelpers");
+
+    // Core test case
+    tc_core = tcase_create("commandJournal");
+
+    tcase_add_test(tc_core, test_openCommandJournal_resumesInterruptedCommand);
+    tcase_add_test(tc_core, test_openCommandJournal_ignoresTornRecord);
+    tcase_add_test(tc_core, test_openCommandJournal_doesNotResumeShutdown);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
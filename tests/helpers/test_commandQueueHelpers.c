@@ -0,0 +1,145 @@
+#include <check.h>
+#include <string.h>
+#include "ERTbot_common.h"
+#include "commandQueueHelpers.h"
+
+START_TEST(test_enqueueCommand_keepsFifoOrder) {
+    commandQueue* queue = createCommandQueue();
+    command cmd;
+
+    ck_assert_int_eq(enqueueCommand(queue, "updateDRL", "ST", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "updateVCD", "PR", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "help", NULL, COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(queue->size, 3);
+
+    ck_assert(dequeueCommand(queue, &cmd));
+    ck_assert_str_eq(cmd.function, "updateDRL");
+    ck_assert_str_eq(cmd.argument, "ST");
+    freeCommand(&cmd);
+
+    ck_assert(dequeueCommand(queue, &cmd));
+    ck_assert_str_eq(cmd.function, "updateVCD");
+    ck_assert_str_eq(cmd.argument, "PR");
+    freeCommand(&cmd);
+
+    ck_assert(dequeueCommand(queue, &cmd));
+    ck_assert_str_eq(cmd.function, "help");
+    ck_assert_ptr_null(cmd.argument);
+    freeCommand(&cmd);
+
+    ck_assert(isCommandQueueEmpty(queue));
+    ck_assert(!dequeueCommand(queue, &cmd));
+
+    freeCommandQueue(&queue);
+    ck_assert_ptr_null(queue);
+}
+END_TEST
+
+START_TEST(test_enqueueCommand_mergesDuplicates) {
+    commandQueue* queue = createCommandQueue();
+    command cmd;
+
+    ck_assert_int_eq(enqueueCommand(queue, "onPageUpdate", "1995", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "updateDRL", "ST", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "onPageUpdate", "1995", COMMAND_PRIORITY_SCHEDULED), 0);
+    ck_assert_int_eq(enqueueCommand(queue, "onPageUpdate", "1996", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(queue->size, 3);
+
+    ck_assert(dequeueCommand(queue, &cmd));
+    ck_assert_str_eq(cmd.argument, "1995");
+    freeCommand(&cmd);
+
+    // Once dequeued the same command can be queued again
+    ck_assert_int_eq(enqueueCommand(queue, "onPageUpdate", "1995", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(queue->size, 3);
+
+    freeCommandQueue(&queue);
+}
+END_TEST
+
+START_TEST(test_enqueueCommand_syncAbsorbsPendingCommands) {
+    commandQueue* queue = createCommandQueue();
+    command cmd;
+
+    ck_assert_int_eq(enqueueCommand(queue, "help", NULL, COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "updateReq", "ST", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "updateVCD", "PR", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "updateDRL", "ST", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "sync", "ST", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(queue->size, 3);
+
+    // Covered by the pending sync
+    ck_assert_int_eq(enqueueCommand(queue, "updateVCD", "ST", COMMAND_PRIORITY_SCHEDULED), 0);
+    ck_assert_int_eq(queue->size, 3);
+
+    ck_assert(dequeueCommand(queue, &cmd));
+    ck_assert_str_eq(cmd.function, "help");
+    freeCommand(&cmd);
+
+    // sync ST took the place of updateReq ST
+    ck_assert(dequeueCommand(queue, &cmd));
+    ck_assert_str_eq(cmd.function, "sync");
+    ck_assert_str_eq(cmd.argument, "ST");
+    freeCommand(&cmd);
+
+    ck_assert(dequeueCommand(queue, &cmd));
+    ck_assert_str_eq(cmd.function, "updateVCD");
+    ck_assert_str_eq(cmd.argument, "PR");
+    freeCommand(&cmd);
+
+    ck_assert(isCommandQueueEmpty(queue));
+
+    freeCommandQueue(&queue);
+}
+END_TEST
+
+START_TEST(test_dequeueCommand_takesHighestPriorityLaneFirst) {
+    commandQueue* queue = createCommandQueue();
+    command cmd;
+
+    ck_assert_int_eq(enqueueCommand(queue, "onPageUpdate", "1995", COMMAND_PRIORITY_BACKGROUND), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "sync", "ST", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "updateVCD", "PR", COMMAND_PRIORITY_SCHEDULED), 1);
+    ck_assert_int_eq(enqueueCommand(queue, "help", NULL, COMMAND_PRIORITY_INTERACTIVE), 1);
+
+    // Not covered by the scheduled sync, the user is waiting for it
+    ck_assert_int_eq(enqueueCommand(queue, "updateReq", "ST", COMMAND_PRIORITY_INTERACTIVE), 1);
+
+    // Duplicate of a scheduled command typed on Slack is promoted
+    ck_assert_int_eq(enqueueCommand(queue, "updateVCD", "PR", COMMAND_PRIORITY_INTERACTIVE), 0);
+    ck_assert_int_eq(queue->size, 5);
+
+    ck_assert_str_eq(peekCommand(queue, COMMAND_PRIORITY_INTERACTIVE)->function, "help");
+
+    const char *expectedOrder[] = {"help", "updateReq", "updateVCD", "sync", "onPageUpdate"};
+    for(int i = 0; i < 5; i++){
+        ck_assert(dequeueCommand(queue, &cmd));
+        ck_assert_str_eq(cmd.function, expectedOrder[i]);
+        freeCommand(&cmd);
+    }
+
+    ck_assert(isCommandQueueEmpty(queue));
+    ck_assert_ptr_null(peekCommand(queue, COMMAND_PRIORITY_INTERACTIVE));
+
+    freeCommandQueue(&queue);
+}
+END_TEST
+
+// Test suite setup
+Suite *commandQueueHelpers_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("commandQueueHelpers");
+
+    // Core test case
+    tc_core = tcase_create("commandQueue");
+
+    tcase_add_test(tc_core, test_enqueueCommand_keepsFifoOrder);
+    tcase_add_test(tc_core, test_enqueueCommand_mergesDuplicates);
+    tcase_add_test(tc_core, test_enqueueCommand_syncAbsorbsPendingCommands);
+    tcase_add_test(tc_core, test_dequeueCommand_takesHighestPriorityLaneFirst);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -24,6 +24,23 @@ START_TEST(test_getSubsystemInfo) {
 }
 END_TEST
 
+START_TEST(test_getSubsystemAcronymFromRequirementId) {
+    char* acronym = getSubsystemAcronymFromRequirementId("2024_C_SE_ST_REQ_01");
+    ck_assert_str_eq(acronym, "ST");
+    free(acronym);
+
+    acronym = getSubsystemAcronymFromRequirementId("2024_C_SE_UT_DRL_1_REQ_12");
+    ck_assert_str_eq(acronym, "UT_DRL_1");
+    free(acronym);
+
+    ck_assert_ptr_null(getSubsystemAcronymFromRequirementId("2024_C_REQ_01"));
+
+    ck_assert(isRequirementId("2024_C_SE_ST_REQ_01"));
+    ck_assert(!isRequirementId("ST"));
+    ck_assert(!isRequirementId(NULL));
+}
+END_TEST
+
 // Test suite setup
 Suite *requirementHelpers_suite(void) {
     Suite *s;
@@ -38,5 +55,9 @@ Suite *requirementHelpers_suite(void) {
     tcase_add_test(tc_core, test_getSubsystemInfo);
     suite_add_tcase(s, tc_core);
 
+    TCase *tc_requirementId = tcase_create("requirementId");
+    tcase_add_test(tc_requirementId, test_getSubsystemAcronymFromRequirementId);
+    suite_add_tcase(s, tc_requirementId);
+
     return s;
 }
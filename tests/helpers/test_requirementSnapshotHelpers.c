@@ -0,0 +1,128 @@
+#include <check.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cjson/cJSON.h>
+#include "ERTbot_common.h"
+#include "requirementSnapshotHelpers.h"
+
+static cJSON* createRequirement(const char *id, const char *title, const char *verificationStatus){
+    cJSON* requirement = cJSON_CreateObject();
+    cJSON_AddStringToObject(requirement, "ID", id);
+    cJSON_AddStringToObject(requirement, "Title", title);
+    cJSON_AddStringToObject(requirement, "Verification Status 1", verificationStatus);
+    return requirement;
+}
+
+static void setColumn(cJSON* requirement, const char *column, const char *value){
+    cJSON_DeleteItemFromObject(requirement, column);
+    cJSON_AddStringToObject(requirement, column, value);
+}
+
+START_TEST(test_isRequirementChanged) {
+    char directory[] = "/tmp/ERTbot_snapshotsXXXXXX";
+    ck_assert_ptr_nonnull(mkdtemp(directory));
+    setRequirementSnapshotDirectory(directory);
+
+    cJSON* first = createRequirement("2024_C_SE_ST_REQ_01", "Mass", "uncompleted");
+    cJSON* second = createRequirement("2024_C_SE_ST_REQ_02", "Length", "uncompleted");
+    cJSON* removed = createRequirement("2024_C_SE_ST_REQ_03", "Diameter", "uncompleted");
+
+    requirementSnapshot* snapshot = loadRequirementSnapshot("ST", "req");
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_01", hashRequirementRow(first, NULL, REQUIREMENT_HASH_SEED)));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_02", hashRequirementRow(second, NULL, REQUIREMENT_HASH_SEED)));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_03", hashRequirementRow(removed, NULL, REQUIREMENT_HASH_SEED)));
+    ck_assert_int_eq(saveRequirementSnapshot(snapshot), 0);
+    freeRequirementSnapshot(snapshot);
+
+    // Only the edited row changed, and the row missing from this run is reported as removed
+    setColumn(second, "Title", "Height");
+    snapshot = loadRequirementSnapshot("ST", "req");
+    ck_assert(!isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_01", hashRequirementRow(first, NULL, REQUIREMENT_HASH_SEED)));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_02", hashRequirementRow(second, NULL, REQUIREMENT_HASH_SEED)));
+    ck_assert_int_eq(countRemovedRequirements(snapshot), 1);
+    freeRequirementSnapshot(snapshot);
+
+    // Snapshots of other features and subsystems are separate, and deleted on their own
+    snapshot = loadRequirementSnapshot("ST", "drl");
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_01", hashRequirementRow(first, NULL, REQUIREMENT_HASH_SEED)));
+    freeRequirementSnapshot(snapshot);
+
+    ck_assert_int_eq(resetRequirementSnapshots("PR"), 0);
+    ck_assert_int_eq(resetRequirementSnapshots("ST"), 1);
+
+    snapshot = loadRequirementSnapshot("ST", "req");
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_01", hashRequirementRow(first, NULL, REQUIREMENT_HASH_SEED)));
+    freeRequirementSnapshot(snapshot);
+
+    cJSON_Delete(first);
+    cJSON_Delete(second);
+    cJSON_Delete(removed);
+    setRequirementSnapshotDirectory(NULL);
+    rmdir(directory);
+}
+END_TEST
+
+START_TEST(test_forgetRequirement) {
+    char directory[] = "/tmp/ERTbot_snapshotsXXXXXX";
+    ck_assert_ptr_nonnull(mkdtemp(directory));
+    setRequirementSnapshotDirectory(directory);
+
+    requirementSnapshot* snapshot = loadRequirementSnapshot("ST", "req");
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_01", 1));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_02", 2));
+    forgetRequirement(snapshot, "2024_C_SE_ST_REQ_02");
+    forgetRequirement(snapshot, "2024_C_SE_ST_REQ_02");
+    ck_assert_int_eq(countForgottenRequirements(snapshot), 1);
+    ck_assert_int_eq(saveRequirementSnapshot(snapshot), 0);
+    freeRequirementSnapshot(snapshot);
+
+    // Only the forgotten requirement is processed again by the next run
+    snapshot = loadRequirementSnapshot("ST", "req");
+    ck_assert(!isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_01", 1));
+    ck_assert(isRequirementChanged(snapshot, "2024_C_SE_ST_REQ_02", 2));
+    ck_assert_int_eq(countForgottenRequirements(snapshot), 0);
+    freeRequirementSnapshot(snapshot);
+
+    ck_assert_int_eq(resetRequirementSnapshots("ST"), 1);
+    setRequirementSnapshotDirectory(NULL);
+    rmdir(directory);
+}
+END_TEST
+
+START_TEST(test_hashRequirementRow_columns) {
+    cJSON* requirement = createRequirement("2024_C_SE_ST_REQ_01", "Mass", "uncompleted");
+    static const char* const verificationColumns[] = {"ID", "Verification *", NULL};
+
+    unsigned long long allColumns = hashRequirementRow(requirement, NULL, REQUIREMENT_HASH_SEED);
+    unsigned long long selectedColumns = hashRequirementRow(requirement, verificationColumns, REQUIREMENT_HASH_SEED);
+
+    // A column which is not selected does not change the hash
+    setColumn(requirement, "Title", "Weight");
+    ck_assert(hashRequirementRow(requirement, NULL, REQUIREMENT_HASH_SEED) != allColumns);
+    ck_assert(hashRequirementRow(requirement, verificationColumns, REQUIREMENT_HASH_SEED) == selectedColumns);
+
+    // A column matched by a prefix does
+    setColumn(requirement, "Verification Status 1", "completed");
+    ck_assert(hashRequirementRow(requirement, verificationColumns, REQUIREMENT_HASH_SEED) != selectedColumns);
+
+    cJSON_Delete(requirement);
+}
+END_TEST
+
+// Test suite setup
+Suite *requirementSnapshotHelpers_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("requirementSnapshotHelpers");
+
+    // Core test case
+    tc_core = tcase_create("requirementSnapshotHelpers");
+
+    tcase_add_test(tc_core, test_isRequirementChanged);
+    tcase_add_test(tc_core, test_forgetRequirement);
+    tcase_add_test(tc_core, test_hashRequirementRow_columns);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
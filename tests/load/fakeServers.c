@@ -0,0 +1,1050 @@
+/**
+ * @file fakeServers.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Contains stand-ins for Wiki.js, Google Sheets and Slack which the load test runs the bot against.
+ *
+ * @details Each service listens on its own loopback port and answers one request at a time, like the real ones only
+ *          as much of each protocol is implemented as the bot uses. The wiki keeps the pages the bot creates and
+ *          updates in memory, the Req_DB sheets are generated from the subsystems added with `addFakeSubsystem`.
+ */
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <cjson/cJSON.h>
+#include "ERTbot_common.h"
+#include "ERTbot_config.h"
+#include "stringHelpers.h"
+#include "fakeServers.h"
+
+#define FAKE_WIKI_FIRST_PAGE_ID 1000
+#define FAKE_MAXIMUM_SUBSYSTEMS 16
+#define FAKE_REQUIREMENTS_PER_GROUP 50
+#define FAKE_NUMBER_OF_VERIFICATIONS 2
+#define FAKE_MAXIMUM_HEADER_LENGTH 65536
+#define FAKE_SPREADSHEET_ID "fakeSpreadsheet"
+
+typedef struct fakePage {
+    int id;
+    char *path;
+    char *title;
+    char *content;
+    char updatedAt[32];
+    bool isDeleted;
+    unsigned long renderedInPeriod; //counterPeriod of the last render, to count the pages rendered more than once
+}fakePage;
+
+typedef struct fakeSubsystem {
+    char acronym[32];
+    char directory[128];
+    int numberOfRequirements;
+    int drlPageId;
+    int vcdPageId;
+    char *reqDbValues;
+}fakeSubsystem;
+
+typedef struct fakeServer {
+    fakeService service;
+    int listener;
+    pthread_t thread;
+    bool isRunning;
+}fakeServer;
+
+typedef struct fakeResponse {
+    int status;
+    char *body;
+}fakeResponse;
+
+static fakeServersConfig serversConfig;
+static fakeServer servers[NUMBER_OF_FAKE_SERVICES];
+
+// Held while a request is handled and by every function called from the load test
+static pthread_mutex_t fakeStateMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static fakePage* pages = NULL;
+static int numberOfPages = 0;
+static int pagesCapacity = 0;
+
+static fakeSubsystem subsystems[FAKE_MAXIMUM_SUBSYSTEMS];
+static int numberOfSubsystems = 0;
+
+static fakeServerCounters counters;
+static unsigned long counterPeriod = 1; //incremented every time the counters are reset
+static unsigned long numberOfSlackMessages = 0;
+
+static void setUpdatedAt(fakePage* page){
+    // Like Wiki.js, in milliseconds, and never twice the same so that every update can be told apart
+    static long long lastUpdatedAtMs = 0;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long nowMs = (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    if(nowMs <= lastUpdatedAtMs){
+        nowMs = lastUpdatedAtMs + 1;
+    }
+    lastUpdatedAtMs = nowMs;
+
+    time_t seconds = (time_t)(nowMs / 1000);
+    struct tm tm_info;
+    gmtime_r(&seconds, &tm_info);
+    char dateTime[24];
+    strftime(dateTime, sizeof(dateTime), "%Y-%m-%dT%H:%M:%S", &tm_info);
+    snprintf(page->updatedAt, sizeof(page->updatedAt), "%s.%03lldZ", dateTime, nowMs % 1000);
+}
+
+static fakePage* addPage(const char *path, const char *title, const char *content){
+    if(numberOfPages == pagesCapacity){
+        int newCapacity = pagesCapacity ? 2 * pagesCapacity : 1024;
+        fakePage* newPages = (fakePage*)realloc(pages, (size_t)newCapacity * sizeof(fakePage));
+        if(!newPages){
+            log_message(LOG_ERROR, "Memory allocation error");
+            exit(1);
+        }
+
+        pages = newPages;
+        pagesCapacity = newCapacity;
+    }
+
+    // Pages are never moved so that a page's ID is always its index plus FAKE_WIKI_FIRST_PAGE_ID
+    fakePage* page = &pages[numberOfPages];
+    page->id = FAKE_WIKI_FIRST_PAGE_ID + numberOfPages;
+    page->path = duplicate_Malloc(path);
+    page->title = duplicate_Malloc(title);
+    page->content = duplicate_Malloc(content);
+    page->isDeleted = false;
+    page->renderedInPeriod = 0;
+    setUpdatedAt(page);
+
+    numberOfPages++;
+    return page;
+}
+
+static void deletePage(fakePage* page){
+    free(page->path);
+    free(page->title);
+    free(page->content);
+    page->path = NULL;
+    page->title = NULL;
+    page->content = NULL;
+    page->isDeleted = true;
+}
+
+static fakePage* findPage(int id){
+    int index = id - FAKE_WIKI_FIRST_PAGE_ID;
+
+    if(index < 0 || index >= numberOfPages || pages[index].isDeleted){
+        return NULL;
+    }
+
+    return &pages[index];
+}
+
+static fakeSubsystem* findSubsystem(const char *acronym, size_t length){
+    for(int i = 0; i < numberOfSubsystems; i++){
+        if(strlen(subsystems[i].acronym) == length && strncmp(subsystems[i].acronym, acronym, length) == 0){
+            return &subsystems[i];
+        }
+    }
+
+    return NULL;
+}
+
+static char* printAndDelete(cJSON* json){
+    char* text = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+
+    return text;
+}
+
+static fakeResponse makeResponse(int status, char *body){
+    fakeResponse response = {status, body};
+    return response;
+}
+
+static fakeResponse makeErrorResponse(int status, const char *message){
+    cJSON* error = cJSON_CreateObject();
+    cJSON* errors = cJSON_AddArrayToObject(error, "errors");
+    cJSON* item = cJSON_CreateObject();
+    cJSON_AddStringToObject(item, "message", message);
+    cJSON_AddItemToArray(errors, item);
+
+    counters.rejectedRequests++;
+
+    return makeResponse(status, printAndDelete(error));
+}
+
+/**
+ * @brief Reads the GraphQL string argument `name: "..."` found after `from`, undoing the GraphQL escapes.
+ *
+ * @return char* Newly allocated value, NULL if the argument is missing. `end` is set to the character after its closing
+ *         quote.
+ */
+static char* extractGraphqlString(const char *from, const char *name, const char **end){
+    char key[64];
+    snprintf(key, sizeof(key), "%s: \"", name);
+
+    const char *start = strstr(from, key);
+    if(!start){
+        return NULL;
+    }
+    start += strlen(key);
+
+    char* value = (char*)malloc(strlen(start) + 1);
+    if(!value){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    size_t length = 0;
+    const char *c = start;
+    for(; *c && *c != '"'; c++){
+        if(*c == '\\' && c[1]){
+            c++;
+            value[length++] = *c == 'n' ? '\n' : *c == 't' ? '\t' : *c;
+        }
+        else{
+            value[length++] = *c;
+        }
+    }
+    value[length] = '\0';
+
+    if(end){
+        *end = *c ? c + 1 : c;
+    }
+
+    return value;
+}
+
+static int extractGraphqlId(const char *query){
+    const char *id = strstr(query, "id: ");
+    return id ? atoi(id + strlen("id: ")) : -1;
+}
+
+static cJSON* buildMutationResult(const char *mutation, bool succeeded, const char *message){
+    cJSON* pagesObject = cJSON_CreateObject();
+    cJSON* result = cJSON_AddObjectToObject(pagesObject, mutation);
+    cJSON* responseResult = cJSON_AddObjectToObject(result, "responseResult");
+    cJSON_AddBoolToObject(responseResult, "succeeded", succeeded);
+    cJSON_AddNumberToObject(responseResult, "errorCode", succeeded ? 0 : 6003);
+    cJSON_AddStringToObject(responseResult, "slug", succeeded ? "ok" : "error");
+    cJSON_AddStringToObject(responseResult, "message", message);
+
+    return pagesObject;
+}
+
+static char* buildPageList(){
+    cJSON* json = cJSON_CreateObject();
+    cJSON* data = cJSON_AddObjectToObject(json, "data");
+    cJSON* pagesObject = cJSON_AddObjectToObject(data, "pages");
+    cJSON* list = cJSON_AddArrayToObject(pagesObject, "list");
+
+    // Same field order as the bot's query, parseJSON depends on it
+    for(int i = 0; i < numberOfPages; i++){
+        if(pages[i].isDeleted){
+            continue;
+        }
+
+        cJSON* page = cJSON_CreateObject();
+        cJSON_AddStringToObject(page, "path", pages[i].path);
+        cJSON_AddStringToObject(page, "title", pages[i].title);
+        cJSON_AddNumberToObject(page, "id", pages[i].id);
+        cJSON_AddStringToObject(page, "updatedAt", pages[i].updatedAt);
+        cJSON_AddItemToArray(list, page);
+    }
+
+    return printAndDelete(json);
+}
+
+static void addSinglePage(cJSON* pagesObject, const char *fieldName, const fakePage* page){
+    if(!page){
+        cJSON_AddNullToObject(pagesObject, fieldName);
+        return;
+    }
+
+    // The content must be directly followed by the description, see jsonParserGetStringValue
+    cJSON* single = cJSON_AddObjectToObject(pagesObject, fieldName);
+    cJSON_AddNumberToObject(single, "id", page->id);
+    cJSON_AddStringToObject(single, "path", page->path);
+    cJSON_AddStringToObject(single, "title", page->title);
+    cJSON_AddStringToObject(single, "content", page->content);
+    cJSON_AddStringToObject(single, "description", "");
+    cJSON_AddStringToObject(single, "updatedAt", page->updatedAt);
+    cJSON_AddStringToObject(single, "createdAt", page->updatedAt);
+    cJSON_AddNumberToObject(single, "authorId", 1);
+}
+
+/**
+ * @brief Answers every `single(id:)` field of the query, under its alias (e.g. `page3: single(id: 12)`) if it has one.
+ */
+static char* buildSinglePages(const char *query){
+    cJSON* json = cJSON_CreateObject();
+    cJSON* data = cJSON_AddObjectToObject(json, "data");
+    cJSON* pagesObject = cJSON_AddObjectToObject(data, "pages");
+
+    for(const char *single = strstr(query, "single("); single; single = strstr(single + 1, "single(")){
+        char fieldName[32] = "single";
+
+        const char *aliasEnd = single;
+        while(aliasEnd > query && aliasEnd[-1] == ' '){
+            aliasEnd--;
+        }
+        if(aliasEnd > query && aliasEnd[-1] == ':'){
+            const char *aliasStart = --aliasEnd;
+            while(aliasStart > query && (isalnum((unsigned char)aliasStart[-1]) || aliasStart[-1] == '_')){
+                aliasStart--;
+            }
+            snprintf(fieldName, sizeof(fieldName), "%.*s", (int)(aliasEnd - aliasStart), aliasStart);
+        }
+
+        addSinglePage(pagesObject, fieldName, findPage(extractGraphqlId(single)));
+    }
+
+    return printAndDelete(json);
+}
+
+static char* buildPadding(const char *prefix){
+    char* padding = duplicate_Malloc(prefix);
+
+    size_t length = strlen(padding);
+    size_t targetLength = length + (size_t)serversConfig.pageContentPadding;
+    while(length < targetLength){
+        padding = appendToString(padding, "Notes written by hand on the requirement page, kept by every update. ");
+        length = strlen(padding);
+    }
+
+    return padding;
+}
+
+/**
+ * @brief Applies a single page mutation.
+ *
+ * @return cJSON* Result of the mutation, the value of the `pages` field, or NULL if the mutation is not supported.
+ */
+static cJSON* applyWikiMutation(const char *query){
+    cJSON* result = NULL;
+
+    if(strstr(query, "update(")){
+        fakePage* page = findPage(extractGraphqlId(query));
+        char* content = extractGraphqlString(query, "content", NULL);
+
+        if(page && content){
+            free(page->content);
+            page->content = content;
+            content = NULL;
+            setUpdatedAt(page);
+        }
+        free(content);
+
+        result = buildMutationResult("update", page != NULL, page ? "Page has been updated." : "This page does not exist.");
+    }
+
+    else if(strstr(query, "create(")){
+        const char *end = query;
+        char* content = extractGraphqlString(query, "content", &end);
+        char* pagePath = extractGraphqlString(end, "path", NULL);
+        char* title = extractGraphqlString(end, "title", NULL);
+
+        if(content && pagePath && title){
+            char* paddedContent = buildPadding("");
+            paddedContent = appendToString(paddedContent, "\n");
+            paddedContent = appendToString(paddedContent, content);
+            (void)addPage(pagePath, title, paddedContent);
+            free(paddedContent);
+        }
+
+        result = buildMutationResult("create", content && pagePath && title, "Page has been created.");
+
+        free(content);
+        free(pagePath);
+        free(title);
+    }
+
+    else if(strstr(query, "delete(")){
+        fakePage* page = findPage(extractGraphqlId(query));
+        if(page){
+            deletePage(page);
+        }
+
+        result = buildMutationResult("delete", page != NULL, "Page has been deleted.");
+    }
+
+    else if(strstr(query, "render(")){
+        fakePage* page = findPage(extractGraphqlId(query));
+        if(page){
+            counters.pageRenders++;
+            if(page->renderedInPeriod == counterPeriod){
+                counters.repeatedPageRenders++;
+            }
+            page->renderedInPeriod = counterPeriod;
+        }
+
+        result = buildMutationResult("render", page != NULL, "ok");
+    }
+
+    else if(strstr(query, "move(")){
+        fakePage* page = findPage(extractGraphqlId(query));
+        result = buildMutationResult("move", page != NULL, "ok");
+    }
+
+    return result;
+}
+
+static fakeResponse handleWikiRequest(const char *method, const char *path, const char *body, networkEndpoint* endpoint){
+    (void)path;
+
+    if(strcmp(method, "POST") != 0){
+        return makeErrorResponse(405, "GraphQL requests must be POSTed");
+    }
+
+    *endpoint = classifyWikiQuery(body);
+
+    cJSON* request = cJSON_Parse(body);
+    const cJSON* queryItem = request ? cJSON_GetObjectItem(request, "query") : NULL;
+    if(!cJSON_IsString(queryItem)){
+        cJSON_Delete(request);
+        return makeErrorResponse(400, "POST body sent invalid JSON.");
+    }
+    const char *query = queryItem->valuestring;
+
+    fakeResponse response;
+
+    if(strstr(query, "list(")){
+        response = makeResponse(200, buildPageList());
+    }
+
+    else if(strstr(query, "single(")){
+        response = makeResponse(200, buildSinglePages(query));
+    }
+
+    else if(strstr(query, "mutation")){
+        cJSON* json = cJSON_CreateObject();
+        cJSON* data = cJSON_AddObjectToObject(json, "data");
+        bool isSupported = true;
+
+        // A batch of mutations is made of top level `pages` fields aliased m0, m1, ...
+        if(strstr(query, " m0: pages")){
+            for(int i = 0; ; i++){
+                char alias[32];
+                snprintf(alias, sizeof(alias), " m%d: pages", i);
+                const char *mutationStart = strstr(query, alias);
+                if(!mutationStart){
+                    break;
+                }
+
+                snprintf(alias, sizeof(alias), " m%d: pages", i + 1);
+                const char *mutationEnd = strstr(mutationStart, alias);
+                size_t mutationLength = mutationEnd ? (size_t)(mutationEnd - mutationStart) : strlen(mutationStart);
+
+                char* mutation = (char*)malloc(mutationLength + 1);
+                if(!mutation){
+                    log_message(LOG_ERROR, "Memory allocation error");
+                    exit(1);
+                }
+                memcpy(mutation, mutationStart, mutationLength);
+                mutation[mutationLength] = '\0';
+
+                cJSON* result = applyWikiMutation(mutation);
+                snprintf(alias, sizeof(alias), "m%d", i);
+                if(result){
+                    cJSON_AddItemToObject(data, alias, result);
+                }
+                else{
+                    cJSON_AddNullToObject(data, alias);
+                }
+
+                free(mutation);
+            }
+        }
+        else{
+            cJSON* result = applyWikiMutation(query);
+            isSupported = result != NULL;
+            if(result){
+                cJSON_AddItemToObject(data, "pages", result);
+            }
+        }
+
+        response = isSupported ? makeResponse(200, printAndDelete(json)) : makeErrorResponse(400, "Query not supported by the fake wiki.");
+        if(!isSupported){
+            cJSON_Delete(json);
+        }
+    }
+
+    else{
+        response = makeErrorResponse(400, "Query not supported by the fake wiki.");
+    }
+
+    cJSON_Delete(request);
+    return response;
+}
+
+static void addRow(cJSON* values, const char* const* cells, int numberOfCells){
+    cJSON* row = cJSON_CreateArray();
+    for(int i = 0; i < numberOfCells; i++){
+        cJSON_AddItemToArray(row, cJSON_CreateString(cells[i]));
+    }
+    cJSON_AddItemToArray(values, row);
+}
+
+static cJSON* buildInfoSheetValues(){
+    cJSON* values = cJSON_CreateArray();
+
+    const char* header[] = {"Acronym", "Name", "Requirement Pages Directory", "DRL Page ID", "VCD Page ID",
+                            "Req_DB Spreadsheet ID", "Req_DB Sheet Acronym and Range"};
+    addRow(values, header, 7);
+
+    for(int i = 0; i < numberOfSubsystems; i++){
+        char drlPageId[16];
+        char vcdPageId[16];
+        char range[sizeof(subsystems[i].acronym) + sizeof("!A1:Z")];
+        snprintf(drlPageId, sizeof(drlPageId), "%d", subsystems[i].drlPageId);
+        snprintf(vcdPageId, sizeof(vcdPageId), "%d", subsystems[i].vcdPageId);
+        if(snprintf(range, sizeof(range), "%s!A1:Z", subsystems[i].acronym) >= (int)sizeof(range)){
+            log_message(LOG_ERROR, "Fake sheets: the range of subsystem %s is too long", subsystems[i].acronym);
+            continue;
+        }
+
+        const char* row[] = {subsystems[i].acronym, subsystems[i].acronym, subsystems[i].directory, drlPageId, vcdPageId,
+                             FAKE_SPREADSHEET_ID, range};
+        addRow(values, row, 7);
+    }
+
+    return values;
+}
+
+static char* buildReqDbValues(const fakeSubsystem* subsystem){
+    static const char* const methods[] = {"Test", "Review Of Design", "Inspection", "Analysis"};
+    static const char* const deadlines[] = {"PDR", "CDR", "Integration", "Launch"};
+    static const char* const statuses[] = {"uncompleted", "in progress", "completed"};
+
+    cJSON* values = cJSON_CreateArray();
+
+    const char* header[9 + 3 * FAKE_NUMBER_OF_VERIFICATIONS] = {"ID", "Title", "Description", "Source", "Author",
+                                                                 "Assignee", "Justification", "Compliance", "Criticality"};
+    char verificationHeaders[3 * FAKE_NUMBER_OF_VERIFICATIONS][32];
+    for(int verification = 0; verification < FAKE_NUMBER_OF_VERIFICATIONS; verification++){
+        snprintf(verificationHeaders[3 * verification], 32, "Verification Method %d", verification + 1);
+        snprintf(verificationHeaders[3 * verification + 1], 32, "Verification Deadline %d", verification + 1);
+        snprintf(verificationHeaders[3 * verification + 2], 32, "Verification Status %d", verification + 1);
+    }
+    for(int i = 0; i < 3 * FAKE_NUMBER_OF_VERIFICATIONS; i++){
+        header[9 + i] = verificationHeaders[i];
+    }
+    addRow(values, header, 9 + 3 * FAKE_NUMBER_OF_VERIFICATIONS);
+
+    char* description = duplicate_Malloc("The system shall meet this requirement.");
+    while(strlen(description) < (size_t)serversConfig.descriptionLength){
+        description = appendToString(description, " It is verified at every milestone.");
+    }
+
+    for(int i = 0; i < subsystem->numberOfRequirements; i++){
+        if(i % FAKE_REQUIREMENTS_PER_GROUP == 0){
+            char group[32];
+            snprintf(group, sizeof(group), "Group %d", i / FAKE_REQUIREMENTS_PER_GROUP + 1);
+            const char* groupRow[] = {group};
+            addRow(values, groupRow, 1);
+        }
+
+        char id[64];
+        char title[64];
+        snprintf(id, sizeof(id), "2024_C_SE_%s_REQ_%04d", subsystem->acronym, i + 1);
+        snprintf(title, sizeof(title), "Requirement %d of %s", i + 1, subsystem->acronym);
+
+        const char* row[9 + 3 * FAKE_NUMBER_OF_VERIFICATIONS] = {id, title, description, "Competition rules", "Load test",
+                                                                  "Load test", "Needed by the mission", "Compliant", "High"};
+        for(int verification = 0; verification < FAKE_NUMBER_OF_VERIFICATIONS; verification++){
+            row[9 + 3 * verification] = methods[(i + verification) % 4];
+            row[10 + 3 * verification] = deadlines[(i + 2 * verification) % 4];
+            row[11 + 3 * verification] = statuses[(i / 3 + verification) % 3];
+        }
+        addRow(values, row, 9 + 3 * FAKE_NUMBER_OF_VERIFICATIONS);
+    }
+
+    free(description);
+
+    return printAndDelete(values);
+}
+
+static char* urlDecode(const char *text, size_t length){
+    char* decoded = (char*)malloc(length + 1);
+    if(!decoded){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    size_t decodedLength = 0;
+    for(size_t i = 0; i < length; i++){
+        unsigned int character;
+        if(text[i] == '%' && i + 2 < length && sscanf(&text[i + 1], "%2x", &character) == 1){
+            decoded[decodedLength++] = (char)character;
+            i += 2;
+        }
+        else{
+            decoded[decodedLength++] = text[i] == '+' ? ' ' : text[i];
+        }
+    }
+    decoded[decodedLength] = '\0';
+
+    return decoded;
+}
+
+/**
+ * @return char* The "values" array of the range as JSON, NULL if the sheet does not exist.
+ */
+static char* getSheetValues(const char *range){
+    const char *sheetEnd = strchr(range, '!');
+    size_t sheetLength = sheetEnd ? (size_t)(sheetEnd - range) : strlen(range);
+
+    if(sheetLength == strlen("INFO") && strncmp(range, "INFO", sheetLength) == 0){
+        return printAndDelete(buildInfoSheetValues());
+    }
+
+    fakeSubsystem* subsystem = findSubsystem(range, sheetLength);
+    if(!subsystem){
+        return NULL;
+    }
+
+    // Generated once, the sheet does not change during a run
+    if(!subsystem->reqDbValues){
+        subsystem->reqDbValues = buildReqDbValues(subsystem);
+    }
+
+    return duplicate_Malloc(subsystem->reqDbValues);
+}
+
+static char* buildValueRange(const char *range, const char *values){
+    char* valueRange = duplicate_Malloc("{\"range\":\"");
+    valueRange = appendToString(valueRange, range);
+    valueRange = appendToString(valueRange, "\",\"majorDimension\":\"ROWS\",\"values\":");
+    valueRange = appendToString(valueRange, values);
+    valueRange = appendToString(valueRange, "}");
+
+    return valueRange;
+}
+
+static fakeResponse handleSheetsRequest(const char *method, const char *path, const char *body, networkEndpoint* endpoint){
+    (void)body;
+
+    // The bot parses the token with the space Google puts after the colon
+    if(strcmp(path, "/token") == 0){
+        *endpoint = NETWORK_ENDPOINT_SHEET_OAUTH;
+        return makeResponse(200, duplicate_Malloc("{\n  \"access_token\": \"fake-access-token\",\n  \"expires_in\": 3599,\n  \"scope\": \"https://www.googleapis.com/auth/spreadsheets\",\n  \"token_type\": \"Bearer\"\n}"));
+    }
+
+    const char *values = strstr(path, "/values");
+    if(strncmp(path, "/v4/spreadsheets/", strlen("/v4/spreadsheets/")) != 0 || !values){
+        return makeErrorResponse(404, "Requested entity was not found.");
+    }
+
+    if(strncmp(values, "/values:batchUpdate", strlen("/values:batchUpdate")) == 0){
+        *endpoint = NETWORK_ENDPOINT_SHEET_UPDATE;
+        if(strcmp(method, "POST") != 0){
+            return makeErrorResponse(405, "values:batchUpdate must be POSTed");
+        }
+        return makeResponse(200, duplicate_Malloc("{\"spreadsheetId\":\"" FAKE_SPREADSHEET_ID "\",\"totalUpdatedRows\":1,\"totalUpdatedColumns\":1,\"totalUpdatedCells\":1,\"totalUpdatedSheets\":1}"));
+    }
+
+    *endpoint = NETWORK_ENDPOINT_SHEET_GET;
+
+    if(strncmp(values, "/values:batchGet", strlen("/values:batchGet")) == 0){
+        char* response = duplicate_Malloc("{\"spreadsheetId\":\"" FAKE_SPREADSHEET_ID "\",\"valueRanges\":[");
+        bool isFirst = true;
+
+        for(const char *parameter = strstr(values, "ranges="); parameter; parameter = strstr(parameter, "ranges=")){
+            parameter += strlen("ranges=");
+            size_t length = strcspn(parameter, "&");
+            char* range = urlDecode(parameter, length);
+
+            char* rangeValues = getSheetValues(range);
+            if(!rangeValues){
+                free(range);
+                free(response);
+                return makeErrorResponse(400, "Unable to parse range");
+            }
+
+            char* valueRange = buildValueRange(range, rangeValues);
+            response = appendToString(response, isFirst ? "" : ",");
+            response = appendToString(response, valueRange);
+            isFirst = false;
+
+            free(valueRange);
+            free(rangeValues);
+            free(range);
+        }
+
+        return makeResponse(200, appendToString(response, "]}"));
+    }
+
+    if(strncmp(values, "/values/", strlen("/values/")) != 0){
+        return makeErrorResponse(404, "Requested entity was not found.");
+    }
+
+    const char *encodedRange = values + strlen("/values/");
+    char* range = urlDecode(encodedRange, strcspn(encodedRange, "?"));
+    char* rangeValues = getSheetValues(range);
+    if(!rangeValues){
+        free(range);
+        return makeErrorResponse(400, "Unable to parse range");
+    }
+
+    char* response = buildValueRange(range, rangeValues);
+    free(rangeValues);
+    free(range);
+
+    return makeResponse(200, response);
+}
+
+static fakeResponse handleSlackRequest(const char *method, const char *path, const char *body, networkEndpoint* endpoint){
+    (void)method;
+    (void)body;
+
+    *endpoint = classifySlackUrl(path);
+
+    if(strncmp(path, "/api/conversations.history", strlen("/api/conversations.history")) == 0){
+        return makeResponse(200, duplicate_Malloc("{\"ok\":true,\"messages\":[],\"has_more\":false,\"response_metadata\":{\"next_cursor\":\"\"}}"));
+    }
+
+    if(strcmp(path, "/api/chat.postMessage") != 0 && strcmp(path, "/api/chat.update") != 0){
+        return makeErrorResponse(404, "unknown_method");
+    }
+
+    // The bot reads the first "ts" of the response, it has to be the message's
+    char* response = (char*)malloc(160);
+    if(!response){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+    snprintf(response, 160, "{\"ok\":true,\"channel\":\"%s\",\"ts\":\"%lld.%06lu\"}", SLACK_WIKI_TOOLBOX_CHANNEL,
+             (long long)time(NULL), ++numberOfSlackMessages % 1000000);
+
+    return makeResponse(200, response);
+}
+
+static void sendAll(int client, const char *data, size_t length){
+    while(length > 0){
+        ssize_t sent = send(client, data, length, MSG_NOSIGNAL);
+        if(sent <= 0){
+            return;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+}
+
+static void sleepMilliseconds(int milliseconds){
+    if(milliseconds <= 0){
+        return;
+    }
+
+    struct timespec delay = {milliseconds / 1000, (long)(milliseconds % 1000) * 1000000L};
+    nanosleep(&delay, NULL);
+}
+
+static const char* getStatusText(int status){
+    switch(status){
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        default: return "Error";
+    }
+}
+
+/**
+ * @brief Reads one HTTP/1.1 request, answers it and returns. Connections are not kept alive, the bot opens a new one
+ *        for every request anyway.
+ */
+static void answerRequest(fakeServer* server, int client){
+    char* request = (char*)malloc(FAKE_MAXIMUM_HEADER_LENGTH + 1);
+    if(!request){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+
+    size_t received = 0;
+    char *headerEnd = NULL;
+    while(!headerEnd && received < FAKE_MAXIMUM_HEADER_LENGTH){
+        ssize_t length = recv(client, request + received, FAKE_MAXIMUM_HEADER_LENGTH - received, 0);
+        if(length <= 0){
+            free(request);
+            return;
+        }
+        received += (size_t)length;
+        request[received] = '\0';
+        headerEnd = strstr(request, "\r\n\r\n");
+    }
+
+    if(!headerEnd){
+        free(request);
+        return;
+    }
+    *headerEnd = '\0';
+    const char *bodyStart = headerEnd + 4;
+    size_t bodyReceived = received - (size_t)(bodyStart - request);
+
+    char method[16] = "";
+    char path[4096] = "";
+    (void)sscanf(request, "%15s %4095s", method, path);
+
+    size_t contentLength = 0;
+    bool expectsContinue = false;
+    for(char *line = strstr(request, "\r\n"); line; line = strstr(line + 2, "\r\n")){
+        if(strncasecmp(line + 2, "Content-Length:", strlen("Content-Length:")) == 0){
+            contentLength = (size_t)strtoul(line + 2 + strlen("Content-Length:"), NULL, 10);
+        }
+        if(strncasecmp(line + 2, "Expect: 100-continue", strlen("Expect: 100-continue")) == 0){
+            expectsContinue = true;
+        }
+    }
+
+    if(expectsContinue){
+        const char *continueResponse = "HTTP/1.1 100 Continue\r\n\r\n";
+        sendAll(client, continueResponse, strlen(continueResponse));
+    }
+
+    char* body = (char*)malloc(contentLength + 1);
+    if(!body){
+        log_message(LOG_ERROR, "Memory allocation error");
+        exit(1);
+    }
+    size_t bodyLength = bodyReceived < contentLength ? bodyReceived : contentLength;
+    memcpy(body, bodyStart, bodyLength);
+    while(bodyLength < contentLength){
+        ssize_t length = recv(client, body + bodyLength, contentLength - bodyLength, 0);
+        if(length <= 0){
+            break;
+        }
+        bodyLength += (size_t)length;
+    }
+    body[bodyLength] = '\0';
+
+    sleepMilliseconds(serversConfig.latencyMs[server->service]);
+
+    pthread_mutex_lock(&fakeStateMutex);
+
+    networkEndpoint endpoint = NUMBER_OF_NETWORK_ENDPOINTS;
+    fakeResponse response;
+    switch(server->service){
+        case FAKE_SERVICE_WIKI:
+            response = handleWikiRequest(method, path, body, &endpoint);
+            break;
+
+        case FAKE_SERVICE_SHEETS:
+            response = handleSheetsRequest(method, path, body, &endpoint);
+            break;
+
+        default:
+            response = handleSlackRequest(method, path, body, &endpoint);
+            break;
+    }
+
+    size_t responseLength = strlen(response.body);
+
+    if(endpoint < NUMBER_OF_NETWORK_ENDPOINTS){
+        counters.requests[endpoint]++;
+    }
+    counters.bytesReceived[server->service] += received + bodyLength - bodyReceived;
+    counters.bytesSent[server->service] += responseLength;
+
+    pthread_mutex_unlock(&fakeStateMutex);
+
+    char header[256];
+    int headerLength = snprintf(header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                                response.status, getStatusText(response.status), responseLength);
+
+    sendAll(client, header, (size_t)headerLength);
+    sendAll(client, response.body, responseLength);
+
+    free(response.body);
+    free(body);
+    free(request);
+}
+
+static void* runFakeServer(void* argument){
+    fakeServer* server = (fakeServer*)argument;
+
+    while(server->isRunning){
+        int client = accept(server->listener, NULL, NULL);
+        if(client < 0){
+            continue;
+        }
+
+        answerRequest(server, client);
+        close(client);
+    }
+
+    return NULL;
+}
+
+static int startFakeServer(fakeServer* server, fakeService service, const char *urlVariable, const char *urlPath,
+                           const char *oauthUrlVariable){
+    server->service = service;
+    server->listener = socket(AF_INET, SOCK_STREAM, 0);
+    if(server->listener < 0){
+        log_message(LOG_ERROR, "Fake server: could not create socket");
+        return 1;
+    }
+
+    int reuseAddress = 1;
+    setsockopt(server->listener, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+
+    // Port 0, the kernel picks a free one
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = 0;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    socklen_t addressLength = sizeof(address);
+    if(bind(server->listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(server->listener, 64) != 0
+       || getsockname(server->listener, (struct sockaddr*)&address, &addressLength) != 0){
+        log_message(LOG_ERROR, "Fake server: could not listen on loopback");
+        close(server->listener);
+        return 1;
+    }
+
+    int port = ntohs(address.sin_port);
+
+    char url[128];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d%s", port, urlPath);
+    setenv(urlVariable, url, 1);
+
+    if(oauthUrlVariable){
+        snprintf(url, sizeof(url), "http://127.0.0.1:%d/token", port);
+        setenv(oauthUrlVariable, url, 1);
+    }
+
+    server->isRunning = true;
+    if(pthread_create(&server->thread, NULL, runFakeServer, server) != 0){
+        log_message(LOG_ERROR, "Fake server: could not start thread");
+        server->isRunning = false;
+        close(server->listener);
+        return 1;
+    }
+
+    return 0;
+}
+
+int startFakeServers(const fakeServersConfig* config){
+    log_message(LOG_DEBUG, "Entering function startFakeServers");
+
+    serversConfig = *config;
+    memset(&counters, 0, sizeof(counters));
+
+    pthread_mutex_lock(&fakeStateMutex);
+    for(int i = 0; i < config->unrelatedPages; i++){
+        char path[128];
+        char title[64];
+        snprintf(path, sizeof(path), "competition/firehorn/notes/page_%d", i);
+        snprintf(title, sizeof(title), "Notes %d", i);
+        (void)addPage(path, title, "# Notes\n");
+    }
+    pthread_mutex_unlock(&fakeStateMutex);
+
+    if(startFakeServer(&servers[FAKE_SERVICE_WIKI], FAKE_SERVICE_WIKI, "ERTBOT_WIKI_API_URL", "/graphql", NULL) != 0
+       || startFakeServer(&servers[FAKE_SERVICE_SHEETS], FAKE_SERVICE_SHEETS, "ERTBOT_SHEETS_API_URL", "/v4", "ERTBOT_GOOGLE_OAUTH_URL") != 0
+       || startFakeServer(&servers[FAKE_SERVICE_SLACK], FAKE_SERVICE_SLACK, "ERTBOT_SLACK_API_URL", "/api", NULL) != 0){
+        stopFakeServers();
+        return 1;
+    }
+
+    log_message(LOG_DEBUG, "Exiting function startFakeServers");
+    return 0;
+}
+
+void stopFakeServers(){
+    log_message(LOG_DEBUG, "Entering function stopFakeServers");
+
+    for(int i = 0; i < NUMBER_OF_FAKE_SERVICES; i++){
+        if(!servers[i].isRunning){
+            continue;
+        }
+
+        // Unblocks accept
+        servers[i].isRunning = false;
+        shutdown(servers[i].listener, SHUT_RDWR);
+        close(servers[i].listener);
+        pthread_join(servers[i].thread, NULL);
+    }
+
+    pthread_mutex_lock(&fakeStateMutex);
+    for(int i = 0; i < numberOfPages; i++){
+        if(!pages[i].isDeleted){
+            deletePage(&pages[i]);
+        }
+    }
+    free(pages);
+    pages = NULL;
+    numberOfPages = 0;
+    pagesCapacity = 0;
+
+    for(int i = 0; i < numberOfSubsystems; i++){
+        free(subsystems[i].reqDbValues);
+    }
+    numberOfSubsystems = 0;
+    pthread_mutex_unlock(&fakeStateMutex);
+
+    log_message(LOG_DEBUG, "Exiting function stopFakeServers");
+}
+
+void addFakeSubsystem(const char *acronym, int numberOfRequirements){
+    pthread_mutex_lock(&fakeStateMutex);
+
+    if(numberOfSubsystems == FAKE_MAXIMUM_SUBSYSTEMS){
+        pthread_mutex_unlock(&fakeStateMutex);
+        log_message(LOG_ERROR, "Fake sheets: too many subsystems");
+        return;
+    }
+
+    fakeSubsystem* subsystem = &subsystems[numberOfSubsystems++];
+    memset(subsystem, 0, sizeof(*subsystem));
+    snprintf(subsystem->acronym, sizeof(subsystem->acronym), "%s", acronym);
+    snprintf(subsystem->directory, sizeof(subsystem->directory), "loadtest/%s/requirements/", acronym);
+    subsystem->numberOfRequirements = numberOfRequirements;
+
+    char path[160];
+    snprintf(path, sizeof(path), "loadtest/%s/drl", acronym);
+    subsystem->drlPageId = addPage(path, "DRL", "")->id;
+    snprintf(path, sizeof(path), "loadtest/%s/vcd", acronym);
+    subsystem->vcdPageId = addPage(path, "VCD", "")->id;
+
+    pthread_mutex_unlock(&fakeStateMutex);
+}
+
+int countFakeWikiPages(const char *pathPrefix){
+    pthread_mutex_lock(&fakeStateMutex);
+
+    int count = 0;
+    for(int i = 0; i < numberOfPages; i++){
+        if(!pages[i].isDeleted && strncmp(pages[i].path, pathPrefix, strlen(pathPrefix)) == 0){
+            count++;
+        }
+    }
+
+    pthread_mutex_unlock(&fakeStateMutex);
+    return count;
+}
+
+const char* getFakeRequirementPagesDirectory(const char *acronym){
+    fakeSubsystem* subsystem = findSubsystem(acronym, strlen(acronym));
+    return subsystem ? subsystem->directory : NULL;
+}
+
+void getFakeServerCounters(fakeServerCounters* result){
+    pthread_mutex_lock(&fakeStateMutex);
+    *result = counters;
+    pthread_mutex_unlock(&fakeStateMutex);
+}
+
+void resetFakeServerCounters(){
+    pthread_mutex_lock(&fakeStateMutex);
+    memset(&counters, 0, sizeof(counters));
+    counterPeriod++;
+    pthread_mutex_unlock(&fakeStateMutex);
+}
@@ -0,0 +1,85 @@
+#ifndef ERTBOT_FAKE_SERVERS_H
+#define ERTBOT_FAKE_SERVERS_H
+
+#include "networkTelemetry.h"
+
+/**
+ * @enum fakeService
+ * @brief Services stood in for by the load test, each one listens on its own loopback port.
+ *
+ * @details
+ * - `FAKE_SERVICE_WIKI`: Wiki.js GraphQL, `pages` list/single/update/render/create/move/delete.
+ * - `FAKE_SERVICE_SHEETS`: Google Sheets `values` get/batchGet/batchUpdate and the OAuth token endpoint.
+ * - `FAKE_SERVICE_SLACK`: `chat.postMessage`, `chat.update` and `conversations.history`.
+ */
+typedef enum fakeService {
+    FAKE_SERVICE_WIKI,
+    FAKE_SERVICE_SHEETS,
+    FAKE_SERVICE_SLACK,
+    NUMBER_OF_FAKE_SERVICES
+}fakeService;
+
+/**
+ * @struct fakeServersConfig
+ * @brief How the fake servers behave.
+ *
+ * @details
+ * - `latencyMs`: Delay added before every response of each service.
+ * - `descriptionLength`: Length in bytes of the description of every requirement of the Req_DB sheets.
+ * - `pageContentPadding`: Bytes of hand-written text added before the generated section of every page created on the
+ *   wiki, makes the pages the bot downloads and uploads bigger.
+ * - `unrelatedPages`: Pages outside of the load test subsystems, listed by every `pages.list`.
+ */
+typedef struct fakeServersConfig {
+    int latencyMs[NUMBER_OF_FAKE_SERVICES];
+    int descriptionLength;
+    int pageContentPadding;
+    int unrelatedPages;
+}fakeServersConfig;
+
+/**
+ * @brief Counters of what the fake servers received, reset by `resetFakeServerCounters`.
+ */
+typedef struct fakeServerCounters {
+    unsigned long requests[NUMBER_OF_NETWORK_ENDPOINTS];
+    unsigned long long bytesReceived[NUMBER_OF_FAKE_SERVICES];
+    unsigned long long bytesSent[NUMBER_OF_FAKE_SERVICES];
+    unsigned long rejectedRequests;
+    unsigned long pageRenders;
+    unsigned long repeatedPageRenders; //renders of a page already rendered since the counters were reset
+}fakeServerCounters;
+
+/**
+ * @brief Starts the fake servers on loopback and points the bot at them by setting the `ERTBOT_*_URL` environment
+ *        variables read by `getApiUrl`.
+ *
+ * @return int 0 on success, 1 if a server could not be started.
+ */
+int startFakeServers(const fakeServersConfig* config);
+
+/**
+ * @brief Stops the fake servers and frees everything they stored.
+ */
+void stopFakeServers();
+
+/**
+ * @brief Adds a subsystem to the INFO sheet, with a Req_DB of `numberOfRequirements` synthetic requirements and empty
+ *        DRL and VCD pages on the wiki.
+ */
+void addFakeSubsystem(const char *acronym, int numberOfRequirements);
+
+/**
+ * @brief Counts the pages of the fake wiki whose path starts with `pathPrefix`.
+ */
+int countFakeWikiPages(const char *pathPrefix);
+
+/**
+ * @brief Returns the path of the directory the requirement pages of a fake subsystem are created in.
+ */
+const char* getFakeRequirementPagesDirectory(const char *acronym);
+
+void getFakeServerCounters(fakeServerCounters* counters);
+
+void resetFakeServerCounters();
+
+#endif
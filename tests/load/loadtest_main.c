@@ -0,0 +1,350 @@
+/**
+ * @file loadtest_main.c
+ * @author Ryan Svoboda (ryan.svoboda@epfl.ch)
+ * @brief Runs `sync` end to end against the fake servers and reports how long it took and how many requests it sent.
+ *
+ * @details For every size a synthetic subsystem with that many requirements is added to the fake INFO sheet and
+ *          synced four times: "cold" creates every requirement page, "warm" finds them all already there but updated
+ *          since they were last fetched, "cached" finds them unchanged and reads them from the page cache, "unchanged"
+ *          finds every requirement row in the snapshots of the last run and regenerates nothing. The snapshots are
+ *          deleted before the first three passes so that they still regenerate every page. The bot code is the same as
+ *          in production, only its base URLs point to loopback and its page cache and snapshots to temporary files.
+ *          Then every subsystem is synced at once with `sync all`, its snapshots deleted first. Finally `checkForChanges` is run three times: the syncs queued by the first probe are dropped, so the second
+ *          probe must queue a sync per subsystem again, and the third none once those syncs succeeded.
+ *          The results are printed to stdout as JSON.
+ *
+ *          Usage: ./ERTbot_loadtest [--latency-ms N] [--wiki-latency-ms N] [--sheets-latency-ms N]
+ *                                   [--slack-latency-ms N] [--description-length N] [--page-padding N]
+ *                                   [--unrelated-pages N] [sizes, default 100,1000,5000]
+ *
+ *          Returns 1 if a sync did not leave one page per requirement on the fake wiki, sent a request the fake
+ *          servers rejected or rendered a page twice, or if the change probe did not queue the expected syncs.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include "ERTbot_common.h"
+#include "ERTbot_command.h"
+#include "ERTbot_commandRegistry.h"
+#include "apiHelpers.h"
+#include "slackAPI.h"
+#include "commandQueueHelpers.h"
+#include "networkTelemetry.h"
+#include "ERTbot_allocationProfiler.h"
+#include "wikiPageCache.h"
+#include "requirementSnapshotHelpers.h"
+#include "rateLimiter.h"
+#include "fakeServers.h"
+
+#define LOADTEST_DEFAULT_SIZES "100,1000,5000"
+#define LOADTEST_MAXIMUM_SIZES 16
+
+static const char* const fakeServiceNames[NUMBER_OF_FAKE_SERVICES] = {
+    [FAKE_SERVICE_WIKI] = "wiki",
+    [FAKE_SERVICE_SHEETS] = "sheets",
+    [FAKE_SERVICE_SLACK] = "slack",
+};
+
+static double getMonotonicSeconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int parseSizes(const char *text, int sizes[LOADTEST_MAXIMUM_SIZES]){
+    int numberOfSizes = 0;
+
+    for(const char *c = text; *c && numberOfSizes < LOADTEST_MAXIMUM_SIZES; ){
+        int size = atoi(c);
+        if(size > 0){
+            sizes[numberOfSizes++] = size;
+        }
+
+        c = strchr(c, ',');
+        if(!c){
+            break;
+        }
+        c++;
+    }
+
+    return numberOfSizes;
+}
+
+static void getAcronym(int numberOfRequirements, char acronym[32]){
+    snprintf(acronym, 32, "LT%d", numberOfRequirements);
+}
+
+/**
+ * @brief Queues and runs a single `sync`, the way the main loop would.
+ *
+ * @param[in] argument Argument of the sync, e.g. "LT100" or "all".
+ * @param[in] sizes Sizes of the subsystems the sync covers.
+ * @param[in] keepsSnapshots false to delete the snapshots of the last run first, so that every page is regenerated.
+ *
+ * @return bool true if the sync left one page per requirement, no request was rejected and no page was rendered twice.
+ */
+static bool runSync(const char *argument, const int *sizes, int numberOfSizes, const char *pass, bool keepsSnapshots, bool isFirstResult){
+    int numberOfRequirements = 0;
+    for(int i = 0; i < numberOfSizes; i++){
+        char acronym[32];
+        getAcronym(sizes[i], acronym);
+        if(!keepsSnapshots){
+            (void)resetRequirementSnapshots(acronym);
+        }
+        numberOfRequirements += sizes[i];
+    }
+
+    resetFakeServerCounters();
+
+    // Every pass starts with full token buckets, as a sync does when it runs long after the last one
+    resetRateLimits();
+
+    (void)enqueueCommand(mainCommandQueue, "sync", argument, COMMAND_PRIORITY_INTERACTIVE);
+
+    double start = getMonotonicSeconds();
+    mainCommandQueue = executeCommand(mainCommandQueue);
+    double wallTime = getMonotonicSeconds() - start;
+
+    fakeServerCounters counters;
+    getFakeServerCounters(&counters);
+
+    int numberOfPages = 0;
+    bool isEverySubsystemSynced = true;
+    for(int i = 0; i < numberOfSizes; i++){
+        char acronym[32];
+        getAcronym(sizes[i], acronym);
+        int numberOfSubsystemPages = countFakeWikiPages(getFakeRequirementPagesDirectory(acronym));
+        if(numberOfSubsystemPages != sizes[i]){
+            fprintf(stderr, "%s sync of %s left %d requirement pages of %s instead of %d\n", pass, argument, numberOfSubsystemPages, acronym, sizes[i]);
+            isEverySubsystemSynced = false;
+        }
+        numberOfPages += numberOfSubsystemPages;
+    }
+
+    unsigned long totalRequests = 0;
+    for(int i = 0; i < NUMBER_OF_NETWORK_ENDPOINTS; i++){
+        totalRequests += counters.requests[i];
+    }
+
+    printf("%s\n    {\"requirements\": %d, \"pass\": \"%s\", \"wall_seconds\": %.3f, \"requests_per_second\": %.1f, \"total_requests\": %lu, \"rejected_requests\": %lu, \"requirement_pages\": %d, \"page_renders\": %lu,\n     \"requests\": {",
+           isFirstResult ? "" : ",", numberOfRequirements, pass, wallTime, wallTime > 0 ? (double)totalRequests / wallTime : 0.0,
+           totalRequests, counters.rejectedRequests, numberOfPages, counters.pageRenders);
+
+    bool isFirstEndpoint = true;
+    for(int i = 0; i < NUMBER_OF_NETWORK_ENDPOINTS; i++){
+        if(counters.requests[i] == 0){
+            continue;
+        }
+
+        printf("%s\"%s\": %lu", isFirstEndpoint ? "" : ", ", getNetworkEndpointName((networkEndpoint)i), counters.requests[i]);
+        isFirstEndpoint = false;
+    }
+
+    printf("},\n     \"bytes_from_bot\": {");
+    for(int i = 0; i < NUMBER_OF_FAKE_SERVICES; i++){
+        printf("%s\"%s\": %llu", i == 0 ? "" : ", ", fakeServiceNames[i], counters.bytesReceived[i]);
+    }
+
+    printf("}, \"bytes_to_bot\": {");
+    for(int i = 0; i < NUMBER_OF_FAKE_SERVICES; i++){
+        printf("%s\"%s\": %llu", i == 0 ? "" : ", ", fakeServiceNames[i], counters.bytesSent[i]);
+    }
+    printf("}}");
+    fflush(stdout);
+
+    if(!isEverySubsystemSynced){
+        return false;
+    }
+
+    if(counters.rejectedRequests > 0){
+        fprintf(stderr, "%s sync of %s sent %lu requests the fake servers rejected\n", pass, argument, counters.rejectedRequests);
+        return false;
+    }
+
+    if(counters.repeatedPageRenders > 0){
+        fprintf(stderr, "%s sync of %s rendered %lu pages more than once\n", pass, argument, counters.repeatedPageRenders);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Runs `checkForChanges` then every sync it queued, or drops them if `isSyncing` is false.
+ *
+ * @return int Number of syncs the probe queued.
+ */
+static int runChangeProbe(unsigned long* sheetRequests, bool isSyncing){
+    resetFakeServerCounters();
+
+    (void)enqueueCommand(mainCommandQueue, "checkForChanges", NULL, COMMAND_PRIORITY_SCHEDULED);
+    mainCommandQueue = executeCommand(mainCommandQueue);
+
+    fakeServerCounters counters;
+    getFakeServerCounters(&counters);
+    *sheetRequests = counters.requests[NETWORK_ENDPOINT_SHEET_GET];
+
+    int numberOfSyncs = 0;
+    while(!isCommandQueueEmpty(mainCommandQueue)){
+        if(isSyncing){
+            mainCommandQueue = executeCommand(mainCommandQueue);
+        }
+        else{
+            command cmd;
+            (void)dequeueCommand(mainCommandQueue, &cmd);
+            freeCommand(&cmd);
+        }
+        numberOfSyncs++;
+    }
+
+    return numberOfSyncs;
+}
+
+int main(int argc, char **argv){
+    fakeServersConfig config = {
+        .latencyMs = {0, 0, 0},
+        .descriptionLength = 200,
+        .pageContentPadding = 2000,
+        .unrelatedPages = 2000,
+    };
+
+    static const struct option options[] = {
+        {"latency-ms", required_argument, NULL, 'l'},
+        {"wiki-latency-ms", required_argument, NULL, 'w'},
+        {"sheets-latency-ms", required_argument, NULL, 's'},
+        {"slack-latency-ms", required_argument, NULL, 'k'},
+        {"description-length", required_argument, NULL, 'd'},
+        {"page-padding", required_argument, NULL, 'p'},
+        {"unrelated-pages", required_argument, NULL, 'u'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int option;
+    while((option = getopt_long(argc, argv, "", options, NULL)) != -1){
+        switch(option){
+            case 'l':
+                for(int i = 0; i < NUMBER_OF_FAKE_SERVICES; i++){
+                    config.latencyMs[i] = atoi(optarg);
+                }
+                break;
+            case 'w': config.latencyMs[FAKE_SERVICE_WIKI] = atoi(optarg); break;
+            case 's': config.latencyMs[FAKE_SERVICE_SHEETS] = atoi(optarg); break;
+            case 'k': config.latencyMs[FAKE_SERVICE_SLACK] = atoi(optarg); break;
+            case 'd': config.descriptionLength = atoi(optarg); break;
+            case 'p': config.pageContentPadding = atoi(optarg); break;
+            case 'u': config.unrelatedPages = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [--latency-ms N] [--wiki-latency-ms N] [--sheets-latency-ms N] [--slack-latency-ms N] [--description-length N] [--page-padding N] [--unrelated-pages N] [sizes]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    int sizes[LOADTEST_MAXIMUM_SIZES];
+    int numberOfSizes = parseSizes(optind < argc ? argv[optind] : LOADTEST_DEFAULT_SIZES, sizes);
+
+    initializeAllocationProfiler();
+
+    // Debug lines would be most of the run time, ERTBOT_LOG_LEVEL still wins
+    if(getenv("ERTBOT_LOG_LEVEL")){
+        initializeLogLevels();
+    }
+    else{
+        (void)setLogLevels("error");
+    }
+
+    // Never send anything real, even if the shell has the production tokens
+    setenv("WIKI_API_TOKEN", "loadtest", 1);
+    setenv("SLACK_API_TOKEN", "loadtest", 1);
+    setenv("GOOGLE_CLIENT_ID", "loadtest", 1);
+    setenv("GOOGLE_CLIENT_SECRET", "loadtest", 1);
+    setenv("GOOGLE_REFRESH_TOKEN", "loadtest", 1);
+
+    if(startFakeServers(&config) != 0){
+        fprintf(stderr, "Could not start the fake servers\n");
+        return 1;
+    }
+
+    char pageCachePath[] = "/tmp/ERTbot_loadtest_pageCacheXXXXXX";
+    int pageCacheDescriptor = mkstemp(pageCachePath);
+    if(pageCacheDescriptor < 0 || openPageCache(pageCachePath) != 0){
+        fprintf(stderr, "Could not create the page cache\n");
+        return 1;
+    }
+    close(pageCacheDescriptor);
+
+    char snapshotDirectory[] = "/tmp/ERTbot_loadtest_snapshotsXXXXXX";
+    if(!mkdtemp(snapshotDirectory)){
+        fprintf(stderr, "Could not create the snapshot directory\n");
+        return 1;
+    }
+    setRequirementSnapshotDirectory(snapshotDirectory);
+
+    initializeApiTokenVariables();
+    initialiseSlackCommandStatusMessage();
+    initializeCommandRegistry();
+    mainCommandQueue = createCommandQueue();
+
+    printf("{\n  \"latency_ms\": {\"wiki\": %d, \"sheets\": %d, \"slack\": %d}, \"description_length\": %d, \"page_padding\": %d, \"unrelated_pages\": %d,\n  \"results\": [",
+           config.latencyMs[FAKE_SERVICE_WIKI], config.latencyMs[FAKE_SERVICE_SHEETS], config.latencyMs[FAKE_SERVICE_SLACK],
+           config.descriptionLength, config.pageContentPadding, config.unrelatedPages);
+
+    bool succeeded = true;
+    bool isFirstResult = true;
+    for(int i = 0; i < numberOfSizes; i++){
+        char acronym[32];
+        getAcronym(sizes[i], acronym);
+        addFakeSubsystem(acronym, sizes[i]);
+
+        succeeded = runSync(acronym, &sizes[i], 1, "cold", false, isFirstResult) && succeeded;
+        isFirstResult = false;
+        succeeded = runSync(acronym, &sizes[i], 1, "warm", false, isFirstResult) && succeeded;
+        succeeded = runSync(acronym, &sizes[i], 1, "cached", false, isFirstResult) && succeeded;
+        succeeded = runSync(acronym, &sizes[i], 1, "unchanged", true, isFirstResult) && succeeded;
+
+    }
+
+    // Every subsystem at once, to compare with the sum of their "cached" passes
+    if(numberOfSizes > 0){
+        succeeded = runSync("all", sizes, numberOfSizes, "all", false, isFirstResult) && succeeded;
+    }
+
+    printf("\n  ],\n");
+
+    // Every subsystem was synced by the load test but never probed. The syncs of the first probe are dropped, so the
+    // second one queues them again, then nothing changes
+    unsigned long droppedProbeSheetRequests = 0;
+    unsigned long firstProbeSheetRequests = 0;
+    unsigned long secondProbeSheetRequests = 0;
+    int droppedProbeSyncs = runChangeProbe(&droppedProbeSheetRequests, false);
+    int firstProbeSyncs = runChangeProbe(&firstProbeSheetRequests, true);
+    int secondProbeSyncs = runChangeProbe(&secondProbeSheetRequests, true);
+
+    printf("  \"change_probe\": {\"dropped_syncs\": %d, \"first_syncs\": %d, \"first_sheet_requests\": %lu, \"second_syncs\": %d, \"second_sheet_requests\": %lu}\n}\n",
+           droppedProbeSyncs, firstProbeSyncs, firstProbeSheetRequests, secondProbeSyncs, secondProbeSheetRequests);
+
+    if(droppedProbeSyncs != numberOfSizes || firstProbeSyncs != numberOfSizes || secondProbeSyncs != 0){
+        fprintf(stderr, "The change probe queued %d, %d then %d syncs instead of %d, %d then 0\n", droppedProbeSyncs, firstProbeSyncs,
+                secondProbeSyncs, numberOfSizes, numberOfSizes);
+        succeeded = false;
+    }
+
+    freeCommandQueue(&mainCommandQueue);
+    stopFakeServers();
+    closePageCache();
+    remove(pageCachePath);
+    for(int i = 0; i < numberOfSizes; i++){
+        char acronym[32];
+        getAcronym(sizes[i], acronym);
+        (void)resetRequirementSnapshots(acronym);
+    }
+    setRequirementSnapshotDirectory(NULL);
+    rmdir(snapshotDirectory);
+    flushLogs();
+
+    return succeeded ? 0 : 1;
+}
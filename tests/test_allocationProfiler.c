@@ -0,0 +1,89 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "ERTbot_common.h"
+#include "ERTbot_allocationProfiler.h"
+
+START_TEST(test_allocationProfile) {
+    void* allocatedBefore = profiledMalloc(1000);
+
+    beginAllocationProfile("test");
+
+    void* kept = profiledMalloc(100);
+    void* freed = profiledCalloc(10, 5);
+    kept = profiledRealloc(kept, 200);
+    profiledFree(freed);
+
+    // A failed realloc leaves the block tracked
+    ck_assert_ptr_null(profiledRealloc(kept, SIZE_MAX));
+
+    // Blocks from before the profile are not counted
+    profiledFree(allocatedBefore);
+
+    allocationProfile profile;
+    getAllocationProfile(&profile);
+    ck_assert_uint_eq(profile.numberOfAllocations, 3);
+    ck_assert_uint_eq(profile.bytesAllocated, 350);
+    ck_assert_uint_eq(profile.peakLiveBytes, 250);
+    ck_assert_uint_eq(profile.leakedBlocks, 1);
+    ck_assert_uint_eq(profile.leakedBytes, 200);
+
+    endAllocationProfile();
+
+    // The profile is kept as it was when it ended
+    profiledFree(kept);
+    getAllocationProfile(&profile);
+    ck_assert_uint_eq(profile.leakedBlocks, 1);
+    ck_assert_uint_eq(profile.leakedBytes, 200);
+}
+END_TEST
+
+START_TEST(test_allocationProfileManyBlocks) {
+    enum { NUMBER_OF_BLOCKS = 20000 };
+    void** blocks = malloc(NUMBER_OF_BLOCKS * sizeof(void*));
+    ck_assert_ptr_nonnull(blocks);
+
+    beginAllocationProfile("test");
+
+    for(int i = 0; i < NUMBER_OF_BLOCKS; i++){
+        blocks[i] = profiledMalloc(16);
+    }
+    for(int i = 0; i < NUMBER_OF_BLOCKS; i += 2){
+        profiledFree(blocks[i]);
+    }
+
+    allocationProfile profile;
+    getAllocationProfile(&profile);
+    ck_assert_uint_eq(profile.numberOfAllocations, NUMBER_OF_BLOCKS);
+    ck_assert_uint_eq(profile.peakLiveBytes, 16 * NUMBER_OF_BLOCKS);
+    ck_assert_uint_eq(profile.leakedBlocks, NUMBER_OF_BLOCKS / 2);
+
+    for(int i = 1; i < NUMBER_OF_BLOCKS; i += 2){
+        profiledFree(blocks[i]);
+    }
+
+    endAllocationProfile();
+    getAllocationProfile(&profile);
+    ck_assert_uint_eq(profile.leakedBlocks, 0);
+    ck_assert_uint_eq(profile.leakedBytes, 0);
+
+    free(blocks);
+}
+END_TEST
+
+// Test suite setup
+Suite *allocationProfiler_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("allocationProfiler");
+
+    // Core test case
+    tc_core = tcase_create("allocationProfiler");
+
+    tcase_add_test(tc_core, test_allocationProfile);
+    tcase_add_test(tc_core, test_allocationProfileManyBlocks);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
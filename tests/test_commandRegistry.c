@@ -0,0 +1,83 @@
+#include <check.h>
+#include <string.h>
+#include "ERTbot_common.h"
+#include "ERTbot_commandRegistry.h"
+
+START_TEST(test_findCommandDefinition) {
+    const char *names[] = {"help", "shutdown", "sync", "createMissingRequirementPages", "updateDRL", "updateReq", "updateVCD"};
+
+    initializeCommandRegistry();
+
+    for(size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++){
+        const commandDefinition* definition = findCommandDefinition(names[i]);
+        ck_assert_ptr_nonnull(definition);
+        ck_assert_str_eq(definition->name, names[i]);
+        ck_assert_ptr_nonnull(definition->handler);
+    }
+
+    ck_assert_ptr_null(findCommandDefinition("updatereq"));
+    ck_assert_ptr_null(findCommandDefinition("onPageUpdate"));
+    ck_assert_ptr_null(findCommandDefinition(""));
+    ck_assert_ptr_null(findCommandDefinition(NULL));
+}
+END_TEST
+
+START_TEST(test_isCommandArgumentValid) {
+    ck_assert(isCommandArgumentValid(findCommandDefinition("help"), NULL));
+    ck_assert(isCommandArgumentValid(findCommandDefinition("sync"), "ST"));
+    ck_assert(!isCommandArgumentValid(findCommandDefinition("sync"), NULL));
+    ck_assert(isCommandArgumentValid(findCommandDefinition("sync"), "all"));
+    ck_assert(isCommandArgumentValid(findCommandDefinition("sync"), "ST,GE,PR"));
+    ck_assert(!isCommandArgumentValid(findCommandDefinition("sync"), "ST,,GE"));
+    ck_assert(!isCommandArgumentValid(findCommandDefinition("sync"), "ST,"));
+    ck_assert(!isCommandArgumentValid(findCommandDefinition("sync"), "2024_C_SE_ST_REQ_01"));
+    ck_assert(!isCommandArgumentValid(findCommandDefinition("updateVCD"), "2024_C_SE_ST_REQ_01"));
+    ck_assert(isCommandArgumentValid(findCommandDefinition("updateReq"), "2024_C_SE_ST_REQ_01"));
+    ck_assert(isCommandArgumentValid(findCommandDefinition("updateReq"), "ST"));
+}
+END_TEST
+
+START_TEST(test_isLightweightCommand) {
+    command help = {"help", NULL, NULL};
+    command singleRequirement = {"updateReq", "2024_C_SE_ST_REQ_01", NULL};
+    command wholeSubsystem = {"updateReq", "ST", NULL};
+    command unknown = {"foo", NULL, NULL};
+    command probe = {"checkForChanges", NULL, NULL};
+
+    ck_assert(isLightweightCommand(&help));
+    ck_assert(isLightweightCommand(&singleRequirement));
+    ck_assert(!isLightweightCommand(&wholeSubsystem));
+    ck_assert(!isLightweightCommand(&unknown));
+    ck_assert(!isLightweightCommand(&probe));
+}
+END_TEST
+
+START_TEST(test_buildHelpMessage) {
+    char* helpMessage = buildHelpMessage();
+
+    ck_assert_ptr_nonnull(strstr(helpMessage, "*updateReq*"));
+    ck_assert_ptr_nonnull(strstr(helpMessage, "-> example: sync ST"));
+    ck_assert_ptr_null(strchr(helpMessage, '\n'));
+
+    free(helpMessage);
+}
+END_TEST
+
+// Test suite setup
+Suite *commandRegistry_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("commandRegistry");
+
+    // Core test case
+    tc_core = tcase_create("commandRegistry");
+
+    tcase_add_test(tc_core, test_findCommandDefinition);
+    tcase_add_test(tc_core, test_isCommandArgumentValid);
+    tcase_add_test(tc_core, test_isLightweightCommand);
+    tcase_add_test(tc_core, test_buildHelpMessage);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -0,0 +1,94 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "ERTbot_common.h"
+
+static bool logFileContains(const char *path, const char *text){
+    FILE *file = fopen(path, "r");
+    if(!file){
+        return false;
+    }
+
+    char line[4096];
+    bool found = false;
+    while(!found && fgets(line, sizeof(line), file)){
+        found = strstr(line, text) != NULL;
+    }
+
+    fclose(file);
+    return found;
+}
+
+START_TEST(test_log_message_reachesFileAfterFlush) {
+    char marker[64];
+    snprintf(marker, sizeof(marker), "test_log marker %ld", (long)time(NULL));
+
+    for(int i = 0; i < 100; i++){
+        log_message(LOG_INFO, "test_log filler line %d", i);
+    }
+    log_message(LOG_INFO, "%s", marker);
+
+    flushLogs();
+
+    ck_assert(logFileContains("logs/info.log", marker));
+}
+END_TEST
+
+START_TEST(test_log_message_truncatesLongLines) {
+    static char longLine[3 * 4096];
+    memset(longLine, 'x', sizeof(longLine) - 1);
+    longLine[sizeof(longLine) - 1] = '\0';
+
+    // Must not overflow the ring slot
+    log_message(LOG_ERROR, "%s", longLine);
+    flushLogs();
+}
+END_TEST
+
+static int numberOfEvaluations = 0;
+
+static const char* countEvaluation(){
+    numberOfEvaluations++;
+    return "payload";
+}
+
+START_TEST(test_log_message_skipsArgumentsWhenDisabled) {
+    ck_assert_int_eq(setLogModuleLevel("core", "error"), 0);
+
+    numberOfEvaluations = 0;
+    log_message(LOG_INFO, "expensive: %s", countEvaluation());
+    ck_assert_int_eq(numberOfEvaluations, 0);
+    ck_assert(!LOG_ENABLED(LOG_INFO));
+
+    ck_assert_int_eq(setLogLevels("core=info,wikiAPI=error"), 0);
+    log_message(LOG_INFO, "expensive: %s", countEvaluation());
+    ck_assert_int_eq(numberOfEvaluations, 1);
+    ck_assert_int_eq(logModuleLevels[LOG_MODULE_WIKI_API], LOG_ERROR);
+
+    ck_assert_int_ne(setLogLevels("core=verbose"), 0);
+    ck_assert_int_ne(setLogModuleLevel("unknownModule", "info"), 0);
+
+    ck_assert_int_eq(setLogModuleLevel("all", "debug"), 0);
+    ck_assert_int_eq(logModuleLevels[LOG_MODULE_WIKI_API], LOG_DEBUG);
+}
+END_TEST
+
+// Test suite setup
+Suite *log_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("log");
+
+    // Core test case
+    tc_core = tcase_create("log");
+
+    tcase_add_test(tc_core, test_log_message_reachesFileAfterFlush);
+    tcase_add_test(tc_core, test_log_message_truncatesLongLines);
+    tcase_add_test(tc_core, test_log_message_skipsArgumentsWhenDisabled);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
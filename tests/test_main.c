@@ -7,7 +7,7 @@ int main(void) {
     log_message(LOG_DEBUG, "\n\nStarting Tests\n\n");
 
     int number_failed;
-    Suite *s1, *s2, *s3, *s4, *s5, *s6, *s7;
+    Suite *s1, *s2, *s3, *s4, *s5, *s6, *s7, *s8, *s9, *s10, *s11, *s12, *s13, *s14, *s15, *s16, *s17, *s18, *s19, *s20, *s21, *s22, *s23, *s24;
     SRunner *sr;
 
     s1 = stringHelpers_suite();
@@ -31,6 +31,57 @@ int main(void) {
     //s7 = updateVcdPage_suite();
     //srunner_add_suite(sr, s7);
 
+    s8 = commandQueueHelpers_suite();
+    srunner_add_suite(sr, s8);
+
+    s9 = commandRegistry_suite();
+    srunner_add_suite(sr, s9);
+
+    s10 = slackAPI_suite();
+    srunner_add_suite(sr, s10);
+
+    s11 = log_suite();
+    srunner_add_suite(sr, s11);
+
+    s12 = trace_suite();
+    srunner_add_suite(sr, s12);
+
+    s13 = networkTelemetry_suite();
+    srunner_add_suite(sr, s13);
+
+    s14 = metrics_suite();
+    srunner_add_suite(sr, s14);
+
+    s15 = httpTransport_suite();
+    srunner_add_suite(sr, s15);
+
+    s16 = allocationProfiler_suite();
+    srunner_add_suite(sr, s16);
+
+    s17 = wikiMutationBatch_suite();
+    srunner_add_suite(sr, s17);
+
+    s18 = wikiPageCache_suite();
+    srunner_add_suite(sr, s18);
+
+    s19 = requirementSnapshotHelpers_suite();
+    srunner_add_suite(sr, s19);
+
+    s20 = fetchStage_suite();
+    srunner_add_suite(sr, s20);
+
+    s21 = commandJournalHelpers_suite();
+    srunner_add_suite(sr, s21);
+
+    s22 = rateLimiter_suite();
+    srunner_add_suite(sr, s22);
+
+    s23 = httpRetry_suite();
+    srunner_add_suite(sr, s23);
+
+    s24 = circuitBreaker_suite();
+    srunner_add_suite(sr, s24);
+
     srunner_run_all(sr, CK_NORMAL);
     number_failed = srunner_ntests_failed(sr);
     srunner_free(sr);
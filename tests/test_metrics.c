@@ -0,0 +1,47 @@
+#include <check.h>
+#include <string.h>
+#include "ERTbot_common.h"
+#include "ERTbot_metrics.h"
+#include "commandQueueHelpers.h"
+
+START_TEST(test_buildMetricsText) {
+    commandQueue* queue = createCommandQueue();
+    (void)enqueueCommand(queue, "help", NULL, COMMAND_PRIORITY_INTERACTIVE);
+    (void)enqueueCommand(queue, "updateVCD", "ST", COMMAND_PRIORITY_BACKGROUND);
+    (void)enqueueCommand(queue, "updateVCD", "PR", COMMAND_PRIORITY_BACKGROUND);
+    setQueueDepthMetric(queue);
+
+    recordCommandDurationMetric("metricsTest", 0.5);
+    recordCommandDurationMetric("metricsTest", 20);
+    recordSchedulerLagMetric(3);
+
+    char* text = buildMetricsText();
+
+    ck_assert_ptr_nonnull(strstr(text, "ertbot_queue_depth{lane=\"interactive\"} 1\n"));
+    ck_assert_ptr_nonnull(strstr(text, "ertbot_queue_depth{lane=\"background\"} 2\n"));
+    ck_assert_ptr_nonnull(strstr(text, "ertbot_command_duration_seconds_bucket{command=\"metricsTest\",le=\"1\"} 1\n"));
+    ck_assert_ptr_nonnull(strstr(text, "ertbot_command_duration_seconds_bucket{command=\"metricsTest\",le=\"60\"} 2\n"));
+    ck_assert_ptr_nonnull(strstr(text, "ertbot_command_duration_seconds_count{command=\"metricsTest\"} 2\n"));
+    ck_assert_ptr_nonnull(strstr(text, "ertbot_scheduler_lag_seconds 3\n"));
+    ck_assert_ptr_nonnull(strstr(text, "# TYPE process_resident_memory_bytes gauge\n"));
+
+    free(text);
+    freeCommandQueue(&queue);
+}
+END_TEST
+
+// Test suite setup
+Suite *metrics_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("metrics");
+
+    // Core test case
+    tc_core = tcase_create("metrics");
+
+    tcase_add_test(tc_core, test_buildMetricsText);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
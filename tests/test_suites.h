@@ -16,4 +16,38 @@ Suite *wikiAPI_suite(void);
 Suite *requirementHelpers_suite(void);
 
 Suite *updateVcdPage_suite(void);
+
+Suite *commandQueueHelpers_suite(void);
+
+Suite *commandRegistry_suite(void);
+
+Suite *slackAPI_suite(void);
+
+Suite *log_suite(void);
+
+Suite *trace_suite(void);
+
+Suite *networkTelemetry_suite(void);
+
+Suite *metrics_suite(void);
+
+Suite *httpTransport_suite(void);
+
+Suite *allocationProfiler_suite(void);
+
+Suite *wikiMutationBatch_suite(void);
+
+Suite *wikiPageCache_suite(void);
+
+Suite *requirementSnapshotHelpers_suite(void);
+
+Suite *fetchStage_suite(void);
+
+Suite *commandJournalHelpers_suite(void);
+
+Suite *rateLimiter_suite(void);
+
+Suite *httpRetry_suite(void);
+
+Suite *circuitBreaker_suite(void);
 #endif
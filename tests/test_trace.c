@@ -0,0 +1,163 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "ERTbot_config.h"
+#include "ERTbot_common.h"
+#include "ERTbot_trace.h"
+
+static bool fileContains(const char *path, const char *text){
+    FILE *file = fopen(path, "r");
+    if(!file){
+        return false;
+    }
+
+    char line[4096];
+    bool found = false;
+    while(!found && fgets(line, sizeof(line), file)){
+        found = strstr(line, text) != NULL;
+    }
+
+    fclose(file);
+    return found;
+}
+
+/**
+ * @brief Deletes the trace files written by a test and its directory.
+ */
+static void removeTraceDirectory(const char *path){
+    DIR *directory = opendir(path);
+    ck_assert_ptr_nonnull(directory);
+
+    struct dirent *entry;
+    while((entry = readdir(directory))){
+        if(strncmp(entry->d_name, "trace_", strlen("trace_")) == 0){
+            char file[512];
+            snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+            remove(file);
+        }
+    }
+
+    closedir(directory);
+    setTraceDirectory(NULL);
+    rmdir(path);
+}
+
+START_TEST(test_endTraceSpan_writesTraceOfCommand) {
+    char directory[] = "/tmp/ERTbot_tracesXXXXXX";
+    ck_assert_ptr_nonnull(mkdtemp(directory));
+    setTraceDirectory(directory);
+
+    beginTraceSpan(TRACE_CATEGORY_COMMAND, "sync", "PR");
+    markTracePhase("fetching requirements");
+    beginTraceSpan(TRACE_CATEGORY_API, "wikiApi", NULL);
+    endTraceSpan();
+    markTracePhase("updating \"requirement\" pages");
+    endTraceSpan();
+
+    char* summary = buildLastTraceSummary();
+    ck_assert_ptr_nonnull(summary);
+    ck_assert_ptr_nonnull(strstr(summary, "*sync PR*"));
+    ck_assert_ptr_nonnull(strstr(summary, "- fetching requirements: "));
+    ck_assert_ptr_nonnull(strstr(summary, "- updating \\\"requirement\\\" pages: "));
+    ck_assert_ptr_nonnull(strstr(summary, "API calls: wikiApi 1x "));
+
+    // The summary gives the path of the trace file in parentheses
+    char path[256];
+    const char *pathStart = strchr(summary, '(');
+    ck_assert_ptr_nonnull(pathStart);
+    ck_assert_int_eq(sscanf(pathStart + 1, "%255[^)]", path), 1);
+
+    ck_assert(fileContains(path, "\"name\":\"sync\",\"cat\":\"command\",\"ph\":\"X\""));
+    ck_assert(fileContains(path, "\"name\":\"wikiApi\",\"cat\":\"api\""));
+    ck_assert(fileContains(path, "\"args\":{\"detail\":\"PR\"}"));
+    ck_assert_int_eq(strncmp(path, directory, strlen(directory)), 0);
+
+    free(summary);
+    removeTraceDirectory(directory);
+}
+END_TEST
+
+START_TEST(test_beginTraceSpan_ignoresSpansOutsideCommands) {
+    beginTraceSpan(TRACE_CATEGORY_COMMAND, "updateReq", "ST");
+    endTraceSpan();
+    char* summaryBefore = buildLastTraceSummary();
+
+    // e.g. the Slack polling of the main loop
+    beginTraceSpan(TRACE_CATEGORY_API, "slackAPI", "conversations.history");
+    markTracePhase("not a phase");
+    endTraceSpan();
+
+    char* summaryAfter = buildLastTraceSummary();
+    ck_assert_str_eq(summaryAfter, summaryBefore);
+
+    free(summaryBefore);
+    free(summaryAfter);
+}
+END_TEST
+
+static int countTraceFiles(const char *path){
+    DIR *directory = opendir(path);
+    ck_assert_ptr_nonnull(directory);
+
+    int count = 0;
+    struct dirent *entry;
+    while((entry = readdir(directory))){
+        count += strncmp(entry->d_name, "trace_", strlen("trace_")) == 0;
+    }
+
+    closedir(directory);
+    return count;
+}
+
+START_TEST(test_endTraceSpan_keepsLastTraceFiles) {
+    char directory[] = "/tmp/ERTbot_tracesXXXXXX";
+    ck_assert_ptr_nonnull(mkdtemp(directory));
+    setTraceDirectory(directory);
+
+    char* firstSummary = NULL;
+
+    for(int i = 0; i < TRACE_MAX_FILES + 2; i++){
+        beginTraceSpan(TRACE_CATEGORY_COMMAND, "sync", "PR ST");
+        endTraceSpan();
+
+        if(i == TRACE_MAX_FILES + 1){
+            firstSummary = buildLastTraceSummary();
+        }
+    }
+    ck_assert_int_eq(countTraceFiles(directory), TRACE_MAX_FILES);
+
+    // Runs in the same second do not overwrite each other, the argument is part of the name
+    beginTraceSpan(TRACE_CATEGORY_COMMAND, "sync", "PR ST");
+    endTraceSpan();
+    char* secondSummary = buildLastTraceSummary();
+
+    ck_assert_ptr_nonnull(strstr(firstSummary, "_sync_PR_ST.json"));
+    ck_assert_str_ne(firstSummary, secondSummary);
+    ck_assert_int_eq(countTraceFiles(directory), TRACE_MAX_FILES);
+
+    free(firstSummary);
+    free(secondSummary);
+    removeTraceDirectory(directory);
+}
+END_TEST
+
+// Test suite setup
+Suite *trace_suite(void) {
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("trace");
+
+    // Core test case
+    tc_core = tcase_create("trace");
+
+    tcase_add_test(tc_core, test_endTraceSpan_writesTraceOfCommand);
+    tcase_add_test(tc_core, test_beginTraceSpan_ignoresSpansOutsideCommands);
+    tcase_add_test(tc_core, test_endTraceSpan_keepsLastTraceFiles);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}